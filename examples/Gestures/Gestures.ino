@@ -0,0 +1,103 @@
+/**
+ * @file      Gestures.ino
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-07-14
+ * @note      Prints tap, double tap, long press, swipe, pinch and rotate.
+ *            With lvgl use beginLvglGestures instead, the gestures are then
+ *            sent to the active screen as an lvgl event.
+ *            Pinch and rotate need a multi touch controller, e.g. the 2.41 inch board.
+ */
+#include <LilyGo_AMOLED.h>
+#include <GestureEngine.h>
+
+// Print the raw samples in the tools/gesture_test trace format instead of the gestures
+#define PRINT_TRACE     0
+
+LilyGo_Class amoled;
+GestureEngine gestures;
+
+static const char *gestureName(const GestureEvent_t &event)
+{
+    switch (event.type) {
+    case GESTURE_TAP:           return "TAP";
+    case GESTURE_DOUBLE_TAP:    return "DOUBLE_TAP";
+    case GESTURE_LONG_PRESS:    return "LONG_PRESS";
+    case GESTURE_SWIPE:
+        switch (event.direction) {
+        case GESTURE_DIR_LEFT:  return "SWIPE_LEFT";
+        case GESTURE_DIR_RIGHT: return "SWIPE_RIGHT";
+        case GESTURE_DIR_UP:    return "SWIPE_UP";
+        default:                return "SWIPE_DOWN";
+        }
+    case GESTURE_PINCH:         return "PINCH";
+    case GESTURE_ROTATE:        return "ROTATE";
+    default:                    return "NONE";
+    }
+}
+
+void setup(void)
+{
+    Serial.begin(115200);
+
+    // Automatically determine the access device
+    if (!amoled.begin()) {
+        while (1) {
+            Serial.println("The board model cannot be detected, please raise the Core Debug Level to an error");
+            delay(1000);
+        }
+    }
+
+    // Read the touch controller on its interrupt, every sample is timestamped
+    if (!amoled.startTouchSampler()) {
+        while (1) {
+            Serial.println("The board has no touch interrupt pin");
+            delay(1000);
+        }
+    }
+}
+
+void loop()
+{
+    TouchEvent_t sample;
+    bool received = false;
+    while (amoled.readTouchEvent(&sample)) {
+        received = true;
+#if PRINT_TRACE
+        if (sample.points > 1) {
+            Serial.printf("%lld %u %d %d %d %d\n", sample.timestamp / 1000, sample.points,
+                          sample.x, sample.y, sample.x2, sample.y2);
+        } else {
+            Serial.printf("%lld %u %d %d\n", sample.timestamp / 1000, sample.points, sample.x, sample.y);
+        }
+#endif
+        gestures.update(sample);
+    }
+    if (!received) {
+        // A finger held still sends no samples, long press needs the time to move on
+        gestures.tick(esp_timer_get_time());
+    }
+
+    GestureEvent_t event;
+    while (gestures.read(&event)) {
+#if !PRINT_TRACE
+        switch (event.type) {
+        case GESTURE_SWIPE:
+            Serial.printf("%s from X:%d Y:%d dx:%d dy:%d speed:%.0f,%.0f px/s\n", gestureName(event),
+                          event.x, event.y, event.dx, event.dy, event.vx, event.vy);
+            break;
+        case GESTURE_PINCH:
+            Serial.printf("%s scale:%.2f\n", gestureName(event), event.scale);
+            break;
+        case GESTURE_ROTATE:
+            Serial.printf("%s angle:%.1f\n", gestureName(event), event.angle);
+            break;
+        default:
+            Serial.printf("%s X:%d Y:%d\n", gestureName(event), event.x, event.y);
+            break;
+        }
+#endif
+    }
+    delay(5);
+}
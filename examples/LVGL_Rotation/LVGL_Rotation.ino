@@ -4,8 +4,7 @@
  * @license   MIT
  * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
  * @date      2023-07-14
- * @note      Screen rotation only supports 2.41 Inch or 1.91-inch touch and non-touch versions
- * @note      Screen rotation only supports 2.41 Inch or 1.91-inch touch and non-touch versions
+ * @note      The 1.91 and 2.41 inch panels rotate in hardware, the 1.47 inch board rotates in software
  */
 
 #include <LilyGo_AMOLED.h>
@@ -25,12 +24,9 @@ const char *format_string = "#0000ff X:%d#\n #ff00ff Y:%d#\n #f00f00 Rotation:%d
 
 void setRotation()
 {
-    amoled.setRotation(rotation++);
+    // Rotates the panel, touch and lvgl together, the screen is redrawn once
+    setLvglHelperRotation(amoled, rotation++);
     rotation %= 4;
-    lv_disp_drv_t *drv = lv_disp_get_default()->driver;
-    drv->hor_res = amoled.width();
-    drv->ver_res = amoled.height();
-    lv_disp_drv_update(lv_disp_get_default(), drv);
 }
 
 void handleEvent(AceButton * /* button */, uint8_t eventType,
@@ -58,7 +54,7 @@ void setup(void)
 
     bool rslt = false;
 
-    // 1.47 inches does not support rotation, this sketch cannot be used
+    // Begin LilyGo  1.47 Inch AMOLED board class
     //rslt = amoled.beginAMOLED_147();
 
     // Begin LilyGo  1.91 Inch AMOLED board class
@@ -124,12 +124,13 @@ void setup()
     beginLvglHelper(amoled);
 
     // Register USB input device
-    inputParams.queue = xQueueCreate( 10, sizeof( struct InputData  ) );    //Creating an Input Queue
+    inputParams.queue = xQueueCreate( 10, sizeof( struct InputData  ) );    //Creating a keyboard Input Queue
+    inputParams.mouseQueue = xQueueCreate( 10, sizeof( struct InputData  ) );   //Creating a mouse Input Queue
     inputParams.icon = (const void *)&image_emoji;  //Set mouse pointer icon
     beginLvglInputDevice(inputParams);  //Register lvgl to allow input device input
 
 
-    setupUSB(inputParams.queue);    // Initialize USB Host
+    setupUSB(inputParams.queue, inputParams.mouseQueue);    // Initialize USB Host
 
     // Creating an Input Box
     lv_obj_t *radio_ta = lv_textarea_create(lv_scr_act());
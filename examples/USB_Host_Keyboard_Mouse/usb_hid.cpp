@@ -31,6 +31,7 @@ static const char *TAG = "example";
 static QueueHandle_t hid_host_event_queue;
 static bool user_shutdown = false;
 static  QueueHandle_t queue_in = NULL;
+static  QueueHandle_t mouse_queue = NULL;
 static  struct InputData pdat = {0};
 
 /**
@@ -336,19 +337,27 @@ static void hid_host_mouse_report_callback(const uint8_t *const data, const int
     hid_print_new_device_report_header(HID_PROTOCOL_MOUSE);
 
 
-    if (queue_in) {
-        pdat.id = 'm';
-        pdat.left = mouse_report->buttons.button1;
-        pdat.right = mouse_report->buttons.button2;
-        pdat.x = x_pos;
-        pdat.y = y_pos;
+    if (mouse_queue) {
+        struct InputData mdat = {0};
+        mdat.id = 'm';
+        mdat.left = mouse_report->buttons.button1;
+        mdat.right = mouse_report->buttons.button2;
+        mdat.x = x_pos;
+        mdat.y = y_pos;
         // Serial.printf("X: %06d\tY: %06d\t|%c|%c|\r",
         //               x_pos, y_pos,
         //               (mouse_report->buttons.button1 ? 'o' : ' '),
         //               (mouse_report->buttons.button2 ? 'o' : ' '));
         // Serial.println();
 
-        xQueueSend(queue_in, &pdat, portMAX_DELAY);
+        // Positions are absolute, a move may be dropped when lvgl falls behind,
+        // a button change must arrive
+        static bool last_left = false, last_right = false;
+        bool edge = mdat.left != last_left || mdat.right != last_right;
+        if (xQueueSend(mouse_queue, &mdat, edge ? portMAX_DELAY : 0) == pdPASS) {
+            last_left = mdat.left;
+            last_right = mdat.right;
+        }
     }
 
 }
@@ -553,10 +562,11 @@ void hid_host_device_callback(hid_host_device_handle_t hid_device_handle,
     xQueueSend(hid_host_event_queue, &evt_queue, 0);
 }
 
-void setupUSB(QueueHandle_t queue_i)
+void setupUSB(QueueHandle_t queue_i, QueueHandle_t mouse_queue_i)
 {
 
     queue_in = queue_i;
+    mouse_queue = mouse_queue_i ? mouse_queue_i : queue_i;
 
     BaseType_t task_created;
     Serial.println("HID Host example");
@@ -13,6 +13,7 @@
 #include "InputParams.h"
 
 
-void setupUSB(QueueHandle_t queue_i);
+// Keys are sent to queue_i, mouse reports to mouse_queue_i or to queue_i when it is NULL
+void setupUSB(QueueHandle_t queue_i, QueueHandle_t mouse_queue_i = NULL);
 
 
@@ -0,0 +1,80 @@
+/**
+ * @file      AreaMerge.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+
+/*
+* Dirty area scheduling shared by the lvgl 8 and 9 helpers. Two areas are
+* merged when one transfer of their bounding box costs less bus time than two
+* separate transfers. lvgl only joins overlapping areas whose union is
+* smaller than their sum, which ignores the fixed cost of every window.
+* The area type only needs x1, y1, x2 and y2, inclusive, e.g. lv_area_t.
+* Builds on the host, see tools/merge_replay.
+*/
+
+typedef struct __AreaCostModel {
+    uint32_t setupUs;           // Window commands and transaction setup of one area
+    uint32_t bytesPerSecond;    // Pixel data rate of the bus
+    uint8_t bytesPerPixel;
+} AreaCostModel_t;
+
+// Estimated bus time of sending one area in nanoseconds
+static inline uint64_t areaCostNs(int32_t x1, int32_t y1, int32_t x2, int32_t y2, const AreaCostModel_t *model)
+{
+    uint64_t bytes = (uint64_t)(x2 - x1 + 1) * (y2 - y1 + 1) * model->bytesPerPixel;
+    return (uint64_t)model->setupUs * 1000ULL + bytes * 1000000000ULL / model->bytesPerSecond;
+}
+
+/*
+* Merge the areas not flagged in joined, a merged area is flagged and the
+* other one grows to the bounding box. Areas are always merged into the
+* higher index, so the area lvgl already selected as the last one of the
+* frame stays valid. Returns the number of merges.
+*/
+template <typename Area>
+uint32_t areaMerge(Area *areas, uint8_t *joined, uint32_t count, const AreaCostModel_t *model)
+{
+    if (!model->setupUs || !model->bytesPerSecond) {
+        return 0;
+    }
+    uint32_t merges = 0;
+    bool merged;
+    do {
+        merged = false;
+        for (uint32_t i = 0; i < count; i++) {
+            if (joined[i]) {
+                continue;
+            }
+            for (uint32_t j = i + 1; j < count; j++) {
+                if (joined[j]) {
+                    continue;
+                }
+                Area &a = areas[i];
+                Area &b = areas[j];
+                int32_t x1 = a.x1 < b.x1 ? a.x1 : b.x1;
+                int32_t y1 = a.y1 < b.y1 ? a.y1 : b.y1;
+                int32_t x2 = a.x2 > b.x2 ? a.x2 : b.x2;
+                int32_t y2 = a.y2 > b.y2 ? a.y2 : b.y2;
+                if (areaCostNs(x1, y1, x2, y2, model) <
+                        areaCostNs(a.x1, a.y1, a.x2, a.y2, model) + areaCostNs(b.x1, b.y1, b.x2, b.y2, model)) {
+                    b.x1 = x1;
+                    b.y1 = y1;
+                    b.x2 = x2;
+                    b.y2 = y2;
+                    joined[i] = 1;
+                    merges++;
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    } while (merged);
+    return merges;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file      BoardDetect.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+
+#include "BoardDetect.h"
+
+#define PROBE_CACHE_SIZE    (8)
+
+typedef struct {
+    const BoardProbe_t *table;
+    uint32_t count;
+    BoardProbeCallback probe;
+    void *user_data;
+    struct {
+        int sda;
+        int scl;
+        uint8_t address;
+        bool found;
+    } cache[PROBE_CACHE_SIZE];
+    uint8_t cached;
+} ProbeContext_t;
+
+static bool probeAddress(ProbeContext_t *ctx, int sda, int scl, uint8_t address)
+{
+    for (uint8_t i = 0; i < ctx->cached; i++) {
+        if (ctx->cache[i].sda == sda && ctx->cache[i].scl == scl && ctx->cache[i].address == address) {
+            return ctx->cache[i].found;
+        }
+    }
+    bool found = ctx->probe(sda, scl, address, ctx->user_data);
+    if (ctx->cached < PROBE_CACHE_SIZE) {
+        ctx->cache[ctx->cached].sda = sda;
+        ctx->cache[ctx->cached].scl = scl;
+        ctx->cache[ctx->cached].address = address;
+        ctx->cache[ctx->cached].found = found;
+        ctx->cached++;
+    }
+    return found;
+}
+
+static bool probeEntry(ProbeContext_t *ctx, const BoardProbe_t *p)
+{
+    if (!probeAddress(ctx, p->sda, p->scl, p->address)) {
+        return false;
+    }
+    return p->alsoAddress == 0 || probeAddress(ctx, p->sda, p->scl, p->alsoAddress);
+}
+
+// Walk the table, entries on other pins than the given ones are skipped when sda is not -1
+static int walkTable(ProbeContext_t *ctx, int sda, int scl)
+{
+    for (uint32_t i = 0; i < ctx->count; i++) {
+        const BoardProbe_t *p = &ctx->table[i];
+        if (sda != -1 && (p->sda != sda || p->scl != scl)) {
+            continue;
+        }
+        if (probeEntry(ctx, p)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int detectBoard(const BoardProbe_t *table, uint32_t count, BoardProbeCallback probe, void *user_data)
+{
+    if (!table || !probe) {
+        return -1;
+    }
+    ProbeContext_t ctx = {table, count, probe, user_data, {}, 0};
+    return walkTable(&ctx, -1, -1);
+}
+
+bool verifyBoard(const BoardProbe_t *table, uint32_t count, uint32_t index, BoardProbeCallback probe, void *user_data)
+{
+    if (!table || !probe || index >= count) {
+        return false;
+    }
+    ProbeContext_t ctx = {table, count, probe, user_data, {}, 0};
+    return walkTable(&ctx, table[index].sda, table[index].scl) == (int)index;
+}
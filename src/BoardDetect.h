@@ -0,0 +1,42 @@
+/**
+ * @file      BoardDetect.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+
+/*
+* Table driven board detection. Every entry names the I2C pins, one or two
+* device addresses that must answer and the board reported on a match. The
+* table is walked in order, so more specific entries go first.
+* The bus access is a callback, the engine itself has no Arduino dependency.
+*/
+
+typedef struct __BoardProbe {
+    int sda;
+    int scl;
+    uint8_t address;            // Device that must answer
+    uint8_t alsoAddress;        // Second device that must also answer, 0 for none
+    uint8_t board;              // Board ID reported on a match
+} BoardProbe_t;
+
+// Returns true if a device acknowledges address on the sda/scl pins
+typedef bool (*BoardProbeCallback)(int sda, int scl, uint8_t address, void *user_data);
+
+/**
+ * @brief  Find the first matching table entry
+ * @note   Every (pins, address) pair is probed at most once
+ * @retval Index of the matching entry, -1 if none matches
+ */
+int detectBoard(const BoardProbe_t *table, uint32_t count, BoardProbeCallback probe, void *user_data);
+
+/**
+ * @brief  Check that the table still resolves to index, only the entries that share
+ *         its pins are probed, used to confirm a cached detection result
+ */
+bool verifyBoard(const BoardProbe_t *table, uint32_t count, uint32_t index, BoardProbeCallback probe, void *user_data);
@@ -0,0 +1,211 @@
+/**
+ * @file      DisplayConfigure.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include "initSequence.h"
+
+/*
+* Panel and bus configuration of the boards. Kept free of Arduino so that
+* LilyGo_VirtualDisplay and the host tools model the same panels as the driver.
+*/
+
+#ifndef BOARD_NONE_PIN
+#define BOARD_NONE_PIN      (-1)
+#endif
+#define DISPLAY_MAX_CHUNK_SIZE  (16384) // Maximum pixels per QSPI transaction, sets the bus max_transfer_sz
+#define DISPLAY_QSPI_TRANS_OVERHEAD_US  (8)     // Queue, interrupt and callback time of one QSPI transaction
+#define DISPLAY_SPI_TRANS_OVERHEAD_US   (20)    // beginTransaction and DC/CS toggling of one SPI write
+
+/*
+* One entry per setRotation value. Panels that have a frame buffer are rotated
+* in software by pushColors and ignore madctl, the other fields apply to all.
+*/
+typedef struct __DisplayRotation {
+    uint8_t madctl;         // Scan direction written to MADCTL
+    bool swapSize;          // Logical width and height are the configured height and width
+    uint8_t offsetX;        // Hidden GRAM columns before the visible area
+    uint8_t offsetY;        // Hidden GRAM rows before the visible area
+    bool touchSwapXY;
+    bool touchMirrorX;
+    bool touchMirrorY;
+} DisplayRotation_t;
+
+typedef struct __DisplayConfigure {
+    int d0;
+    int d1;
+    int d2;
+    int d3;
+    int sck;
+    int cs;
+    int dc;
+    int rst;
+    int te;
+    uint8_t cmdBit;
+    uint8_t addBit;
+    int  freq;
+    const lcd_init_t *initSequence;
+    uint16_t width;
+    uint16_t height;
+    uint32_t frameBufferSize;
+    bool fullRefresh;
+    bool hardwareCS;    // QSPI only, let the SPI peripheral drive CS, opt in, false drives CS as a GPIO from the transaction callbacks
+    uint32_t chunkSize; // QSPI only, default pixels per transaction, at most DISPLAY_MAX_CHUNK_SIZE
+    uint16_t resetSettleMs; // Fast boot power settle time before the reset pulse, not specified by the panel datasheets
+    uint16_t resetLowMs;    // Fast boot reset pulse width, tRESW of the panel datasheet where the tree has it
+    uint16_t resetWaitMs;   // Fast boot wait between reset release and the first command, see the board entries
+    const DisplayRotation_t *rotation;  // Four entries indexed by setRotation, NULL if the panel cannot rotate
+} DisplayConfigure_t;
+
+// Touch is mapped in the panel scan order, rotation 1 needs no transpose
+static const DisplayRotation_t SH8501_ROTATION[4] = {
+    // madctl   swapSize offsetX offsetY touchSwapXY touchMirrorX touchMirrorY
+    {0,         false,   0,      0,      true,       false,       true},
+    {0,         true,    0,      0,      false,      false,       false},
+    {0,         false,   0,      0,      true,       true,        false},
+    {0,         true,    0,      0,      false,      true,        true},
+};
+
+static const DisplayRotation_t RM67162_ROTATION[4] = {
+    {RM67162_MADCTL_MX | RM67162_MADCTL_MV | RM67162_MADCTL_RGB,    true,   0, 0, false, false, false},
+    {RM67162_MADCTL_RGB,                                            false,  0, 0, true,  true,  false},
+    {RM67162_MADCTL_MV | RM67162_MADCTL_MY | RM67162_MADCTL_RGB,    true,   0, 0, false, true,  true},
+    {RM67162_MADCTL_MX | RM67162_MADCTL_MY | RM67162_MADCTL_RGB,    false,  0, 0, true,  false, true},
+};
+
+static const DisplayRotation_t RM690B0_ROTATION[4] = {
+    {RM690B0_MADCTL_MX | RM690B0_MADCTL_MV | RM690B0_MADCTL_RGB,    false,  0,  16, true,  false, true},
+    {RM690B0_MADCTL_RGB,                                            true,   16, 0,  false, false, false},
+    {RM690B0_MADCTL_MV | RM690B0_MADCTL_MY | RM690B0_MADCTL_RGB,    false,  0,  16, true,  true,  false},
+    {RM690B0_MADCTL_MX | RM690B0_MADCTL_MY | RM690B0_MADCTL_RGB,    true,   16, 0,  false, true,  true},
+};
+
+// LILYGO 1.47 Inch AMOLED(SH8501) S3R8
+// https://www.lilygo.cc/products/t-display-amoled
+static const DisplayConfigure_t SH8501_AMOLED  = {
+    7, //BOARD_DISP_DATA0,
+    10,//BOARD_DISP_DATA1,
+    11,//BOARD_DISP_DATA2,
+    12,//BOARD_DISP_DATA3,
+    5,//BOARD_DISP_SCK,
+    4,//BOARD_DISP_CS,
+    BOARD_NONE_PIN,//DC
+    40,//BOARD_DISP_RESET,
+    6,//BOARD_DISP_TE,
+    8,//command bit
+    24,//address bit
+    30000000,
+    &sh8501_init,
+    SH8501_WIDTH, //width
+    SH8501_HEIGHT, //height
+    SH8501_WIDTH *SH8501_HEIGHT * sizeof(uint16_t), //frameBufferSize
+    false, //fullRefresh, areas are rotated by pushColors, start and end must stay even
+    false, //hardwareCS
+    DISPLAY_MAX_CHUNK_SIZE, //chunkSize
+    10, //resetSettleMs, carried over, no SH8501 datasheet in datasheet/
+    10, //resetLowMs, carried over
+    50, //resetWaitMs, carried over
+    SH8501_ROTATION //rotation
+};
+
+// LILYGO 1.91 Inch AMOLED(RM67162) S3R8
+// https://www.lilygo.cc/products/t-display-s3-amoled
+static const DisplayConfigure_t RM67162_AMOLED  = {
+    18,//BOARD_DISP_DATA0,
+    7,//BOARD_DISP_DATA1,
+    48,//BOARD_DISP_DATA2,
+    5,//BOARD_DISP_DATA3,
+    47,//BOARD_DISP_SCK,
+    6,//BOARD_DISP_CS,
+    BOARD_NONE_PIN,//DC
+    17,//BOARD_DISP_RESET,
+    9, //BOARD_DISP_TE,
+    8, //command bit
+    24,//address bit
+    75000000,
+    &rm67162_init,
+    RM67162_WIDTH,//width
+    RM67162_HEIGHT,//height
+    0,//frameBufferSize
+    false, //fullRefresh
+    false, //hardwareCS
+    DISPLAY_MAX_CHUNK_SIZE, //chunkSize
+    10, //resetSettleMs, carried over, the datasheet gives no supply to RESX time
+    1, //resetLowMs, RM67162 datasheet 7.6.3 tRESW 10 us, rounded up to delay()
+    120, //resetWaitMs, RM67162 datasheet 7.6.3 note 5, no Sleep Out for 120 ms after RESX, the init sends it first
+    RM67162_ROTATION //rotation
+};
+
+// LILYGO 1.91 Inch AMOLED(RM67162) S3R8
+// https://www.lilygo.cc/products/t-display-s3-amoled
+static const DisplayConfigure_t RM67162_AMOLED_SPI  = {
+    18,//BOARD_DISP_DATA0,          //MOSI
+    7,//BOARD_DISP_DATA1,           //DC
+    -1,//BOARD_DISP_DATA2,
+    -1,//BOARD_DISP_DATA3,
+    47,//BOARD_DISP_SCK,            //SCK
+    6,//BOARD_DISP_CS,              //CS
+    BOARD_NONE_PIN,//DC
+    17,//BOARD_DISP_RESET,          //RST
+    9, //BOARD_DISP_TE,
+    8, //command bit
+    24,//address bit
+    40000000,
+    &rm67162_spi_init,
+    RM67162_WIDTH,//width
+    RM67162_HEIGHT,//height
+    0,//frameBufferSize
+    false, //fullRefresh
+    false, //hardwareCS
+    DISPLAY_MAX_CHUNK_SIZE, //chunkSize
+    10, //resetSettleMs, carried over, the datasheet gives no supply to RESX time
+    1, //resetLowMs, RM67162 datasheet 7.6.3 tRESW 10 us, rounded up to delay()
+    120, //resetWaitMs, RM67162 datasheet 7.6.3 note 5, no Sleep Out for 120 ms after RESX, the init sends it first
+    RM67162_ROTATION //rotation
+};
+
+// LILYGO 2.41 Inch AMOLED(RM690B0) S3R8
+// https://www.lilygo.cc/products/t4-s3
+static const DisplayConfigure_t RM690B0_AMOLED  = {
+    14,//BOARD_DISP_DATA0,
+    10,//BOARD_DISP_DATA1,
+    16,//BOARD_DISP_DATA2,
+    12,//BOARD_DISP_DATA3,
+    15,//BOARD_DISP_SCK,
+    11,//BOARD_DISP_CS,
+    BOARD_NONE_PIN,//DC
+    13,//BOARD_DISP_RESET,
+    18, //BOARD_DISP_TE,
+    8, //command bit
+    24,//address bit
+    36000000,
+    &rm690b0_init,
+    RM690B0_WIDTH,//width
+    RM690B0_HEIGHT,//height
+    0,//frameBufferSize
+    false, //fullRefresh
+    false, //hardwareCS
+    DISPLAY_MAX_CHUNK_SIZE, //chunkSize
+    10, //resetSettleMs, carried over, no RM690B0 datasheet in datasheet/
+    10, //resetLowMs, carried over
+    20, //resetWaitMs, carried over
+    RM690B0_ROTATION //rotation
+};
+
+// Data lines of the pixel bus, the SPI variant leaves d2 and d3 unconnected
+static inline uint8_t displayBusLanes(const DisplayConfigure_t *display)
+{
+    return display->d2 >= 0 && display->d3 >= 0 ? 4 : 1;
+}
+
+// Fixed cost of one transaction on the pixel bus
+static inline uint32_t displayTransOverheadUs(const DisplayConfigure_t *display)
+{
+    return displayBusLanes(display) == 1 ? DISPLAY_SPI_TRANS_OVERHEAD_US : DISPLAY_QSPI_TRANS_OVERHEAD_US;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file      DisplayTrace.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+* Binary trace of the display bus transactions, written by LilyGo_AMOLED::startTrace
+* and read back by tools/trace_replay.
+*
+* File layout: one DisplayTraceHeader_t, then DisplayTraceRecord_t entries, each
+* followed by length bytes of data when TRACE_PAYLOAD is set. Data bytes are in
+* bus order, pixels are RGB565 high byte first. All fields are little endian.
+*/
+
+#define DISPLAY_TRACE_MAGIC     (0x43525444)    // "DTRC"
+#define DISPLAY_TRACE_VERSION   (1)
+
+enum DisplayTraceFlags {
+    TRACE_QIO       = (1 << 0),     // Data phase on four lines (SPI_TRANS_MODE_QIO)
+    TRACE_CONTINUE  = (1 << 1),     // No command and address phase, data continues the previous RAMWR
+    TRACE_CS_BEGIN  = (1 << 2),     // CS is asserted before the transaction
+    TRACE_CS_END    = (1 << 3),     // CS is released after the transaction
+    TRACE_POLLING   = (1 << 4),     // Sent with a blocking transfer instead of the DMA queue
+    TRACE_PAYLOAD   = (1 << 5),     // length data bytes follow the record
+    TRACE_FRAME     = (1 << 6),     // Frame start marker, not a bus transaction
+};
+
+typedef struct __attribute__((packed)) __DisplayTraceHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t gramWidth;             // Largest column + 1 the driver may address, offsets included
+    uint16_t gramHeight;
+    uint8_t lanes;                  // Data lines of a TRACE_QIO transaction, 1 for the SPI interface
+    uint8_t reserved;
+    uint32_t freq;                  // Bus clock in Hz
+} DisplayTraceHeader_t;
+
+typedef struct __attribute__((packed)) __DisplayTraceRecord {
+    uint32_t timestamp;             // Queue time in microseconds
+    uint32_t addr;                  // 24 bit address phase, the panel command is addr >> 8
+    uint32_t length;                // Data bytes
+    uint8_t cmd;                    // Command phase, 0x02 register write, 0x32 pixel write
+    uint8_t flags;                  // DisplayTraceFlags
+} DisplayTraceRecord_t;
+
+// Returns the number of bytes written
+typedef size_t (*DisplayTraceWriter)(const void *data, size_t len, void *user_data);
@@ -0,0 +1,289 @@
+/**
+ * @file      GestureEngine.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+
+#include "GestureEngine.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GESTURE_PI      (3.14159265f)
+
+static const GestureConfig_t defaultConfig = GESTURE_CONFIG_DEFAULT;
+
+static inline int32_t distance2(int32_t dx, int32_t dy)
+{
+    return dx * dx + dy * dy;
+}
+
+// Wrap an angle difference into [-180, 180)
+static inline float wrapDegrees(float a)
+{
+    while (a >= 180.0f) {
+        a -= 360.0f;
+    }
+    while (a < -180.0f) {
+        a += 360.0f;
+    }
+    return a;
+}
+
+GestureEngine::GestureEngine()
+{
+    setConfig(defaultConfig);
+    reset();
+}
+
+GestureEngine::GestureEngine(const GestureConfig_t &config)
+{
+    setConfig(config);
+    reset();
+}
+
+void GestureEngine::setConfig(const GestureConfig_t &config)
+{
+    _config = config;
+}
+
+void GestureEngine::reset()
+{
+    _state = STATE_IDLE;
+    memset(&_start, 0, sizeof(_start));
+    memset(&_lastTap, 0, sizeof(_lastTap));
+    _historyCount = 0;
+    _historyHead = 0;
+    _moved = false;
+    _longFired = false;
+    _startDistance = 0;
+    _lastRawAngle = 0;
+    _angle = 0;
+    _lastScale = 1.0f;
+    _lastAngle = 0;
+    _queueHead = 0;
+    _queueCount = 0;
+    _dropped = 0;
+}
+
+bool GestureEngine::read(GestureEvent_t *event)
+{
+    if (!_queueCount) {
+        return false;
+    }
+    *event = _queue[_queueHead];
+    _queueHead = (_queueHead + 1) % GESTURE_QUEUE_SIZE;
+    _queueCount--;
+    return true;
+}
+
+uint32_t GestureEngine::dropped()
+{
+    return _dropped;
+}
+
+void GestureEngine::initEvent(GestureEvent_t *event, GestureType type, int64_t timestamp, int16_t x, int16_t y)
+{
+    memset(event, 0, sizeof(GestureEvent_t));
+    event->type = type;
+    event->timestamp = timestamp;
+    event->x = x;
+    event->y = y;
+    event->scale = 1.0f;
+}
+
+void GestureEngine::emit(const GestureEvent_t &event)
+{
+    if (_queueCount == GESTURE_QUEUE_SIZE) {
+        _dropped++;
+        return;
+    }
+    _queue[(_queueHead + _queueCount) % GESTURE_QUEUE_SIZE] = event;
+    _queueCount++;
+}
+
+void GestureEngine::update(const TouchEvent_t &sample)
+{
+    if (!sample.points) {
+        release(sample.timestamp);
+        return;
+    }
+    if (sample.points > 1) {
+        updateMulti(sample);
+        return;
+    }
+
+    switch (_state) {
+    case STATE_IDLE:
+        startSingle(sample);
+        break;
+    case STATE_SINGLE: {
+        Sample_t &s = _history[_historyHead];
+        s.timestamp = sample.timestamp;
+        s.x = sample.x;
+        s.y = sample.y;
+        _historyHead = (_historyHead + 1) % GESTURE_HISTORY_SIZE;
+        if (_historyCount < GESTURE_HISTORY_SIZE) {
+            _historyCount++;
+        }
+        if (!_moved && distance2(sample.x - _start.x, sample.y - _start.y) > (int32_t)_config.slop * _config.slop) {
+            _moved = true;
+        }
+        checkLongPress(sample.timestamp);
+        break;
+    }
+    case STATE_MULTI:
+        // One finger lifted, the rest of the touch belongs to the two finger gesture
+        _state = STATE_WAIT_RELEASE;
+        break;
+    default:
+        break;
+    }
+}
+
+void GestureEngine::tick(int64_t now_us)
+{
+    checkLongPress(now_us);
+}
+
+void GestureEngine::startSingle(const TouchEvent_t &sample)
+{
+    _state = STATE_SINGLE;
+    _start.timestamp = sample.timestamp;
+    _start.x = sample.x;
+    _start.y = sample.y;
+    _history[0] = _start;
+    _historyHead = 1;
+    _historyCount = 1;
+    _moved = false;
+    _longFired = false;
+}
+
+void GestureEngine::checkLongPress(int64_t now)
+{
+    if (_state != STATE_SINGLE || _moved || _longFired) {
+        return;
+    }
+    if (now - _start.timestamp < (int64_t)_config.longPressMs * 1000) {
+        return;
+    }
+    GestureEvent_t event;
+    initEvent(&event, GESTURE_LONG_PRESS, now, _start.x, _start.y);
+    emit(event);
+    _longFired = true;
+}
+
+void GestureEngine::release(int64_t now)
+{
+    if (_state != STATE_SINGLE) {
+        _state = STATE_IDLE;
+        return;
+    }
+    _state = STATE_IDLE;
+    checkLongPress(now);
+    if (_longFired) {
+        return;
+    }
+
+    const Sample_t &last = _history[(_historyHead + GESTURE_HISTORY_SIZE - 1) % GESTURE_HISTORY_SIZE];
+    GestureEvent_t event;
+    if (_moved) {
+        // Velocity over the last few samples, not the whole path
+        const Sample_t &first = _history[(_historyHead + GESTURE_HISTORY_SIZE - _historyCount) % GESTURE_HISTORY_SIZE];
+        int16_t dx = last.x - _start.x, dy = last.y - _start.y;
+        float dt = (float)(last.timestamp - first.timestamp) / 1000000.0f;
+        float vx = 0, vy = 0;
+        if (dt > 0) {
+            vx = (last.x - first.x) / dt;
+            vy = (last.y - first.y) / dt;
+        }
+        if (distance2(dx, dy) < (int32_t)_config.swipeDistance * _config.swipeDistance ||
+                vx * vx + vy * vy < (float)_config.swipeVelocity * _config.swipeVelocity) {
+            return;
+        }
+        initEvent(&event, GESTURE_SWIPE, now, _start.x, _start.y);
+        event.dx = dx;
+        event.dy = dy;
+        event.vx = vx;
+        event.vy = vy;
+        if (abs(dx) >= abs(dy)) {
+            event.direction = dx < 0 ? GESTURE_DIR_LEFT : GESTURE_DIR_RIGHT;
+        } else {
+            event.direction = dy < 0 ? GESTURE_DIR_UP : GESTURE_DIR_DOWN;
+        }
+        emit(event);
+        return;
+    }
+
+    if (now - _start.timestamp > (int64_t)_config.tapMs * 1000) {
+        return;
+    }
+    int32_t near = 2 * _config.slop;
+    if (_lastTap.timestamp && _start.timestamp - _lastTap.timestamp <= (int64_t)_config.doubleTapMs * 1000 &&
+            distance2(_start.x - _lastTap.x, _start.y - _lastTap.y) <= near * near) {
+        initEvent(&event, GESTURE_DOUBLE_TAP, now, _start.x, _start.y);
+        emit(event);
+        // A third tap starts over
+        _lastTap.timestamp = 0;
+        return;
+    }
+    initEvent(&event, GESTURE_TAP, now, _start.x, _start.y);
+    emit(event);
+    _lastTap.timestamp = now;
+    _lastTap.x = _start.x;
+    _lastTap.y = _start.y;
+}
+
+/*
+* The angle is accumulated sample to sample so that turns past 180 degrees
+* keep counting. Controllers may report the two fingers in either order, a
+* swap shows up as a 180 degree step and is ignored.
+*/
+void GestureEngine::updateMulti(const TouchEvent_t &sample)
+{
+    float dx = (float)(sample.x2 - sample.x), dy = (float)(sample.y2 - sample.y);
+    float distance = sqrtf(dx * dx + dy * dy);
+    float raw = atan2f(dy, dx) * 180.0f / GESTURE_PI;
+    int16_t cx = (sample.x + sample.x2) / 2, cy = (sample.y + sample.y2) / 2;
+
+    if (_state != STATE_MULTI) {
+        // A tap or long press in progress is cancelled by the second finger
+        _state = STATE_MULTI;
+        _startDistance = distance;
+        _lastRawAngle = raw;
+        _angle = 0;
+        _lastScale = 1.0f;
+        _lastAngle = 0;
+        _lastTap.timestamp = 0;
+        return;
+    }
+    if (_startDistance < 1.0f) {
+        _startDistance = distance;
+        return;
+    }
+
+    float step = wrapDegrees(raw - _lastRawAngle);
+    if (fabsf(step) > 150.0f) {
+        step = wrapDegrees(step + 180.0f);
+    }
+    _lastRawAngle = raw;
+    _angle += step;
+
+    GestureEvent_t event;
+    float scale = distance / _startDistance;
+    if (fabsf(scale - _lastScale) >= _config.pinchStep) {
+        initEvent(&event, GESTURE_PINCH, sample.timestamp, cx, cy);
+        event.scale = scale;
+        emit(event);
+        _lastScale = scale;
+    }
+    if (fabsf(_angle - _lastAngle) >= _config.rotateStep) {
+        initEvent(&event, GESTURE_ROTATE, sample.timestamp, cx, cy);
+        event.angle = _angle;
+        emit(event);
+        _lastAngle = _angle;
+    }
+}
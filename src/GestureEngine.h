@@ -0,0 +1,131 @@
+/**
+ * @file      GestureEngine.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include "TouchRing.h"
+
+/*
+* Recognizes tap, double tap, long press, swipe and two finger pinch / rotate
+* on timestamped touch samples, e.g. from LilyGo_AMOLED::readTouchEvent.
+* Nothing is allocated and every call does a fixed amount of work, recognized
+* gestures are queued until read. The first tap of a double tap is reported
+* as a tap as well, so a single tap is not delayed.
+* Builds on the host, see tools/gesture_test.
+*/
+
+#define GESTURE_QUEUE_SIZE      (8)     // Recognized gestures waiting for read
+#define GESTURE_HISTORY_SIZE    (4)     // Samples used for the swipe release velocity
+
+enum GestureType {
+    GESTURE_NONE,
+    GESTURE_TAP,
+    GESTURE_DOUBLE_TAP,
+    GESTURE_LONG_PRESS,
+    GESTURE_SWIPE,
+    GESTURE_PINCH,
+    GESTURE_ROTATE,
+};
+
+enum GestureDirection {
+    GESTURE_DIR_NONE,
+    GESTURE_DIR_LEFT,
+    GESTURE_DIR_RIGHT,
+    GESTURE_DIR_UP,
+    GESTURE_DIR_DOWN,
+};
+
+typedef struct __GestureEvent {
+    GestureType type;
+    int64_t timestamp;          // Sample that completed the gesture, microseconds
+    int16_t x;                  // Tap and long press position, swipe start, center of two fingers
+    int16_t y;
+    GestureDirection direction; // Swipe, dominant axis of the travel
+    int16_t dx;                 // Swipe travel
+    int16_t dy;
+    float vx;                   // Swipe velocity at release, pixels per second
+    float vy;
+    float scale;                // Pinch, finger distance over the distance when the second finger came down
+    float angle;                // Rotate, degrees turned since the second finger came down, clockwise
+} GestureEvent_t;
+
+typedef struct __GestureConfig {
+    uint16_t slop;              // Pixels a finger may move and still tap or long press
+    uint16_t tapMs;             // Longest press that is a tap
+    uint16_t doubleTapMs;       // Longest release to press gap between the taps of a double tap
+    uint16_t longPressMs;
+    uint16_t swipeDistance;     // Shortest swipe in pixels
+    uint16_t swipeVelocity;     // Slowest swipe at release in pixels per second
+    float pinchStep;            // Scale change between two pinch events
+    float rotateStep;           // Angle change in degrees between two rotate events
+} GestureConfig_t;
+
+#define GESTURE_CONFIG_DEFAULT  {12, 250, 300, 500, 40, 150, 0.1f, 10.0f}
+
+class GestureEngine
+{
+public:
+    GestureEngine();
+    explicit GestureEngine(const GestureConfig_t &config);
+
+    void setConfig(const GestureConfig_t &config);
+    // Feed one sample, samples must come in time order
+    void update(const TouchEvent_t &sample);
+    // Let time pass without a sample, a finger held still turns into a long press
+    void tick(int64_t now_us);
+    // Returns false if no gesture is queued
+    bool read(GestureEvent_t *event);
+    // Gestures lost because the queue was full
+    uint32_t dropped();
+    // Forget the finger state and queued gestures
+    void reset();
+
+private:
+    enum State {
+        STATE_IDLE,
+        STATE_SINGLE,           // One finger down
+        STATE_MULTI,            // Two fingers down
+        STATE_WAIT_RELEASE,     // Fingers left over from a two finger gesture
+    };
+
+    typedef struct {
+        int64_t timestamp;
+        int16_t x, y;
+    } Sample_t;
+
+    void startSingle(const TouchEvent_t &sample);
+    void updateMulti(const TouchEvent_t &sample);
+    void release(int64_t now);
+    void checkLongPress(int64_t now);
+    void initEvent(GestureEvent_t *event, GestureType type, int64_t timestamp, int16_t x, int16_t y);
+    void emit(const GestureEvent_t &event);
+
+    GestureConfig_t _config;
+    State _state;
+
+    Sample_t _start;
+    Sample_t _history[GESTURE_HISTORY_SIZE];
+    uint8_t _historyCount;
+    uint8_t _historyHead;
+    bool _moved;
+    bool _longFired;
+
+    Sample_t _lastTap;          // Release of the last tap, timestamp 0 if none
+
+    float _startDistance;
+    float _lastRawAngle;
+    float _angle;
+    float _lastScale;
+    float _lastAngle;
+
+    GestureEvent_t _queue[GESTURE_QUEUE_SIZE];
+    uint8_t _queueHead;
+    uint8_t _queueCount;
+    uint32_t _dropped;
+};
@@ -0,0 +1,342 @@
+/**
+ * @file      I2CBus.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+
+#include "I2CBus.h"
+#include <string.h>
+#if defined(ESP_PLATFORM)
+#include <freertos/semphr.h>
+#include <esp_timer.h>
+#else
+#include <chrono>
+#include <condition_variable>
+#endif
+#if defined(ARDUINO)
+#include <Wire.h>
+#endif
+
+I2CBus *I2CBus::_default = NULL;
+
+// A task waiting for the bus, lives on the stack of the waiting task
+struct I2CBus::Waiter {
+    I2CBusPriority priority;
+    Waiter *next;
+#if defined(ESP_PLATFORM)
+    StaticSemaphore_t buffer;
+    SemaphoreHandle_t ready;
+#else
+    std::condition_variable cv;
+    bool ready;
+#endif
+};
+
+static inline int64_t nowUs()
+{
+#if defined(ESP_PLATFORM)
+    return esp_timer_get_time();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+I2CBus::I2CBus() :
+    _transfer(NULL),
+    _userData(NULL),
+    _deviceNum(0),
+    _busy(false),
+    _waiters(NULL)
+{
+#if defined(ESP_PLATFORM)
+    portMUX_INITIALIZE(&_guard);
+#endif
+}
+
+void I2CBus::begin(i2c_bus_transfer_t transfer, void *user_data)
+{
+    _transfer = transfer;
+    _userData = user_data;
+}
+
+bool I2CBus::addDevice(const I2CDeviceConfig_t &config)
+{
+    if (config.burstLast && (config.burstLast < config.burstFirst ||
+                             config.burstLast - config.burstFirst + 1 > I2C_BUS_MAX_BURST)) {
+        return false;
+    }
+    Device_t *device = findDevice(config.address);
+    if (!device) {
+        return false;
+    }
+    lock(I2C_PRIORITY_HIGH);
+    device->config = config;
+    device->cacheValid = false;
+    unlock();
+    return true;
+}
+
+// Returns the entry of address, unknown addresses are added, NULL if the table is full
+I2CBus::Device_t *I2CBus::findDevice(uint8_t address)
+{
+    Device_t *device = NULL;
+#if defined(ESP_PLATFORM)
+    portENTER_CRITICAL(&_guard);
+#else
+    std::lock_guard<std::mutex> guard(_guard);
+#endif
+    for (uint8_t i = 0; i < _deviceNum; i++) {
+        if (_devices[i].config.address == address) {
+            device = &_devices[i];
+            break;
+        }
+    }
+    if (!device && _deviceNum < I2C_BUS_MAX_DEVICES) {
+        device = &_devices[_deviceNum++];
+        memset(device, 0, sizeof(Device_t));
+        device->config.address = address;
+        device->config.priority = I2C_PRIORITY_NORMAL;
+    }
+#if defined(ESP_PLATFORM)
+    portEXIT_CRITICAL(&_guard);
+#endif
+    return device;
+}
+
+// Called with the guard held, behind every waiter of the same or a higher priority
+void I2CBus::enqueue(Waiter *waiter)
+{
+    Waiter **p = &_waiters;
+    while (*p && (*p)->priority >= waiter->priority) {
+        p = &(*p)->next;
+    }
+    waiter->next = *p;
+    *p = waiter;
+}
+
+void I2CBus::lock(I2CBusPriority priority)
+{
+#if defined(ESP_PLATFORM)
+    portENTER_CRITICAL(&_guard);
+    if (!_busy) {
+        _busy = true;
+        portEXIT_CRITICAL(&_guard);
+        return;
+    }
+    portEXIT_CRITICAL(&_guard);
+
+    Waiter waiter;
+    waiter.priority = priority;
+    waiter.ready = xSemaphoreCreateBinaryStatic(&waiter.buffer);
+    portENTER_CRITICAL(&_guard);
+    if (!_busy) {
+        // Released in between
+        _busy = true;
+        portEXIT_CRITICAL(&_guard);
+        vSemaphoreDelete(waiter.ready);
+        return;
+    }
+    enqueue(&waiter);
+    portEXIT_CRITICAL(&_guard);
+    // The bus is handed over by unlock, it stays busy
+    xSemaphoreTake(waiter.ready, portMAX_DELAY);
+    vSemaphoreDelete(waiter.ready);
+#else
+    std::unique_lock<std::mutex> guard(_guard);
+    if (!_busy) {
+        _busy = true;
+        return;
+    }
+    Waiter waiter;
+    waiter.priority = priority;
+    waiter.ready = false;
+    enqueue(&waiter);
+    waiter.cv.wait(guard, [&waiter] { return waiter.ready; });
+#endif
+}
+
+void I2CBus::unlock()
+{
+#if defined(ESP_PLATFORM)
+    portENTER_CRITICAL(&_guard);
+    Waiter *waiter = _waiters;
+    if (waiter) {
+        _waiters = waiter->next;
+    } else {
+        _busy = false;
+    }
+    portEXIT_CRITICAL(&_guard);
+    if (waiter) {
+        xSemaphoreGive(waiter->ready);
+    }
+#else
+    std::lock_guard<std::mutex> guard(_guard);
+    Waiter *waiter = _waiters;
+    if (waiter) {
+        _waiters = waiter->next;
+        // Notified with the guard held, the waiter and its cv stay valid until it is released
+        waiter->ready = true;
+        waiter->cv.notify_one();
+    } else {
+        _busy = false;
+    }
+#endif
+}
+
+// Called with the bus held
+void I2CBus::finish(Device_t *device, int64_t start, int64_t owned, int result, size_t bytes, bool write)
+{
+    if (!device) {
+        return;
+    }
+    I2CDeviceStats_t &stats = device->stats;
+    uint32_t latency = (uint32_t)(nowUs() - start);
+    uint32_t wait = (uint32_t)(owned - start);
+    if (write) {
+        stats.writes++;
+    } else {
+        stats.reads++;
+    }
+    if (result != 0) {
+        stats.errors++;
+    } else {
+        stats.bytes += bytes;
+    }
+    stats.lastLatencyUs = latency;
+    stats.maxLatencyUs = latency > stats.maxLatencyUs ? latency : stats.maxLatencyUs;
+    stats.lastWaitUs = wait;
+    stats.maxWaitUs = wait > stats.maxWaitUs ? wait : stats.maxWaitUs;
+}
+
+int I2CBus::readRegister(uint8_t address, uint8_t reg, uint8_t *data, uint8_t len)
+{
+    if (!_transfer || !data || !len) {
+        return -1;
+    }
+    int64_t start = nowUs();
+    Device_t *device = findDevice(address);
+    lock(device ? device->config.priority : I2C_PRIORITY_NORMAL);
+    int64_t owned = nowUs();
+
+    int result;
+    const I2CDeviceConfig_t *config = device ? &device->config : NULL;
+    if (config && config->burstLast && reg >= config->burstFirst && reg + len - 1 <= config->burstLast) {
+        if (!device->cacheValid || owned - device->cacheUs > config->burstCacheUs) {
+            // Whole range in one transfer, timed from its start so that it never serves longer than asked
+            uint8_t first = config->burstFirst;
+            size_t span = config->burstLast - config->burstFirst + 1;
+            result = _transfer(_userData, address, &first, 1, device->cache, span);
+            device->cacheValid = result == 0;
+            device->cacheUs = owned;
+            finish(device, start, owned, result, span, false);
+        } else {
+            device->stats.burstHits++;
+            result = 0;
+        }
+        if (result == 0) {
+            memcpy(data, device->cache + (reg - config->burstFirst), len);
+        }
+    } else {
+        result = _transfer(_userData, address, &reg, 1, data, len);
+        finish(device, start, owned, result, len, false);
+    }
+
+    unlock();
+    return result == 0 ? 0 : -1;
+}
+
+int I2CBus::writeRegister(uint8_t address, uint8_t reg, uint8_t *data, uint8_t len)
+{
+    if (!_transfer || (len && !data) || len > I2C_BUS_MAX_BURST) {
+        return -1;
+    }
+    uint8_t buffer[I2C_BUS_MAX_BURST + 1];
+    buffer[0] = reg;
+    if (len) {
+        memcpy(buffer + 1, data, len);
+    }
+
+    int64_t start = nowUs();
+    Device_t *device = findDevice(address);
+    lock(device ? device->config.priority : I2C_PRIORITY_NORMAL);
+    int64_t owned = nowUs();
+    if (device) {
+        // A write may change what the burst registers read, e.g. an ADC channel enable
+        device->cacheValid = false;
+    }
+    int result = _transfer(_userData, address, buffer, len + 1, NULL, 0);
+    finish(device, start, owned, result, len, true);
+    unlock();
+    return result == 0 ? 0 : -1;
+}
+
+bool I2CBus::getStats(uint8_t address, I2CDeviceStats_t *stats)
+{
+    if (!stats) {
+        return false;
+    }
+    bool found = false;
+    lock(I2C_PRIORITY_HIGH);
+    for (uint8_t i = 0; i < _deviceNum; i++) {
+        if (_devices[i].config.address == address) {
+            *stats = _devices[i].stats;
+            found = true;
+            break;
+        }
+    }
+    unlock();
+    return found;
+}
+
+void I2CBus::resetStats()
+{
+    lock(I2C_PRIORITY_HIGH);
+    for (uint8_t i = 0; i < _deviceNum; i++) {
+        memset(&_devices[i].stats, 0, sizeof(I2CDeviceStats_t));
+    }
+    unlock();
+}
+
+void I2CBus::setDefault(I2CBus *bus)
+{
+    _default = bus;
+}
+
+I2CBus *I2CBus::getDefault()
+{
+    return _default;
+}
+
+int I2CBus::readCallback(uint8_t devAddr, uint8_t regAddr, uint8_t *data, uint8_t len)
+{
+    return _default ? _default->readRegister(devAddr, regAddr, data, len) : -1;
+}
+
+int I2CBus::writeCallback(uint8_t devAddr, uint8_t regAddr, uint8_t *data, uint8_t len)
+{
+    return _default ? _default->writeRegister(devAddr, regAddr, data, len) : -1;
+}
+
+#if defined(ARDUINO)
+int i2cBusWireTransfer(void *user_data, uint8_t address, const uint8_t *write, size_t write_len,
+                       uint8_t *read, size_t read_len)
+{
+    TwoWire *wire = (TwoWire *)user_data;
+    wire->beginTransmission(address);
+    wire->write(write, write_len);
+    if (wire->endTransmission() != 0) {
+        return -1;
+    }
+    if (!read_len) {
+        return 0;
+    }
+    if (wire->requestFrom((uint16_t)address, read_len, true) != read_len) {
+        return -1;
+    }
+    return wire->readBytes(read, read_len) == read_len ? 0 : -1;
+}
+#endif
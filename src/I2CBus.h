@@ -0,0 +1,137 @@
+/**
+ * @file      I2CBus.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#else
+#include <mutex>
+#endif
+
+/*
+* Arbitration of the I2C bus shared by the touch controller, the PMU, the RTC
+* and the light sensor. Every transfer takes the bus first, tasks waiting for
+* it are queued by priority and in order of arrival within a priority, so a
+* touch read waits for at most the one transfer already on the bus and never
+* behind queued telemetry.
+* Registers read often in groups, e.g. the ADC results of the PMU, can be
+* declared as a burst range: a read inside the range fetches the whole range
+* in one transfer and the following reads are served from it until
+* burstCacheUs has passed or the device is written.
+* SensorLib and XPowersLib drivers use the bus through their begin(address,
+* readCallback, writeCallback), drivers that talk to Wire directly take the
+* bus with lock / unlock around their access.
+* Builds on the host, see tools/i2c_bus.
+*/
+
+#define I2C_BUS_MAX_DEVICES     (8)
+#define I2C_BUS_MAX_BURST       (32)        // Largest burst range, bytes
+
+enum I2CBusPriority {
+    I2C_PRIORITY_LOW,           // Housekeeping, PMU and sensor telemetry
+    I2C_PRIORITY_NORMAL,
+    I2C_PRIORITY_HIGH,          // Touch reads
+};
+
+typedef struct __I2CDeviceConfig {
+    uint8_t address;
+    I2CBusPriority priority;
+    uint8_t burstFirst;         // Burst range, first and last register, burstLast 0 for none
+    uint8_t burstLast;
+    uint32_t burstCacheUs;      // Time a burst read serves the registers of its range
+} I2CDeviceConfig_t;
+
+typedef struct __I2CDeviceStats {
+    uint32_t reads;             // Read transfers on the bus
+    uint32_t writes;            // Write transfers on the bus
+    uint32_t errors;            // Transfers that failed
+    uint32_t burstHits;         // Register reads served from a burst read
+    uint64_t bytes;             // Register bytes moved on the bus
+    uint32_t lastLatencyUs;     // Call to transfer done of the last transfer, bus wait included
+    uint32_t maxLatencyUs;
+    uint32_t lastWaitUs;        // Time the last transfer waited for the bus
+    uint32_t maxWaitUs;
+} I2CDeviceStats_t;
+
+/*
+* Bus backend, writes write_len bytes and then, if read_len is not 0, reads
+* read_len bytes. Returns 0 on success, -1 on error.
+*/
+typedef int (*i2c_bus_transfer_t)(void *user_data, uint8_t address, const uint8_t *write, size_t write_len,
+                                  uint8_t *read, size_t read_len);
+
+class I2CBus
+{
+public:
+    I2CBus();
+
+    void begin(i2c_bus_transfer_t transfer, void *user_data);
+    /**
+     * @brief  Declare a device, transfers to unknown addresses use I2C_PRIORITY_NORMAL without burst
+     * @retval Returns false if the device table is full or the burst range is larger than I2C_BUS_MAX_BURST
+     */
+    bool addDevice(const I2CDeviceConfig_t &config);
+
+    // Same arguments and results as the SensorLib and XPowersLib register callbacks, 0 or -1
+    int readRegister(uint8_t address, uint8_t reg, uint8_t *data, uint8_t len);
+    // Writes up to I2C_BUS_MAX_BURST bytes and drops the burst read of the device
+    int writeRegister(uint8_t address, uint8_t reg, uint8_t *data, uint8_t len);
+
+    // Hold the bus for a driver that accesses it directly, not reentrant
+    void lock(I2CBusPriority priority);
+    void unlock();
+
+    bool getStats(uint8_t address, I2CDeviceStats_t *stats);
+    void resetStats();
+
+    // Bus used by the static callbacks
+    static void setDefault(I2CBus *bus);
+    static I2CBus *getDefault();
+    static int readCallback(uint8_t devAddr, uint8_t regAddr, uint8_t *data, uint8_t len);
+    static int writeCallback(uint8_t devAddr, uint8_t regAddr, uint8_t *data, uint8_t len);
+
+private:
+    typedef struct {
+        I2CDeviceConfig_t config;
+        I2CDeviceStats_t stats;
+        bool cacheValid;
+        int64_t cacheUs;
+        uint8_t cache[I2C_BUS_MAX_BURST];
+    } Device_t;
+
+    struct Waiter;
+
+    Device_t *findDevice(uint8_t address);
+    void enqueue(Waiter *waiter);
+    void finish(Device_t *device, int64_t start, int64_t owned, int result, size_t bytes, bool write);
+
+    i2c_bus_transfer_t _transfer;
+    void *_userData;
+    Device_t _devices[I2C_BUS_MAX_DEVICES];
+    uint8_t _deviceNum;
+
+    // Waiters sorted by priority, the owner hands the bus to the head on unlock
+    bool _busy;
+    Waiter *_waiters;
+#if defined(ESP_PLATFORM)
+    portMUX_TYPE _guard;
+#else
+    std::mutex _guard;
+#endif
+
+    static I2CBus *_default;
+};
+
+#if defined(ARDUINO)
+// Backend for an Arduino TwoWire bus, user_data is the TwoWire object
+int i2cBusWireTransfer(void *user_data, uint8_t address, const uint8_t *write, size_t write_len,
+                       uint8_t *read, size_t read_len);
+#endif
@@ -12,6 +12,10 @@
 
 #include <freertos/queue.h>
 
+#ifndef INPUT_KEY_BUFFER_SIZE
+#define INPUT_KEY_BUFFER_SIZE   (16)    // Keys drained from the queue but not yet read by lvgl
+#endif
+
 struct InputData {
     char id;        // 'm' = mouse ,'k' = keyboard
     char key;
@@ -21,8 +25,14 @@ struct InputData {
     int y;
 };
 
+/*
+* The lvgl helper drains the queues without blocking. With mouseQueue set the
+* mouse has its own queue and a burst of moves cannot hold up the keys, without
+* it both devices share queue. Members that are not set stay NULL.
+*/
 struct InputParams {
-    QueueHandle_t queue;
-    const void *icon;
+    QueueHandle_t queue = NULL;         // Keyboard, and the mouse when mouseQueue is NULL
+    const void *icon = NULL;            // Mouse pointer image, no pointer is drawn if NULL
+    QueueHandle_t mouseQueue = NULL;
 };
 
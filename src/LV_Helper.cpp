@@ -8,25 +8,62 @@
  */
 #include <Arduino.h>
 #include "LV_Helper.h"
+#include "PixelKernels.h"
+#include "AreaMerge.h"
+#include <esp_timer.h>
 
 
 #if LVGL_VERSION_MAJOR == 8
 
 static lv_disp_draw_buf_t draw_buf;
 static lv_disp_drv_t disp_drv;
+static lv_disp_t *disp = NULL;
 static lv_indev_drv_t  indev_drv;
 static lv_indev_t  *mouse_indev = NULL;
 static lv_indev_t  *kb_indev = NULL;
 static lv_indev_drv_t indev_mouse;
 static lv_indev_drv_t indev_keypad;
 static struct InputParams params_copy;
+static bool dma_async = false;
+static bool soft_rotation = false;
+static bool frame_start = true;
+static uint16_t *panel_copy = NULL;
+static bool panel_copy_valid = false;
+static TouchFilter touch_filter;
+static bool touch_filter_on = false;
+static int64_t touch_sample_us = 0;
+static uint64_t touch_latency_sum = 0;
+static TouchLatencyStats_t touch_latency;
+
+// The newest touch sample read by lvgl is on the panel once the frame is flushed
+static void touch_frame_done()
+{
+    if (!touch_sample_us) {
+        return;
+    }
+    uint32_t us = esp_timer_get_time() - touch_sample_us;
+    touch_sample_us = 0;
+    touch_latency.frames++;
+    touch_latency.lastUs = us;
+    if (us > touch_latency.maxUs) {
+        touch_latency.maxUs = us;
+    }
+    touch_latency_sum += us;
+}
 
 /* Display flushing */
 static void disp_flush( lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p )
 {
     uint32_t w = ( area->x2 - area->x1 + 1 );
     uint32_t h = ( area->y2 - area->y1 + 1 );
+    if (frame_start) {
+        static_cast<LilyGo_Display *>(disp_drv->user_data)->waitVSync();
+    }
+    frame_start = lv_disp_flush_is_last(disp_drv);
     static_cast<LilyGo_Display *>(disp_drv->user_data)->pushColors(area->x1, area->y1, w, h, (uint16_t *)color_p);
+    if (frame_start) {
+        touch_frame_done();
+    }
     lv_disp_flush_ready( disp_drv );
 }
 
@@ -34,20 +71,93 @@ static void disp_flushDMA( lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_co
 {
     uint32_t w = ( area->x2 - area->x1 + 1 );
     uint32_t h = ( area->y2 - area->y1 + 1 );
+    if (frame_start) {
+        static_cast<LilyGo_Display *>(disp_drv->user_data)->waitVSync();
+    }
+    frame_start = lv_disp_flush_is_last(disp_drv);
+    if (soft_rotation) {
+        // The area is rotated while it is sent, pushColors returns once it is on the panel
+        static_cast<LilyGo_Display *>(disp_drv->user_data)->pushColors(area->x1, area->y1, w, h, (uint16_t *)color_p);
+        if (frame_start) {
+            touch_frame_done();
+        }
+        lv_disp_flush_ready( disp_drv );
+        return;
+    }
     static_cast<LilyGo_Display *>(disp_drv->user_data)->setAddrWindow(area->x1, area->y1, area->x2, area->y2);
     static_cast<LilyGo_Display *>(disp_drv->user_data)->pushColorsDMA((uint16_t *)color_p, w * h);
+    if (frame_start) {
+        // Queued, the transfer of the last area is not waited for
+        touch_frame_done();
+    }
 
-    lv_disp_flush_ready( disp_drv );
+    // When asynchronous, flush ready is signalled by disp_dma_done once the last chunk is sent
+    if (!dma_async) {
+        lv_disp_flush_ready( disp_drv );
+    }
+}
+
+static void disp_dma_done(void *user_data)
+{
+    lv_disp_flush_ready( (lv_disp_drv_t *)user_data );
+}
+
+static GestureEngine gesture_engine;
+static uint32_t gesture_event_code = 0;
+
+// Recognized gestures go to the active screen, event parameter is the GestureEvent_t
+static void send_gestures()
+{
+    GestureEvent_t gesture;
+    while (gesture_engine.read(&gesture)) {
+        lv_event_send(lv_scr_act(), (lv_event_code_t)gesture_event_code, &gesture);
+    }
 }
 
 /*Read the touchpad*/
 static void touchpad_read( lv_indev_drv_t *indev_driver, lv_indev_data_t *data )
 {
-    static int16_t x, y;
-    uint8_t touched =   static_cast<LilyGo_Display *>(indev_driver->user_data)->getPoint(&x, &y, 1);
+    static int16_t x[2], y[2];
+    LilyGo_Display *board = static_cast<LilyGo_Display *>(indev_driver->user_data);
+    if (board->hasTouchSampler()) {
+        // One queued sample per call, lvgl calls again while more are pending
+        static TouchEvent_t shown = {};
+        TouchEvent_t event;
+        if (board->readTouchEvent(&event)) {
+            data->continue_reading = board->getTouchEventsPending() != 0;
+            // Gestures see the raw samples, lvgl the filtered ones
+            if (gesture_event_code) {
+                gesture_engine.update(event);
+            }
+            shown = event;
+            if (touch_filter_on) {
+                touch_filter.update(&shown);
+            }
+            if (shown.points) {
+                touch_sample_us = shown.timestamp;
+            }
+        } else if (gesture_event_code) {
+            gesture_engine.tick(esp_timer_get_time());
+        }
+        send_gestures();
+        data->point.x = shown.x;
+        data->point.y = shown.y;
+        data->state = shown.points ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+        return;
+    }
+    uint8_t touched = board->getPoint(x, y, gesture_event_code ? 2 : 1);
+    TouchEvent_t event = {esp_timer_get_time(), x[0], y[0], touched, x[1], y[1]};
+    if (gesture_event_code) {
+        gesture_engine.update(event);
+        send_gestures();
+    }
+    if (touch_filter_on) {
+        touch_filter.update(&event);
+    }
     if ( touched ) {
-        data->point.x = x;
-        data->point.y = y;
+        touch_sample_us = event.timestamp;
+        data->point.x = event.x;
+        data->point.y = event.y;
         data->state = LV_INDEV_STATE_PR;
         return;
     }
@@ -68,44 +178,121 @@ void lv_log_print_g_cb(const char *buf)
 }
 #endif
 
-static void mouse_read(lv_indev_drv_t *indev, lv_indev_data_t *data)
+/*
+* Input messages are drained without waiting, once per read of either device.
+* Mouse moves are merged, only the newest position is shown. A button change
+* is held back, draining included, until lvgl has seen the moves before it,
+* so drags and clicks land where they happened. Keys are buffered and each is pressed and released.
+*/
+static struct InputData mouse_now;
+static struct InputData mouse_held;
+static bool mouse_has_held = false;
+static char key_buffer[INPUT_KEY_BUFFER_SIZE];
+static uint8_t key_head = 0;
+static uint8_t key_count = 0;
+
+static void drain_input(QueueHandle_t queue, bool has_mouse)
 {
-    static int16_t last_x;
-    static int16_t last_y;
     struct InputData msg;
+    while (queue && !(has_mouse && mouse_has_held) && xQueueReceive(queue, &msg, 0) == pdPASS) {
+        if (msg.id == 'k') {
+            if (key_count < INPUT_KEY_BUFFER_SIZE) {
+                key_buffer[(key_head + key_count++) % INPUT_KEY_BUFFER_SIZE] = msg.key;
+            }
+        } else if (msg.id == 'm') {
+            if (msg.left == mouse_now.left && msg.right == mouse_now.right) {
+                mouse_now = msg;
+            } else {
+                mouse_held = msg;
+                mouse_has_held = true;
+            }
+        }
+    }
+}
+
+static void drain_inputs()
+{
+    drain_input(params_copy.mouseQueue, true);
+    drain_input(params_copy.queue, params_copy.mouseQueue == NULL);
+}
+
+static void mouse_read(lv_indev_drv_t *indev, lv_indev_data_t *data)
+{
     const lv_img_dsc_t *cur = (const lv_img_dsc_t *)params_copy.icon;
-    uint16_t _maxX = lv_disp_get_hor_res(NULL) - cur->header.w;
-    uint16_t _maxY = lv_disp_get_ver_res(NULL) - cur->header.h;
-
-    if (xQueueReceive(params_copy.queue, &msg, pdTICKS_TO_MS(30)) == pdPASS) {
-        if (msg.id == 'm') {
-            last_x = constrain(msg.x, 0, _maxX);
-            last_y = constrain(msg.y, 0, _maxY);
-            data->state = (msg.left || msg.right) ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+    uint16_t _maxX = lv_disp_get_hor_res(NULL) - (cur ? cur->header.w : 1);
+    uint16_t _maxY = lv_disp_get_ver_res(NULL) - (cur ? cur->header.h : 1);
+
+    static bool show_held = false;
+
+    if (show_held) {
+        // The button change, the moves before it were shown by the last read
+        mouse_now = mouse_held;
+        mouse_has_held = false;
+        show_held = false;
+    } else {
+        drain_inputs();
+        if (mouse_has_held) {
+            // Read again right away for the button change
+            show_held = true;
+            data->continue_reading = true;
         }
     }
-    data->point.x = last_x;
-    data->point.y = last_y;
+    data->point.x = constrain(mouse_now.x, 0, _maxX);
+    data->point.y = constrain(mouse_now.y, 0, _maxY);
+    data->state = (mouse_now.left || mouse_now.right) ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
 }
 
 static void keypad_read(lv_indev_drv_t *indev_drv, lv_indev_data_t *data)
 {
-    static uint32_t last_key = 0;
-    uint32_t act_key ;
-    struct InputData msg;
-    if (xQueueReceive(params_copy.queue, &msg, pdTICKS_TO_MS(30)) == pdPASS) {
-        if (msg.id == 'k') {
-            last_key =  msg.key;
-            data->key = msg.key;
-            data->state = LV_INDEV_STATE_PR;
-            return;
-        }
+    static bool pressed = false;
+    static char last_key = 0;
+
+    drain_inputs();
+    data->key = last_key;
+    if (pressed) {
+        pressed = false;
+        data->state = LV_INDEV_STATE_REL;
+        data->continue_reading = key_count != 0;
+        return;
     }
-    data->state = LV_INDEV_STATE_REL;
+    if (!key_count) {
+        data->state = LV_INDEV_STATE_REL;
+        return;
+    }
+    last_key = key_buffer[key_head];
+    key_head = (key_head + 1) % INPUT_KEY_BUFFER_SIZE;
+    key_count--;
+    pressed = true;
     data->key = last_key;
+    data->state = LV_INDEV_STATE_PR;
+    data->continue_reading = true;
 }
 
 
+/*
+* Merge the dirty areas of the frame before they are rendered, see AreaMerge.h.
+* With LVGL_HELPER_PRINT_AREAS the areas are printed as a tools/merge_replay trace.
+*/
+static void lv_render_start_cb(lv_disp_drv_t *disp_drv)
+{
+    LilyGo_Display *board = static_cast<LilyGo_Display *>(disp_drv->user_data);
+    lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+    if (!disp) {
+        return;
+    }
+#if LVGL_HELPER_PRINT_AREAS
+    Serial.println("frame");
+    for (uint16_t i = 0; i < disp->inv_p; i++) {
+        if (!disp->inv_area_joined[i]) {
+            const lv_area_t *a = &disp->inv_areas[i];
+            Serial.printf("%d %d %d %d\n", a->x1, a->y1, a->x2, a->y2);
+        }
+    }
+#endif
+    AreaCostModel_t model = {board->getAreaSetupUs(), board->getBusBytesPerSecond(), sizeof(lv_color_t)};
+    areaMerge(disp->inv_areas, disp->inv_area_joined, disp->inv_p, &model);
+}
+
 static void lv_rounder_cb(lv_disp_drv_t *disp_drv, lv_area_t *area)
 {
     // make sure all coordinates are even
@@ -119,7 +306,117 @@ static void lv_rounder_cb(lv_disp_drv_t *disp_drv, lv_area_t *area)
         area->y2++;
 }
 
-void beginLvglHelperDMA(LilyGo_Display &board, bool debug) {
+/*
+* Send one dirty area of the direct mode screen buffer. With a panel copy only
+* the box of the pixels that really changed is sent, kept at even coordinates,
+* and copied over afterwards so that the copy matches the panel again.
+*/
+static void push_direct_area(LilyGo_Display *board, uint16_t *screen, uint16_t stride, const lv_area_t *area)
+{
+    uint16_t x = area->x1, y = area->y1;
+    uint16_t w = lv_area_get_width(area), h = lv_area_get_height(area);
+    if (panel_copy && panel_copy_valid) {
+        if (!pixelChangedArea(screen, panel_copy, stride, &x, &y, &w, &h)) {
+            return;
+        }
+        uint16_t x2 = (x + w + 1) & ~1, y2 = (y + h + 1) & ~1;
+        x &= ~1;
+        y &= ~1;
+        w = x2 - x;
+        h = y2 - y;
+    }
+    uint32_t offset = (uint32_t)y * stride + x;
+    board->pushRect(x, y, w, h, screen + offset, stride);
+    if (panel_copy) {
+        for (uint16_t i = 0; i < h; i++) {
+            pixelCopy(panel_copy + offset + (uint32_t)i * stride, screen + offset + (uint32_t)i * stride, w);
+        }
+    }
+}
+
+/*
+* In direct mode lvgl passes the whole screen with every area, the dirty areas
+* are sent once the last area of the frame has been rendered
+*/
+static void disp_flushDirect( lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p )
+{
+    if (lv_disp_flush_is_last(disp_drv)) {
+        LilyGo_Display *board = static_cast<LilyGo_Display *>(disp_drv->user_data);
+        lv_disp_t *refr = _lv_refr_get_disp_refreshing();
+        board->waitVSync();
+        for (uint16_t i = 0; refr && i < refr->inv_p; i++) {
+            if (!refr->inv_area_joined[i]) {
+                push_direct_area(board, (uint16_t *)color_p, disp_drv->hor_res, &refr->inv_areas[i]);
+            }
+        }
+        // The first frame covers the whole screen
+        panel_copy_valid = true;
+        touch_frame_done();
+    }
+    lv_disp_flush_ready( disp_drv );
+}
+
+void beginLvglHelperDMA(LilyGo_Display &board, bool debug)
+{
+    const LvglBufferStrategy_t strategy = LVGL_STRATEGY_DMA;
+    bool ret = beginLvglHelper(board, strategy, debug);
+    assert(ret);
+}
+
+void beginLvglHelper(LilyGo_Display &board, bool debug)
+{
+    const LvglBufferStrategy_t strategy = LVGL_STRATEGY_FULL_SCREEN;
+    bool ret = beginLvglHelper(board, strategy, debug);
+    assert(ret);
+}
+
+bool beginLvglHelper(LilyGo_Display &board, const LvglBufferStrategy_t &strategy, bool debug)
+{
+    uint32_t screen = (uint32_t)board.width() * board.height();
+    LvglRenderMode mode = strategy.mode;
+    if (board.needFullRefresh()) {
+        mode = LVGL_RENDER_FULL;
+    }
+
+    // Validate before anything is allocated or registered
+    uint32_t pixels = 0;
+    if (strategy.lines) {
+        pixels = (uint32_t)strategy.lines * board.width();
+    } else if (strategy.fraction) {
+        pixels = screen / strategy.fraction;
+    }
+    if (pixels > screen) {
+        pixels = screen;
+    }
+    if (strategy.count < 1 || strategy.count > 2 || !pixels) {
+        log_e("Invalid draw buffer strategy, count:%u lines:%u fraction:%u", strategy.count, strategy.lines, strategy.fraction);
+        return false;
+    }
+    if (mode != LVGL_RENDER_PARTIAL && pixels < screen) {
+        log_e("Full and direct rendering need screen sized draw buffers");
+        return false;
+    }
+
+    uint32_t caps = strategy.memory == LVGL_BUFFER_PSRAM ? MALLOC_CAP_SPIRAM : (MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    size_t lv_buffer_size = pixels * sizeof(lv_color_t);
+    size_t largest = heap_caps_get_largest_free_block(caps);
+    size_t free_size = heap_caps_get_free_size(caps);
+    size_t reserve = strategy.memory == LVGL_BUFFER_PSRAM ? 0 : LVGL_HELPER_INTERNAL_RESERVE;
+    if (largest < lv_buffer_size || free_size < lv_buffer_size * strategy.count + reserve) {
+        log_e("Not enough memory for %u draw buffer(s) of %u bytes, free:%u largest:%u",
+              strategy.count, lv_buffer_size, free_size, largest);
+        return false;
+    }
+
+    lv_color_t *buf1 = (lv_color_t *)heap_caps_malloc(lv_buffer_size, caps);
+    lv_color_t *buf2 = strategy.count > 1 ? (lv_color_t *)heap_caps_malloc(lv_buffer_size, caps) : NULL;
+    if (!buf1 || (strategy.count > 1 && !buf2)) {
+        log_e("Failed to allocate the draw buffers");
+        heap_caps_free(buf1);
+        heap_caps_free(buf2);
+        return false;
+    }
+
     lv_init();
 
 #if LV_USE_LOG
@@ -128,33 +425,46 @@ void beginLvglHelperDMA(LilyGo_Display &board, bool debug) {
     }
 #endif
 
-    size_t lv_buffer_size = (board.width() * board.height() / 10) * sizeof(lv_color_t);
-
-    lv_color_t *buf1 = (lv_color_t *)heap_caps_malloc(lv_buffer_size, MALLOC_CAP_DMA);
-    lv_color_t *buf2 = (lv_color_t *)heap_caps_malloc(lv_buffer_size, MALLOC_CAP_DMA);
-
-    assert (buf1 && buf2);
-
-    if (!esp_ptr_dma_capable(buf1) || !esp_ptr_dma_capable(buf2)) {
-        Serial.println("Error: Buffers are not DMA-capable!");
+    buf = buf1;
+    // In direct mode lvgl keeps one screen buffer, the second one is the panel copy
+    panel_copy = NULL;
+    panel_copy_valid = false;
+    if (mode == LVGL_RENDER_DIRECT) {
+        panel_copy = (uint16_t *)buf2;
+        buf2 = NULL;
     }
-
-    lv_disp_draw_buf_init(&draw_buf, buf1, buf2, board.width() * board.height() / 10);
+    lv_disp_draw_buf_init(&draw_buf, buf1, buf2, pixels);
 
     /*Initialize the display*/
     lv_disp_drv_init( &disp_drv );
     /* display resolution */
     disp_drv.hor_res = board.width();
     disp_drv.ver_res = board.height();
-    disp_drv.flush_cb = disp_flushDMA;
     disp_drv.draw_buf = &draw_buf;
-    bool full_refresh = board.needFullRefresh();
-    disp_drv.full_refresh = full_refresh;
     disp_drv.user_data = &board;
-    if (!full_refresh) {
+    disp_drv.full_refresh = mode == LVGL_RENDER_FULL;
+    disp_drv.direct_mode = mode == LVGL_RENDER_DIRECT;
+    if (mode != LVGL_RENDER_FULL) {
         disp_drv.rounder_cb = lv_rounder_cb;
+        disp_drv.render_start_cb = lv_render_start_cb;
+    }
+
+    // Direct mode sends several areas per flush and stays blocking
+    soft_rotation = board.needSoftRotation();
+    if (mode == LVGL_RENDER_DIRECT) {
+        disp_drv.flush_cb = disp_flushDirect;
+    } else if (strategy.dmaFlush) {
+        disp_drv.flush_cb = disp_flushDMA;
+    } else {
+        disp_drv.flush_cb = disp_flush;
+    }
+    disp = lv_disp_drv_register( &disp_drv );
+
+    // Let lvgl render into the second buffer while the first one is being sent
+    dma_async = false;
+    if (disp_drv.flush_cb == disp_flushDMA && !soft_rotation) {
+        dma_async = board.setDMADoneCallback(disp_dma_done, &disp_drv);
     }
-    lv_disp_drv_register( &disp_drv );
 
     if (board.hasTouch()) {
         lv_indev_drv_init( &indev_drv );
@@ -165,53 +475,96 @@ void beginLvglHelperDMA(LilyGo_Display &board, bool debug) {
     }
 
     lv_group_set_default(lv_group_create());
+
+    log_i("Draw buffers: %u x %u bytes %s, mode:%u dma:%u", strategy.count, lv_buffer_size,
+          strategy.memory == LVGL_BUFFER_PSRAM ? "PSRAM" : "internal", mode, dma_async);
+    return true;
 }
 
-void beginLvglHelper(LilyGo_Display &board, bool debug)
+uint32_t beginLvglGestures(const GestureConfig_t &config)
 {
+    if (!gesture_event_code) {
+        gesture_event_code = lv_event_register_id();
+    }
+    gesture_engine.setConfig(config);
+    gesture_engine.reset();
+    return gesture_event_code;
+}
 
-    lv_init();
-
-#if LV_USE_LOG
-    if (debug) {
-        lv_log_register_print_cb(lv_log_print_g_cb);
+bool beginLvglTouchFilter(LilyGo_Display &board)
+{
+    TouchFilterConfig_t config;
+    if (!board.getTouchFilter(&config)) {
+        return false;
     }
-#endif
+    beginLvglTouchFilter(config);
+    return true;
+}
 
-    size_t lv_buffer_size = board.width() * board.height() * sizeof(lv_color_t);
-    buf = (lv_color_t *)ps_malloc(lv_buffer_size);
-    assert(buf);
+void beginLvglTouchFilter(const TouchFilterConfig_t &config)
+{
+    touch_filter.setConfig(config);
+    touch_filter.reset();
+    touch_filter_on = true;
+}
 
-    lv_disp_draw_buf_init( &draw_buf, buf, NULL, board.width() * board.height());
+void endLvglTouchFilter()
+{
+    touch_filter_on = false;
+}
 
-    /*Initialize the display*/
-    lv_disp_drv_init( &disp_drv );
-    /* display resolution */
-    disp_drv.hor_res = board.width();
-    disp_drv.ver_res = board.height();
-    disp_drv.flush_cb = disp_flush;
-    disp_drv.draw_buf = &draw_buf;
-    bool full_refresh = board.needFullRefresh();
-    disp_drv.full_refresh = full_refresh;
-    disp_drv.user_data = &board;
-    if (!full_refresh) {
-        disp_drv.rounder_cb = lv_rounder_cb;
+void getLvglTouchLatency(TouchLatencyStats_t *stats)
+{
+    if (!stats) {
+        return;
     }
-    lv_disp_drv_register( &disp_drv );
+    *stats = touch_latency;
+    stats->avgUs = touch_latency.frames ? touch_latency_sum / touch_latency.frames : 0;
+}
 
-    if (board.hasTouch()) {
-        lv_indev_drv_init( &indev_drv );
-        indev_drv.type = LV_INDEV_TYPE_POINTER;
-        indev_drv.read_cb = touchpad_read;
-        indev_drv.user_data = &board;
-        lv_indev_drv_register( &indev_drv );
+void resetLvglTouchLatency()
+{
+    memset(&touch_latency, 0, sizeof(touch_latency));
+    touch_latency_sum = 0;
+}
+
+void setLvglHelperRotation(LilyGo_Display &board, uint8_t rotation)
+{
+    if (!disp) {
+        board.setRotation(rotation);
+        return;
     }
+    // Let the last area of the previous frame leave the bus before the scan direction changes,
+    // yield meanwhile so that a lower priority task calling lv_disp_flush_ready can run
+    uint32_t start = millis();
+    while (disp_drv.draw_buf->flushing) {
+        if (millis() - start > LVGL_HELPER_FLUSH_TIMEOUT_MS) {
+            log_w("Flush not finished after %u ms, rotate anyway", LVGL_HELPER_FLUSH_TIMEOUT_MS);
+            break;
+        }
+        delay(1);
+    }
+    board.setRotation(rotation);
 
-    lv_group_set_default(lv_group_create());
+    // The pixel count is the same in every rotation, so the draw buffers are kept.
+    // lv_disp_drv_update drops the pending areas and invalidates the active screen once
+    disp_drv.hor_res = board.width();
+    disp_drv.ver_res = board.height();
+    lv_disp_drv_update(disp, &disp_drv);
+    frame_start = true;
+    panel_copy_valid = false;
 }
 
 void beginLvglInputDevice(struct InputParams prams)
 {
+    if (!prams.queue && !prams.mouseQueue) {
+        log_e("No input queue set");
+        return;
+    }
+    if (prams.mouseQueue == prams.queue) {
+        // One queue for both devices
+        prams.mouseQueue = NULL;
+    }
     memcpy(&params_copy, &prams, sizeof(struct InputParams));
 
     if (!mouse_indev) {
@@ -222,9 +575,11 @@ void beginLvglInputDevice(struct InputParams prams)
         mouse_indev = lv_indev_drv_register( &indev_mouse );
     }
 
-    lv_obj_t *cursor = lv_img_create(lv_scr_act());
-    lv_img_set_src(cursor, params_copy.icon);
-    lv_indev_set_cursor(mouse_indev, cursor);
+    if (params_copy.icon) {
+        lv_obj_t *cursor = lv_img_create(lv_scr_act());
+        lv_img_set_src(cursor, params_copy.icon);
+        lv_indev_set_cursor(mouse_indev, cursor);
+    }
 
     /*Register a keypad input device*/
     if (!kb_indev) {
@@ -11,10 +11,97 @@
 #include <lvgl.h>
 #include "LilyGo_Display.h"
 #include "InputParams.h"
+#include "GestureEngine.h"
 
+// Internal SRAM that must stay free after the draw buffers are allocated
+#ifndef LVGL_HELPER_INTERNAL_RESERVE
+#define LVGL_HELPER_INTERNAL_RESERVE    (32 * 1024)
+#endif
+
+// Longest wait for the last area of a frame to be sent before the rotation changes
+#ifndef LVGL_HELPER_FLUSH_TIMEOUT_MS
+#define LVGL_HELPER_FLUSH_TIMEOUT_MS    (100)
+#endif
+
+// Print the dirty areas of every frame to Serial, as a tools/merge_replay trace
+#ifndef LVGL_HELPER_PRINT_AREAS
+#define LVGL_HELPER_PRINT_AREAS         (0)
+#endif
+
+enum LvglBufferMemory {
+    LVGL_BUFFER_PSRAM,              // Large, slower to render into, sent through the display bounce buffers
+    LVGL_BUFFER_INTERNAL_DMA,       // Internal SRAM the SPI DMA reads directly
+};
+
+enum LvglRenderMode {
+    LVGL_RENDER_PARTIAL,            // Dirty areas are rendered in buffer sized parts
+    LVGL_RENDER_FULL,               // The whole screen is rendered and sent every frame
+    LVGL_RENDER_DIRECT,             // Rendered in place into a persistent screen buffer, only dirty areas are sent
+};
+
+/*
+* How the helper allocates and uses the lvgl draw buffers.
+* FULL and DIRECT need screen sized buffers. A display that needs a full
+* refresh turns PARTIAL into FULL.
+* In DIRECT mode lvgl renders into the first buffer only, the second one keeps
+* a copy of the panel content so that only the pixels that changed inside a
+* dirty area are sent.
+*/
+typedef struct __LvglBufferStrategy {
+    uint8_t count;                  // Draw buffers, 1 or 2
+    uint16_t lines;                 // Buffer height in lines, 0 to use fraction
+    uint8_t fraction;               // Buffer holds 1/fraction of the screen when lines is 0
+    LvglBufferMemory memory;
+    LvglRenderMode mode;
+    bool dmaFlush;                  // Send with pushColorsDMA so that lvgl renders into the other buffer meanwhile
+} LvglBufferStrategy_t;
+
+// One full screen PSRAM buffer, the beginLvglHelper default on lvgl 8
+#define LVGL_STRATEGY_FULL_SCREEN       {1, 0, 1, LVGL_BUFFER_PSRAM, LVGL_RENDER_PARTIAL, false}
+// Two 1/10 screen internal buffers sent with DMA, beginLvglHelperDMA
+#define LVGL_STRATEGY_DMA               {2, 0, 10, LVGL_BUFFER_INTERNAL_DMA, LVGL_RENDER_PARTIAL, true}
+// Two full screen PSRAM buffers, the beginLvglHelper default on lvgl 9
+#define LVGL_STRATEGY_DOUBLE_SCREEN     {2, 0, 1, LVGL_BUFFER_PSRAM, LVGL_RENDER_PARTIAL, false}
+// Persistent PSRAM screen buffer plus panel copy, only changed pixels are sent
+#define LVGL_STRATEGY_DIRECT            {2, 0, 1, LVGL_BUFFER_PSRAM, LVGL_RENDER_DIRECT, false}
 
 void beginLvglHelper(LilyGo_Display &board, bool debug = false);
 void beginLvglHelperDMA(LilyGo_Display &board, bool debug = false);
+/**
+ * @brief  Register the display with lvgl using the given draw buffer strategy
+ * @retval Returns false if the strategy is invalid or the buffers do not fit in the free heap,
+ *         nothing is registered in that case
+ */
+bool beginLvglHelper(LilyGo_Display &board, const LvglBufferStrategy_t &strategy, bool debug = false);
+// Rotate the display and resize lvgl to match, the draw buffers are reused
+void setLvglHelperRotation(LilyGo_Display &board, uint8_t rotation);
+/**
+ * @brief  Recognize gestures on the touch input registered by beginLvglHelper
+ * @note   Each gesture is sent to the active screen with the returned event code,
+ *         lv_event_get_param returns the GestureEvent_t. Calling again changes the config.
+ * @retval lvgl event code of the gestures
+ */
+uint32_t beginLvglGestures(const GestureConfig_t &config = GESTURE_CONFIG_DEFAULT);
+
+typedef struct __TouchLatencyStats {
+    uint32_t frames;            // Frames that showed a new touch sample
+    uint32_t lastUs;            // Sample timestamp to the last area of the frame flushed
+    uint32_t avgUs;
+    uint32_t maxUs;
+} TouchLatencyStats_t;
+
+/**
+ * @brief  Smooth the lvgl touch point and move it ahead by the pipeline delay
+ * @note   Uses the preset of the board, set TouchFilterConfig_t predictMs close to
+ *         the avgUs of getLvglTouchLatency. Gestures are still recognized on the raw samples.
+ * @retval Returns false if the board has no preset, the filter is not enabled then
+ */
+bool beginLvglTouchFilter(LilyGo_Display &board);
+void beginLvglTouchFilter(const TouchFilterConfig_t &config);
+void endLvglTouchFilter();
+// Touch to photon delay, measured with or without the filter
+void getLvglTouchLatency(TouchLatencyStats_t *stats);
+void resetLvglTouchLatency();
 void beginLvglInputDevice(struct InputParams prams);
 
 
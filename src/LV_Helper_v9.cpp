@@ -8,9 +8,15 @@
  */
 #include <Arduino.h>
 #include "LV_Helper.h"
+#include "PixelKernels.h"
+#include "AreaMerge.h"
+#include <esp_timer.h>
 
 #if LVGL_VERSION_MAJOR == 9
 
+// The invalidated area list is only reachable through the private display structure
+#include <src/display/lv_display_private.h>
+
 static lv_display_t *disp_drv;
 static lv_draw_buf_t draw_buf;
 static lv_indev_t *indev_drv;
@@ -23,26 +29,197 @@ static lv_color16_t *buf1  = NULL;
 static lv_indev_t  *mouse_indev = NULL;
 static lv_indev_t  *kb_indev = NULL;
 static struct InputParams params_copy;
+static bool frame_start = true;
+static bool swap_in_driver = false;
+static bool dma_async = false;
+static bool soft_rotation = false;
+static uint16_t *panel_copy = NULL;
+static bool panel_copy_valid = false;
+static TouchFilter touch_filter;
+static bool touch_filter_on = false;
+static int64_t touch_sample_us = 0;
+static uint64_t touch_latency_sum = 0;
+static TouchLatencyStats_t touch_latency;
+
+// The newest touch sample read by lvgl is on the panel once the frame is flushed
+static void touch_frame_done()
+{
+    if (!touch_sample_us) {
+        return;
+    }
+    uint32_t us = esp_timer_get_time() - touch_sample_us;
+    touch_sample_us = 0;
+    touch_latency.frames++;
+    touch_latency.lastUs = us;
+    if (us > touch_latency.maxUs) {
+        touch_latency.maxUs = us;
+    }
+    touch_latency_sum += us;
+}
 
 static void disp_flush( lv_display_t *disp_drv, const lv_area_t *area, uint8_t *color_p)
 {
     uint32_t w = ( area->x2 - area->x1 + 1 );
     uint32_t h = ( area->y2 - area->y1 + 1 );
     auto *plane = (LilyGo_Display *)lv_display_get_user_data(disp_drv);
-    lv_draw_sw_rgb565_swap(color_p, w * h);
+    if (!swap_in_driver) {
+        pixelSwapCopy((uint16_t *)color_p, (uint16_t *)color_p, w * h);
+    }
+    if (frame_start) {
+        plane->waitVSync();
+    }
+    frame_start = lv_display_flush_is_last(disp_drv);
     plane->pushColors(area->x1, area->y1, w, h, (uint16_t *)color_p);
+    if (frame_start) {
+        touch_frame_done();
+    }
+    lv_display_flush_ready( disp_drv );
+}
+
+static void disp_flushDMA( lv_display_t *disp_drv, const lv_area_t *area, uint8_t *color_p)
+{
+    uint32_t w = ( area->x2 - area->x1 + 1 );
+    uint32_t h = ( area->y2 - area->y1 + 1 );
+    auto *plane = (LilyGo_Display *)lv_display_get_user_data(disp_drv);
+    if (!swap_in_driver) {
+        pixelSwapCopy((uint16_t *)color_p, (uint16_t *)color_p, w * h);
+    }
+    if (frame_start) {
+        plane->waitVSync();
+    }
+    frame_start = lv_display_flush_is_last(disp_drv);
+    if (soft_rotation) {
+        // The area is rotated while it is sent, pushColors returns once it is on the panel
+        plane->pushColors(area->x1, area->y1, w, h, (uint16_t *)color_p);
+        if (frame_start) {
+            touch_frame_done();
+        }
+        lv_display_flush_ready( disp_drv );
+        return;
+    }
+    plane->setAddrWindow(area->x1, area->y1, area->x2, area->y2);
+    plane->pushColorsDMA((uint16_t *)color_p, w * h);
+    if (frame_start) {
+        // Queued, the transfer of the last area is not waited for
+        touch_frame_done();
+    }
+
+    // When asynchronous, flush ready is signalled by disp_dma_done once the last chunk is sent
+    if (!dma_async) {
+        lv_display_flush_ready( disp_drv );
+    }
+}
+
+static void disp_dma_done(void *user_data)
+{
+    lv_display_flush_ready( (lv_display_t *)user_data );
+}
+
+/*
+* Send one dirty area of the direct mode screen buffer. With a panel copy only
+* the box of the pixels that really changed is sent, kept at even coordinates,
+* and copied over afterwards so that the copy matches the panel again.
+*/
+static void push_direct_area(LilyGo_Display *plane, uint16_t *screen, uint16_t stride, const lv_area_t *area)
+{
+    uint16_t x = area->x1, y = area->y1;
+    uint16_t w = lv_area_get_width(area), h = lv_area_get_height(area);
+    if (panel_copy && panel_copy_valid) {
+        if (!pixelChangedArea(screen, panel_copy, stride, &x, &y, &w, &h)) {
+            return;
+        }
+        uint16_t x2 = (x + w + 1) & ~1, y2 = (y + h + 1) & ~1;
+        x &= ~1;
+        y &= ~1;
+        w = x2 - x;
+        h = y2 - y;
+    }
+    uint32_t offset = (uint32_t)y * stride + x;
+    plane->pushRect(x, y, w, h, screen + offset, stride);
+    if (panel_copy) {
+        for (uint16_t i = 0; i < h; i++) {
+            pixelCopy(panel_copy + offset + (uint32_t)i * stride, screen + offset + (uint32_t)i * stride, w);
+        }
+    }
+}
+
+/*
+* In direct mode color_p is the start of the screen buffer and area is one
+* dirty area in it. The buffer keeps its content between frames, so it is
+* never swapped in place.
+*/
+static void disp_flushDirect( lv_display_t *disp_drv, const lv_area_t *area, uint8_t *color_p)
+{
+    auto *plane = (LilyGo_Display *)lv_display_get_user_data(disp_drv);
+    if (frame_start) {
+        plane->waitVSync();
+    }
+    frame_start = lv_display_flush_is_last(disp_drv);
+    push_direct_area(plane, (uint16_t *)color_p, lv_display_get_horizontal_resolution(disp_drv), area);
+    if (frame_start) {
+        // The first frame covers the whole screen
+        panel_copy_valid = true;
+        touch_frame_done();
+    }
     lv_display_flush_ready( disp_drv );
 }
 
+static GestureEngine gesture_engine;
+static uint32_t gesture_event_code = 0;
+
+// Recognized gestures go to the active screen, event parameter is the GestureEvent_t
+static void send_gestures()
+{
+    GestureEvent_t gesture;
+    while (gesture_engine.read(&gesture)) {
+        lv_obj_send_event(lv_screen_active(), (lv_event_code_t)gesture_event_code, &gesture);
+    }
+}
+
 /*Read the touchpad*/
 static void touchpad_read( lv_indev_t *indev, lv_indev_data_t *data )
 {
-    static int16_t x, y;
+    static int16_t x[2], y[2];
     auto *plane = (LilyGo_Display *)lv_indev_get_user_data(indev);
-    uint8_t touched = plane->getPoint(&x, &y, 1);
+    if (plane->hasTouchSampler()) {
+        // One queued sample per call, lvgl calls again while more are pending
+        static TouchEvent_t shown = {};
+        TouchEvent_t event;
+        if (plane->readTouchEvent(&event)) {
+            data->continue_reading = plane->getTouchEventsPending() != 0;
+            // Gestures see the raw samples, lvgl the filtered ones
+            if (gesture_event_code) {
+                gesture_engine.update(event);
+            }
+            shown = event;
+            if (touch_filter_on) {
+                touch_filter.update(&shown);
+            }
+            if (shown.points) {
+                touch_sample_us = shown.timestamp;
+            }
+        } else if (gesture_event_code) {
+            gesture_engine.tick(esp_timer_get_time());
+        }
+        send_gestures();
+        data->point.x = shown.x;
+        data->point.y = shown.y;
+        data->state = shown.points ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+        return;
+    }
+    uint8_t touched = plane->getPoint(x, y, gesture_event_code ? 2 : 1);
+    TouchEvent_t event = {esp_timer_get_time(), x[0], y[0], touched, x[1], y[1]};
+    if (gesture_event_code) {
+        gesture_engine.update(event);
+        send_gestures();
+    }
+    if (touch_filter_on) {
+        touch_filter.update(&event);
+    }
     if ( touched ) {
-        data->point.x = x;
-        data->point.y = y;
+        touch_sample_us = event.timestamp;
+        data->point.x = event.x;
+        data->point.y = event.y;
         data->state = LV_INDEV_STATE_PR;
         return;
     }
@@ -54,41 +231,94 @@ static uint32_t lv_tick_get_callback(void)
     return millis();
 }
 
-static void mouse_read( lv_indev_t *indev, lv_indev_data_t *data )
+/*
+* Input messages are drained without waiting, once per read of either device.
+* Mouse moves are merged, only the newest position is shown. A button change
+* is held back, draining included, until lvgl has seen the moves before it,
+* so drags and clicks land where they happened. Keys are buffered and each is pressed and released.
+*/
+static struct InputData mouse_now;
+static struct InputData mouse_held;
+static bool mouse_has_held = false;
+static char key_buffer[INPUT_KEY_BUFFER_SIZE];
+static uint8_t key_head = 0;
+static uint8_t key_count = 0;
+
+static void drain_input(QueueHandle_t queue, bool has_mouse)
 {
-    static int16_t last_x;
-    static int16_t last_y;
     struct InputData msg;
+    while (queue && !(has_mouse && mouse_has_held) && xQueueReceive(queue, &msg, 0) == pdPASS) {
+        if (msg.id == 'k') {
+            if (key_count < INPUT_KEY_BUFFER_SIZE) {
+                key_buffer[(key_head + key_count++) % INPUT_KEY_BUFFER_SIZE] = msg.key;
+            }
+        } else if (msg.id == 'm') {
+            if (msg.left == mouse_now.left && msg.right == mouse_now.right) {
+                mouse_now = msg;
+            } else {
+                mouse_held = msg;
+                mouse_has_held = true;
+            }
+        }
+    }
+}
+
+static void drain_inputs()
+{
+    drain_input(params_copy.mouseQueue, true);
+    drain_input(params_copy.queue, params_copy.mouseQueue == NULL);
+}
+
+static void mouse_read( lv_indev_t *indev, lv_indev_data_t *data )
+{
     const lv_img_dsc_t *cur = (const lv_img_dsc_t *)params_copy.icon;
-    uint16_t _maxX = lv_disp_get_hor_res(NULL) - cur->header.w;
-    uint16_t _maxY = lv_disp_get_ver_res(NULL) - cur->header.h;
-
-    if (xQueueReceive(params_copy.queue, &msg, pdTICKS_TO_MS(30)) == pdPASS) {
-        if (msg.id == 'm') {
-            last_x = constrain(msg.x, 0, _maxX);
-            last_y = constrain(msg.y, 0, _maxY);
-            data->state = (msg.left || msg.right) ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+    uint16_t _maxX = lv_disp_get_hor_res(NULL) - (cur ? cur->header.w : 1);
+    uint16_t _maxY = lv_disp_get_ver_res(NULL) - (cur ? cur->header.h : 1);
+
+    static bool show_held = false;
+
+    if (show_held) {
+        // The button change, the moves before it were shown by the last read
+        mouse_now = mouse_held;
+        mouse_has_held = false;
+        show_held = false;
+    } else {
+        drain_inputs();
+        if (mouse_has_held) {
+            // Read again right away for the button change
+            show_held = true;
+            data->continue_reading = true;
         }
     }
-    data->point.x = last_x;
-    data->point.y = last_y;
+    data->point.x = constrain(mouse_now.x, 0, _maxX);
+    data->point.y = constrain(mouse_now.y, 0, _maxY);
+    data->state = (mouse_now.left || mouse_now.right) ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
 }
 
 static void keypad_read( lv_indev_t *indev, lv_indev_data_t *data )
 {
-    static uint32_t last_key = 0;
-    uint32_t act_key ;
-    struct InputData msg;
-    if (xQueueReceive(params_copy.queue, &msg, pdTICKS_TO_MS(30)) == pdPASS) {
-        if (msg.id == 'k') {
-            last_key =  msg.key;
-            data->key = msg.key;
-            data->state = LV_INDEV_STATE_PR;
-            return;
-        }
+    static bool pressed = false;
+    static char last_key = 0;
+
+    drain_inputs();
+    data->key = last_key;
+    if (pressed) {
+        pressed = false;
+        data->state = LV_INDEV_STATE_RELEASED;
+        data->continue_reading = key_count != 0;
+        return;
     }
-    data->state = LV_INDEV_STATE_REL;
+    if (!key_count) {
+        data->state = LV_INDEV_STATE_RELEASED;
+        return;
+    }
+    last_key = key_buffer[key_head];
+    key_head = (key_head + 1) % INPUT_KEY_BUFFER_SIZE;
+    key_count--;
+    pressed = true;
     data->key = last_key;
+    data->state = LV_INDEV_STATE_PRESSED;
+    data->continue_reading = true;
 }
 
 static void lv_rounder_cb(lv_event_t *e)
@@ -104,8 +334,104 @@ static void lv_rounder_cb(lv_event_t *e)
         area->y2++;
 }
 
+/*
+* Merge the dirty areas of the frame before they are rendered, see AreaMerge.h.
+* lvgl has picked the last area of the frame when it sends LV_EVENT_RENDER_START,
+* merging into the higher index keeps it valid.
+* With LVGL_HELPER_PRINT_AREAS the areas are printed as a tools/merge_replay trace.
+*/
+static void lv_render_start_cb(lv_event_t *e)
+{
+    lv_display_t *disp = (lv_display_t *)lv_event_get_current_target(e);
+    auto *board = (LilyGo_Display *)lv_display_get_user_data(disp);
+#if LVGL_HELPER_PRINT_AREAS
+    Serial.println("frame");
+    for (uint32_t i = 0; i < disp->inv_p; i++) {
+        if (!disp->inv_area_joined[i]) {
+            const lv_area_t *a = &disp->inv_areas[i];
+            Serial.printf("%d %d %d %d\n", (int)a->x1, (int)a->y1, (int)a->x2, (int)a->y2);
+        }
+    }
+#endif
+    AreaCostModel_t model = {board->getAreaSetupUs(), board->getBusBytesPerSecond(), sizeof(lv_color16_t)};
+    areaMerge(disp->inv_areas, disp->inv_area_joined, disp->inv_p, &model);
+}
+
 void beginLvglHelper(LilyGo_Display &board, bool debug)
 {
+    const LvglBufferStrategy_t strategy = LVGL_STRATEGY_DOUBLE_SCREEN;
+    bool ret = beginLvglHelper(board, strategy, debug);
+    assert(ret);
+}
+
+void beginLvglHelperDMA(LilyGo_Display &board, bool debug)
+{
+    const LvglBufferStrategy_t strategy = LVGL_STRATEGY_DMA;
+    bool ret = beginLvglHelper(board, strategy, debug);
+    assert(ret);
+}
+
+bool beginLvglHelper(LilyGo_Display &board, const LvglBufferStrategy_t &strategy, bool debug)
+{
+    uint32_t screen = (uint32_t)board.width() * board.height();
+    LvglRenderMode mode = strategy.mode;
+    if (board.needFullRefresh()) {
+        mode = LVGL_RENDER_FULL;
+    }
+
+    // Validate before anything is allocated or registered
+    uint32_t pixels = 0;
+    if (strategy.lines) {
+        pixels = (uint32_t)strategy.lines * board.width();
+    } else if (strategy.fraction) {
+        pixels = screen / strategy.fraction;
+    }
+    if (pixels > screen) {
+        pixels = screen;
+    }
+    if (strategy.count < 1 || strategy.count > 2 || !pixels) {
+        log_e("Invalid draw buffer strategy, count:%u lines:%u fraction:%u", strategy.count, strategy.lines, strategy.fraction);
+        return false;
+    }
+    if (mode != LVGL_RENDER_PARTIAL && pixels < screen) {
+        log_e("Full and direct rendering need screen sized draw buffers");
+        return false;
+    }
+
+    uint32_t caps = strategy.memory == LVGL_BUFFER_PSRAM ? MALLOC_CAP_SPIRAM : (MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    size_t lv_buffer_size = pixels * sizeof(lv_color16_t);
+    size_t largest = heap_caps_get_largest_free_block(caps);
+    size_t free_size = heap_caps_get_free_size(caps);
+    size_t reserve = strategy.memory == LVGL_BUFFER_PSRAM ? 0 : LVGL_HELPER_INTERNAL_RESERVE;
+    if (largest < lv_buffer_size || free_size < lv_buffer_size * strategy.count + reserve) {
+        log_e("Not enough memory for %u draw buffer(s) of %u bytes, free:%u largest:%u",
+              strategy.count, lv_buffer_size, free_size, largest);
+        return false;
+    }
+
+    buf = (lv_color16_t *)heap_caps_malloc(lv_buffer_size, caps);
+    buf1 = strategy.count > 1 ? (lv_color16_t *)heap_caps_malloc(lv_buffer_size, caps) : NULL;
+    if (!buf || (strategy.count > 1 && !buf1)) {
+        log_e("Failed to allocate the draw buffers");
+        heap_caps_free(buf);
+        heap_caps_free(buf1);
+        buf = NULL;
+        buf1 = NULL;
+        return false;
+    }
+
+    // Let the display swap the bytes while sending instead of an extra pass over the buffer,
+    // only once nothing else can fail so that the display is left as it was on an error
+    swap_in_driver = board.setSwapBytes(true);
+    if (mode == LVGL_RENDER_DIRECT && !swap_in_driver) {
+        log_e("Direct rendering needs a display that swaps the bytes while sending");
+        board.setSwapBytes(false);
+        heap_caps_free(buf);
+        heap_caps_free(buf1);
+        buf = NULL;
+        buf1 = NULL;
+        return false;
+    }
 
     lv_init();
 
@@ -115,27 +441,46 @@ void beginLvglHelper(LilyGo_Display &board, bool debug)
     }
 #endif
 
-    size_t lv_buffer_size = board.width() * board.height() * sizeof(lv_color16_t);
-
-    buf = (lv_color16_t *)ps_malloc(lv_buffer_size);
-    assert(buf);
-
-    buf1 = (lv_color16_t *)ps_malloc(lv_buffer_size);
-    assert(buf1);
-
     disp_drv = lv_display_create(board.width(), board.height());
+    panel_copy = NULL;
+    panel_copy_valid = false;
 
-    if (board.needFullRefresh()) {
+    switch (mode) {
+    case LVGL_RENDER_FULL:
         lv_display_set_buffers(disp_drv, buf, buf1, lv_buffer_size, LV_DISPLAY_RENDER_MODE_FULL);
-    } else {
+        break;
+    case LVGL_RENDER_DIRECT:
+        // lvgl keeps one screen buffer, the second one is the panel copy
+        lv_display_set_buffers(disp_drv, buf, NULL, lv_buffer_size, LV_DISPLAY_RENDER_MODE_DIRECT);
+        lv_display_add_event_cb(disp_drv, lv_rounder_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+        lv_display_add_event_cb(disp_drv, lv_render_start_cb, LV_EVENT_RENDER_START, NULL);
+        panel_copy = (uint16_t *)buf1;
+        break;
+    default:
         lv_display_set_buffers(disp_drv, buf, buf1, lv_buffer_size, LV_DISPLAY_RENDER_MODE_PARTIAL);
         lv_display_add_event_cb(disp_drv, lv_rounder_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+        lv_display_add_event_cb(disp_drv, lv_render_start_cb, LV_EVENT_RENDER_START, NULL);
+        break;
     }
 
     lv_display_set_color_format(disp_drv, LV_COLOR_FORMAT_RGB565);
-    lv_display_set_flush_cb(disp_drv, disp_flush);
     lv_display_set_user_data(disp_drv, &board);
 
+    // Direct mode sends from the persistent screen buffer and stays blocking
+    soft_rotation = board.needSoftRotation();
+    dma_async = false;
+    if (mode == LVGL_RENDER_DIRECT) {
+        lv_display_set_flush_cb(disp_drv, disp_flushDirect);
+    } else if (strategy.dmaFlush) {
+        lv_display_set_flush_cb(disp_drv, disp_flushDMA);
+        // Let lvgl render into the second buffer while the first one is being sent
+        if (!soft_rotation) {
+            dma_async = board.setDMADoneCallback(disp_dma_done, disp_drv);
+        }
+    } else {
+        lv_display_set_flush_cb(disp_drv, disp_flush);
+    }
+
     if (board.hasTouch()) {
         indev_drv = lv_indev_create();
         lv_indev_set_type(indev_drv, LV_INDEV_TYPE_POINTER);
@@ -148,10 +493,94 @@ void beginLvglHelper(LilyGo_Display &board, bool debug)
     lv_tick_set_cb(lv_tick_get_callback);
 
     lv_group_set_default(lv_group_create());
+
+    log_i("Draw buffers: %u x %u bytes %s, mode:%u dma:%u", strategy.count, lv_buffer_size,
+          strategy.memory == LVGL_BUFFER_PSRAM ? "PSRAM" : "internal", mode, dma_async);
+    return true;
+}
+
+uint32_t beginLvglGestures(const GestureConfig_t &config)
+{
+    if (!gesture_event_code) {
+        gesture_event_code = lv_event_register_id();
+    }
+    gesture_engine.setConfig(config);
+    gesture_engine.reset();
+    return gesture_event_code;
+}
+
+bool beginLvglTouchFilter(LilyGo_Display &board)
+{
+    TouchFilterConfig_t config;
+    if (!board.getTouchFilter(&config)) {
+        return false;
+    }
+    beginLvglTouchFilter(config);
+    return true;
+}
+
+void beginLvglTouchFilter(const TouchFilterConfig_t &config)
+{
+    touch_filter.setConfig(config);
+    touch_filter.reset();
+    touch_filter_on = true;
+}
+
+void endLvglTouchFilter()
+{
+    touch_filter_on = false;
+}
+
+void getLvglTouchLatency(TouchLatencyStats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    *stats = touch_latency;
+    stats->avgUs = touch_latency.frames ? touch_latency_sum / touch_latency.frames : 0;
+}
+
+void resetLvglTouchLatency()
+{
+    memset(&touch_latency, 0, sizeof(touch_latency));
+    touch_latency_sum = 0;
+}
+
+void setLvglHelperRotation(LilyGo_Display &board, uint8_t rotation)
+{
+    if (!disp_drv) {
+        board.setRotation(rotation);
+        return;
+    }
+    // Let the last area of the previous frame leave the bus before the scan direction changes,
+    // yield meanwhile so that a lower priority task calling lv_display_flush_ready can run
+    uint32_t start = millis();
+    while (disp_drv->flushing) {
+        if (millis() - start > LVGL_HELPER_FLUSH_TIMEOUT_MS) {
+            log_w("Flush not finished after %u ms, rotate anyway", LVGL_HELPER_FLUSH_TIMEOUT_MS);
+            break;
+        }
+        delay(1);
+    }
+    board.setRotation(rotation);
+
+    // The pixel count is the same in every rotation, so the draw buffers are kept.
+    // The new resolution invalidates the screens once
+    lv_display_set_resolution(disp_drv, board.width(), board.height());
+    frame_start = true;
+    panel_copy_valid = false;
 }
 
 void beginLvglInputDevice(struct InputParams prams)
 {
+    if (!prams.queue && !prams.mouseQueue) {
+        log_e("No input queue set");
+        return;
+    }
+    if (prams.mouseQueue == prams.queue) {
+        // One queue for both devices
+        prams.mouseQueue = NULL;
+    }
     memcpy(&params_copy, &prams, sizeof(struct InputParams));
 
     if (!mouse_indev) {
@@ -161,11 +590,14 @@ void beginLvglInputDevice(struct InputParams prams)
         lv_indev_set_read_cb(indev_mouse, mouse_read);
         lv_indev_enable(indev_mouse, true);
         lv_indev_set_display(indev_mouse, disp_drv);
+        mouse_indev = indev_mouse;
     }
 
-    lv_obj_t *cursor = lv_image_create(lv_scr_act());
-    lv_image_set_src(cursor, params_copy.icon);
-    lv_indev_set_cursor(mouse_indev, cursor);
+    if (params_copy.icon) {
+        lv_obj_t *cursor = lv_image_create(lv_scr_act());
+        lv_image_set_src(cursor, params_copy.icon);
+        lv_indev_set_cursor(mouse_indev, cursor);
+    }
 
     /*Register a keypad input device*/
     if (!kb_indev) {
@@ -174,6 +606,7 @@ void beginLvglInputDevice(struct InputParams prams)
         lv_indev_set_read_cb(indev_keypad, keypad_read);
         lv_indev_enable(indev_keypad, true);
         lv_indev_set_display(indev_keypad, disp_drv);
+        kb_indev = indev_keypad;
         lv_indev_set_group(kb_indev, lv_group_get_default());
     }
 }
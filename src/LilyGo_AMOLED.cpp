@@ -8,7 +8,9 @@
  */
 
 #include "LilyGo_AMOLED.h"
+#include "PixelKernels.h"
 #include <driver/gpio.h>
+#include <Preferences.h>
 
 #if ESP_ARDUINO_VERSION < ESP_ARDUINO_VERSION_VAL(3,0,0)
 #include <esp_adc_cal.h>
@@ -36,16 +38,52 @@
 #endif
 
 
+#ifndef LCD_CMD_RDDPM
+#define LCD_CMD_RDDPM        (0x0A) // Read display power mode
+#endif
+
 #ifndef LCD_CMD_SLPIN
 #define LCD_CMD_SLPIN        (0x10) // Go into sleep mode (DC/DC, oscillator, scanning stopped, but memory keeps content)
 #endif
 
+#ifndef LCD_CMD_TEOFF
+#define LCD_CMD_TEOFF        (0x34) // Tearing effect line off
+#endif
+
+#ifndef LCD_CMD_TEON
+#define LCD_CMD_TEON         (0x35) // Tearing effect line on
+#endif
+
 #ifndef LCD_CMD_BRIGHTNESS
 #define LCD_CMD_BRIGHTNESS   (0x51)
 #endif
 
-#define SEND_BUF_SIZE           (16384)
+#define BOARD_PROBE_TIMEOUT_MS  (10)        // I2C timeout while probing for the board model
+#define LCD_READ_CMD            (0x03)      // QSPI single line register read
+#define LCD_RDDPM_SLPOUT        _BV(4)
+#define LCD_RDDPM_DISPON        _BV(2)
+#define RESET_SETTLE_MS         (200)       // Conservative reset timings, used unless fast boot is enabled
+#define RESET_LOW_MS            (300)
+#define RESET_WAIT_MS           (200)
+#define ROTATE_STRIP_SIZE       (4096)      // Pixels per internal SRAM rotate buffer, two are used alternately
+#define BOUNCE_BUF_SIZE         (4096)      // Default pixels per internal SRAM bounce buffer
+#define BOUNCE_BUF_NUM          (2)         // Default number of bounce buffers in the ring
+#define ROW_SCRATCH_SIZE        (256)       // Pixels of the stack scratch used to swap rows without a bounce buffer
+#define PMU_BURST_CACHE_US      (5000)      // Time one burst read of the PMU ADC registers serves the voltage getters
 #define TFT_SPI_MODE            SPI_MODE0
+#define PROFILE_BUCKET_FIRST_US (500)       // Upper bound of the first flush latency bucket, doubled per bucket
+
+#if DISPLAY_PROFILE
+#define PROFILE_ADD(field, value)       do { portENTER_CRITICAL(&_profileLock); _profile.field += (value); portEXIT_CRITICAL(&_profileLock); } while (0)
+#define PROFILE_MARK(var)               int64_t var = esp_timer_get_time()
+#define PROFILE_ELAPSED(field, var)     PROFILE_ADD(field, esp_timer_get_time() - (var))
+#define PROFILE_FLUSH_DONE(var)         profileFlushDone(var, false)
+#else
+#define PROFILE_ADD(field, value)
+#define PROFILE_MARK(var)
+#define PROFILE_ELAPSED(field, var)
+#define PROFILE_FLUSH_DONE(var)
+#endif
 #define DEFAULT_SPI_HANDLER    (SPI3_HOST)
 
 LilyGo_AMOLED::LilyGo_AMOLED() : boards(NULL), _hasRTC(false), _disableTouch(false)
@@ -54,6 +92,51 @@ LilyGo_AMOLED::LilyGo_AMOLED() : boards(NULL), _hasRTC(false), _disableTouch(fal
     pBuffer = NULL;
     spi = NULL;
     _brightness = AMOLED_DEFAULT_BRIGHTNESS;
+    _dmaHead = 0;
+    _dmaInFlight = 0;
+    _dmaDoneCb = NULL;
+    _dmaDoneUserData = NULL;
+    _dmaNotify = false;
+    _rotateBuffer[0] = NULL;
+    _rotateBuffer[1] = NULL;
+    _addrWindowValid = false;
+    _hardwareCS = false;
+    _swapBytes = false;
+    _bounceIndex = 0;
+    _bounceNum = BOUNCE_BUF_NUM;
+    _bounceSize = BOUNCE_BUF_SIZE;
+    _chunkSize = DISPLAY_MAX_CHUNK_SIZE;
+    _bounceAllocated = 0;
+    memset(_bounceBuffer, 0, sizeof(_bounceBuffer));
+    memset(&_bounceStats, 0, sizeof(_bounceStats));
+    _bounceTimed = false;
+    _bounceStartUs = 0;
+    _bounceDoneUs = 0;
+    _teMode = TE_SYNC_DISABLE;
+    _teTimeout = 0;
+    _teSemaphore = NULL;
+    _teCount = 0;
+    _teTimestamp = 0;
+    memset(&_teStats, 0, sizeof(_teStats));
+    _touchTask = NULL;
+    _touchRunning = false;
+    _touchReleaseMs = 0;
+    portMUX_INITIALIZE(&_touchLock);
+    _touchIrqUs = 0;
+    memset(&_touchStats, 0, sizeof(_touchStats));
+    _traceWriter = NULL;
+    _traceUserData = NULL;
+    _tracePayload = false;
+    _fastBoot = false;
+    _bootFirstFrame = false;
+    memset(&_bootProfile, 0, sizeof(_bootProfile));
+#if DISPLAY_PROFILE
+    portMUX_INITIALIZE(&_profileLock);
+    memset(&_profile, 0, sizeof(_profile));
+    _profileStart = esp_timer_get_time();
+    _profileFlushStart = 0;
+    _profileCSStart = 0;
+#endif
     // Prevent previously set hold
     switch (esp_sleep_get_wakeup_cause()) {
     case ESP_SLEEP_WAKEUP_EXT0 :
@@ -70,11 +153,31 @@ LilyGo_AMOLED::LilyGo_AMOLED() : boards(NULL), _hasRTC(false), _disableTouch(fal
 
 LilyGo_AMOLED::~LilyGo_AMOLED()
 {
+    stopTouchSampler();
+    setTESync(TE_SYNC_DISABLE);
+    if (_teSemaphore) {
+        vSemaphoreDelete(_teSemaphore);
+        _teSemaphore = NULL;
+    }
+
+    if (spi) {
+        waitDMADone();
+    }
+
     if (pBuffer) {
         free(pBuffer);
         pBuffer = NULL;
     }
 
+    for (int i = 0; i < 2; i++) {
+        if (_rotateBuffer[i]) {
+            heap_caps_free(_rotateBuffer[i]);
+            _rotateBuffer[i] = NULL;
+        }
+    }
+
+    freeBounceBuffers();
+
     if (spiDev) {
         spiDev->end();
         spiDev = NULL;
@@ -124,14 +227,19 @@ uint16_t  LilyGo_AMOLED::height()
     return _height;
 }
 
+// When CS is driven by the SPI peripheral, there is nothing to do here
 void inline LilyGo_AMOLED::setCS()
 {
-    digitalWrite(boards->display.cs, LOW);
+    if (!_hardwareCS) {
+        digitalWrite(boards->display.cs, LOW);
+    }
 }
 
 void inline LilyGo_AMOLED::clrCS()
 {
-    digitalWrite(boards->display.cs, HIGH);
+    if (!_hardwareCS) {
+        digitalWrite(boards->display.cs, HIGH);
+    }
 }
 
 bool LilyGo_AMOLED::isPressed()
@@ -154,13 +262,44 @@ void LilyGo_AMOLED::enableTouch()
     _disableTouch = false;
 }
 
-uint8_t LilyGo_AMOLED::getPoint(int16_t *x, int16_t *y, uint8_t get_point )
+uint8_t LilyGo_AMOLED::readTouch(int16_t *x, int16_t *y, uint8_t get_point)
 {
     uint8_t point = 0;
     if (boards == &BOARD_AMOLED_147) {
-        point =  TouchDrvCHSC5816::getPoint(x, y);
-    } else if (boards == &BOARD_AMOLED_191 || boards == &BOARD_AMOLED_241 || boards == &BOARD_AMOLED_191_SPI) {
-        point =  TouchDrvCSTXXX::getPoint(x, y);
+        // CHSC5816 only supports single touch, its driver uses Wire directly
+        _i2cBus.lock(I2C_PRIORITY_HIGH);
+        point = TouchDrvCHSC5816::getPoint(x, y);
+        _i2cBus.unlock();
+    } else if (boards == &BOARD_AMOLED_241) {
+        // CST226 reports up to five fingers, its driver uses Wire directly
+        _i2cBus.lock(I2C_PRIORITY_HIGH);
+        point = TouchDrvCSTXXX::getPoint(x, y, get_point);
+        _i2cBus.unlock();
+    } else if (boards == &BOARD_AMOLED_191 || boards == &BOARD_AMOLED_191_SPI) {
+        // CST816 reports one finger, the driver goes through the bus callbacks
+        point = TouchDrvCSTXXX::getPoint(x, y, get_point);
+    }
+    return point;
+}
+
+uint8_t LilyGo_AMOLED::getPoint(int16_t *x, int16_t *y, uint8_t get_point )
+{
+    uint8_t point = 0;
+    if (_touchTask) {
+        // Latest sample of the sampler task, the bus is not accessed and the queued samples stay for readTouchEvent
+        TouchEvent_t latest;
+        _touchLatest.load(&latest);
+        point = latest.points;
+        if (point && get_point) {
+            x[0] = latest.x;
+            y[0] = latest.y;
+        }
+        if (point > 1 && get_point > 1) {
+            x[1] = latest.x2;
+            y[1] = latest.y2;
+        }
+    } else {
+        point = readTouch(x, y, get_point);
     }
 
     // Disable touch, just return the touch press touch point Set to 0, does not actually disable touch
@@ -342,9 +481,45 @@ uint32_t deviceScan(TwoWire *_port, Stream *stream)
     return nDevices;
 }
 
+void LilyGo_AMOLED::initI2CBus()
+{
+    // Wire is already started on the board pins
+    _i2cBus.begin(i2cBusWireTransfer, &Wire);
+    I2CBus::setDefault(&_i2cBus);
+
+    if (boards == &BOARD_AMOLED_147) {
+        _i2cBus.addDevice({CHSC5816_SLAVE_ADDRESS, I2C_PRIORITY_HIGH, 0, 0, 0});
+        // Battery, VBUS and system voltage are read one ADC register at a time
+        _i2cBus.addDevice({AXP2101_SLAVE_ADDRESS, I2C_PRIORITY_LOW, XPOWERS_AXP2101_ADC_DATA_RELUST0,
+                           XPOWERS_AXP2101_ADC_DATA_RELUST9, PMU_BURST_CACHE_US});
+        _i2cBus.addDevice({CM32181_SLAVE_ADDRESS, I2C_PRIORITY_LOW, 0, 0, 0});
+    } else if (boards == &BOARD_AMOLED_241) {
+        _i2cBus.addDevice({CST226SE_SLAVE_ADDRESS, I2C_PRIORITY_HIGH, 0, 0, 0});
+        // ADC results, the fault register 0x0C before them clears on read
+        _i2cBus.addDevice({SY6970_SLAVE_ADDRESS, I2C_PRIORITY_LOW, POWERS_PPM_REG_0EH, POWERS_PPM_REG_13H, PMU_BURST_CACHE_US});
+    } else {
+        _i2cBus.addDevice({CST816_SLAVE_ADDRESS, I2C_PRIORITY_HIGH, 0, 0, 0});
+        _i2cBus.addDevice({SY6970_SLAVE_ADDRESS, I2C_PRIORITY_LOW, POWERS_PPM_REG_0EH, POWERS_PPM_REG_13H, PMU_BURST_CACHE_US});
+        _i2cBus.addDevice({BQ25896_SLAVE_ADDRESS, I2C_PRIORITY_LOW, POWERS_PPM_REG_0EH, POWERS_PPM_REG_13H, PMU_BURST_CACHE_US});
+        _i2cBus.addDevice({PCF85063_SLAVE_ADDRESS, I2C_PRIORITY_LOW, 0, 0, 0});
+    }
+}
+
+bool LilyGo_AMOLED::getI2CStats(uint8_t address, I2CDeviceStats_t *stats)
+{
+    return _i2cBus.getStats(address, stats);
+}
+
+void LilyGo_AMOLED::resetI2CStats()
+{
+    _i2cBus.resetStats();
+}
+
 bool LilyGo_AMOLED::initPMU()
 {
-    bool res = XPowersAXP2101::init(Wire, boards->pmu->sda, boards->pmu->scl, AXP2101_SLAVE_ADDRESS);
+    Wire.begin(boards->pmu->sda, boards->pmu->scl);
+    initI2CBus();
+    bool res = XPowersAXP2101::begin(AXP2101_SLAVE_ADDRESS, I2CBus::readCallback, I2CBus::writeCallback);
     if (!res) {
         return false;
     }
@@ -383,6 +558,8 @@ bool LilyGo_AMOLED::initPMU()
 bool LilyGo_AMOLED::initBUS(DriverBusType type)
 {
     assert(boards);
+    memset(&_bootProfile, 0, sizeof(_bootProfile));
+    _bootProfile.startUs = esp_timer_get_time();
     log_i("=====CONFIGURE======");
     log_i("RST    > %d", boards->display.rst);
     log_i("CS     > %d", boards->display.cs);
@@ -398,9 +575,24 @@ bool LilyGo_AMOLED::initBUS(DriverBusType type)
 
     _width = boards->display.width;
     _height = boards->display.height;
+    _addrWindowValid = false;
+    if (!setChunkSize(boards->display.chunkSize)) {
+        _chunkSize = DISPLAY_MAX_CHUNK_SIZE;
+    }
+
+#ifdef SPI_TRANS_CS_KEEP_ACTIVE
+    _hardwareCS = (type == QSPI_DRIVER) && boards->display.hardwareCS;
+#else
+    if (boards->display.hardwareCS) {
+        log_w("SPI_TRANS_CS_KEEP_ACTIVE is not supported by this esp-idf version, use GPIO CS");
+    }
+    _hardwareCS = false;
+#endif
 
     pinMode(boards->display.rst, OUTPUT);
-    pinMode(boards->display.cs, OUTPUT);
+    if (!_hardwareCS) {
+        pinMode(boards->display.cs, OUTPUT);
+    }
 
     if (boards->display.te != -1) {
         pinMode(boards->display.te, INPUT);
@@ -412,13 +604,15 @@ bool LilyGo_AMOLED::initBUS(DriverBusType type)
     }
 
     //reset display
-    digitalWrite(boards->display.rst, HIGH);
-    delay(200);
-    digitalWrite(boards->display.rst, LOW);
-    delay(300);
-    digitalWrite(boards->display.rst, HIGH);
-    delay(200);
+    int64_t start = esp_timer_get_time();
+    if (_fastBoot) {
+        resetPanel(boards->display.resetSettleMs, boards->display.resetLowMs, boards->display.resetWaitMs);
+    } else {
+        resetPanel(RESET_SETTLE_MS, RESET_LOW_MS, RESET_WAIT_MS);
+    }
+    _bootProfile.resetUs = esp_timer_get_time() - start;
 
+    start = esp_timer_get_time();
     if (type == QSPI_DRIVER) {
         spi_bus_config_t buscfg = {
             .data0_io_num = boards->display.d0,
@@ -430,7 +624,7 @@ bool LilyGo_AMOLED::initBUS(DriverBusType type)
             .data5_io_num = BOARD_NONE_PIN,
             .data6_io_num = BOARD_NONE_PIN,
             .data7_io_num = BOARD_NONE_PIN,
-            .max_transfer_sz = (SEND_BUF_SIZE * 16) + 8,
+            .max_transfer_sz = (DISPLAY_MAX_CHUNK_SIZE * sizeof(uint16_t)) + 8,
             .flags = SPICOMMON_BUSFLAG_MASTER | SPICOMMON_BUSFLAG_GPIO_PINS,
         };
 
@@ -439,9 +633,11 @@ bool LilyGo_AMOLED::initBUS(DriverBusType type)
             .address_bits = boards->display.addBit,
             .mode = TFT_SPI_MODE,
             .clock_speed_hz = boards->display.freq,
-            .spics_io_num = -1,
+            .spics_io_num = _hardwareCS ? boards->display.cs : -1,
             .flags = SPI_DEVICE_HALFDUPLEX,
-            .queue_size = 17,
+            .queue_size = DISPLAY_DMA_QUEUE_SIZE,
+            .pre_cb = dmaPreCallback,
+            .post_cb = dmaPostCallback,
         };
         esp_err_t ret = spi_bus_initialize(DEFAULT_SPI_HANDLER, &buscfg, SPI_DMA_CH_AUTO);
         if (ret != ESP_OK) {
@@ -453,81 +649,214 @@ bool LilyGo_AMOLED::initBUS(DriverBusType type)
             log_e("spi_bus_add_device fail!");
             return false;
         }
+        // The display is the only device on this bus, keep it acquired,
+        // which is required to hold CS across the chunks of a pixel burst
+        if (_hardwareCS) {
+            ret = spi_device_acquire_bus(spi, portMAX_DELAY);
+            if (ret != ESP_OK) {
+                log_e("spi_device_acquire_bus fail!");
+                return false;
+            }
+        }
+        log_i("CS     > %s", _hardwareCS ? "hardware" : "gpio");
     } else {
         pinMode(boards->display.d1, OUTPUT);    //set dc output
         spiDev = new SPIClass(HSPI);
         assert(spiDev);
         spiDev->begin(boards->display.sck, -1 /*miso */, boards->display.d0);
     }
-    // prevent initialization failure
-    int retry = 2;
-    while (retry--) {
-        const lcd_cmd_t *t = boards->display.initSequence;
-        for (uint32_t i = 0; i < boards->display.initSize; i++) {
-            writeCommand(t[i].addr, (uint8_t *)t[i].param, t[i].len & 0x1F);
-            if (t[i].len & 0x80) {
-                delay(120);
-            }
-            if (t[i].len & 0x20) {
-                delay(10);
-            }
-        }
-    }
-    return true;
+    _bootProfile.busUs = esp_timer_get_time() - start;
+
+    bool ret = initPanel();
+    _bootFirstFrame = true;
+
+    log_i("Boot: reset %u us, bus %u us, init %u us x %u, verify %u us %s",
+          _bootProfile.resetUs, _bootProfile.busUs, _bootProfile.initUs, _bootProfile.attempts,
+          _bootProfile.verifyUs, !_bootProfile.checked ? "skipped" : _bootProfile.verified ? "ok" : "failed");
+    return ret;
 }
 
+void LilyGo_AMOLED::resetPanel(uint32_t settle_ms, uint32_t low_ms, uint32_t wait_ms)
+{
+    digitalWrite(boards->display.rst, HIGH);
+    delay(settle_ms);
+    digitalWrite(boards->display.rst, LOW);
+    delay(low_ms);
+    digitalWrite(boards->display.rst, HIGH);
+    delay(wait_ms);
+}
 
-bool LilyGo_AMOLED::begin()
+bool LilyGo_AMOLED::initPanel()
 {
-    //Try find 1.47 inch i2c devices
-    Wire.begin(1, 2);
-    Wire.beginTransmission(AXP2101_SLAVE_ADDRESS);
-    if (Wire.endTransmission() == 0) {
-        return beginAMOLED_147();
+    int64_t start = esp_timer_get_time();
+    if (!_fastBoot) {
+        // prevent initialization failure
+        int retry = 2;
+        while (retry--) {
+            writeInitSequence(boards->display.initSequence);
+            _bootProfile.attempts++;
+        }
+        _bootProfile.initUs = esp_timer_get_time() - start;
+        return true;
     }
 
-    log_e("Unable to detect 1.47-inch board model!");
+    writeInitSequence(boards->display.initSequence);
+    _bootProfile.attempts++;
+    _bootProfile.initUs = esp_timer_get_time() - start;
 
+    // The SPI interface has no read line, trust the single pass
+    if (!spi) {
+        return true;
+    }
 
-    Wire.end();
+    uint8_t mode = 0;
+    _bootProfile.checked = true;
+    bool ok = verifyPanel(&mode);
+    if (!ok) {
+        // Fall back to the conservative path, full reset and the init sequence twice
+        log_w("Panel power mode 0x%02X after fast init, retrying with full reset", mode);
+        start = esp_timer_get_time();
+        resetPanel(RESET_SETTLE_MS, RESET_LOW_MS, RESET_WAIT_MS);
+        _bootProfile.resetUs += esp_timer_get_time() - start;
+
+        for (int i = 0; i < 2 && !ok; i++) {
+            start = esp_timer_get_time();
+            writeInitSequence(boards->display.initSequence);
+            _bootProfile.attempts++;
+            _bootProfile.initUs += esp_timer_get_time() - start;
+            ok = verifyPanel(&mode);
+        }
+    }
+    _bootProfile.verified = ok;
+    if (!ok) {
+        log_e("Panel power mode 0x%02X, display may not be initialized", mode);
+    }
+    return ok;
+}
 
-    delay(10);
+// Read back the power mode, the panel must be out of sleep with the display on
+bool LilyGo_AMOLED::verifyPanel(uint8_t *mode)
+{
+    int64_t start = esp_timer_get_time();
+    bool ok = readCommand(LCD_CMD_RDDPM, mode, 1) &&
+              (*mode & (LCD_RDDPM_SLPOUT | LCD_RDDPM_DISPON)) == (LCD_RDDPM_SLPOUT | LCD_RDDPM_DISPON);
+    _bootProfile.verifyUs += esp_timer_get_time() - start;
+    return ok;
+}
 
-    // Try find 1.91 inch i2c devices
-    Wire.begin(3, 2);
-    Wire.beginTransmission(CSTXXX_SLAVE_ADDRESS);
-    if (Wire.endTransmission() == 0) {
+// Single line register read, only available on the QSPI bus
+bool LilyGo_AMOLED::readCommand(uint32_t cmd, uint8_t *pdat, uint32_t length)
+{
+    if (!spi || !pdat || !length) {
+        return false;
+    }
+    waitDMADone();
+    setCS();
+    spi_transaction_t t;
+    memset(&t, 0, sizeof(t));
+    t.cmd = LCD_READ_CMD;
+    t.addr = cmd << 8;
+    t.rx_buffer = pdat;
+    t.rxlength = 8 * length;
+    esp_err_t ret = spi_device_polling_transmit(spi, &t);
+    clrCS();
+    return ret == ESP_OK;
+}
 
-        // Check RTC Slave address
-        Wire.beginTransmission(0x51);
-        if (Wire.endTransmission() == 0) {
-            log_i("Detect 1.91-inch SPI board model!");
-            return beginAMOLED_191_SPI(true);
-        } else {
-            log_i("Detect 1.91-inch QSPI board model!");
-            return beginAMOLED_191(true);
-        }
+void LilyGo_AMOLED::setFastBoot(bool enable)
+{
+    _fastBoot = enable;
+}
+
+void LilyGo_AMOLED::getBootProfile(DisplayBootProfile_t *profile)
+{
+    if (!profile) {
+        return;
     }
-    log_e("Unable to detect 1.91-inch touch board model!");
+    memcpy(profile, &_bootProfile, sizeof(DisplayBootProfile_t));
+}
 
-    Wire.end();
 
-    delay(10);
+typedef struct {
+    int sda;
+    int scl;
+} WireProbePins_t;
 
-    // Try find 2.41 inch i2c devices
-    Wire.begin(6, 7);
-    Wire.beginTransmission(SY6970_SLAVE_ADDRESS);
-    if (Wire.endTransmission() == 0) {
-        return beginAMOLED_241();
+// Probe over Wire, the bus is restarted only when the pins change
+static bool wireProbe(int sda, int scl, uint8_t address, void *user_data)
+{
+    WireProbePins_t *pins = (WireProbePins_t *)user_data;
+    if (pins->sda != sda || pins->scl != scl) {
+        if (pins->sda != -1) {
+            Wire.end();
+        }
+        Wire.begin(sda, scl);
+        Wire.setTimeOut(BOARD_PROBE_TIMEOUT_MS);
+        pins->sda = sda;
+        pins->scl = scl;
     }
-    log_e("Unable to detect 2.41-inch touch board model!");
+    Wire.beginTransmission(address);
+    return Wire.endTransmission() == 0;
+}
 
-    Wire.end();
+bool LilyGo_AMOLED::begin()
+{
+    const uint32_t count = sizeof(AMOLED_BOARD_PROBES) / sizeof(*AMOLED_BOARD_PROBES);
+    WireProbePins_t pins = {-1, -1};
+    uint16_t timeout = Wire.getTimeOut();
+    int index = -1;
+
+    Preferences prefs;
+    bool nvs = prefs.begin("amoled", false);
+    uint8_t cached = nvs ? prefs.getUChar("board", LILYGO_AMOLED_UNKNOWN) : LILYGO_AMOLED_UNKNOWN;
+
+    // Warm boot, only the devices on the pins of the last detected board are probed
+    for (uint32_t i = 0; i < count; i++) {
+        if (AMOLED_BOARD_PROBES[i].board == cached) {
+            if (verifyBoard(AMOLED_BOARD_PROBES, count, i, wireProbe, &pins)) {
+                index = i;
+            }
+            break;
+        }
+    }
+    if (index < 0) {
+        index = detectBoard(AMOLED_BOARD_PROBES, count, wireProbe, &pins);
+    }
+    Wire.setTimeOut(timeout);
 
+    if (index < 0) {
+        if (pins.sda != -1) {
+            Wire.end();
+        }
+        if (nvs) {
+            prefs.remove("board");
+            prefs.end();
+        }
+        log_e("Unable to detect board model, begin 1.91-inch no touch board model");
+        return beginAMOLED_191(false);
+    }
 
-    log_e("Begin 1.91-inch no touch board model");
+    uint8_t board = AMOLED_BOARD_PROBES[index].board;
+    if (nvs) {
+        if (board != cached) {
+            prefs.putUChar("board", board);
+        }
+        prefs.end();
+    }
 
-    return beginAMOLED_191(false);
+    switch (board) {
+    case LILYGO_AMOLED_147:
+        return beginAMOLED_147();
+    case LILYGO_AMOLED_191_SPI:
+        log_i("Detect 1.91-inch SPI board model!");
+        return beginAMOLED_191_SPI(true);
+    case LILYGO_AMOLED_241:
+        return beginAMOLED_241();
+    case LILYGO_AMOLED_191:
+    default:
+        log_i("Detect 1.91-inch QSPI board model!");
+        return beginAMOLED_191(true);
+    }
 }
 
 
@@ -540,19 +869,22 @@ bool LilyGo_AMOLED::beginAMOLED_191(bool touchFunc)
 {
     boards = &BOARD_AMOLED_191;
 
-    initBUS();
+    if (!initBUS()) {
+        return false;
+    }
 
     if (touchFunc && boards->touch) {
         if (boards->touch->sda != -1 && boards->touch->scl != -1) {
             Wire.begin(boards->touch->sda, boards->touch->scl);
             deviceScan(&Wire, &Serial);
+            initI2CBus();
 
             // Try to find touch device
             Wire.beginTransmission(CST816_SLAVE_ADDRESS);
             if (Wire.endTransmission() == 0) {
                 TouchDrvCSTXXX::setTouchDrvModel(TouchDrv_CST8XX);
                 TouchDrvCSTXXX::setPins(boards->touch->rst, boards->touch->irq);
-                bool res = TouchDrvCSTXXX::begin(Wire, CST816_SLAVE_ADDRESS, boards->touch->sda, boards->touch->scl);
+                bool res = TouchDrvCSTXXX::begin(CST816_SLAVE_ADDRESS, I2CBus::readCallback, I2CBus::writeCallback);
                 if (!res) {
                     log_e("Failed to find CST816T - check your wiring!");
                     // return false;
@@ -576,7 +908,9 @@ bool LilyGo_AMOLED::beginAMOLED_191_SPI(bool touchFunc)
 {
     boards = &BOARD_AMOLED_191_SPI;
 
-    initBUS(SPI_DRIVER);
+    if (!initBUS(SPI_DRIVER)) {
+        return false;
+    }
 
     if (boards->pmu) {
         uint8_t slaveAddress = 0;
@@ -596,7 +930,8 @@ bool LilyGo_AMOLED::beginAMOLED_191_SPI(bool touchFunc)
         if (slaveAddress == 0) {
             return false;
         }
-        if (BQ.init(Wire, boards->pmu->sda, boards->pmu->scl, slaveAddress)) {
+        initI2CBus();
+        if (BQ.begin(slaveAddress, I2CBus::readCallback, I2CBus::writeCallback)) {
             BQ.enableMeasure();
             BQ.disableOTG();
             BQ.disableCharge();    //Default disable charge function
@@ -606,9 +941,10 @@ bool LilyGo_AMOLED::beginAMOLED_191_SPI(bool touchFunc)
     }
 
 #if SENSORLIB_VERSION_MINOR > 2
-    _hasRTC = SensorPCF85063::begin(Wire, boards->pmu->sda, boards->pmu->scl);
+    _hasRTC = SensorPCF85063::begin(PCF85063_SLAVE_ADDRESS, I2CBus::readCallback, I2CBus::writeCallback);
 #else
-    _hasRTC = SensorPCF85063::init(Wire, boards->pmu->sda, boards->pmu->scl);
+    // SensorPCF85063 has no begin of its own before 0.3, the callback begin of SensorCommon keeps it on the shared bus
+    _hasRTC = SensorCommon<SensorPCF85063>::begin(PCF85063_SLAVE_ADDRESS, I2CBus::readCallback, I2CBus::writeCallback);
 #endif
     if (!_hasRTC) {
         log_e("begin rtc failed!");
@@ -618,13 +954,14 @@ bool LilyGo_AMOLED::beginAMOLED_191_SPI(bool touchFunc)
         if (boards->touch->sda != -1 && boards->touch->scl != -1) {
             Wire.begin(boards->touch->sda, boards->touch->scl);
             deviceScan(&Wire, &Serial);
+            initI2CBus();
 
             // Try to find touch device
             Wire.beginTransmission(CST816_SLAVE_ADDRESS);
             if (Wire.endTransmission() == 0) {
                 TouchDrvCSTXXX::setTouchDrvModel(TouchDrv_CST8XX);
                 TouchDrvCSTXXX::setPins(boards->touch->rst, boards->touch->irq);
-                bool res = TouchDrvCSTXXX::begin(Wire, CST816_SLAVE_ADDRESS, boards->touch->sda, boards->touch->scl);
+                bool res = TouchDrvCSTXXX::begin(CST816_SLAVE_ADDRESS, I2CBus::readCallback, I2CBus::writeCallback);
                 if (!res) {
                     log_e("Failed to find CST816T - check your wiring!");
                     // return false;
@@ -652,11 +989,14 @@ bool LilyGo_AMOLED::beginAMOLED_241(bool disable_sd, bool disable_state_led)
 {
     boards = &BOARD_AMOLED_241;
 
-    initBUS();
+    if (!initBUS()) {
+        return false;
+    }
 
     if (boards->pmu) {
         Wire.begin(boards->pmu->sda, boards->pmu->scl);
-        SY.init(Wire, boards->pmu->sda, boards->pmu->scl, SY6970_SLAVE_ADDRESS);
+        initI2CBus();
+        SY.begin(SY6970_SLAVE_ADDRESS, I2CBus::readCallback, I2CBus::writeCallback);
         SY.enableMeasure();
         SY.disableOTG();
         if (disable_state_led) {
@@ -766,7 +1106,9 @@ bool LilyGo_AMOLED::beginAMOLED_147()
         deviceScan(&Wire, &Serial);
     }
 
-    initBUS();
+    if (!initBUS()) {
+        return false;
+    }
 
 
     if (boards->display.frameBufferSize) {
@@ -776,6 +1118,14 @@ bool LilyGo_AMOLED::beginAMOLED_147()
             pBuffer = (uint16_t *)malloc(boards->display.frameBufferSize);
         }
         assert(pBuffer);
+
+        // Internal SRAM strips used by the rotate-and-send path, fall back to pBuffer if unavailable
+        for (int i = 0; i < 2; i++) {
+            _rotateBuffer[i] = (uint16_t *)heap_caps_malloc(ROTATE_STRIP_SIZE * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        }
+        if (!_rotateBuffer[0] || !_rotateBuffer[1]) {
+            log_e("Failed to allocate rotate buffer, use the frame buffer");
+        }
     }
 
     TouchDrvCHSC5816::setPins(boards->touch->rst, boards->touch->irq);
@@ -783,14 +1133,10 @@ bool LilyGo_AMOLED::beginAMOLED_147()
     if (!_touchOnline) {
         log_e("Failed to find CHSC5816 - check your wiring!");
         // return false;
-    } else {
-        TouchDrvCHSC5816::setMaxCoordinates(_width, _height);
-        TouchDrvCHSC5816::setSwapXY(true);
-        TouchDrvCHSC5816::setMirrorXY(false, true);
     }
 
     // Share I2C Bus
-    bool res = SensorCM32181::begin(Wire, CM32181_SLAVE_ADDRESS, boards->sensor->sda, boards->sensor->scl);
+    bool res = SensorCM32181::begin(CM32181_SLAVE_ADDRESS, I2CBus::readCallback, I2CBus::writeCallback);
     if (!res) {
         log_e("Failed to find CM32181 - check your wiring!");
         // return false;
@@ -806,11 +1152,24 @@ bool LilyGo_AMOLED::beginAMOLED_147()
                       powerOn();
     }
 
+    setRotation(0);
+
     return true;
 }
 
 void LilyGo_AMOLED::writeCommand(uint32_t cmd, uint8_t *pdat, uint32_t length)
 {
+    if (cmd == LCD_CMD_CASET || cmd == LCD_CMD_RASET) {
+        _addrWindowValid = false;
+    }
+
+    PROFILE_ADD(commands, 1);
+    PROFILE_MARK(cs_start);
+
+    if (_traceWriter) {
+        traceTransaction(0x02, cmd << 8, TRACE_CS_BEGIN | TRACE_CS_END | TRACE_POLLING, pdat, pdat ? length : 0);
+    }
+
     if (spiDev) {
         // Write spi command
         setCS();
@@ -830,10 +1189,13 @@ void LilyGo_AMOLED::writeCommand(uint32_t cmd, uint8_t *pdat, uint32_t length)
             spiDev->endTransaction();
             clrCS();
         }
+        PROFILE_ELAPSED(csUs, cs_start);
         return;
     }
 
     // QSPI
+    // Polling transactions cannot be mixed with unfinished queued transactions
+    waitDMADone();
     setCS();
     spi_transaction_t t;
     memset(&t, 0, sizeof(t));
@@ -849,6 +1211,7 @@ void LilyGo_AMOLED::writeCommand(uint32_t cmd, uint8_t *pdat, uint32_t length)
     }
     spi_device_polling_transmit(spi, &t);
     clrCS();
+    PROFILE_ELAPSED(csUs, cs_start);
 }
 
 void LilyGo_AMOLED::setBrightness(uint8_t level)
@@ -893,160 +1256,804 @@ void LilyGo_AMOLED::setAddrWindow(uint16_t xs, uint16_t ys, uint16_t xe, uint16_
         },
     };
 
-    for (uint32_t i = 0; i < 3; i++) {
-        writeCommand(t[i].addr, t[i].param, t[i].len);
+    // Skip CASET/RASET when the window has not changed since the last call
+    if (_addrWindowValid && _addrWindow[0] == xs && _addrWindow[1] == ys &&
+            _addrWindow[2] == xe && _addrWindow[3] == ye) {
+        writeCommands(&t[2], 1);
+        return;
     }
+
+    writeCommands(t, 3);
+
+    _addrWindow[0] = xs;
+    _addrWindow[1] = ys;
+    _addrWindow[2] = xe;
+    _addrWindow[3] = ye;
+    _addrWindowValid = true;
 }
 
 // Push (aka write pixel) colours to the TFT (use setAddrWindow() first)
 void LilyGo_AMOLED::pushColors(uint16_t *data, uint32_t len)
+{
+    PROFILE_MARK(flush_start);
+    pushPixels(data, len, _swapBytes);
+    PROFILE_FLUSH_DONE(flush_start);
+}
+
+void LilyGo_AMOLED::pushPixels(uint16_t *data, uint32_t len, bool swap)
 {
     if (spiDev) {
+        PROFILE_ADD(transactions, 1);
+        PROFILE_ADD(bytes, len * sizeof(uint16_t));
+        PROFILE_MARK(cs_start);
         setCS();
         spiDev->beginTransaction(SPISettings(boards->display.freq, MSBFIRST, TFT_SPI_MODE));
         digitalWrite(boards->display.d1, HIGH);
-        spiDev->writeBytes((uint8_t *)data, len * sizeof(uint16_t));
+        if (swap) {
+            if (!allocBounceBuffers()) {
+                log_e("Byte swap needs a bounce buffer");
+                spiDev->endTransaction();
+                clrCS();
+                return;
+            }
+            bool first = true;
+            while (len > 0) {
+                uint32_t chunk_size = min(len, _bounceSize);
+                pixelSwapCopy(_bounceBuffer[0], data, chunk_size);
+                if (_traceWriter) {
+                    traceTransaction(0, 0, TRACE_CONTINUE | (first ? TRACE_CS_BEGIN : 0) | (chunk_size == len ? TRACE_CS_END : 0),
+                                     _bounceBuffer[0], chunk_size * sizeof(uint16_t));
+                }
+                spiDev->writeBytes((uint8_t *)_bounceBuffer[0], chunk_size * sizeof(uint16_t));
+                first = false;
+                data += chunk_size;
+                len -= chunk_size;
+            }
+        } else {
+            if (_traceWriter) {
+                traceTransaction(0, 0, TRACE_CONTINUE | TRACE_CS_BEGIN | TRACE_CS_END, data, len * sizeof(uint16_t));
+            }
+            spiDev->writeBytes((uint8_t *)data, len * sizeof(uint16_t));
+        }
         spiDev->endTransaction();
         clrCS();
+        PROFILE_ELAPSED(csUs, cs_start);
+        if (_bootFirstFrame) {
+            _bootFirstFrame = false;
+            _bootProfile.firstFrameUs = esp_timer_get_time();
+        }
         return;
     }
 
-    bool first_send = true;
-    uint16_t *p = data;
-    assert(p);
+    assert(data);
     assert(spi);
-    setCS();
-    do {
-        size_t chunk_size = len;
-        spi_transaction_ext_t t = {0};
-        memset(&t, 0, sizeof(t));
-        if (first_send) {
-            t.base.flags = SPI_TRANS_MODE_QIO;
-            t.base.cmd = 0x32 ;
-            t.base.addr = 0x002C00;
-            first_send = 0;
-        } else {
-            t.base.flags = SPI_TRANS_MODE_QIO | SPI_TRANS_VARIABLE_CMD | SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY;
-            t.command_bits = 0;
-            t.address_bits = 0;
-            t.dummy_bits = 0;
-        }
-        if (chunk_size > SEND_BUF_SIZE) {
-            chunk_size = SEND_BUF_SIZE;
-        }
-        t.base.tx_buffer = p;
-        t.base.length = chunk_size * 16;
-        spi_device_polling_transmit(spi, (spi_transaction_t *)&t);
-        len -= chunk_size;
-        p += chunk_size;
-    } while (len > 0);
-    clrCS();
+    if (!len) {
+        return;
+    }
+    _dmaNotify = false;
+    queuePixelsBounce(data, len, true, true, swap);
+    waitDMADone();
 }
 
-void LilyGo_AMOLED::pushColors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data)
+bool LilyGo_AMOLED::setSwapBytes(bool swap)
 {
-
-    if (boards->display.frameBufferSize) {
-        assert(pBuffer);
-        uint16_t _x = this->height() - (y + hight);
-        uint16_t _y = x;
-        uint16_t _h = width;
-        uint16_t _w = hight;
-        uint16_t *p = data;
-        uint32_t cum = 0;
-        for (uint16_t j = 0; j < width; j++) {
-            for (uint16_t i = 0; i < hight; i++) {
-                pBuffer[cum] = ((uint16_t)p[width * (hight - i - 1) + j]);
-                cum++;
-            }
-        }
-        setAddrWindow(_x, _y, _x + _w - 1, _y + _h - 1);
-        pushColors(pBuffer, width * hight);
-    } else {
-        setAddrWindow(x, y, x + width - 1, y + hight - 1);
-        pushColors(data, width * hight);
+    waitDMADone();
+    // Never swap in place, the caller's buffer may still be in use
+    if (swap && !allocBounceBuffers()) {
+        log_e("Byte swap needs a bounce buffer");
+        _swapBytes = false;
+        return false;
     }
+    _swapBytes = swap;
+    return true;
 }
 
-void LilyGo_AMOLED::pushColorsDMA(uint16_t *data, uint32_t len)
+bool LilyGo_AMOLED::setBounceBuffers(uint8_t count, uint32_t chunk_pixels)
 {
-    if (!spi) return;
+    if (count > DISPLAY_BOUNCE_BUF_MAX || (count && !chunk_pixels) || chunk_pixels > DISPLAY_MAX_CHUNK_SIZE) {
+        log_e("Invalid bounce buffer configure, count:%u chunk:%u", count, chunk_pixels);
+        return false;
+    }
+    if (!count && _swapBytes) {
+        log_e("Byte swap needs a bounce buffer, disable it first");
+        return false;
+    }
+    waitDMADone();
+    freeBounceBuffers();
+    _bounceNum = count;
+    _bounceSize = chunk_pixels;
+    if (!count) {
+        return true;
+    }
+    if (!allocBounceBuffers()) {
+        _swapBytes = false;
+        return false;
+    }
+    return true;
+}
 
-    bool first_send = true;
-    setCS();
+// Allocate the bounce ring on first use, returns false if it is disabled or out of memory
+bool LilyGo_AMOLED::allocBounceBuffers()
+{
+    if (_bounceAllocated) {
+        return true;
+    }
+    if (!_bounceNum) {
+        return false;
+    }
+    for (uint8_t i = 0; i < _bounceNum; i++) {
+        _bounceBuffer[i] = (uint16_t *)heap_caps_malloc(_bounceSize * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (!_bounceBuffer[i]) {
+            log_e("Failed to allocate bounce buffer %u of %u bytes", i, _bounceSize * sizeof(uint16_t));
+            freeBounceBuffers();
+            // Do not retry on every transfer
+            _bounceNum = 0;
+            return false;
+        }
+    }
+    _bounceAllocated = _bounceNum;
+    _bounceIndex = 0;
+    return true;
+}
 
-    while (len > 0) {
-        size_t chunk_size = len;
-        if (chunk_size > SEND_BUF_SIZE) {
-            chunk_size = SEND_BUF_SIZE;
+void LilyGo_AMOLED::freeBounceBuffers()
+{
+    for (uint8_t i = 0; i < DISPLAY_BOUNCE_BUF_MAX; i++) {
+        if (_bounceBuffer[i]) {
+            heap_caps_free(_bounceBuffer[i]);
+            _bounceBuffer[i] = NULL;
         }
+    }
+    _bounceAllocated = 0;
+}
 
-        spi_transaction_ext_t t = {0};
-        memset(&t, 0, sizeof(t));
+bool LilyGo_AMOLED::setChunkSize(uint32_t pixels)
+{
+    if (!pixels || pixels > DISPLAY_MAX_CHUNK_SIZE) {
+        log_e("Invalid chunk size %u", pixels);
+        return false;
+    }
+    // Transactions already queued keep their size
+    _chunkSize = pixels;
+    return true;
+}
 
-        if (first_send) {
-            t.base.flags = SPI_TRANS_MODE_QIO;
-            t.base.cmd = 0x32;
-            t.base.addr = 0x002C00;
-            first_send = 0;
-        } else {
-            t.base.flags = SPI_TRANS_MODE_QIO | SPI_TRANS_VARIABLE_CMD | SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY;
-            t.command_bits = 0;
-            t.address_bits = 0;
-            t.dummy_bits = 0;
-        }
+uint32_t LilyGo_AMOLED::getChunkSize()
+{
+    return _chunkSize;
+}
+
+uint32_t LilyGo_AMOLED::autoTuneChunkSize(bool force)
+{
+    static const uint32_t candidates[] = {1024, 2048, 4096, 8192, 16384};
+    const uint8_t rounds = 3;
 
-        t.base.tx_buffer = data;
-        t.base.length = chunk_size * 16;
+    if (!spi) {
+        return _chunkSize;
+    }
 
-        esp_err_t ret = spi_device_queue_trans(spi, &t.base, portMAX_DELAY);
-        if (ret != ESP_OK) {
-            log_e("DMA transfer failed!");
+    char key[16];
+    snprintf(key, sizeof(key), "chunk%u", getBoardID());
+
+    Preferences prefs;
+    bool nvs = prefs.begin("amoled", false);
+    if (nvs && !force) {
+        uint32_t stored = prefs.getUInt(key, 0);
+        if (stored && setChunkSize(stored)) {
+            log_i("Use stored chunk size %u", stored);
+            prefs.end();
+            return _chunkSize;
         }
+    }
 
-        spi_transaction_t *trans_result;
-        ret = spi_device_get_trans_result(spi, &trans_result, portMAX_DELAY);
-        if (ret != ESP_OK) {
-            log_e("DMA SPI transfer failed!");
+    // Window in panel coordinates, the 1.47 inch panel keeps its scan order in every rotation
+    uint16_t cols = boards->display.frameBufferSize ? boards->display.height : width();
+    uint16_t rows = boards->display.frameBufferSize ? boards->display.width : height();
+    uint32_t frame = (uint32_t)cols * rows;
+
+    // A black internal buffer, sent repeatedly to cover the whole frame
+    uint32_t buffer_size = DISPLAY_MAX_CHUNK_SIZE;
+    uint16_t *buffer = (uint16_t *)heap_caps_calloc(buffer_size, sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!buffer) {
+        log_e("Failed to allocate tuning buffer");
+        if (nvs) {
+            prefs.end();
         }
+        return _chunkSize;
+    }
 
-        data += chunk_size;
-        len -= chunk_size;
+    uint32_t best_size = _chunkSize;
+    int64_t best_us = INT64_MAX;
+    _dmaNotify = false;
+    for (uint8_t i = 0; i < sizeof(candidates) / sizeof(*candidates); i++) {
+        setChunkSize(candidates[i]);
+        int64_t start = esp_timer_get_time();
+        for (uint8_t r = 0; r < rounds; r++) {
+            setAddrWindow(0, 0, cols - 1, rows - 1);
+            uint32_t remain = frame;
+            bool first = true;
+            while (remain) {
+                uint32_t n = min(remain, buffer_size);
+                queuePixels(buffer, n, first, n == remain);
+                first = false;
+                remain -= n;
+            }
+            waitDMADone();
+        }
+        int64_t us = (esp_timer_get_time() - start) / rounds;
+        log_i("Chunk size %5u : %lld us per frame", candidates[i], us);
+        if (us < best_us) {
+            best_us = us;
+            best_size = candidates[i];
+        }
     }
+    heap_caps_free(buffer);
 
-    clrCS();
+    setChunkSize(best_size);
+    log_i("Selected chunk size %u, %lld us per frame", best_size, best_us);
+    if (nvs) {
+        prefs.putUInt(key, best_size);
+        prefs.end();
+    }
+    return best_size;
 }
 
-float LilyGo_AMOLED::readCoreTemp()
+void LilyGo_AMOLED::getBounceStats(DisplayBounceStats_t *stats)
 {
-    return temperatureRead();
+    if (!stats) {
+        return;
+    }
+    // The time of a transfer is added when its last chunk is taken back
+    waitDMADone();
+    memcpy(stats, &_bounceStats, sizeof(DisplayBounceStats_t));
+    uint64_t us = _bounceStats.activeUs;
+    stats->kbytesPerSecond = us ? (uint32_t)(_bounceStats.bytes * 1000ULL / us / 1024ULL) : 0;
 }
 
+void LilyGo_AMOLED::resetBounceStats()
+{
+    waitDMADone();
+    memset(&_bounceStats, 0, sizeof(_bounceStats));
+}
 
-void LilyGo_AMOLED::attachPMU(void(*cb)(void))
+/*
+* Rotate the output rows [start, end) of a width x hight area for the frame
+* buffer panel, source rows are stride pixels apart. Rotations 0 and 2 turn
+* source columns into panel rows, rotation 3 mirrors whole source rows,
+* rotation 1 is the panel scan order and is not handled here.
+*/
+static void rotateArea(uint8_t rotation, uint16_t *dst, const uint16_t *src, uint16_t width, uint16_t hight,
+                       uint32_t stride, uint16_t start, uint16_t end, bool swap)
 {
-    assert(boards);
-    if (boards->pmu) {
-        pinMode(boards->pmu->irq, INPUT_PULLUP);
-        attachInterrupt(boards->pmu->irq, cb, FALLING);
+    switch (rotation) {
+    case 2:
+        pixelRotate270Strip(dst, src, stride, hight, width - end, width - start, swap);
+        break;
+    case 3:
+        if (stride == width) {
+            pixelRotate180(dst, src + (uint32_t)(hight - end) * width, width, end - start, swap);
+            break;
+        }
+        for (uint16_t i = start; i < end; i++) {
+            pixelRotate180(dst + (uint32_t)(i - start) * width, src + (uint32_t)(hight - 1 - i) * stride, width, 1, swap);
+        }
+        break;
+    default:
+        pixelRotate90Strip(dst, src, stride, hight, start, end, swap);
+        break;
     }
 }
 
-uint64_t LilyGo_AMOLED::readPMU()
+void LilyGo_AMOLED::pushColors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data)
 {
-    assert(boards);
-    if (!boards->pmu) {
-        return 0;
-    }
-    if (boards == &BOARD_AMOLED_147) {
-        return XPowersAXP2101::getIrqStatus();
-    }
-    return 0;
+    pushRect(x, y, width, hight, data, width);
 }
 
-void LilyGo_AMOLED::clearPMU()
+void LilyGo_AMOLED::pushRect(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data, uint32_t stride)
 {
-    if (boards) {
+    PROFILE_MARK(flush_start);
+
+    if (boards->display.frameBufferSize && _rotation != 1) {
+        // Panel window of the area, the panel scans 90 degrees from rotation 0
+        uint16_t _x, _y, _w, _h;
+        switch (_rotation) {
+        case 2:
+            _x = y;
+            _y = this->width() - (x + width);
+            _w = hight;
+            _h = width;
+            break;
+        case 3:
+            _x = this->width() - (x + width);
+            _y = this->height() - (y + hight);
+            _w = width;
+            _h = hight;
+            break;
+        default:
+            _x = this->height() - (y + hight);
+            _y = x;
+            _w = hight;
+            _h = width;
+            break;
+        }
+        setAddrWindow(_x, _y, _x + _w - 1, _y + _h - 1);
+
+        // Each output row is one panel row of _w pixels
+        uint16_t rows = _h;
+        uint16_t strip_rows = ROTATE_STRIP_SIZE / _w;
+        if (!_rotateBuffer[0] || !_rotateBuffer[1] || !strip_rows) {
+            assert(pBuffer);
+            rotateArea(_rotation, pBuffer, data, width, hight, stride, 0, rows, _swapBytes);
+            pushPixels(pBuffer, width * hight, false);
+            PROFILE_FLUSH_DONE(flush_start);
+            return;
+        }
+
+        // Rotate the next strip into one internal buffer while the other one is being sent
+        _dmaNotify = false;
+        uint8_t index = 0;
+        for (uint16_t row = 0; row < rows; row += strip_rows) {
+            uint16_t row_end = min(row + strip_rows, (int)rows);
+            // Only the previous strip may still be in flight
+            waitDMAInFlight(1);
+            rotateArea(_rotation, _rotateBuffer[index], data, width, hight, stride, row, row_end, _swapBytes);
+            if (!queuePixels(_rotateBuffer[index], (row_end - row) * _w, row == 0, row_end == rows)) {
+                break;
+            }
+            index ^= 1;
+        }
+        waitDMADone();
+    } else if (stride == width) {
+        setAddrWindow(x, y, x + width - 1, y + hight - 1);
+        pushPixels(data, width * hight, _swapBytes);
+    } else {
+        pushRows(x, y, width, hight, data, stride);
+    }
+    PROFILE_FLUSH_DONE(flush_start);
+}
+
+/*
+* Send a sub-area of a larger buffer without touching it. The rows are gathered
+* into the bounce buffers, swapped on the way if needed, and go out as one burst.
+*/
+void LilyGo_AMOLED::pushRows(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data, uint32_t stride)
+{
+    uint16_t band = allocBounceBuffers() ? _bounceSize / width : 0;
+    if (!band) {
+        // No bounce buffer holds a row, one window per row or per piece of a swapped row,
+        // the pieces are swapped into a bounded scratch so the caller's buffer is never written
+        uint16_t scratch[ROW_SCRATCH_SIZE];
+        for (uint16_t i = 0; i < hight; i++) {
+            uint16_t *row = data + (uint32_t)i * stride;
+            if (!_swapBytes) {
+                setAddrWindow(x, y + i, x + width - 1, y + i);
+                pushPixels(row, width, false);
+                continue;
+            }
+            for (uint16_t col = 0; col < width; col += ROW_SCRATCH_SIZE) {
+                uint16_t n = min((uint16_t)ROW_SCRATCH_SIZE, (uint16_t)(width - col));
+                pixelSwapCopy(scratch, row + col, n);
+                setAddrWindow(x + col, y + i, x + col + n - 1, y + i);
+                pushPixels(scratch, n, false);
+            }
+        }
+        return;
+    }
+
+    if (spiDev) {
+        for (uint16_t row = 0; row < hight; row += band) {
+            uint16_t n = min(band, (uint16_t)(hight - row));
+            for (uint16_t i = 0; i < n; i++) {
+                uint16_t *src = data + (uint32_t)(row + i) * stride;
+                uint16_t *dst = _bounceBuffer[0] + (uint32_t)i * width;
+                _swapBytes ? pixelSwapCopy(dst, src, width) : pixelCopy(dst, src, width);
+            }
+            setAddrWindow(x, y + row, x + width - 1, y + row + n - 1);
+            pushPixels(_bounceBuffer[0], n * width, false);
+        }
+        return;
+    }
+
+    setAddrWindow(x, y, x + width - 1, y + hight - 1);
+    _dmaNotify = false;
+    _bounceStats.transfers++;
+    _bounceTimed = true;
+    for (uint16_t row = 0; row < hight; row += band) {
+        uint16_t n = min(band, (uint16_t)(hight - row));
+        // Keep one buffer free to fill while the others are on the bus
+        waitDMAInFlight(_bounceAllocated - 1);
+        uint16_t *buf = _bounceBuffer[_bounceIndex];
+        for (uint16_t i = 0; i < n; i++) {
+            uint16_t *src = data + (uint32_t)(row + i) * stride;
+            uint16_t *dst = buf + (uint32_t)i * width;
+            _swapBytes ? pixelSwapCopy(dst, src, width) : pixelCopy(dst, src, width);
+        }
+        _bounceStats.bytes += n * width * sizeof(uint16_t);
+        if (!queuePixels(buf, n * width, row == 0, row + n == hight)) {
+            break;
+        }
+        _bounceIndex = (_bounceIndex + 1) % _bounceAllocated;
+    }
+    _bounceTimed = false;
+    waitDMADone();
+}
+
+void IRAM_ATTR LilyGo_AMOLED::dmaPreCallback(spi_transaction_t *t)
+{
+    // Polling transactions have user set to NULL and handle CS themselves
+    DisplayTransaction_t *d = (DisplayTransaction_t *)t->user;
+    if (d && (d->flags & TRANS_CS_BEGIN)) {
+        if (!d->owner->_hardwareCS) {
+            gpio_set_level((gpio_num_t)d->owner->boards->display.cs, 0);
+        }
+#if DISPLAY_PROFILE
+        d->owner->_profileCSStart = esp_timer_get_time();
+#endif
+    }
+}
+
+void IRAM_ATTR LilyGo_AMOLED::dmaPostCallback(spi_transaction_t *t)
+{
+    DisplayTransaction_t *d = (DisplayTransaction_t *)t->user;
+    if (!d) {
+        return;
+    }
+    LilyGo_AMOLED *self = d->owner;
+    if (d->flags & TRANS_BOUNCE_END) {
+        // Read by the task once the result is taken back
+        d->doneUs = esp_timer_get_time();
+    }
+    if (d->flags & TRANS_CS_END) {
+        if (!self->_hardwareCS) {
+            gpio_set_level((gpio_num_t)self->boards->display.cs, 1);
+        }
+#if DISPLAY_PROFILE
+        int64_t cs_us = esp_timer_get_time() - self->_profileCSStart;
+        portENTER_CRITICAL_ISR(&self->_profileLock);
+        self->_profile.csUs += cs_us;
+        portEXIT_CRITICAL_ISR(&self->_profileLock);
+#endif
+    }
+#if DISPLAY_PROFILE
+    if (d->flags & TRANS_NOTIFY) {
+        self->profileFlushDone(d->flushStartUs, true);
+    }
+#endif
+    if ((d->flags & TRANS_NOTIFY) && self->_dmaDoneCb) {
+        self->_dmaDoneCb(self->_dmaDoneUserData);
+    }
+}
+
+bool LilyGo_AMOLED::setDMADoneCallback(DisplayDMADoneCallback cb, void *user_data)
+{
+    waitDMADone();
+    _dmaDoneUserData = user_data;
+    _dmaDoneCb = cb;
+    // Only the QSPI bus supports queued transfers
+    return spiDev == NULL;
+}
+
+void LilyGo_AMOLED::waitDMADone()
+{
+    waitDMAInFlight(0);
+}
+
+void LilyGo_AMOLED::waitDMAInFlight(uint8_t count)
+{
+    spi_transaction_t *trans_result;
+    if (_dmaInFlight <= count) {
+        return;
+    }
+    PROFILE_MARK(wait_start);
+    while (_dmaInFlight > count) {
+        if (spi_device_get_trans_result(spi, &trans_result, portMAX_DELAY) != ESP_OK) {
+            log_e("DMA SPI transfer failed!");
+        } else {
+            // Results come back in queue order, a transfer that overlaps the previous one adds the rest only
+            DisplayTransaction_t *d = (DisplayTransaction_t *)trans_result->user;
+            if (d && (d->flags & TRANS_BOUNCE_END)) {
+                _bounceStats.activeUs += d->doneUs - max(d->startUs, _bounceDoneUs);
+                _bounceDoneUs = d->doneUs;
+            }
+        }
+        _dmaInFlight--;
+    }
+    PROFILE_ELAPSED(waitUs, wait_start);
+}
+
+// Recycle transaction descriptors from the pool, the oldest one is reclaimed
+// once all of them are in flight
+LilyGo_AMOLED::DisplayTransaction_t *LilyGo_AMOLED::getDMATransaction()
+{
+    waitDMAInFlight(DISPLAY_DMA_QUEUE_SIZE - 1);
+    DisplayTransaction_t *d = &_dmaTrans[_dmaHead];
+    _dmaHead = (_dmaHead + 1) % DISPLAY_DMA_QUEUE_SIZE;
+    memset(&d->ext, 0, sizeof(spi_transaction_ext_t));
+    d->ext.base.user = d;
+    d->owner = this;
+    d->flags = 0;
+    return d;
+}
+
+// Queue a single command, CS is toggled around it by the transaction callbacks
+bool LilyGo_AMOLED::queueCommand(uint32_t cmd, const uint8_t *pdat, uint32_t length)
+{
+    if (cmd == LCD_CMD_CASET || cmd == LCD_CMD_RASET) {
+        _addrWindowValid = false;
+    }
+
+    DisplayTransaction_t *d = getDMATransaction();
+    spi_transaction_t *t = &d->ext.base;
+    d->flags = TRANS_CS_BEGIN | TRANS_CS_END;
+    t->flags = (SPI_TRANS_MULTILINE_CMD | SPI_TRANS_MULTILINE_ADDR);
+    t->cmd = 0x02;
+    t->addr = cmd << 8;
+    if (pdat && length) {
+        if (length > sizeof(d->param)) {
+            length = sizeof(d->param);
+        }
+        if (length <= sizeof(t->tx_data)) {
+            t->flags |= SPI_TRANS_USE_TXDATA;
+            memcpy(t->tx_data, pdat, length);
+        } else {
+            memcpy(d->param, pdat, length);
+            t->tx_buffer = d->param;
+        }
+        t->length = 8 * length;
+    }
+
+    if (spi_device_queue_trans(spi, t, portMAX_DELAY) != ESP_OK) {
+        log_e("Queue command 0x%02X failed!", cmd);
+        return false;
+    }
+    if (_traceWriter) {
+        traceTransaction(0x02, t->addr, TRACE_CS_BEGIN | TRACE_CS_END, pdat, t->length / 8);
+    }
+    _dmaInFlight++;
+    PROFILE_ADD(commands, 1);
+    return true;
+}
+
+void LilyGo_AMOLED::writeCommands(const lcd_cmd_t *cmds, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t length = cmds[i].len & 0x1F;
+        if (spi) {
+            queueCommand(cmds[i].addr, cmds[i].param, length);
+        } else {
+            writeCommand(cmds[i].addr, (uint8_t *)cmds[i].param, length);
+        }
+        if (cmds[i].len & 0xA0) {
+            waitDMADone();
+            if (cmds[i].len & 0x80) {
+                delay(120);
+            }
+            if (cmds[i].len & 0x20) {
+                delay(10);
+            }
+        }
+    }
+}
+
+/*
+* Decode the packed entries in batches, the commands of a batch are queued back
+* to back and writeCommands flushes the queue before every delay.
+*/
+void LilyGo_AMOLED::writeInitSequence(const lcd_init_t *seq)
+{
+    lcd_cmd_t batch[8];
+    uint32_t count = 0;
+    const uint8_t *p = seq->data;
+    const uint8_t *end = seq->data + seq->size;
+    while (p + 2 <= end) {
+        lcd_cmd_t *t = &batch[count++];
+        uint32_t length = p[1] & 0x1F;
+        t->addr = p[0];
+        t->len = p[1];
+        memcpy(t->param, p + 2, min(length, (uint32_t)sizeof(t->param)));
+        p += 2 + length;
+        if (count == sizeof(batch) / sizeof(*batch)) {
+            writeCommands(batch, count);
+            count = 0;
+        }
+    }
+    writeCommands(batch, count);
+    waitDMADone();
+}
+
+/*
+* Queue pixel data as one RAMWR burst.
+* The first chunk carries the write command and asserts CS, the last chunk
+* releases CS and, if requested, notifies the DMA done callback.
+*/
+bool LilyGo_AMOLED::queuePixels(uint16_t *data, uint32_t len, bool first, bool last)
+{
+    while (len > 0) {
+        size_t chunk_size = len;
+        if (chunk_size > _chunkSize) {
+            chunk_size = _chunkSize;
+        }
+
+        DisplayTransaction_t *d = getDMATransaction();
+        spi_transaction_ext_t *t = &d->ext;
+
+        if (first) {
+            t->base.flags = SPI_TRANS_MODE_QIO;
+            t->base.cmd = 0x32;
+            t->base.addr = 0x002C00;
+            d->flags |= TRANS_CS_BEGIN;
+            first = false;
+            if (_bounceTimed) {
+                _bounceStartUs = esp_timer_get_time();
+            }
+        } else {
+            t->base.flags = SPI_TRANS_MODE_QIO | SPI_TRANS_VARIABLE_CMD | SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY;
+            t->command_bits = 0;
+            t->address_bits = 0;
+            t->dummy_bits = 0;
+        }
+
+        t->base.tx_buffer = data;
+        t->base.length = chunk_size * 16;
+        if (last && chunk_size == len) {
+            d->flags |= TRANS_CS_END;
+            if (_dmaNotify) {
+                d->flags |= TRANS_NOTIFY;
+#if DISPLAY_PROFILE
+                // The next flush may start before this one is done
+                d->flushStartUs = _profileFlushStart;
+#endif
+            }
+            if (_bounceTimed) {
+                d->flags |= TRANS_BOUNCE_END;
+                d->startUs = _bounceStartUs;
+            }
+            if (_bootFirstFrame) {
+                _bootFirstFrame = false;
+                _bootProfile.firstFrameUs = esp_timer_get_time();
+            }
+        }
+#ifdef SPI_TRANS_CS_KEEP_ACTIVE
+        else if (_hardwareCS) {
+            // Hold CS between the chunks of one burst
+            t->base.flags |= SPI_TRANS_CS_KEEP_ACTIVE;
+        }
+#endif
+
+        esp_err_t ret = spi_device_queue_trans(spi, &t->base, portMAX_DELAY);
+        if (ret != ESP_OK) {
+            log_e("DMA transfer failed!");
+            waitDMADone();
+            clrCS();
+            if (_dmaNotify && _dmaDoneCb) {
+                _dmaDoneCb(_dmaDoneUserData);
+            }
+            return false;
+        }
+        _dmaInFlight++;
+        PROFILE_ADD(transactions, 1);
+        PROFILE_ADD(bytes, chunk_size * sizeof(uint16_t));
+        if (_traceWriter) {
+            uint8_t flags = TRACE_QIO;
+            flags |= (d->flags & TRANS_CS_BEGIN) ? TRACE_CS_BEGIN : TRACE_CONTINUE;
+            flags |= (d->flags & TRANS_CS_END) ? TRACE_CS_END : 0;
+            traceTransaction(t->base.cmd, t->base.addr, flags, data, chunk_size * sizeof(uint16_t));
+        }
+
+        data += chunk_size;
+        len -= chunk_size;
+    }
+    return true;
+}
+
+/*
+* Stage PSRAM resident or byte swapped pixel data through the ring of internal
+* SRAM bounce buffers, each chunk is copied (and swapped if requested) while the
+* previous ones are being sent. Internal SRAM data that needs no swap is queued
+* as is. When a bounce buffer was used, the source is no longer referenced when
+* this returns. A swap without a bounce buffer is refused, the source is never
+* swapped in place.
+*/
+bool LilyGo_AMOLED::queuePixelsBounce(uint16_t *data, uint32_t len, bool first, bool last, bool swap)
+{
+    if (!(swap || esp_ptr_external_ram(data)) || !allocBounceBuffers()) {
+        if (swap) {
+            log_e("Byte swap needs a bounce buffer");
+            return false;
+        }
+        return queuePixels(data, len, first, last);
+    }
+
+    _bounceStats.transfers++;
+    _bounceTimed = true;
+    while (len > 0) {
+        uint32_t chunk_size = min(len, _bounceSize);
+        int64_t start = esp_timer_get_time();
+        // The transaction that last used this buffer is at least _bounceAllocated - 1 transactions old
+        waitDMAInFlight(_bounceAllocated - 1);
+        int64_t ready = esp_timer_get_time();
+        uint16_t *buf = _bounceBuffer[_bounceIndex];
+        if (swap) {
+            pixelSwapCopy(buf, data, chunk_size);
+        } else {
+            memcpy(buf, data, chunk_size * sizeof(uint16_t));
+        }
+        _bounceStats.stallUs += ready - start;
+        _bounceStats.copyUs += esp_timer_get_time() - ready;
+        _bounceStats.bytes += chunk_size * sizeof(uint16_t);
+        if (!queuePixels(buf, chunk_size, first, last && chunk_size == len)) {
+            _bounceTimed = false;
+            return false;
+        }
+        _bounceIndex = (_bounceIndex + 1) % _bounceAllocated;
+        first = false;
+        data += chunk_size;
+        len -= chunk_size;
+    }
+    _bounceTimed = false;
+    return true;
+}
+
+void LilyGo_AMOLED::pushColorsDMA(uint16_t *data, uint32_t len)
+{
+    if (!spi) {
+        if (spiDev) {
+            pushColors(data, len);
+            if (_dmaDoneCb) {
+                _dmaDoneCb(_dmaDoneUserData);
+            }
+        }
+        return;
+    }
+
+    if (!len) {
+        return;
+    }
+
+    // Queued behind any pending commands, CS is handled by the transaction callbacks
+    _dmaNotify = true;
+#if DISPLAY_PROFILE
+    _profileFlushStart = esp_timer_get_time();
+#endif
+    if (!queuePixelsBounce(data, len, true, true, _swapBytes)) {
+        return;
+    }
+
+    if (!_dmaDoneCb) {
+        waitDMADone();
+    }
+}
+
+float LilyGo_AMOLED::readCoreTemp()
+{
+    return temperatureRead();
+}
+
+
+void LilyGo_AMOLED::attachPMU(void(*cb)(void))
+{
+    assert(boards);
+    if (boards->pmu) {
+        pinMode(boards->pmu->irq, INPUT_PULLUP);
+        attachInterrupt(boards->pmu->irq, cb, FALLING);
+    }
+}
+
+uint64_t LilyGo_AMOLED::readPMU()
+{
+    assert(boards);
+    if (!boards->pmu) {
+        return 0;
+    }
+    if (boards == &BOARD_AMOLED_147) {
+        return XPowersAXP2101::getIrqStatus();
+    }
+    return 0;
+}
+
+void LilyGo_AMOLED::clearPMU()
+{
+    if (boards) {
         if (boards->pmu && (boards == &BOARD_AMOLED_147)) {
             log_i("clearPMU");
             XPowersAXP2101::clearIrqStatus();
@@ -1076,6 +2083,9 @@ void LilyGo_AMOLED::sleep(bool touchpad_sleep_enable)
 {
     assert(boards);
 
+    // The sampler must not read the controller while it goes to sleep
+    stopTouchSampler();
+
     //Wire amoled to sleep mode
     lcd_cmd_t t = {LCD_CMD_SLPIN, {0x00}, 1}; //Sleep in
     writeCommand(t.addr, t.param, t.len);
@@ -1174,107 +2184,37 @@ bool LilyGo_AMOLED::hasOTG()
 
 void LilyGo_AMOLED::setRotation(uint8_t rotation)
 {
-    uint8_t data = 0x00;
+    if (!boards || !boards->display.rotation) {
+        log_e("The screen you are currently using does not support screen rotation!!!");
+        return;
+    }
     rotation %= 4;
     _rotation = rotation;
-    if (boards == &BOARD_AMOLED_191 || boards == &BOARD_AMOLED_191_SPI) {
-        switch (_rotation) {
-        case 1:
-            data = RM67162_MADCTL_RGB;
-            _height = boards->display.height;
-            _width = boards->display.width;
-            if (_touchOnline) {
-                TouchDrvCSTXXX::setMaxCoordinates(_width, _height);
-                TouchDrvCSTXXX::setSwapXY(true);
-                TouchDrvCSTXXX::setMirrorXY(true, false);
-            }
-            break;
-        case 2:
-            data = RM67162_MADCTL_MV | RM67162_MADCTL_MY | RM67162_MADCTL_RGB;
-            _height = boards->display.width;
-            _width = boards->display.height;
-            if (_touchOnline) {
-                TouchDrvCSTXXX::setMaxCoordinates(_width, _height);
-                TouchDrvCSTXXX::setSwapXY(false);
-                TouchDrvCSTXXX::setMirrorXY(true, true);
-            }
-            break;
-        case 3:
-            data = RM67162_MADCTL_MX | RM67162_MADCTL_MY | RM67162_MADCTL_RGB;
-            _height = boards->display.height;
-            _width = boards->display.width;
-            if (_touchOnline) {
-                TouchDrvCSTXXX::setMaxCoordinates(_width, _height);
-                TouchDrvCSTXXX::setSwapXY(true);
-                TouchDrvCSTXXX::setMirrorXY(false, true);
-            }
-            break;
-        default:
-            data = RM67162_MADCTL_MX | RM67162_MADCTL_MV | RM67162_MADCTL_RGB;
-            _height = boards->display.width;
-            _width = boards->display.height;
-            if (_touchOnline) {
-                TouchDrvCSTXXX::setMaxCoordinates(_width, _height);
-                TouchDrvCSTXXX::setSwapXY(false);
-                TouchDrvCSTXXX::setMirrorXY(false, false);
-            }
-            break;
-        }
-        writeCommand(LCD_CMD_MADCTL, &data, 1);
-    } else if (boards == &BOARD_AMOLED_241) {
-        switch (_rotation) {
-        case 1:
-            _offset_x = 16;
-            _offset_y = 0;
-            data = RM690B0_MADCTL_RGB;
-            _height = boards->display.width;
-            _width = boards->display.height;
-            if (_touchOnline) {
-                TouchDrvCSTXXX::setMaxCoordinates(_width, _height);
-                TouchDrvCSTXXX::setSwapXY(false);
-                TouchDrvCSTXXX::setMirrorXY(false, false);
-            }
-            break;
-        case 2:
-            _offset_x = 0;
-            _offset_y = 16;
-            data = RM690B0_MADCTL_MV | RM690B0_MADCTL_MY | RM690B0_MADCTL_RGB;
-            _height = boards->display.height;
-            _width = boards->display.width;
-            if (_touchOnline) {
-                TouchDrvCSTXXX::setMaxCoordinates(_width, _height);
-                TouchDrvCSTXXX::setSwapXY(true);
-                TouchDrvCSTXXX::setMirrorXY(true, false);
-            }
-            break;
-        case 3:
-            _offset_x = 16;
-            _offset_y = 0;
-            data = RM690B0_MADCTL_MX | RM690B0_MADCTL_MY | RM690B0_MADCTL_RGB;
-            _height = boards->display.width;
-            _width = boards->display.height;
-            if (_touchOnline) {
-                TouchDrvCSTXXX::setMaxCoordinates(_width, _height);
-                TouchDrvCSTXXX::setSwapXY(false);
-                TouchDrvCSTXXX::setMirrorXY(true, true);
-            }
-            break;
-        default:
-            _offset_x = 0;
-            _offset_y = 16;
-            data = RM690B0_MADCTL_MX | RM690B0_MADCTL_MV | RM690B0_MADCTL_RGB;
-            _height = boards->display.height;
-            _width = boards->display.width;
-            if (_touchOnline) {
-                TouchDrvCSTXXX::setMaxCoordinates(_width, _height);
-                TouchDrvCSTXXX::setSwapXY(true);
-                TouchDrvCSTXXX::setMirrorXY(false, true);
-            }
-            break;
+    // Offsets and scan direction change, the cached address window is no longer valid
+    _addrWindowValid = false;
+
+    const DisplayRotation_t *r = &boards->display.rotation[_rotation];
+    _width = r->swapSize ? boards->display.height : boards->display.width;
+    _height = r->swapSize ? boards->display.width : boards->display.height;
+    _offset_x = r->offsetX;
+    _offset_y = r->offsetY;
+
+    if (_touchOnline) {
+        if (boards == &BOARD_AMOLED_147) {
+            TouchDrvCHSC5816::setMaxCoordinates(_width, _height);
+            TouchDrvCHSC5816::setSwapXY(r->touchSwapXY);
+            TouchDrvCHSC5816::setMirrorXY(r->touchMirrorX, r->touchMirrorY);
+        } else {
+            TouchDrvCSTXXX::setMaxCoordinates(_width, _height);
+            TouchDrvCSTXXX::setSwapXY(r->touchSwapXY);
+            TouchDrvCSTXXX::setMirrorXY(r->touchMirrorX, r->touchMirrorY);
         }
+    }
+
+    // The frame buffer panel keeps its scan order, pushColors rotates the pixels instead
+    if (!boards->display.frameBufferSize) {
+        uint8_t data = r->madctl;
         writeCommand(LCD_CMD_MADCTL, &data, 1);
-    } else {
-        log_e("The screen you are currently using does not support screen rotation!!!");
     }
 }
 
@@ -1291,7 +2231,448 @@ bool LilyGo_AMOLED::needFullRefresh()
     return false;
 }
 
+bool LilyGo_AMOLED::needSoftRotation()
+{
+    if (boards) {
+        return boards->display.frameBufferSize != 0;
+    }
+    return false;
+}
+
+uint32_t LilyGo_AMOLED::getAreaSetupUs()
+{
+    if (!boards) {
+        return 0;
+    }
+    // CASET + RASET + RAMWR, each one 8 bit command, 24 bit address and up to 4 parameter bytes on a single line,
+    // plus the first pixel transaction
+    uint32_t bits = 3 * (boards->display.cmdBit + boards->display.addBit + 32);
+    uint32_t bus_us = (bits * 1000000ULL) / boards->display.freq;
+    if (spiDev) {
+        // The SPI interface sends command and data separately
+        return bus_us + 6 * DISPLAY_SPI_TRANS_OVERHEAD_US;
+    }
+    return bus_us + 4 * DISPLAY_QSPI_TRANS_OVERHEAD_US;
+}
+
+uint32_t LilyGo_AMOLED::getBusBytesPerSecond()
+{
+    if (!boards) {
+        return 0;
+    }
+    uint32_t lanes = spiDev ? 1 : 4;
+    return (boards->display.freq / 8) * lanes;
+}
+
 bool LilyGo_AMOLED::hasRTC()
 {
     return _hasRTC;
-}
\ No newline at end of file
+}
+
+void IRAM_ATTR LilyGo_AMOLED::teISR(void *arg)
+{
+    LilyGo_AMOLED *self = (LilyGo_AMOLED *)arg;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    self->_teTimestamp = esp_timer_get_time();
+    self->_teCount++;
+    xSemaphoreGiveFromISR(self->_teSemaphore, &xHigherPriorityTaskWoken);
+    if (xHigherPriorityTaskWoken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+bool LilyGo_AMOLED::setTESync(DisplayTESync mode, uint32_t timeout_ms)
+{
+    if (!boards || boards->display.te == -1) {
+        return false;
+    }
+
+    if (mode == _teMode) {
+        _teTimeout = timeout_ms;
+        return true;
+    }
+
+    if (mode == TE_SYNC_DISABLE) {
+        detachInterrupt(boards->display.te);
+        _teMode = TE_SYNC_DISABLE;
+        return true;
+    }
+
+    if (!_teSemaphore) {
+        _teSemaphore = xSemaphoreCreateBinary();
+        if (!_teSemaphore) {
+            log_e("Failed to create TE semaphore");
+            return false;
+        }
+    }
+
+    // RM67162 does not turn on the TE output in its init sequence
+    uint8_t data = 0x00;    // V-Blanking information only
+    writeCommand(LCD_CMD_TEON, &data, 1);
+
+    _teTimeout = timeout_ms;
+    _teMode = mode;
+    pinMode(boards->display.te, INPUT);
+    attachInterruptArg(boards->display.te, teISR, this, RISING);
+    return true;
+}
+
+DisplayTESync LilyGo_AMOLED::getTESync()
+{
+    return _teMode;
+}
+
+void LilyGo_AMOLED::waitVSync()
+{
+    PROFILE_ADD(frames, 1);
+    if (_traceWriter) {
+        traceTransaction(0, 0, TRACE_FRAME, NULL, 0);
+    }
+
+    if (_teMode == TE_SYNC_DISABLE) {
+        return;
+    }
+
+    int64_t start = esp_timer_get_time();
+
+    // Drop an edge that happened while nobody was waiting, the frame must start at the next one
+    xSemaphoreTake(_teSemaphore, 0);
+    bool synced = xSemaphoreTake(_teSemaphore, pdMS_TO_TICKS(_teTimeout)) == pdTRUE;
+
+    int64_t now = esp_timer_get_time();
+    _teStats.frames++;
+    _teStats.lastWaitUs = now - start;
+    if (_teStats.lastWaitUs > _teStats.maxWaitUs) {
+        _teStats.maxWaitUs = _teStats.lastWaitUs;
+    }
+    if (!synced) {
+        _teStats.missed++;
+        return;
+    }
+    _teStats.lastLatencyUs = now - _teTimestamp;
+    if (_teStats.lastLatencyUs > _teStats.maxLatencyUs) {
+        _teStats.maxLatencyUs = _teStats.lastLatencyUs;
+    }
+    _teStats.totalLatencyUs += _teStats.lastLatencyUs;
+}
+
+void LilyGo_AMOLED::getTEStats(DisplayTEStats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    memcpy(stats, &_teStats, sizeof(DisplayTEStats_t));
+    stats->vsyncs = _teCount;
+}
+
+void LilyGo_AMOLED::resetTEStats()
+{
+    memset(&_teStats, 0, sizeof(_teStats));
+    _teCount = 0;
+}
+
+void IRAM_ATTR LilyGo_AMOLED::touchISR(void *arg)
+{
+    LilyGo_AMOLED *self = (LilyGo_AMOLED *)arg;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    portENTER_CRITICAL_ISR(&self->_touchLock);
+    self->_touchIrqUs = esp_timer_get_time();
+    self->_touchStats.interrupts++;
+    portEXIT_CRITICAL_ISR(&self->_touchLock);
+    vTaskNotifyGiveFromISR(self->_touchTask, &xHigherPriorityTaskWoken);
+    if (xHigherPriorityTaskWoken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/*
+* Every sample is queued while a finger is down, so the consumer sees the
+* whole path, and one release when it is lifted. An interrupt without a
+* finger down, e.g. the controller waking up, queues nothing. Every sample
+* that is queued is also published as the latest one for getPoint, even when
+* the ring is full and drops it.
+*/
+void LilyGo_AMOLED::touchSamplerTask(void *arg)
+{
+    LilyGo_AMOLED *self = (LilyGo_AMOLED *)arg;
+    bool pressed = false;
+    while (self->_touchRunning) {
+        uint32_t edges = ulTaskNotifyTake(pdTRUE, pressed ? pdMS_TO_TICKS(self->_touchReleaseMs) : portMAX_DELAY);
+        if (!self->_touchRunning) {
+            break;
+        }
+        TouchEvent_t event;
+        int16_t x[2] = {0, 0}, y[2] = {0, 0};
+        memset(&event, 0, sizeof(event));
+        portENTER_CRITICAL(&self->_touchLock);
+        int64_t irqUs = self->_touchIrqUs;
+        portEXIT_CRITICAL(&self->_touchLock);
+        event.timestamp = edges ? irqUs : esp_timer_get_time();
+        event.points = self->_disableTouch ? 0 : self->readTouch(x, y, 2);
+        event.x = x[0];
+        event.y = y[0];
+        event.x2 = event.points > 1 ? x[1] : 0;
+        event.y2 = event.points > 1 ? y[1] : 0;
+        bool queue = event.points || pressed;
+        pressed = event.points != 0;
+        bool queued = queue && self->_touchRing.push(event);
+        uint32_t latency = (uint32_t)(esp_timer_get_time() - event.timestamp);
+
+        portENTER_CRITICAL(&self->_touchLock);
+        self->_touchStats.reads++;
+        if (queue) {
+            self->_touchLatest.store(event);
+        }
+        if (queued) {
+            self->_touchStats.events++;
+            self->_touchStats.lastLatencyUs = latency;
+            if (latency > self->_touchStats.maxLatencyUs) {
+                self->_touchStats.maxLatencyUs = latency;
+            }
+        }
+        portEXIT_CRITICAL(&self->_touchLock);
+    }
+    self->_touchTask = NULL;
+    vTaskDelete(NULL);
+}
+
+bool LilyGo_AMOLED::startTouchSampler(uint8_t priority, uint32_t release_ms)
+{
+    if (!hasTouch() || boards->touch->irq == -1) {
+        return false;
+    }
+    _touchReleaseMs = release_ms ? release_ms : 1;
+    if (_touchTask) {
+        return true;
+    }
+    _touchRing.clear();
+    _touchLatest.clear();
+    _touchRunning = true;
+    if (xTaskCreate(touchSamplerTask, "touch", 3 * 1024, this, priority, &_touchTask) != pdPASS) {
+        log_e("Failed to create the touch sampler task");
+        _touchRunning = false;
+        _touchTask = NULL;
+        return false;
+    }
+    pinMode(boards->touch->irq, INPUT_PULLUP);
+    attachInterruptArg(boards->touch->irq, touchISR, this, FALLING);
+    return true;
+}
+
+void LilyGo_AMOLED::stopTouchSampler()
+{
+    if (!_touchTask) {
+        return;
+    }
+    detachInterrupt(boards->touch->irq);
+    _touchRunning = false;
+    xTaskNotifyGive(_touchTask);
+    // The task clears the handle right before it deletes itself
+    while (_touchTask) {
+        delay(1);
+    }
+    _touchRing.clear();
+    _touchLatest.clear();
+}
+
+bool LilyGo_AMOLED::hasTouchSampler()
+{
+    return _touchTask != NULL;
+}
+
+bool LilyGo_AMOLED::readTouchEvent(TouchEvent_t *event)
+{
+    if (!_touchTask || !_touchRing.pop(event)) {
+        return false;
+    }
+    if (_disableTouch) {
+        event->points = 0;
+    }
+    return true;
+}
+
+uint32_t LilyGo_AMOLED::getTouchEventsPending()
+{
+    return _touchTask ? _touchRing.available() : 0;
+}
+
+bool LilyGo_AMOLED::getTouchFilter(TouchFilterConfig_t *config)
+{
+    if (!boards || !boards->touchFilter || !config) {
+        return false;
+    }
+    *config = *boards->touchFilter;
+    return true;
+}
+
+void LilyGo_AMOLED::getTouchStats(TouchSamplerStats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    portENTER_CRITICAL(&_touchLock);
+    memcpy(stats, &_touchStats, sizeof(TouchSamplerStats_t));
+    portEXIT_CRITICAL(&_touchLock);
+    stats->dropped = _touchRing.dropped();
+}
+
+void LilyGo_AMOLED::resetTouchStats()
+{
+    portENTER_CRITICAL(&_touchLock);
+    memset(&_touchStats, 0, sizeof(_touchStats));
+    portEXIT_CRITICAL(&_touchLock);
+    _touchRing.resetDropped();
+}
+
+#if DISPLAY_PROFILE
+// Called from the transaction done interrupt for pushColorsDMA, isr set, and from the blocking flushes
+void IRAM_ATTR LilyGo_AMOLED::profileFlushDone(int64_t start, bool isr)
+{
+    uint32_t us = esp_timer_get_time() - start;
+    uint8_t bucket = 0;
+    uint32_t bound = PROFILE_BUCKET_FIRST_US;
+    while (bucket < DISPLAY_PROFILE_BUCKETS - 1 && us > bound) {
+        bound <<= 1;
+        bucket++;
+    }
+    if (isr) {
+        portENTER_CRITICAL_ISR(&_profileLock);
+    } else {
+        portENTER_CRITICAL(&_profileLock);
+    }
+    _profile.histogram[bucket]++;
+    _profile.flushes++;
+    _profile.lastFlushUs = us;
+    if (us > _profile.maxFlushUs) {
+        _profile.maxFlushUs = us;
+    }
+    if (isr) {
+        portEXIT_CRITICAL_ISR(&_profileLock);
+    } else {
+        portEXIT_CRITICAL(&_profileLock);
+    }
+}
+#endif
+
+bool LilyGo_AMOLED::startTrace(DisplayTraceWriter writer, void *user_data, bool payload)
+{
+    if (!boards || !writer) {
+        return false;
+    }
+    // Records are written in queue order, start from an idle bus
+    waitDMADone();
+    // Large enough for every rotation, the offsets move between the axes
+    uint16_t gram = max(boards->display.width, boards->display.height) + _offset_x + _offset_y;
+    DisplayTraceHeader_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = DISPLAY_TRACE_MAGIC;
+    header.version = DISPLAY_TRACE_VERSION;
+    header.gramWidth = gram;
+    header.gramHeight = gram;
+    header.lanes = spiDev ? 1 : 4;
+    header.freq = boards->display.freq;
+    if (writer(&header, sizeof(header), user_data) != sizeof(header)) {
+        log_e("Failed to write trace header");
+        return false;
+    }
+    _tracePayload = payload;
+    _traceUserData = user_data;
+    _traceWriter = writer;
+    // The next window must be sent in full for the trace to be replayable
+    _addrWindowValid = false;
+    return true;
+}
+
+size_t LilyGo_AMOLED::tracePrintWriter(const void *data, size_t len, void *user_data)
+{
+    return ((Print *)user_data)->write((const uint8_t *)data, len);
+}
+
+bool LilyGo_AMOLED::startTrace(Print &out, bool payload)
+{
+    return startTrace(tracePrintWriter, &out, payload);
+}
+
+void LilyGo_AMOLED::stopTrace()
+{
+    waitDMADone();
+    _traceWriter = NULL;
+    _traceUserData = NULL;
+}
+
+void LilyGo_AMOLED::traceTransaction(uint8_t cmd, uint32_t addr, uint8_t flags, const void *data, uint32_t length)
+{
+    DisplayTraceRecord_t record;
+    record.timestamp = (uint32_t)esp_timer_get_time();
+    record.addr = addr;
+    record.length = length;
+    record.cmd = cmd;
+    if (_tracePayload && data && length) {
+        flags |= TRACE_PAYLOAD;
+    }
+    record.flags = flags;
+    _traceWriter(&record, sizeof(record), _traceUserData);
+    if (flags & TRACE_PAYLOAD) {
+        _traceWriter(data, length, _traceUserData);
+    }
+}
+
+bool LilyGo_AMOLED::getProfile(DisplayProfile_t *profile)
+{
+#if DISPLAY_PROFILE
+    if (!profile) {
+        return false;
+    }
+    int64_t now = esp_timer_get_time();
+    // One consistent snapshot, the 64 bit counters can not be read in one access
+    portENTER_CRITICAL(&_profileLock);
+    memcpy(profile, &_profile, sizeof(DisplayProfile_t));
+    portEXIT_CRITICAL(&_profileLock);
+    profile->elapsedUs = now - _profileStart;
+    profile->kbytesPerSecond = profile->csUs ? (uint32_t)(profile->bytes * 1000ULL / profile->csUs / 1024ULL) : 0;
+    profile->fps = profile->elapsedUs ? profile->frames * 1000000.0f / profile->elapsedUs : 0;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void LilyGo_AMOLED::resetProfile()
+{
+#if DISPLAY_PROFILE
+    waitDMADone();
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&_profileLock);
+    memset(&_profile, 0, sizeof(_profile));
+    portEXIT_CRITICAL(&_profileLock);
+    _profileStart = now;
+#endif
+}
+
+bool LilyGo_AMOLED::dumpProfile(Print &out, DisplayProfileFormat format)
+{
+    DisplayProfile_t p;
+    if (!getProfile(&p)) {
+        return false;
+    }
+    if (format == PROFILE_FORMAT_BINARY) {
+        const uint8_t version = 1;
+        out.write((const uint8_t *)"DPRF", 4);
+        out.write(version);
+        out.write((const uint8_t *)&p, sizeof(p));
+        return true;
+    }
+    out.print("flushes,frames,commands,transactions,bytes,cs_us,wait_us,last_flush_us,max_flush_us");
+    for (uint8_t i = 0; i < DISPLAY_PROFILE_BUCKETS - 1; i++) {
+        out.printf(",le%u", PROFILE_BUCKET_FIRST_US << i);
+    }
+    out.println(",gt_last,elapsed_us,kbps,fps");
+    out.printf("%u,%u,%u,%u,%llu,%llu,%llu,%u,%u",
+               p.flushes, p.frames, p.commands, p.transactions,
+               p.bytes, p.csUs, p.waitUs, p.lastFlushUs, p.maxFlushUs);
+    for (uint8_t i = 0; i < DISPLAY_PROFILE_BUCKETS; i++) {
+        out.printf(",%u", p.histogram[i]);
+    }
+    out.printf(",%llu,%u,%.2f\n", p.elapsedUs, p.kbytesPerSecond, p.fps);
+    return true;
+}
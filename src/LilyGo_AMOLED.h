@@ -22,6 +22,7 @@
 #include <SPI.h>
 #include "XPowersLib.h"
 #include "initSequence.h"
+#include "DisplayConfigure.h"
 #include "TouchDrvCHSC5816.hpp"
 #include "TouchDrvCSTXXX.hpp"
 #include "SensorCM32181.hpp"
@@ -30,6 +31,9 @@
 #include <SD.h>
 #include <sys/cdefs.h>
 #include "LilyGo_Display.h"
+#include "DisplayTrace.h"
+#include "BoardDetect.h"
+#include "I2CBus.h"
 #if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5,0,0)
 #include <driver/temp_sensor.h>
 #else
@@ -52,31 +56,18 @@
 #endif
 
 
-#define BOARD_NONE_PIN      (-1)
 #define BOARD_PIXELS_PIN    (18)        //only 1.47 inch
 #define BOARD_PIXELS_NUM    (1)
 #define DEFAULT_SCK_SPEED   (30 * 1000 * 1000)
+#define DISPLAY_DMA_QUEUE_SIZE  (17)    // SPI device queue depth, also the number of in-flight DMA chunks
+#define DISPLAY_BOUNCE_BUF_MAX  (8)     // Maximum number of internal SRAM bounce buffers
 
-typedef struct __DisplayConfigure {
-    int d0;
-    int d1;
-    int d2;
-    int d3;
-    int sck;
-    int cs;
-    int dc;
-    int rst;
-    int te;
-    uint8_t cmdBit;
-    uint8_t addBit;
-    int  freq;
-    lcd_cmd_t *initSequence;
-    uint32_t initSize;
-    uint16_t width;
-    uint16_t height;
-    uint32_t frameBufferSize;
-    bool fullRefresh;
-} DisplayConfigure_t;
+// Set DISPLAY_PROFILE to 1 to build the bus and frame rate counters into the driver,
+// when 0 the counters are compiled out and getProfile returns false
+#ifndef DISPLAY_PROFILE
+#define DISPLAY_PROFILE         (0)
+#endif
+#define DISPLAY_PROFILE_BUCKETS (8)     // Flush latency histogram buckets
 
 typedef struct __BoardTouchPins {
     int sda;
@@ -116,114 +107,25 @@ typedef struct __BoardsConfigure {
     int adcPins;
     int PMICEnPins;
     bool framebuffer;
+    const TouchFilterConfig_t *touchFilter;
 } BoardsConfigure_t;
 
-
-// LILYGO 1.47 Inch AMOLED(SH8501) S3R8
-// https://www.lilygo.cc/products/t-display-amoled
-static const DisplayConfigure_t SH8501_AMOLED  = {
-    7, //BOARD_DISP_DATA0,
-    10,//BOARD_DISP_DATA1,
-    11,//BOARD_DISP_DATA2,
-    12,//BOARD_DISP_DATA3,
-    5,//BOARD_DISP_SCK,
-    4,//BOARD_DISP_CS,
-    BOARD_NONE_PIN,//DC
-    40,//BOARD_DISP_RESET,
-    6,//BOARD_DISP_TE,
-    8,//command bit
-    24,//address bit
-    30000000,
-    (lcd_cmd_t *)sh8501_cmd,
-    SH8501_INIT_SEQUENCE_LENGTH,
-    SH8501_WIDTH, //width
-    SH8501_HEIGHT, //height
-    SH8501_WIDTH *SH8501_HEIGHT * sizeof(uint16_t), //frameBufferSize
-    true //fullRefresh
-};
-
 static const int AMOLED_147_BUTTONTS[2] = {0, 21};
 static const BoardTouchPins_t AMOLED_147_TOUCH_PINS = {1/*SDA*/, 2/*SCL*/, 13/*IRQ*/, 14/*RST*/};
+static const TouchFilterConfig_t AMOLED_147_TOUCH_FILTER = TOUCH_FILTER_AMOLED_147;
 static const BoardPmuPins_t AMOLED_147_PMU_PINS =  {1/*SDA*/, 2/*SCL*/, 3/*IRQ*/};
 static const BoardSensorPins_t AMOLED_147_SENSOR_PINS =  {1/*SDA*/, 2/*SCL*/, 8/*IRQ*/};
 
 static const int AMOLED_191_BUTTONTS[1] = {0};
 static const BoardTouchPins_t AMOLED_191_TOUCH_PINS = {3 /*SDA*/, 2 /*SCL*/, 21/*IRQ*/, -1/*RST*/};
+static const TouchFilterConfig_t AMOLED_191_TOUCH_FILTER = TOUCH_FILTER_AMOLED_191;
 static const BoardSDCardPins_t AMOLED_191_SPI_SD_PINS =  {13/*MISO*/, 12/*MOSI*/, 14/*SCK*/, 11/*CS*/};
 static const BoardPmuPins_t AMOLED_191_SPI_PMU_PINS =  {3/*SDA*/, 2/*SCL*/, 1/*IRQ*/};
 
-// LILYGO 1.91 Inch AMOLED(RM67162) S3R8
-// https://www.lilygo.cc/products/t-display-s3-amoled
-static const DisplayConfigure_t RM67162_AMOLED  = {
-    18,//BOARD_DISP_DATA0,
-    7,//BOARD_DISP_DATA1,
-    48,//BOARD_DISP_DATA2,
-    5,//BOARD_DISP_DATA3,
-    47,//BOARD_DISP_SCK,
-    6,//BOARD_DISP_CS,
-    BOARD_NONE_PIN,//DC
-    17,//BOARD_DISP_RESET,
-    9, //BOARD_DISP_TE,
-    8, //command bit
-    24,//address bit
-    75000000,
-    (lcd_cmd_t *)rm67162_cmd,
-    RM67162_INIT_SEQUENCE_LENGTH,
-    RM67162_WIDTH,//width
-    RM67162_HEIGHT,//height
-    0,//frameBufferSize
-    false //fullRefresh
-};
-
-// LILYGO 1.91 Inch AMOLED(RM67162) S3R8
-// https://www.lilygo.cc/products/t-display-s3-amoled
-static const DisplayConfigure_t RM67162_AMOLED_SPI  = {
-    18,//BOARD_DISP_DATA0,          //MOSI
-    7,//BOARD_DISP_DATA1,           //DC
-    -1,//BOARD_DISP_DATA2,
-    -1,//BOARD_DISP_DATA3,
-    47,//BOARD_DISP_SCK,            //SCK
-    6,//BOARD_DISP_CS,              //CS
-    BOARD_NONE_PIN,//DC
-    17,//BOARD_DISP_RESET,          //RST
-    9, //BOARD_DISP_TE,
-    8, //command bit
-    24,//address bit
-    40000000,
-    (lcd_cmd_t *)rm67162_spi_cmd,
-    RM67162_INIT_SPI_SEQUENCE_LENGTH,
-    RM67162_WIDTH,//width
-    RM67162_HEIGHT,//height
-    0,//frameBufferSize
-    false //fullRefresh
-};
-
-
-// LILYGO 2.41 Inch AMOLED(RM690B0) S3R8
-// https://www.lilygo.cc/products/t4-s3
-static const DisplayConfigure_t RM690B0_AMOLED  = {
-    14,//BOARD_DISP_DATA0,
-    10,//BOARD_DISP_DATA1,
-    16,//BOARD_DISP_DATA2,
-    12,//BOARD_DISP_DATA3,
-    15,//BOARD_DISP_SCK,
-    11,//BOARD_DISP_CS,
-    BOARD_NONE_PIN,//DC
-    13,//BOARD_DISP_RESET,
-    18, //BOARD_DISP_TE,
-    8, //command bit
-    24,//address bit
-    36000000,
-    (lcd_cmd_t *)rm690b0_cmd,
-    RM690B0_INIT_SEQUENCE_LENGTH,
-    RM690B0_WIDTH,//width
-    RM690B0_HEIGHT,//height
-    0,//frameBufferSize
-    false //fullRefresh
-};
 static const int AMOLED_241_BUTTONTS[1] = {0};
 static const BoardPmuPins_t AMOLED_241_PMU_PINS =  {6/*SDA*/, 7/*SCL*/, 5/*IRQ*/};
 static const BoardTouchPins_t AMOLED_241_TOUCH_PINS =  {6/*SDA*/, 7/*SCL*/, 8/*IRQ*/, 17/*RST*/};
+static const TouchFilterConfig_t AMOLED_241_TOUCH_FILTER = TOUCH_FILTER_AMOLED_241;
 static const BoardSDCardPins_t AMOLED_241_SD_PINS =  {4/*MISO*/, 2/*MOSI*/, 3/*SCK*/, 1/*CS*/};
 
 
@@ -240,6 +142,7 @@ static const  BoardsConfigure_t BOARD_AMOLED_191 = {
     4, //adcPins
     38,//PMICEnPins
     false,//framebuffer
+    &AMOLED_191_TOUCH_FILTER,//touchFilter
 };
 
 static const  BoardsConfigure_t BOARD_AMOLED_191_SPI = {
@@ -255,6 +158,7 @@ static const  BoardsConfigure_t BOARD_AMOLED_191_SPI = {
     4, //adcPins
     38,//PMICEnPins
     false,//framebuffer
+    &AMOLED_191_TOUCH_FILTER,//touchFilter
 };
 
 // T-Display AMOLED H593
@@ -271,6 +175,7 @@ static const  BoardsConfigure_t BOARD_AMOLED_147 = {
     -1, //adcPins
     -1,//PMICEnPins
     true,//framebuffer
+    &AMOLED_147_TOUCH_FILTER,//touchFilter
 };
 
 
@@ -288,9 +193,82 @@ static const  BoardsConfigure_t BOARD_AMOLED_241 = {
     -1, //adcPins
     9,  //PMICEnPins
     false,//framebuffer
+    &AMOLED_241_TOUCH_FILTER,//touchFilter
 };
 
 
+enum DisplayTESync {
+    TE_SYNC_DISABLE,        // Push frames immediately, may tear on full-frame updates
+    TE_SYNC_WAIT,           // Wait for the tearing effect edge before the first area of each frame
+};
+
+typedef struct __DisplayTEStats {
+    uint32_t vsyncs;            // Tearing effect edges seen
+    uint32_t frames;            // Frames that waited for vertical blanking
+    uint32_t missed;            // Frames whose TE edge did not arrive within the timeout
+    uint32_t lastLatencyUs;     // TE edge to flush start of the last frame
+    uint32_t maxLatencyUs;
+    uint64_t totalLatencyUs;
+    uint32_t lastWaitUs;        // Time the last frame spent waiting for the TE edge
+    uint32_t maxWaitUs;
+} DisplayTEStats_t;
+
+typedef struct __TouchSamplerStats {
+    uint32_t interrupts;        // Touch interrupt edges
+    uint32_t reads;             // Controller reads done by the sampler task
+    uint32_t events;            // Samples queued for the input read callback
+    uint32_t dropped;           // Samples lost because the ring was full
+    uint32_t lastLatencyUs;     // Interrupt to sample queued of the last read
+    uint32_t maxLatencyUs;
+} TouchSamplerStats_t;
+
+typedef struct __DisplayBootProfile {
+    int64_t startUs;            // initBUS entry, time since chip reset
+    uint32_t resetUs;           // Power settle, reset pulse and reset wait
+    uint32_t busUs;             // SPI bus and device setup
+    uint32_t initUs;            // Init sequence passes, delays included
+    uint32_t verifyUs;          // Readback of the panel power mode
+    uint8_t attempts;           // Init sequence passes
+    bool checked;               // Power mode was read back, fast boot on the QSPI bus only
+    bool verified;              // Readback confirmed sleep out and display on
+    int64_t firstFrameUs;       // Last chunk of the first pixel burst queued, time since chip reset, 0 until then
+} DisplayBootProfile_t;
+
+typedef struct __DisplayBounceStats {
+    uint32_t transfers;         // Transfers streamed through the bounce buffers
+    uint64_t bytes;
+    uint64_t copyUs;            // Time spent copying (and swapping) into the bounce buffers
+    uint64_t stallUs;           // Time spent waiting for a free bounce buffer
+    uint64_t activeUs;          // First chunk queued to last chunk sent, back to back transfers counted once
+    uint32_t kbytesPerSecond;   // Bytes over activeUs, filled by getBounceStats
+} DisplayBounceStats_t;
+
+enum DisplayProfileFormat {
+    PROFILE_FORMAT_CSV,         // Header line followed by one value line
+    PROFILE_FORMAT_BINARY,      // "DPRF" magic, uint8_t version, then the raw DisplayProfile_t
+};
+
+/*
+* Flush latency histogram upper bounds in microseconds, the last bucket
+* counts everything above 32ms:
+* 500, 1000, 2000, 4000, 8000, 16000, 32000, inf
+*/
+typedef struct __DisplayProfile {
+    uint32_t flushes;           // pushColors / pushColorsDMA calls
+    uint32_t frames;            // Frames started, counted by waitVSync
+    uint32_t commands;          // Command transactions
+    uint32_t transactions;      // Pixel transactions
+    uint64_t bytes;             // Pixel bytes sent
+    uint64_t csUs;              // Time CS was held for pixel and command transfers
+    uint64_t waitUs;            // Time the caller was blocked on queued transfers
+    uint32_t lastFlushUs;       // Call to transfer done of the last flush
+    uint32_t maxFlushUs;
+    uint32_t histogram[DISPLAY_PROFILE_BUCKETS];
+    uint64_t elapsedUs;         // Time since the last reset, filled by getProfile
+    uint32_t kbytesPerSecond;   // Pixel bytes over CS held time, filled by getProfile
+    float    fps;               // Frames over elapsed time, filled by getProfile
+} DisplayProfile_t;
+
 enum AmoledBoardID {
     LILYGO_AMOLED_147 = 0x01,
     LILYGO_AMOLED_191,
@@ -299,6 +277,14 @@ enum AmoledBoardID {
     LILYGO_AMOLED_UNKNOWN,
 };
 
+// Probed in order by begin, a 1.91 inch board without touch answers none of them
+static const BoardProbe_t AMOLED_BOARD_PROBES[] = {
+    {1, 2, AXP2101_SLAVE_ADDRESS, 0, LILYGO_AMOLED_147},
+    {3, 2, CSTXXX_SLAVE_ADDRESS, PCF85063_SLAVE_ADDRESS, LILYGO_AMOLED_191_SPI},
+    {3, 2, CSTXXX_SLAVE_ADDRESS, 0, LILYGO_AMOLED_191},
+    {6, 7, SY6970_SLAVE_ADDRESS, 0, LILYGO_AMOLED_241},
+};
+
 class LilyGo_AMOLED:
     public LilyGo_Display,
     public XPowersAXP2101,
@@ -317,7 +303,8 @@ public:
 
     ~LilyGo_AMOLED();
 
-    // Automatically identify hardware
+    // Automatically identify hardware, the result is cached in NVS and only
+    // confirmed on the next boot
     bool begin();
 
     bool beginAutomatic() __attribute__((deprecated("please use begin instead")));
@@ -342,6 +329,19 @@ public:
      */
     bool beginAMOLED_241(bool disable_sd = false, bool disable_state_led = false);
 
+    /**
+     * @brief  Fast boot, call before begin.
+     * @note   Uses the short reset timings of the board configuration and runs the init
+     *         sequence once, the panel power mode is read back and the init is only repeated,
+     *         with the conservative timings and twice, if it is not in sleep out and display on.
+     *         begin fails and getBootProfile reports checked with verified false if that did
+     *         not help either.
+     *         The SPI interface board cannot read back, its init is not verified.
+     */
+    void setFastBoot(bool enable);
+    // Boot time breakdown of the last begin
+    void getBootProfile(DisplayBootProfile_t *profile);
+
 
     void setBrightness(uint8_t level);
     uint8_t getBrightness();
@@ -353,7 +353,61 @@ public:
     void setAddrWindow(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye);
     void pushColors(uint16_t *data, uint32_t len);
     void pushColors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data);
+    void pushRect(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data, uint32_t stride) override;
+    /**
+     * @brief  Queue pixel data to the display and return without waiting.
+     * @note   If a DMA done callback is set, the function returns as soon as all chunks
+     *         are queued, the data buffer must remain valid until the callback is called.
+     *         Without a callback, it blocks until the transfer is complete.
+     */
     void pushColorsDMA(uint16_t *data, uint32_t len);
+    /**
+     * @brief  Swap the two bytes of every pixel while it is sent.
+     * @note   The swap is done while copying each chunk into an internal SRAM
+     *         bounce buffer, overlapped with the transfer of the previous chunk,
+     *         the caller's buffer is left untouched.
+     * @retval Returns false and leaves the swap off if no bounce buffer can be allocated
+     */
+    bool setSwapBytes(bool swap) override;
+
+    /**
+     * @brief  Configure the ring of internal SRAM DMA buffers used to stream PSRAM
+     *         resident and byte swapped pixel data, PSRAM copies overlap with the
+     *         transfer of previously staged chunks.
+     * @param  count: Number of buffers, up to DISPLAY_BOUNCE_BUF_MAX, 0 sends PSRAM data directly,
+     *         not allowed while the byte swap is on
+     * @param  chunk_pixels: Pixels per buffer
+     * @retval Returns false if the parameters are invalid or the buffers cannot be allocated,
+     *         the byte swap is turned off in the latter case
+     */
+    bool setBounceBuffers(uint8_t count, uint32_t chunk_pixels);
+    void getBounceStats(DisplayBounceStats_t *stats);
+    void resetBounceStats();
+
+    // Pixels per QSPI transaction, defaults to the board profile chunkSize
+    bool setChunkSize(uint32_t pixels);
+    uint32_t getChunkSize();
+
+    /**
+     * @brief  Measure full-frame flush time over a sweep of chunk sizes and apply the fastest.
+     * @note   Draws a black frame for every measurement, call it before the UI is shown.
+     *         The result is stored in NVS and reused on the next boot unless force is set.
+     * @param  force: true ignores the stored calibration and measures again
+     * @retval The selected chunk size in pixels
+     */
+    uint32_t autoTuneChunkSize(bool force = false);
+    bool setDMADoneCallback(DisplayDMADoneCallback cb, void *user_data) override;
+    // Block until all queued DMA transfers are finished
+    void waitDMADone();
+
+    /**
+     * @brief  Queue a run of commands back to back without waiting for each one.
+     * @note   Parameters are copied, the array can be released after the call.
+     *         Delay flags (0x80 / 0x20 in len) flush the queue before sleeping.
+     */
+    void writeCommands(const lcd_cmd_t *cmds, uint32_t count);
+    // Send a packed init sequence, see initSequence.h
+    void writeInitSequence(const lcd_init_t *seq);
 
     /**
      * @brief   Hang on SD card
@@ -410,6 +464,81 @@ public:
     bool hasOTG();
 
     bool needFullRefresh();
+    bool needSoftRotation();
+
+    uint32_t getAreaSetupUs() override;
+    uint32_t getBusBytesPerSecond() override;
+
+    /**
+     * @brief  Synchronize frame presentation to the panel tearing effect (TE) signal
+     * @param  mode: TE_SYNC_DISABLE or TE_SYNC_WAIT
+     * @param  timeout_ms: Maximum time to wait for a TE edge before sending anyway
+     * @retval Returns false if the board has no TE pin
+     */
+    bool setTESync(DisplayTESync mode, uint32_t timeout_ms = 50);
+    DisplayTESync getTESync();
+    void waitVSync() override;
+    void getTEStats(DisplayTEStats_t *stats);
+    void resetTEStats();
+
+    /**
+     * @brief  Read the touch controller from a task woken by the touch interrupt pin
+     * @note   Samples are timestamped and queued, getPoint and readTouchEvent then
+     *         no longer access the I2C bus. While a finger is down the controller is
+     *         also read every release_ms, a release does not always raise an interrupt.
+     *         The first two fingers are sampled, getPoint returns both with get_point = 2.
+     *         getPoint returns the latest sample and leaves the queue to readTouchEvent.
+     * @param  priority: Sampler task priority
+     * @param  release_ms: Read interval while touched
+     * @retval Returns false if there is no touch or the board has no touch interrupt pin
+     */
+    bool startTouchSampler(uint8_t priority = 5, uint32_t release_ms = 40);
+    void stopTouchSampler();
+    bool hasTouchSampler() override;
+    bool readTouchEvent(TouchEvent_t *event) override;
+    uint32_t getTouchEventsPending() override;
+    bool getTouchFilter(TouchFilterConfig_t *config) override;
+    void getTouchStats(TouchSamplerStats_t *stats);
+    void resetTouchStats();
+
+    /**
+     * @brief  Transfer counters of a device on the shared I2C bus
+     * @note   The touch controller, PMU, RTC and light sensor share one bus, touch
+     *         reads go ahead of the other devices. A sketch that uses Wire for its
+     *         own devices can take the bus with I2CBus::getDefault()->lock().
+     * @param  address: 7 bit device address, e.g. AXP2101_SLAVE_ADDRESS
+     * @retval Returns false if the device has not been on the bus
+     */
+    bool getI2CStats(uint8_t address, I2CDeviceStats_t *stats);
+    void resetI2CStats();
+
+    /**
+     * @brief  Read the bus and frame rate counters, needs DISPLAY_PROFILE set to 1
+     * @retval Returns false if the counters are compiled out
+     */
+    bool getProfile(DisplayProfile_t *profile);
+    void resetProfile();
+    /**
+     * @brief  Write the counters to a stream, e.g. Serial
+     * @param  out: Output stream
+     * @param  format: PROFILE_FORMAT_CSV or PROFILE_FORMAT_BINARY
+     * @retval Returns false if the counters are compiled out
+     */
+    bool dumpProfile(Print &out, DisplayProfileFormat format = PROFILE_FORMAT_CSV);
+
+    /**
+     * @brief  Record every display bus transaction into a binary trace, see DisplayTrace.h
+     * @note   The writer is called from the drawing task for each transaction, a slow
+     *         writer slows down the display accordingly.
+     * @param  writer: Receives the header and the records
+     * @param  user_data: Passed to the writer
+     * @param  payload: true also records the command parameters and pixel data
+     * @retval Returns false if the display is not initialized
+     */
+    bool startTrace(DisplayTraceWriter writer, void *user_data, bool payload = true);
+    // Record into a stream, e.g. a File on the SD card
+    bool startTrace(Print &out, bool payload = true);
+    void stopTrace();
 
 
     bool hasRTC();
@@ -422,9 +551,54 @@ private:
 
     bool initBUS(DriverBusType type = QSPI_DRIVER);
     bool initPMU();
+    void initI2CBus();
     void inline setCS();
     void inline clrCS();
     void writeCommand(uint32_t cmd, uint8_t *pdat, uint32_t length);
+    bool readCommand(uint32_t cmd, uint8_t *pdat, uint32_t length);
+    void resetPanel(uint32_t settle_ms, uint32_t low_ms, uint32_t wait_ms);
+    bool initPanel();
+    bool verifyPanel(uint8_t *mode);
+
+    enum TransactionFlags {
+        TRANS_CS_BEGIN  = _BV(0),   // Assert CS before the transaction
+        TRANS_CS_END    = _BV(1),   // Release CS after the transaction
+        TRANS_NOTIFY    = _BV(2),   // Call the DMA done callback after the transaction
+        TRANS_BOUNCE_END = _BV(3),  // Last chunk of a bounce transfer, record its done time
+    };
+
+    typedef struct {
+        spi_transaction_ext_t ext;
+        LilyGo_AMOLED *owner;
+        uint8_t flags;
+        uint8_t param[20];
+        int64_t startUs;            // First chunk of the bounce transfer queued, for TRANS_BOUNCE_END
+        int64_t doneUs;             // Set by the post callback for TRANS_BOUNCE_END
+#if DISPLAY_PROFILE
+        int64_t flushStartUs;       // pushColorsDMA call, for TRANS_NOTIFY
+#endif
+    } DisplayTransaction_t;
+
+    DisplayTransaction_t *getDMATransaction();
+    void waitDMAInFlight(uint8_t count);
+    bool queueCommand(uint32_t cmd, const uint8_t *pdat, uint32_t length);
+    bool queuePixels(uint16_t *data, uint32_t len, bool first, bool last);
+    bool queuePixelsBounce(uint16_t *data, uint32_t len, bool first, bool last, bool swap);
+    void pushPixels(uint16_t *data, uint32_t len, bool swap);
+    void pushRows(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data, uint32_t stride);
+    void traceTransaction(uint8_t cmd, uint32_t addr, uint8_t flags, const void *data, uint32_t length);
+    static size_t tracePrintWriter(const void *data, size_t len, void *user_data);
+    bool allocBounceBuffers();
+    void freeBounceBuffers();
+    static void dmaPreCallback(spi_transaction_t *t);
+    static void dmaPostCallback(spi_transaction_t *t);
+    static void teISR(void *arg);
+    static void touchISR(void *arg);
+    static void touchSamplerTask(void *arg);
+    uint8_t readTouch(int16_t *x, int16_t *y, uint8_t get_point);
+#if DISPLAY_PROFILE
+    void profileFlushDone(int64_t start, bool isr);
+#endif
     uint16_t *pBuffer;
     spi_device_handle_t spi;
     uint8_t _brightness;
@@ -441,6 +615,65 @@ private:
     bool _disableTouch;
 
     SPIClass *spiDev;
+
+    DisplayTransaction_t _dmaTrans[DISPLAY_DMA_QUEUE_SIZE];
+    uint8_t _dmaHead;
+    uint8_t _dmaInFlight;
+    DisplayDMADoneCallback _dmaDoneCb;
+    void *_dmaDoneUserData;
+    bool _dmaNotify;
+    uint16_t *_rotateBuffer[2];
+    bool _hardwareCS;
+    bool _swapBytes;
+    uint8_t _bounceIndex;
+    uint8_t _bounceNum;
+    uint8_t _bounceAllocated;
+    uint32_t _bounceSize;
+    uint32_t _chunkSize;
+    uint16_t *_bounceBuffer[DISPLAY_BOUNCE_BUF_MAX];
+    DisplayBounceStats_t _bounceStats;
+    bool _bounceTimed;              // Chunks queued now belong to a bounce transfer
+    int64_t _bounceStartUs;         // First chunk of the current bounce transfer queued
+    int64_t _bounceDoneUs;          // Last chunk of the previous bounce transfer sent
+
+    DisplayTESync _teMode;
+    uint32_t _teTimeout;
+    SemaphoreHandle_t _teSemaphore;
+    volatile uint32_t _teCount;
+    volatile int64_t _teTimestamp;
+    DisplayTEStats_t _teStats;
+
+    TaskHandle_t _touchTask;
+    volatile bool _touchRunning;
+    uint32_t _touchReleaseMs;
+    TouchRing _touchRing;
+    TouchSnapshot _touchLatest;
+    // The interrupt and the sampler task update the stats, every access holds the lock
+    portMUX_TYPE _touchLock;
+    int64_t _touchIrqUs;
+    TouchSamplerStats_t _touchStats;
+
+    I2CBus _i2cBus;
+
+    bool _addrWindowValid;
+    uint16_t _addrWindow[4];
+
+    bool _fastBoot;
+    bool _bootFirstFrame;
+    DisplayBootProfile_t _bootProfile;
+
+    DisplayTraceWriter _traceWriter;
+    void *_traceUserData;
+    bool _tracePayload;
+
+#if DISPLAY_PROFILE
+    // The transaction callbacks update the counters from the interrupt, every access holds the lock
+    portMUX_TYPE _profileLock;
+    DisplayProfile_t _profile;
+    int64_t _profileStart;
+    int64_t _profileFlushStart;
+    volatile int64_t _profileCSStart;
+#endif
 };
 
 #ifndef LilyGo_Class
@@ -9,12 +9,18 @@
 #pragma once
 
 #include <stdint.h>
+#include "TouchRing.h"
+#include "TouchFilter.h"
 
 // enum DispRotation {
 //     DISP_VERTICAL,      // vertical
 //     DISP_HORIZONTAL,    // horizontal
 // };
 
+// Called when the last chunk of a pushColorsDMA transfer has left the bus.
+// NOTE: May be invoked from interrupt context, keep it short.
+typedef void (*DisplayDMADoneCallback)(void *user_data);
+
 class LilyGo_Display
 {
 public:
@@ -25,14 +31,81 @@ public:
     virtual void pushColors(uint16_t *data, uint32_t len) = 0;
     virtual void pushColors(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t *data) = 0;
     virtual void pushColorsDMA(uint16_t *data, uint32_t len) = 0;
+    // Send the width x height area at x, y whose rows are stride pixels apart in data,
+    // e.g. a region of a full screen buffer. data is not modified.
+    virtual void pushRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t *data, uint32_t stride)
+    {
+        if (stride == width) {
+            pushColors(x, y, width, height, data);
+            return;
+        }
+        for (uint16_t i = 0; i < height; i++) {
+            pushColors(x, y + i, width, 1, data + (uint32_t)i * stride);
+        }
+    }
+    // Swap the bytes of each RGB565 pixel while sending, returns false if not supported
+    virtual bool setSwapBytes(bool swap)
+    {
+        return false;
+    }
+    // Returns false if the display cannot complete DMA transfers asynchronously,
+    // in which case pushColorsDMA blocks until the transfer is finished.
+    virtual bool setDMADoneCallback(DisplayDMADoneCallback cb, void *user_data)
+    {
+        return false;
+    }
     virtual uint16_t  width() = 0;
     virtual uint16_t  height() = 0;
 
     virtual uint8_t getPoint(int16_t *x, int16_t *y, uint8_t get_point ) = 0;
     virtual bool    hasTouch() = 0;
 
+    // Returns true if touch samples are buffered by an interrupt driven sampler,
+    // they are then read with readTouchEvent instead of getPoint
+    virtual bool hasTouchSampler()
+    {
+        return false;
+    }
+    // Pop the oldest buffered touch sample, returns false if none is pending
+    virtual bool readTouchEvent(TouchEvent_t *event)
+    {
+        return false;
+    }
+    virtual uint32_t getTouchEventsPending()
+    {
+        return 0;
+    }
+    // Filter and prediction preset of the touch controller, returns false if there is none
+    virtual bool getTouchFilter(TouchFilterConfig_t *config)
+    {
+        return false;
+    }
+
     virtual bool needFullRefresh() = 0;
 
+    // Returns true if the frame is rotated in software before it is sent, such displays
+    // only place pixels correctly through pushColors(x, y, width, height, data)
+    virtual bool needSoftRotation()
+    {
+        return false;
+    }
+
+    // Called before the first area of a frame is sent, displays that synchronize
+    // to the tearing effect signal block here until the next vertical blanking
+    virtual void waitVSync() {}
+
+    // Bus cost model used to decide whether two dirty areas are cheaper to send as one:
+    // fixed time to set up one area (window commands and transaction overhead) and
+    // sustained pixel throughput. Returning 0 disables cost based merging.
+    virtual uint32_t getAreaSetupUs()
+    {
+        return 0;
+    }
+    virtual uint32_t getBusBytesPerSecond()
+    {
+        return 0;
+    }
+
 protected:
     uint16_t _offset_x = 0;
     uint16_t _offset_y = 0;
@@ -0,0 +1,434 @@
+/**
+ * @file      LilyGo_VirtualDisplay.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+
+#include "LilyGo_VirtualDisplay.h"
+#include "PixelKernels.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    const DisplayConfigure_t *display;
+} VirtualBoard_t;
+
+// Same order as VirtualDisplayType
+static const VirtualBoard_t virtualPanels[] = {
+    {"1.47 inch AMOLED",        &SH8501_AMOLED},
+    {"1.91 inch AMOLED",        &RM67162_AMOLED},
+    {"1.91 inch AMOLED (SPI)",  &RM67162_AMOLED_SPI},
+    {"2.41 inch AMOLED",        &RM690B0_AMOLED},
+};
+
+LilyGo_VirtualDisplay::LilyGo_VirtualDisplay(VirtualDisplayType type)
+{
+    if ((uint32_t)type >= sizeof(virtualPanels) / sizeof(*virtualPanels)) {
+        type = VIRTUAL_AMOLED_191;
+    }
+    const DisplayConfigure_t *display = virtualPanels[type].display;
+    bool swap = display->rotation && display->rotation[0].swapSize;
+    _panel.name = virtualPanels[type].name;
+    _panel.display = display;
+    _panel.width = swap ? display->height : display->width;
+    _panel.height = swap ? display->width : display->height;
+    _panel.freq = display->freq;
+    _panel.lanes = displayBusLanes(display);
+    _panel.cmdBit = display->cmdBit;
+    _panel.addBit = display->addBit;
+    _panel.transOverheadUs = displayTransOverheadUs(display);
+    _panel.chunkSize = display->chunkSize ? display->chunkSize : DISPLAY_MAX_CHUNK_SIZE;
+    _panel.fullRefresh = display->fullRefresh;
+    _panel.softRotate = display->frameBufferSize != 0;
+    _panel.rotation = display->rotation != NULL;
+    _gram = NULL;
+    _gramWidth = 0;
+    _gramHeight = 0;
+    _swapBytes = false;
+    _touchX = 0;
+    _touchY = 0;
+    _touched = false;
+    memset(&_stats, 0, sizeof(_stats));
+    setRotation(0);
+}
+
+LilyGo_VirtualDisplay::~LilyGo_VirtualDisplay()
+{
+    free(_gram);
+}
+
+bool LilyGo_VirtualDisplay::allocGRAM()
+{
+    uint16_t w, h;
+    if (_panel.softRotate) {
+        // The panel keeps its scan order, 90 degrees from the logical frame at rotation 0
+        w = _panel.height;
+        h = _panel.width;
+    } else {
+        w = _width + _offset_x;
+        h = _height + _offset_y;
+    }
+    if (_gram && w == _gramWidth && h == _gramHeight) {
+        return true;
+    }
+    free(_gram);
+    _gram = (uint16_t *)calloc((uint32_t)w * h, sizeof(uint16_t));
+    if (!_gram) {
+        _gramWidth = 0;
+        _gramHeight = 0;
+        return false;
+    }
+    _gramWidth = w;
+    _gramHeight = h;
+    _win[0] = 0;
+    _win[1] = 0;
+    _win[2] = w - 1;
+    _win[3] = h - 1;
+    _cursorX = 0;
+    _cursorY = 0;
+    return true;
+}
+
+void LilyGo_VirtualDisplay::setRotation(uint8_t rotation)
+{
+    if (!_panel.rotation) {
+        rotation = 0;
+    }
+    _rotation = rotation % 4;
+    bool odd = _rotation & 1;
+    _width = odd ? _panel.height : _panel.width;
+    _height = odd ? _panel.width : _panel.height;
+    _offset_x = _panel.rotation ? _panel.display->rotation[_rotation].offsetX : 0;
+    _offset_y = _panel.rotation ? _panel.display->rotation[_rotation].offsetY : 0;
+    if (_gram && !_panel.softRotate) {
+        // MADCTL
+        writeCommand(1);
+    }
+    allocGRAM();
+}
+
+uint8_t LilyGo_VirtualDisplay::getRotation()
+{
+    return _rotation;
+}
+
+// One command transaction, 8 bit command and 24 bit address followed by the parameters
+void LilyGo_VirtualDisplay::writeCommand(uint32_t length)
+{
+    uint32_t bits = _panel.cmdBit + _panel.addBit + 8 * length;
+    _stats.busNs += (uint64_t)bits * 1000000000ULL / _panel.freq + _panel.transOverheadUs * 1000ULL;
+    _stats.commands++;
+}
+
+void LilyGo_VirtualDisplay::setAddrWindow(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye)
+{
+    xs += _offset_x;
+    ys += _offset_y;
+    xe += _offset_x;
+    ye += _offset_y;
+
+    // CASET, RASET, RAMWR
+    writeCommand(4);
+    writeCommand(4);
+    writeCommand(0);
+
+    if (!_gram) {
+        return;
+    }
+    if (xe >= _gramWidth) {
+        xe = _gramWidth - 1;
+    }
+    if (ye >= _gramHeight) {
+        ye = _gramHeight - 1;
+    }
+    _win[0] = xs;
+    _win[1] = ys;
+    _win[2] = xe < xs ? xs : xe;
+    _win[3] = ye < ys ? ys : ye;
+    _cursorX = _win[0];
+    _cursorY = _win[1];
+}
+
+// One RAMWR burst of len pixels, split into transactions of the chunk size
+void LilyGo_VirtualDisplay::writeBurst(uint32_t len)
+{
+    uint32_t chunks = (len + _panel.chunkSize - 1) / _panel.chunkSize;
+    uint64_t bits = (uint64_t)len * 16;
+    _stats.busNs += bits * 1000000000ULL / ((uint64_t)_panel.freq * _panel.lanes) +
+                    chunks * _panel.transOverheadUs * 1000ULL;
+    _stats.bytes += len * sizeof(uint16_t);
+    _stats.transactions += chunks;
+}
+
+/*
+* Store pixels at the GRAM write pointer, wrapping inside the address window
+* like the panel does. The panel receives the high byte first, so a pixel
+* arrives intact only if the buffer is byte swapped or swap is requested.
+*/
+void LilyGo_VirtualDisplay::writePixels(const uint16_t *data, uint32_t len, bool swap)
+{
+    if (!_gram || _win[0] >= _gramWidth || _win[1] >= _gramHeight) {
+        return;
+    }
+    while (len--) {
+        uint16_t c = *data++;
+        _gram[(uint32_t)_cursorY * _gramWidth + _cursorX] = swap ? c : __builtin_bswap16(c);
+        if (++_cursorX > _win[2]) {
+            _cursorX = _win[0];
+            if (++_cursorY > _win[3]) {
+                _cursorY = _win[1];
+            }
+        }
+    }
+}
+
+void LilyGo_VirtualDisplay::pushColors(uint16_t *data, uint32_t len)
+{
+    writeBurst(len);
+    writePixels(data, len, _swapBytes);
+}
+
+void LilyGo_VirtualDisplay::pushColors(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data)
+{
+    if (!_panel.softRotate || _rotation == 1) {
+        setAddrWindow(x, y, x + width - 1, y + hight - 1);
+        pushColors(data, (uint32_t)width * hight);
+        return;
+    }
+
+    // Same window and pixel order as the rotated framebuffer path of LilyGo_AMOLED
+    uint16_t _x, _y, _w, _h;
+    switch (_rotation) {
+    case 2:
+        _x = y;
+        _y = this->width() - (x + width);
+        _w = hight;
+        _h = width;
+        break;
+    case 3:
+        _x = this->width() - (x + width);
+        _y = this->height() - (y + hight);
+        _w = width;
+        _h = hight;
+        break;
+    default:
+        _x = this->height() - (y + hight);
+        _y = x;
+        _w = hight;
+        _h = width;
+        break;
+    }
+    setAddrWindow(_x, _y, _x + _w - 1, _y + _h - 1);
+    writeBurst((uint32_t)width * hight);
+    uint16_t *buffer = (uint16_t *)malloc((uint32_t)width * hight * sizeof(uint16_t));
+    if (!buffer) {
+        return;
+    }
+    switch (_rotation) {
+    case 2:
+        pixelRotate270(buffer, data, width, hight, false);
+        break;
+    case 3:
+        pixelRotate180(buffer, data, width, hight, false);
+        break;
+    default:
+        pixelRotate90(buffer, data, width, hight, false);
+        break;
+    }
+    writePixels(buffer, (uint32_t)width * hight, _swapBytes);
+    free(buffer);
+}
+
+// The driver gathers the rows and sends them as one area, so does the emulation
+void LilyGo_VirtualDisplay::pushRect(uint16_t x, uint16_t y, uint16_t width, uint16_t hight, uint16_t *data, uint32_t stride)
+{
+    if (stride == width) {
+        pushColors(x, y, width, hight, data);
+        return;
+    }
+    uint16_t *buffer = (uint16_t *)malloc((uint32_t)width * hight * sizeof(uint16_t));
+    if (!buffer) {
+        return;
+    }
+    for (uint16_t i = 0; i < hight; i++) {
+        pixelCopy(buffer + (uint32_t)i * width, data + (uint32_t)i * stride, width);
+    }
+    pushColors(x, y, width, hight, buffer);
+    free(buffer);
+}
+
+void LilyGo_VirtualDisplay::pushColorsDMA(uint16_t *data, uint32_t len)
+{
+    pushColors(data, len);
+}
+
+bool LilyGo_VirtualDisplay::setSwapBytes(bool swap)
+{
+    _swapBytes = swap;
+    return true;
+}
+
+uint16_t LilyGo_VirtualDisplay::width()
+{
+    return _width;
+}
+
+uint16_t LilyGo_VirtualDisplay::height()
+{
+    return _height;
+}
+
+uint8_t LilyGo_VirtualDisplay::getPoint(int16_t *x, int16_t *y, uint8_t get_point)
+{
+    if (!_touched) {
+        return 0;
+    }
+    if (x) {
+        *x = _touchX;
+    }
+    if (y) {
+        *y = _touchY;
+    }
+    return 1;
+}
+
+bool LilyGo_VirtualDisplay::hasTouch()
+{
+    return true;
+}
+
+bool LilyGo_VirtualDisplay::needFullRefresh()
+{
+    return _panel.fullRefresh;
+}
+
+bool LilyGo_VirtualDisplay::needSoftRotation()
+{
+    return _panel.softRotate;
+}
+
+void LilyGo_VirtualDisplay::waitVSync()
+{
+    _stats.frames++;
+}
+
+// Same model as LilyGo_AMOLED::getAreaSetupUs
+uint32_t LilyGo_VirtualDisplay::getAreaSetupUs()
+{
+    uint32_t bits = 3 * (_panel.cmdBit + _panel.addBit + 32);
+    uint32_t bus_us = (bits * 1000000ULL) / _panel.freq;
+    if (_panel.lanes == 1) {
+        return bus_us + 6 * _panel.transOverheadUs;
+    }
+    return bus_us + 4 * _panel.transOverheadUs;
+}
+
+uint32_t LilyGo_VirtualDisplay::getBusBytesPerSecond()
+{
+    return (_panel.freq / 8) * _panel.lanes;
+}
+
+const char *LilyGo_VirtualDisplay::getName()
+{
+    return _panel.name;
+}
+
+const VirtualPanel_t *LilyGo_VirtualDisplay::getPanel()
+{
+    return &_panel;
+}
+
+void LilyGo_VirtualDisplay::setTouch(int16_t x, int16_t y, bool pressed)
+{
+    _touchX = x;
+    _touchY = y;
+    _touched = pressed;
+}
+
+uint16_t LilyGo_VirtualDisplay::getPixel(uint16_t x, uint16_t y)
+{
+    if (!_gram || x >= _width || y >= _height) {
+        return 0;
+    }
+    if (_panel.softRotate) {
+        uint16_t col, row;
+        switch (_rotation) {
+        case 1:
+            col = x;
+            row = y;
+            break;
+        case 2:
+            col = y;
+            row = _width - 1 - x;
+            break;
+        case 3:
+            col = _width - 1 - x;
+            row = _height - 1 - y;
+            break;
+        default:
+            col = _height - 1 - y;
+            row = x;
+            break;
+        }
+        return _gram[(uint32_t)row * _gramWidth + col];
+    }
+    return _gram[(uint32_t)(y + _offset_y) * _gramWidth + x + _offset_x];
+}
+
+void LilyGo_VirtualDisplay::fillScreen(uint16_t color)
+{
+    if (!_gram) {
+        return;
+    }
+    for (uint32_t i = 0; i < (uint32_t)_gramWidth * _gramHeight; i++) {
+        _gram[i] = color;
+    }
+}
+
+bool LilyGo_VirtualDisplay::writePPM(const char *filename)
+{
+    FILE *fp = fopen(filename, "wb");
+    if (!fp) {
+        return false;
+    }
+    fprintf(fp, "P6\n%u %u\n255\n", _width, _height);
+    bool ret = true;
+    uint8_t *line = (uint8_t *)malloc(_width * 3);
+    if (!line) {
+        fclose(fp);
+        return false;
+    }
+    for (uint16_t y = 0; y < _height && ret; y++) {
+        for (uint16_t x = 0; x < _width; x++) {
+            uint16_t c = getPixel(x, y);
+            uint8_t r = (c >> 11) & 0x1F;
+            uint8_t g = (c >> 5) & 0x3F;
+            uint8_t b = c & 0x1F;
+            line[x * 3 + 0] = (r << 3) | (r >> 2);
+            line[x * 3 + 1] = (g << 2) | (g >> 4);
+            line[x * 3 + 2] = (b << 3) | (b >> 2);
+        }
+        ret = fwrite(line, 3, _width, fp) == _width;
+    }
+    free(line);
+    fclose(fp);
+    return ret;
+}
+
+void LilyGo_VirtualDisplay::getBusStats(VirtualBusStats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    memcpy(stats, &_stats, sizeof(VirtualBusStats_t));
+}
+
+void LilyGo_VirtualDisplay::resetBusStats()
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
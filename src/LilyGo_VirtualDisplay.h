@@ -0,0 +1,114 @@
+/**
+ * @file      LilyGo_VirtualDisplay.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include "LilyGo_Display.h"
+#include "DisplayConfigure.h"
+
+/*
+* In-memory implementation of LilyGo_Display that needs no SPI hardware.
+* Pixels are written into an emulated panel GRAM the same way the real driver
+* addresses it (offsets, the software rotated 1.47 inch frame, byte order on
+* the bus), and the bus time of every transfer is estimated from the clock,
+* bus width and chunk size of the board configuration the driver uses.
+* Builds on the host, frames can be dumped as PPM.
+*/
+
+enum VirtualDisplayType {
+    VIRTUAL_AMOLED_147,         // SH8501 368x194, QSPI 30MHz, rotated in software
+    VIRTUAL_AMOLED_191,         // RM67162 240x536, QSPI 75MHz
+    VIRTUAL_AMOLED_191_SPI,     // RM67162 240x536, SPI 40MHz
+    VIRTUAL_AMOLED_241,         // RM690B0 600x450, QSPI 36MHz, 16 pixel offset
+};
+
+typedef struct __VirtualPanel {
+    const char *name;
+    const DisplayConfigure_t *display;  // Board configuration of the real driver, the fields below are derived from it
+    uint16_t width;             // Logical size at rotation 0, same as LilyGo_AMOLED::width()
+    uint16_t height;
+    uint32_t freq;              // Bus clock
+    uint8_t lanes;              // Data lines used for pixel data
+    uint8_t cmdBit;
+    uint8_t addBit;
+    uint16_t transOverheadUs;   // Fixed cost of one transaction
+    uint32_t chunkSize;         // Pixels per transaction
+    bool fullRefresh;
+    bool softRotate;            // Frame is rotated by the driver before it is sent, the panel scan order never changes
+    bool rotation;              // setRotation is supported
+} VirtualPanel_t;
+
+typedef struct __VirtualBusStats {
+    uint64_t busNs;             // Estimated bus time
+    uint64_t bytes;             // Pixel bytes
+    uint32_t commands;
+    uint32_t transactions;      // Pixel transactions
+    uint32_t frames;            // Frames started, counted by waitVSync
+} VirtualBusStats_t;
+
+class LilyGo_VirtualDisplay : public LilyGo_Display
+{
+public:
+    LilyGo_VirtualDisplay(VirtualDisplayType type = VIRTUAL_AMOLED_191);
+    ~LilyGo_VirtualDisplay();
+
+    void setRotation(uint8_t rotation) override;
+    uint8_t getRotation() override;
+    void setAddrWindow(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye) override;
+    void pushColors(uint16_t *data, uint32_t len) override;
+    void pushColors(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t *data) override;
+    void pushRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t *data, uint32_t stride) override;
+    void pushColorsDMA(uint16_t *data, uint32_t len) override;
+    bool setSwapBytes(bool swap) override;
+    uint16_t  width() override;
+    uint16_t  height() override;
+    uint8_t getPoint(int16_t *x, int16_t *y, uint8_t get_point = 1) override;
+    bool    hasTouch() override;
+    bool needFullRefresh() override;
+    bool needSoftRotation() override;
+    void waitVSync() override;
+    uint32_t getAreaSetupUs() override;
+    uint32_t getBusBytesPerSecond() override;
+
+    const char *getName();
+    const VirtualPanel_t *getPanel();
+
+    // Report a touch point to the next getPoint calls, pressed false releases it
+    void setTouch(int16_t x, int16_t y, bool pressed = true);
+
+    // Pixel as seen on the screen in logical coordinates, RGB565
+    uint16_t getPixel(uint16_t x, uint16_t y);
+    void fillScreen(uint16_t color);
+
+    /**
+     * @brief  Write the visible screen in logical orientation as a binary PPM (P6) file
+     * @retval Returns false if the file cannot be written
+     */
+    bool writePPM(const char *filename);
+
+    void getBusStats(VirtualBusStats_t *stats);
+    void resetBusStats();
+
+private:
+    bool allocGRAM();
+    void writeCommand(uint32_t length);
+    void writeBurst(uint32_t len);
+    void writePixels(const uint16_t *data, uint32_t len, bool swap);
+
+    VirtualPanel_t _panel;
+    uint16_t _width, _height;
+    uint16_t *_gram;
+    uint16_t _gramWidth, _gramHeight;
+    uint16_t _win[4];
+    uint16_t _cursorX, _cursorY;
+    bool _swapBytes;
+    int16_t _touchX, _touchY;
+    bool _touched;
+    VirtualBusStats_t _stats;
+};
@@ -0,0 +1,306 @@
+/**
+ * @file      PixelKernels.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+
+#include "PixelKernels.h"
+#include <string.h>
+
+#define PIXEL_ROTATE_TILE       (16)
+
+// Swap the bytes of the two pixels held in one 32-bit word
+#define SWAP_PAIR(v)            ((((v) & 0x00FF00FF) << 8) | (((v) >> 8) & 0x00FF00FF))
+
+// RGB565 spread over 32 bits as 00000GGGGGG00000RRRRR000000BBBBB, leaving room for the blend products
+#define BLEND_MASK              (0x07E0F81F)
+
+static inline uint16_t minU16(uint32_t a, uint32_t b)
+{
+    return (uint16_t)(a < b ? a : b);
+}
+
+#if PIXEL_KERNELS_PIE
+
+/*
+* EE.VLD.128 / EE.VST.128 ignore the low four address bits, so only the part of
+* the buffers that is 16 byte aligned goes through the vector registers.
+* q0 and q1 are not saved across calls, the kernels must run in task context.
+*/
+void pixelFill(uint16_t *dst, uint16_t color, uint32_t count)
+{
+    while (((uintptr_t)dst & 15) && count) {
+        *dst++ = color;
+        count--;
+    }
+    uint32_t blocks = count >> 3;
+    if (blocks) {
+        const uint16_t value = color;
+        __asm__ volatile("ee.vldbc.16 q0, %0" :: "r"(&value) : "memory");
+        while (blocks--) {
+            __asm__ volatile("ee.vst.128.ip q0, %0, 16" : "+r"(dst) :: "memory");
+        }
+    }
+    count &= 7;
+    while (count--) {
+        *dst++ = color;
+    }
+}
+
+void pixelCopy(uint16_t *dst, const uint16_t *src, uint32_t count)
+{
+    if ((((uintptr_t)dst ^ (uintptr_t)src) & 15) || count < 16) {
+        memcpy(dst, src, count * sizeof(uint16_t));
+        return;
+    }
+    while (((uintptr_t)dst & 15) && count) {
+        *dst++ = *src++;
+        count--;
+    }
+    uint32_t blocks = count >> 4;
+    while (blocks--) {
+        __asm__ volatile(
+            "ee.vld.128.ip q0, %0, 16\n"
+            "ee.vld.128.ip q1, %0, 16\n"
+            "ee.vst.128.ip q0, %1, 16\n"
+            "ee.vst.128.ip q1, %1, 16\n"
+            : "+r"(src), "+r"(dst) :: "memory");
+    }
+    memcpy(dst, src, (count & 15) * sizeof(uint16_t));
+}
+
+#else
+
+void pixelFill(uint16_t *dst, uint16_t color, uint32_t count)
+{
+    if (((uintptr_t)dst & 2) && count) {
+        *dst++ = color;
+        count--;
+    }
+    uint32_t *d32 = (uint32_t *)dst;
+    uint32_t pair = ((uint32_t)color << 16) | color;
+    uint32_t words = count >> 1;
+    while (words >= 4) {
+        d32[0] = pair;
+        d32[1] = pair;
+        d32[2] = pair;
+        d32[3] = pair;
+        d32 += 4;
+        words -= 4;
+    }
+    while (words--) {
+        *d32++ = pair;
+    }
+    if (count & 1) {
+        *(uint16_t *)d32 = color;
+    }
+}
+
+void pixelCopy(uint16_t *dst, const uint16_t *src, uint32_t count)
+{
+    memcpy(dst, src, count * sizeof(uint16_t));
+}
+
+#endif
+
+/*
+* When both pointers share the same word alignment two pixels are handled per
+* 32-bit load/store.
+*/
+void pixelSwapCopy(uint16_t *dst, const uint16_t *src, uint32_t count)
+{
+    if (((((uintptr_t)dst) ^ ((uintptr_t)src)) & 3) == 0) {
+        if (((uintptr_t)src & 3) && count) {
+            *dst++ = __builtin_bswap16(*src++);
+            count--;
+        }
+        uint32_t *d32 = (uint32_t *)dst;
+        const uint32_t *s32 = (const uint32_t *)src;
+        uint32_t words = count >> 1;
+        while (words >= 4) {
+            uint32_t v0 = s32[0], v1 = s32[1], v2 = s32[2], v3 = s32[3];
+            d32[0] = SWAP_PAIR(v0);
+            d32[1] = SWAP_PAIR(v1);
+            d32[2] = SWAP_PAIR(v2);
+            d32[3] = SWAP_PAIR(v3);
+            d32 += 4;
+            s32 += 4;
+            words -= 4;
+        }
+        while (words--) {
+            uint32_t v = *s32++;
+            *d32++ = SWAP_PAIR(v);
+        }
+        dst = (uint16_t *)d32;
+        src = (const uint16_t *)s32;
+        count &= 1;
+    }
+    while (count--) {
+        *dst++ = __builtin_bswap16(*src++);
+    }
+}
+
+/*
+* Works on small square tiles so that a PSRAM source is read row by row and
+* the touched cache lines are reused before they are evicted.
+*/
+void pixelRotate90Strip(uint16_t *dst, const uint16_t *src, uint16_t src_w, uint16_t src_h,
+                        uint16_t col_start, uint16_t col_end, bool swap)
+{
+    for (uint16_t ib = 0; ib < src_h; ib += PIXEL_ROTATE_TILE) {
+        uint16_t ie = minU16(ib + PIXEL_ROTATE_TILE, src_h);
+        for (uint16_t jb = col_start; jb < col_end; jb += PIXEL_ROTATE_TILE) {
+            uint16_t je = minU16(jb + PIXEL_ROTATE_TILE, col_end);
+            for (uint16_t i = ib; i < ie; i++) {
+                const uint16_t *s = src + (uint32_t)(src_h - i - 1) * src_w;
+                uint16_t *d = dst + i;
+                if (swap) {
+                    for (uint16_t j = jb; j < je; j++) {
+                        d[(uint32_t)(j - col_start) * src_h] = __builtin_bswap16(s[j]);
+                    }
+                } else {
+                    for (uint16_t j = jb; j < je; j++) {
+                        d[(uint32_t)(j - col_start) * src_h] = s[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void pixelRotate90(uint16_t *dst, const uint16_t *src, uint16_t src_w, uint16_t src_h, bool swap)
+{
+    pixelRotate90Strip(dst, src, src_w, src_h, 0, src_w, swap);
+}
+
+// Source column j becomes destination row col_end - 1 - j
+void pixelRotate270Strip(uint16_t *dst, const uint16_t *src, uint16_t src_w, uint16_t src_h,
+                         uint16_t col_start, uint16_t col_end, bool swap)
+{
+    for (uint16_t ib = 0; ib < src_h; ib += PIXEL_ROTATE_TILE) {
+        uint16_t ie = minU16(ib + PIXEL_ROTATE_TILE, src_h);
+        for (uint16_t jb = col_start; jb < col_end; jb += PIXEL_ROTATE_TILE) {
+            uint16_t je = minU16(jb + PIXEL_ROTATE_TILE, col_end);
+            for (uint16_t i = ib; i < ie; i++) {
+                const uint16_t *s = src + (uint32_t)i * src_w;
+                uint16_t *d = dst + i;
+                if (swap) {
+                    for (uint16_t j = jb; j < je; j++) {
+                        d[(uint32_t)(col_end - 1 - j) * src_h] = __builtin_bswap16(s[j]);
+                    }
+                } else {
+                    for (uint16_t j = jb; j < je; j++) {
+                        d[(uint32_t)(col_end - 1 - j) * src_h] = s[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void pixelRotate270(uint16_t *dst, const uint16_t *src, uint16_t src_w, uint16_t src_h, bool swap)
+{
+    pixelRotate270Strip(dst, src, src_w, src_h, 0, src_w, swap);
+}
+
+// Every source row is written reversed into the mirrored destination row
+void pixelRotate180(uint16_t *dst, const uint16_t *src, uint16_t src_w, uint16_t src_h, bool swap)
+{
+    for (uint16_t i = 0; i < src_h; i++) {
+        const uint16_t *s = src + (uint32_t)i * src_w;
+        uint16_t *d = dst + (uint32_t)(src_h - i - 1) * src_w + src_w;
+        if (swap) {
+            for (uint16_t j = 0; j < src_w; j++) {
+                *--d = __builtin_bswap16(s[j]);
+            }
+        } else {
+            for (uint16_t j = 0; j < src_w; j++) {
+                *--d = s[j];
+            }
+        }
+    }
+}
+
+/*
+* The three channels are spread apart in one 32-bit word so that a single
+* multiply blends all of them, a negative difference borrows only from the
+* unused bits above each channel which the mask clears again.
+*/
+void pixelBlend(uint16_t *dst, const uint16_t *src, uint32_t count, uint8_t alpha)
+{
+    uint32_t a = (alpha + 4) >> 3;
+    if (a == 0) {
+        return;
+    }
+    if (a == 32) {
+        pixelCopy(dst, src, count);
+        return;
+    }
+    while (count--) {
+        uint32_t fg = *src++;
+        uint32_t bg = *dst;
+        fg = (fg | (fg << 16)) & BLEND_MASK;
+        bg = (bg | (bg << 16)) & BLEND_MASK;
+        uint32_t v = ((((fg - bg) * a) >> 5) + bg) & BLEND_MASK;
+        *dst++ = (uint16_t)((v >> 16) | v);
+    }
+}
+
+void pixelRGB888To565(uint16_t *dst, const uint8_t *src, uint32_t count, bool swap)
+{
+    while (count--) {
+        uint16_t c = (uint16_t)(((src[0] & 0xF8) << 8) | ((src[1] & 0xFC) << 3) | (src[2] >> 3));
+        *dst++ = swap ? __builtin_bswap16(c) : c;
+        src += 3;
+    }
+}
+
+/*
+* Rows are compared with memcmp first, only the changed rows are scanned
+* pixel by pixel for the left and right edge.
+*/
+bool pixelChangedArea(const uint16_t *cur, const uint16_t *prev, uint32_t stride,
+                      uint16_t *x, uint16_t *y, uint16_t *w, uint16_t *h)
+{
+    const uint32_t origin = (uint32_t)*y * stride + *x;
+    const uint16_t width = *w;
+    const size_t row_bytes = width * sizeof(uint16_t);
+    uint16_t top = 0, bottom = *h;
+
+    while (top < bottom && !memcmp(cur + origin + (uint32_t)top * stride, prev + origin + (uint32_t)top * stride, row_bytes)) {
+        top++;
+    }
+    if (top == bottom) {
+        return false;
+    }
+    while (!memcmp(cur + origin + (uint32_t)(bottom - 1) * stride, prev + origin + (uint32_t)(bottom - 1) * stride, row_bytes)) {
+        bottom--;
+    }
+
+    uint16_t left = width, right = 0;
+    for (uint16_t i = top; i < bottom; i++) {
+        const uint16_t *c = cur + origin + (uint32_t)i * stride;
+        const uint16_t *p = prev + origin + (uint32_t)i * stride;
+        for (uint16_t j = 0; j < left; j++) {
+            if (c[j] != p[j]) {
+                left = j;
+                break;
+            }
+        }
+        for (uint16_t j = width; j > right; j--) {
+            if (c[j - 1] != p[j - 1]) {
+                right = j;
+                break;
+            }
+        }
+    }
+
+    *x += left;
+    *y += top;
+    *w = right - left;
+    *h = bottom - top;
+    return true;
+}
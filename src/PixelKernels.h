@@ -0,0 +1,92 @@
+/**
+ * @file      PixelKernels.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+* RGB565 pixel kernels used by the display driver and the LVGL glue.
+* Pixels are 16 bit values in CPU byte order unless noted, swap true writes
+* them high byte first as the panel expects on the bus.
+* The portable versions work on 32 bit words and build on any host. On the
+* ESP32-S3 fill and copy can use the 128 bit PIE load/store instructions,
+* set PIXEL_KERNELS_PIE to 1 to enable them. The PIE versions keep data in
+* q0 / q1 across loop iterations, esp-idf saves those registers on a context
+* switch only from 5.3, so they are refused on older versions. They have not
+* been run on hardware yet and are off by default.
+* No kernel may be called from interrupt context.
+*/
+
+#ifndef PIXEL_KERNELS_PIE
+#define PIXEL_KERNELS_PIE   0
+#endif
+
+#if PIXEL_KERNELS_PIE
+#if defined(ESP_PLATFORM)
+#include "sdkconfig.h"
+#include "esp_idf_version.h"
+#endif
+#if !defined(CONFIG_IDF_TARGET_ESP32S3)
+#error "PIXEL_KERNELS_PIE requires an ESP32-S3"
+#elif ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 3, 0)
+#error "PIXEL_KERNELS_PIE requires esp-idf 5.3 or later, older versions do not save the PIE registers on a context switch"
+#endif
+#endif
+
+// Set count pixels to color
+void pixelFill(uint16_t *dst, uint16_t color, uint32_t count);
+
+// Copy count pixels, the buffers must not overlap
+void pixelCopy(uint16_t *dst, const uint16_t *src, uint32_t count);
+
+// Copy count pixels swapping the two bytes of each one, dst may be src
+void pixelSwapCopy(uint16_t *dst, const uint16_t *src, uint32_t count);
+
+/*
+* Rotate the src_w x src_h image 90 degrees clockwise, dst is src_h pixels wide.
+* The strip version only rotates the source columns [col_start, col_end), each
+* one becomes a destination row of src_h pixels starting at dst. src_w is only
+* used as the row stride there, so columns of a larger buffer can be rotated.
+*/
+void pixelRotate90(uint16_t *dst, const uint16_t *src, uint16_t src_w, uint16_t src_h, bool swap);
+void pixelRotate90Strip(uint16_t *dst, const uint16_t *src, uint16_t src_w, uint16_t src_h,
+                        uint16_t col_start, uint16_t col_end, bool swap);
+
+// Rotate 180 degrees, dst has the size of src
+void pixelRotate180(uint16_t *dst, const uint16_t *src, uint16_t src_w, uint16_t src_h, bool swap);
+
+/*
+* Rotate 270 degrees clockwise, dst is src_h pixels wide. The strip version
+* rotates the source columns [col_start, col_end), column col_end - 1 becomes
+* the first destination row. src_w is only used as the row stride there.
+*/
+void pixelRotate270(uint16_t *dst, const uint16_t *src, uint16_t src_w, uint16_t src_h, bool swap);
+void pixelRotate270Strip(uint16_t *dst, const uint16_t *src, uint16_t src_w, uint16_t src_h,
+                         uint16_t col_start, uint16_t col_end, bool swap);
+
+/*
+* Blend count src pixels over dst, alpha 0 keeps dst and 255 gives src.
+* Every channel becomes (src * a + dst * (32 - a)) >> 5 with a = (alpha + 4) >> 3,
+* the resolution of the RGB565 green channel.
+*/
+void pixelBlend(uint16_t *dst, const uint16_t *src, uint32_t count, uint8_t alpha);
+
+// Convert count R, G, B byte triplets to RGB565, the low bits of every channel are dropped
+void pixelRGB888To565(uint16_t *dst, const uint8_t *src, uint32_t count, bool swap);
+
+/*
+* Shrink the width x height area at cur to the bounding box of the pixels that
+* differ from prev, both buffers have rows stride pixels apart.
+* x, y, w, h are in and out, x and y are absolute in the buffers: the area
+* starts at cur[y * stride + x], and so does the returned box.
+* Returns false if nothing changed.
+*/
+bool pixelChangedArea(const uint16_t *cur, const uint16_t *prev, uint32_t stride,
+                      uint16_t *x, uint16_t *y, uint16_t *w, uint16_t *h);
@@ -0,0 +1,88 @@
+/**
+ * @file      TouchFilter.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+
+#include "TouchFilter.h"
+#include <math.h>
+
+#define TOUCH_FILTER_PI     (3.14159265f)
+
+static const TouchFilterConfig_t defaultConfig = TOUCH_FILTER_DEFAULT;
+
+// Smoothing factor of a first order low pass with the given cutoff
+static inline float smoothing(float cutoff, float dt)
+{
+    float tau = 1.0f / (2.0f * TOUCH_FILTER_PI * cutoff);
+    return 1.0f / (1.0f + tau / dt);
+}
+
+TouchFilter::TouchFilter()
+{
+    setConfig(defaultConfig);
+    reset();
+}
+
+TouchFilter::TouchFilter(const TouchFilterConfig_t &config)
+{
+    setConfig(config);
+    reset();
+}
+
+void TouchFilter::setConfig(const TouchFilterConfig_t &config)
+{
+    _config = config;
+}
+
+void TouchFilter::reset()
+{
+    _pressed = false;
+    _timestamp = 0;
+    _x = _y = 0;
+    _dx = _dy = 0;
+}
+
+void TouchFilter::update(TouchEvent_t *sample)
+{
+    if (!sample->points) {
+        _pressed = false;
+        return;
+    }
+    float dt = (float)(sample->timestamp - _timestamp) / 1000000.0f;
+    if (!_pressed || dt <= 0) {
+        // Touch down, or a sample without time in between, start from the raw point
+        if (!_pressed) {
+            _x = sample->x;
+            _y = sample->y;
+            _dx = _dy = 0;
+            _pressed = true;
+        }
+        _timestamp = sample->timestamp;
+        return;
+    }
+    _timestamp = sample->timestamp;
+
+    // Speed of the raw point against the last filtered one, smoothed on its own
+    float a = smoothing(_config.dCutoff, dt);
+    _dx += a * ((sample->x - _x) / dt - _dx);
+    _dy += a * ((sample->y - _y) / dt - _dy);
+
+    // The faster the finger, the higher the cutoff and the less lag
+    float speed = sqrtf(_dx * _dx + _dy * _dy);
+    a = smoothing(_config.minCutoff + _config.beta * speed, dt);
+    _x += a * (sample->x - _x);
+    _y += a * (sample->y - _y);
+
+    float px = _dx * _config.predictMs / 1000.0f, py = _dy * _config.predictMs / 1000.0f;
+    float lead = sqrtf(px * px + py * py);
+    if (lead > _config.maxPredict) {
+        px *= _config.maxPredict / lead;
+        py *= _config.maxPredict / lead;
+    }
+    sample->x = (int16_t)lroundf(_x + px);
+    sample->y = (int16_t)lroundf(_y + py);
+}
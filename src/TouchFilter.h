@@ -0,0 +1,55 @@
+/**
+ * @file      TouchFilter.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include "TouchRing.h"
+
+/*
+* One Euro filter on the first finger with a short position prediction.
+* A slow finger is smoothed hard, which removes the jitter of a finger held
+* still, a fast finger barely at all, so dragging does not lag behind. The
+* filtered speed then moves the point predictMs ahead to make up for the time
+* between the touch sample and the frame that shows it, see
+* getLvglTouchLatency for the measured delay.
+* Builds on the host, see tools/touch_filter.
+*/
+
+typedef struct __TouchFilterConfig {
+    float minCutoff;            // Hz, smoothing of a finger held still, lower is smoother
+    float beta;                 // Cutoff increase per pixel per second of speed, higher lags less
+    float dCutoff;              // Hz, smoothing of the speed
+    uint16_t predictMs;         // Time the point is moved ahead, 0 only smooths
+    uint16_t maxPredict;        // Pixels the prediction may lead the filtered point
+} TouchFilterConfig_t;
+
+#define TOUCH_FILTER_DEFAULT    {1.0f, 0.05f, 4.0f, 16, 24}
+// Board presets, tuned with tools/touch_filter for the report rate and noise of each controller
+#define TOUCH_FILTER_AMOLED_147 {0.5f, 0.05f, 4.0f, 20, 24}     // CHSC5816, 16ms reports
+#define TOUCH_FILTER_AMOLED_191 {0.5f, 0.02f, 8.0f, 12, 16}     // CST816, 10ms reports
+#define TOUCH_FILTER_AMOLED_241 {2.0f, 0.05f, 4.0f, 16, 16}     // CST226, 10ms reports, larger frames
+
+class TouchFilter
+{
+public:
+    TouchFilter();
+    explicit TouchFilter(const TouchFilterConfig_t &config);
+
+    void setConfig(const TouchFilterConfig_t &config);
+    // Filter one sample in place, a release passes unchanged and restarts the filter
+    void update(TouchEvent_t *sample);
+    void reset();
+
+private:
+    TouchFilterConfig_t _config;
+    bool _pressed;
+    int64_t _timestamp;
+    float _x, _y;               // Filtered position
+    float _dx, _dy;             // Filtered speed, pixels per second
+};
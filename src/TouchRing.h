@@ -0,0 +1,158 @@
+/**
+ * @file      TouchRing.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+/*
+* Touch samples handed from the interrupt driven sampler task to the lvgl
+* input read callback. The ring has exactly one producer and one consumer and
+* needs no lock, the producer only writes head and the consumer only tail.
+* When the ring is full new samples are dropped and counted, the samples
+* already queued are never overwritten. The last slot only takes a release,
+* so the release that ends a touch always finds room behind its samples.
+* Builds on the host, see tools/touch_ring.
+*/
+
+#ifndef TOUCH_RING_SIZE
+#define TOUCH_RING_SIZE     (32)        // Power of two
+#endif
+
+typedef struct __TouchEvent {
+    int64_t timestamp;          // Time of the interrupt that produced the sample, microseconds
+    int16_t x;                  // Screen coordinates, valid when points is not 0
+    int16_t y;
+    uint8_t points;             // Fingers down, 0 is a release
+    int16_t x2;                 // Second finger, valid when points is 2 or more
+    int16_t y2;
+} TouchEvent_t;
+
+#define TOUCH_SNAPSHOT_WORDS    ((sizeof(TouchEvent_t) + 3) / 4)
+
+class TouchRing
+{
+public:
+    TouchRing() : _head(0), _tail(0), _dropped(0) {}
+
+    // Producer side, returns false and counts the sample if the ring is full
+    bool push(const TouchEvent_t &event)
+    {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t limit = event.points ? TOUCH_RING_SIZE - 1 : TOUCH_RING_SIZE;
+        if (head - _tail.load(std::memory_order_acquire) >= limit) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _events[head & (TOUCH_RING_SIZE - 1)] = event;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, returns false if the ring is empty
+    bool pop(TouchEvent_t *event)
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        *event = _events[tail & (TOUCH_RING_SIZE - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Samples waiting, exact on the consumer side
+    uint32_t available()
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed);
+    }
+
+    // Consumer side, drop everything queued
+    void clear()
+    {
+        _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    uint32_t dropped()
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    void resetDropped()
+    {
+        _dropped.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static_assert((TOUCH_RING_SIZE & (TOUCH_RING_SIZE - 1)) == 0, "TOUCH_RING_SIZE must be a power of two");
+
+    TouchEvent_t _events[TOUCH_RING_SIZE];
+    std::atomic<uint32_t> _head;
+    std::atomic<uint32_t> _tail;
+    std::atomic<uint32_t> _dropped;
+};
+
+/*
+* Latest sample for readers that only want the current state (getPoint),
+* written by the sampler task and read from any task without draining the
+* ring. The sequence is odd while a write is in progress, a reader that saw
+* it odd or changed copies again. There is one writer, it must not be
+* preempted by a reader on its core in the middle of store(), the driver
+* stores under its touch lock.
+*/
+class TouchSnapshot
+{
+public:
+    TouchSnapshot() : _seq(0)
+    {
+        clear();
+    }
+
+    // Writer side
+    void store(const TouchEvent_t &event)
+    {
+        uint32_t words[TOUCH_SNAPSHOT_WORDS] = {0};
+        memcpy(words, &event, sizeof(TouchEvent_t));
+        uint32_t seq = _seq.load(std::memory_order_relaxed);
+        _seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (uint32_t i = 0; i < TOUCH_SNAPSHOT_WORDS; i++) {
+            _words[i].store(words[i], std::memory_order_relaxed);
+        }
+        _seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // Reader side, any number of readers
+    void load(TouchEvent_t *event) const
+    {
+        uint32_t words[TOUCH_SNAPSHOT_WORDS];
+        uint32_t seq;
+        do {
+            seq = _seq.load(std::memory_order_acquire);
+            for (uint32_t i = 0; i < TOUCH_SNAPSHOT_WORDS; i++) {
+                words[i] = _words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) || seq != _seq.load(std::memory_order_relaxed));
+        memcpy(event, words, sizeof(TouchEvent_t));
+    }
+
+    // Writer side, a released state
+    void clear()
+    {
+        TouchEvent_t event;
+        memset(&event, 0, sizeof(event));
+        store(event);
+    }
+
+private:
+    std::atomic<uint32_t> _seq;
+    std::atomic<uint32_t> _words[TOUCH_SNAPSHOT_WORDS];
+};
@@ -8,9 +8,77 @@
  */
 
 #include "initSequence.h"
+#include <stddef.h>
+
+/*
+* The readable lcd_cmd_t tables below are only used at compile time, they are
+* packed into lcd_init_t byte streams by the constexpr helpers that follow and
+* only the packed form ends up in flash.
+*
+* Packed entry: opcode, len (parameter count in bits 0-4, delay flags as in
+* lcd_cmd_t::len), then the parameter bytes.
+*/
+
+template <size_t... I> struct lcd_index_seq {
+    typedef lcd_index_seq type;
+};
+
+template <class A, class B> struct lcd_index_concat;
+template <size_t... A, size_t... B> struct lcd_index_concat<lcd_index_seq<A...>, lcd_index_seq<B...>>
+            : lcd_index_seq < A..., (sizeof...(A) + B)... > {};
+
+// Logarithmic depth, a full sequence is well over a thousand bytes
+template <size_t N> struct lcd_make_index_seq
+    : lcd_index_concat < typename lcd_make_index_seq < N / 2 >::type, typename lcd_make_index_seq < N - N / 2 >::type > {};
+template <> struct lcd_make_index_seq<0> : lcd_index_seq<> {};
+template <> struct lcd_make_index_seq<1> : lcd_index_seq<0> {};
+
+static constexpr uint32_t lcdParamCount(const lcd_cmd_t &c)
+{
+    return (c.len & 0x1F) > sizeof(c.param) ? sizeof(c.param) : (c.len & 0x1F);
+}
+
+static constexpr uint32_t lcdEntrySize(const lcd_cmd_t &c)
+{
+    return 2 + lcdParamCount(c);
+}
+
+static constexpr uint32_t lcdPackedSize(const lcd_cmd_t *t, uint32_t n)
+{
+    return n == 0 ? 0 : lcdEntrySize(*t) + lcdPackedSize(t + 1, n - 1);
+}
+
+static constexpr bool lcdTableValid(const lcd_cmd_t *t, uint32_t n)
+{
+    return n == 0 ? true : (t->addr <= 0xFF && (t->len & 0x1F) <= sizeof(t->param) && lcdTableValid(t + 1, n - 1));
+}
+
+static constexpr uint8_t lcdPackedByte(const lcd_cmd_t *t, uint32_t i)
+{
+    return i == 0 ? (uint8_t)t->addr :
+           i == 1 ? (uint8_t)t->len :
+           i < lcdEntrySize(*t) ? t->param[i - 2] :
+           lcdPackedByte(t + 1, i - lcdEntrySize(*t));
+}
+
+template <const lcd_cmd_t *T, class Seq> struct lcd_packed;
+template <const lcd_cmd_t *T, size_t... I> struct lcd_packed<T, lcd_index_seq<I...>> {
+    static const uint8_t data[sizeof...(I)];
+};
+template <const lcd_cmd_t *T, size_t... I>
+const uint8_t lcd_packed<T, lcd_index_seq<I...>>::data[sizeof...(I)] = {lcdPackedByte(T, I)...};
+
+#define LCD_PACK_SEQUENCE(name, table, count)                                                   \
+    static_assert(lcdTableValid(table, count), #table " has a command above 0xFF or too many parameters"); \
+    const lcd_init_t name = {                                                                   \
+        lcd_packed<table, lcd_make_index_seq<lcdPackedSize(table, count)>::type>::data,         \
+        lcdPackedSize(table, count),                                                            \
+        count                                                                                   \
+    }
 
 
-const lcd_cmd_t sh8501_cmd[SH8501_INIT_SEQUENCE_LENGTH] = {
+
+static constexpr lcd_cmd_t sh8501_cmd[SH8501_INIT_SEQUENCE_LENGTH] = {
 
     // ===  CMD2 password  ===
     {0xfe, {0x20}, 0x01},
@@ -502,7 +570,7 @@ const lcd_cmd_t sh8501_cmd[SH8501_INIT_SEQUENCE_LENGTH] = {
     {0x29, {}, 0x80},
 };
 
-const lcd_cmd_t rm67162_cmd[RM67162_INIT_SEQUENCE_LENGTH] = {
+static constexpr lcd_cmd_t rm67162_cmd[RM67162_INIT_SEQUENCE_LENGTH] = {
     {0xFE, {0x00}, 0x01}, //SET APGE 00H
     {0x11, {0x00}, 0x80}, // Sleep Out
 
@@ -526,7 +594,7 @@ const lcd_cmd_t rm67162_cmd[RM67162_INIT_SEQUENCE_LENGTH] = {
     {0x51, {AMOLED_DEFAULT_BRIGHTNESS}, 0x01} // Write Display Brightness   MAX_VAL=0XFF
 };
 
-const lcd_cmd_t rm67162_spi_cmd[RM67162_INIT_SPI_SEQUENCE_LENGTH] = {
+static constexpr lcd_cmd_t rm67162_spi_cmd[RM67162_INIT_SPI_SEQUENCE_LENGTH] = {
     {0xFE, {0x04}, 0x01}, //SET APGE3
     {0x6A, {0x00}, 0x01},
     {0xFE, {0x05}, 0x01}, //SET APGE4
@@ -548,7 +616,7 @@ const lcd_cmd_t rm67162_spi_cmd[RM67162_INIT_SPI_SEQUENCE_LENGTH] = {
     {0x29, {0x00}, 0x01 | 0x80},
 };
 
-const lcd_cmd_t rm690b0_cmd[RM690B0_INIT_SEQUENCE_LENGTH] = {
+static constexpr lcd_cmd_t rm690b0_cmd[RM690B0_INIT_SEQUENCE_LENGTH] = {
     {0xFE, {0x20}, 0x01},           //SET PAGE
     {0x26, {0x0A}, 0x01},           //MIPI OFF
     {0x24, {0x80}, 0x01},           //SPI write RAM
@@ -655,5 +723,7 @@ const lcd_cmd_t jd9613_cmd[JD9613_INIT_SEQUENCE_LENGTH] = {
 };
 
 
-
-
+LCD_PACK_SEQUENCE(sh8501_init, sh8501_cmd, SH8501_INIT_SEQUENCE_LENGTH);
+LCD_PACK_SEQUENCE(rm67162_init, rm67162_cmd, RM67162_INIT_SEQUENCE_LENGTH);
+LCD_PACK_SEQUENCE(rm67162_spi_init, rm67162_spi_cmd, RM67162_INIT_SPI_SEQUENCE_LENGTH);
+LCD_PACK_SEQUENCE(rm690b0_init, rm690b0_cmd, RM690B0_INIT_SEQUENCE_LENGTH);
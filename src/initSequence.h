@@ -16,16 +16,24 @@ typedef struct {
     uint32_t len;
 } lcd_cmd_t;
 
+// Packed init sequence generated from the lcd_cmd_t tables at compile time,
+// every entry is opcode, len (same bits as lcd_cmd_t::len) and the parameters
+typedef struct {
+    const uint8_t *data;
+    uint32_t size;      // Bytes
+    uint32_t count;     // Commands
+} lcd_init_t;
+
 #define AMOLED_DEFAULT_BRIGHTNESS               175
 
 #define SH8501_INIT_SEQUENCE_LENGTH             407
-extern const lcd_cmd_t sh8501_cmd[SH8501_INIT_SEQUENCE_LENGTH];
+extern const lcd_init_t sh8501_init;
 #define SH8501_WIDTH                            368
 #define SH8501_HEIGHT                           194
 
 
 #define RM67162_INIT_SEQUENCE_LENGTH            12
-extern const lcd_cmd_t rm67162_cmd[RM67162_INIT_SEQUENCE_LENGTH];
+extern const lcd_init_t rm67162_init;
 #define RM67162_WIDTH                           240
 #define RM67162_HEIGHT                          536
 #define RM67162_MADCTL_MY                       0x80
@@ -37,7 +45,7 @@ extern const lcd_cmd_t rm67162_cmd[RM67162_INIT_SEQUENCE_LENGTH];
 #define RM67162_MADCTL_BGR                      0x08
 
 #define RM690B0_INIT_SEQUENCE_LENGTH             13
-extern const lcd_cmd_t rm690b0_cmd[RM690B0_INIT_SEQUENCE_LENGTH];
+extern const lcd_init_t rm690b0_init;
 #define RM690B0_WIDTH                            600
 #define RM690B0_HEIGHT                           450
 #define RM690B0_MADCTL_MY                       0x80
@@ -49,13 +57,14 @@ extern const lcd_cmd_t rm690b0_cmd[RM690B0_INIT_SEQUENCE_LENGTH];
 #define RM690B0_MADCTL_BGR                      0x08
 
 #define JD9613_INIT_SEQUENCE_LENGTH             88
+// Different length convention with a terminating entry, kept as a plain table
 extern const lcd_cmd_t jd9613_cmd[JD9613_INIT_SEQUENCE_LENGTH];
 #define JD9613_WIDTH                            294
 #define JD9613_HEIGHT                           126
 
 
 #define RM67162_INIT_SPI_SEQUENCE_LENGTH        18
-extern const lcd_cmd_t rm67162_spi_cmd[RM67162_INIT_SPI_SEQUENCE_LENGTH];
+extern const lcd_init_t rm67162_spi_init;
 
 
 
@@ -0,0 +1,162 @@
+/**
+ * @file      addr_window.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host check of the QSPI command stream of a flush. The driver runs against
+ * the recording bus of the host mock (tools/mock), a series of flushes is
+ * sent and the recorded transactions of each one are compared with the
+ * expected stream:
+ *
+ *   CASET, RASET   only when the window differs from the previous flush or
+ *                  the cache was dropped (rotation, direct CASET/RASET)
+ *   RAMWR          every flush, queued like the other commands
+ *   pixel chunks   one burst of chunk size transactions
+ *
+ * Every byte of the command transactions is compared, command 0x02 with the
+ * register in the address bits on one line, and the number of transactions
+ * per flush is printed. No transaction of a flush may be a polling one.
+ *
+ * Build : g++ -O2 -DARDUINO=10819 -DBOARD_HAS_PSRAM -DARDUINO_USB_CDC_ON_BOOT=1 -I../mock -I../../src
+ *         addr_window.cpp ../mock/MockHost.cpp ../../src/LilyGo_AMOLED.cpp ../../src/PixelKernels.cpp
+ *         ../../src/initSequence.cpp ../../src/I2CBus.cpp ../../src/BoardDetect.cpp
+ *         ../../src/TouchFilter.cpp -o addr_window
+ * Usage : addr_window [board 0: 1.91 inch, 1: 2.41 inch]
+ *
+ * Exits with 1 if any stream differs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "LilyGo_AMOLED.h"
+#include "MockHost.h"
+
+typedef struct {
+    uint8_t rotation;
+    uint16_t x, y, w, h;
+    bool setWindow;             // Expect CASET and RASET
+    const char *name;
+} FlushStep_t;
+
+typedef struct {
+    uint8_t reg;
+    std::vector<uint8_t> param;
+} Command_t;
+
+static LilyGo_AMOLED amoled;
+
+static void encodeWindow(std::vector<Command_t> &out, uint8_t reg, uint16_t start, uint16_t end)
+{
+    out.push_back({reg, {(uint8_t)(start >> 8), (uint8_t)start, (uint8_t)(end >> 8), (uint8_t)end}});
+}
+
+static bool runStep(const FlushStep_t &step, uint16_t *pixels)
+{
+    const BoardsConfigure_t *board = amoled.getBoardsConfigure();
+    const DisplayRotation_t *r = &board->display.rotation[step.rotation];
+    uint32_t len = (uint32_t)step.w * step.h;
+
+    std::vector<Command_t> expected;
+    if (step.setWindow) {
+        encodeWindow(expected, 0x2A, step.x + r->offsetX, step.x + step.w - 1 + r->offsetX);
+        encodeWindow(expected, 0x2B, step.y + r->offsetY, step.y + step.h - 1 + r->offsetY);
+    }
+    expected.push_back({0x2C, {}});
+    uint32_t chunks = (len + amoled.getChunkSize() - 1) / amoled.getChunkSize();
+
+    mockSPIClear();
+    amoled.pushColors(step.x, step.y, step.w, step.h, pixels);
+    const std::vector<MockSPIRecord_t> &records = mockSPIRecords();
+    MockSPIStats_t stats;
+    mockSPIGetStats(&stats);
+
+    bool ok = records.size() == expected.size() + chunks && !stats.polled;
+    if (!ok) {
+        printf("  %s: %zu transactions, %u polling, expected %zu queued\n", step.name, records.size(), stats.polled,
+               expected.size() + chunks);
+    }
+    for (size_t i = 0; ok && i < records.size(); i++) {
+        const MockSPIRecord_t &t = records[i];
+        if (i < expected.size()) {
+            const Command_t &c = expected[i];
+            ok = t.cmd == 0x02 && t.cmdBits == 8 && t.addr == ((uint32_t)c.reg << 8) && t.addrBits == 24 &&
+                 t.lines == 1 && t.data == c.param;
+        } else {
+            bool first = i == expected.size();
+            uint32_t n = i + 1 == records.size() ? len - (chunks - 1) * amoled.getChunkSize() : amoled.getChunkSize();
+            ok = t.lines == 4 && t.bytes == n * sizeof(uint16_t) &&
+                 (first ? (t.cmd == 0x32 && t.addr == 0x002C00) : t.cmdBits == 0 && t.addrBits == 0);
+        }
+        if (!ok) {
+            printf("  %s: transaction %zu differs, reg 0x%02X, %u bytes, %u lines\n", step.name, i,
+                   (t.addr >> 8) & 0xFF, t.bytes, t.lines);
+        }
+    }
+
+    printf("%-26s %s  commands:%zu chunks:%u polling:%u\n", step.name, ok ? "ok  " : "FAIL",
+           expected.size(), chunks, stats.polled);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    int board = argc > 1 ? atoi(argv[1]) : 0;
+    bool begun;
+    if (board == 1) {
+        mockI2CAddDevice(BOARD_AMOLED_241.pmu->sda, BOARD_AMOLED_241.pmu->scl, SY6970_SLAVE_ADDRESS);
+        begun = amoled.beginAMOLED_241(true);
+    } else {
+        begun = amoled.beginAMOLED_191(false);
+    }
+    if (!begun) {
+        printf("begin failed\n");
+        return 1;
+    }
+    mockSPIRecordPayload(true);
+
+    uint16_t *pixels = (uint16_t *)calloc(amoled.width() * amoled.height(), sizeof(uint16_t));
+    uint16_t w = amoled.width(), h = amoled.height();
+
+    static const FlushStep_t tmpl[] = {
+        {0, 0,  0,  0, 0, true,  "first window"},
+        {0, 0,  0,  0, 0, false, "same window"},
+        {0, 0,  0,  0, 0, false, "same window again"},
+        {0, 10, 20, 64, 32, true,  "moved window"},
+        {0, 10, 20, 64, 32, false, "moved window repeated"},
+        {0, 10, 20, 64, 33, true,  "one row taller"},
+        {1, 10, 20, 64, 33, true,  "after rotation"},
+        {1, 10, 20, 64, 33, false, "rotated repeated"},
+        {0, 0,  0,  0, 0, true,  "full after rotation"},
+        {0, 0,  0,  0, 0, true,  "after direct CASET"},
+    };
+
+    bool ok = true;
+    uint8_t rotation = 0;
+    for (size_t i = 0; i < sizeof(tmpl) / sizeof(*tmpl); i++) {
+        FlushStep_t step = tmpl[i];
+        if (step.rotation != rotation) {
+            amoled.setRotation(step.rotation);
+            rotation = step.rotation;
+            w = amoled.width();
+            h = amoled.height();
+        }
+        if (!step.w) {
+            step.w = w;
+            step.h = h;
+        }
+        if (!strcmp(step.name, "after direct CASET")) {
+            // Any CASET or RASET outside setAddrWindow drops the cache
+            lcd_cmd_t t = {0x2A, {0, 0, 0, 0}, 0x04};
+            amoled.writeCommands(&t, 1);
+            amoled.waitDMADone();
+        }
+        ok &= runStep(step, pixels);
+    }
+
+    free(pixels);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,251 @@
+/**
+ * @file      board_detect.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host check of the board detection. First the table engine (BoardDetect)
+ * runs on AMOLED_BOARD_PROBES against a fake bus that answers for the
+ * devices of each board:
+ *  - every board resolves to its entry, a 1.91 inch board without touch to
+ *    none, the SPI entry wins over the QSPI one that shares its pins
+ *  - every (pins, address) pair is probed at most once
+ *  - verify of a cached entry probes only the entries on its pins and fails
+ *    when another board is fitted, invalid arguments are refused
+ *  - a table with more pairs than the probe cache still resolves
+ *
+ * Then LilyGo_AMOLED::begin runs against the fake I2C bus and NVS of the host
+ * mock (tools/mock), a new driver instance per boot:
+ *  - cold boot: the probes are the ones of detectBoard, the board is stored
+ *  - warm boot: only the entries on the pins of the cached one are probed
+ *  - stale or invalid cache: full detection, the new board is stored
+ *  - nothing found: the 1.91 inch board without touch, the cache is removed
+ *
+ * Build : g++ -O2 -DARDUINO=10819 -DBOARD_HAS_PSRAM -DARDUINO_USB_CDC_ON_BOOT=1 -I../mock -I../../src
+ *         board_detect.cpp ../mock/MockHost.cpp ../../src/LilyGo_AMOLED.cpp ../../src/PixelKernels.cpp
+ *         ../../src/initSequence.cpp ../../src/I2CBus.cpp ../../src/BoardDetect.cpp
+ *         ../../src/TouchFilter.cpp -o board_detect
+ * Usage : board_detect
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <set>
+#include <tuple>
+#include <vector>
+#include "LilyGo_AMOLED.h"
+#include "Preferences.h"
+#include "MockHost.h"
+
+typedef std::tuple<int, int, uint8_t> I2CDevice_t;
+
+typedef struct {
+    const char *name;
+    uint8_t board;              // Expected detection result
+    std::vector<I2CDevice_t> devices;
+} BoardModel_t;
+
+static const uint32_t probeCount = sizeof(AMOLED_BOARD_PROBES) / sizeof(*AMOLED_BOARD_PROBES);
+
+static const std::vector<BoardModel_t> models = {
+    {"1.47 inch",           LILYGO_AMOLED_147,      {I2CDevice_t{1, 2, AXP2101_SLAVE_ADDRESS}}},
+    {"1.91 inch SPI",       LILYGO_AMOLED_191_SPI,  {I2CDevice_t{3, 2, CSTXXX_SLAVE_ADDRESS}, I2CDevice_t{3, 2, PCF85063_SLAVE_ADDRESS}, I2CDevice_t{3, 2, SY6970_SLAVE_ADDRESS}}},
+    {"1.91 inch",           LILYGO_AMOLED_191,      {I2CDevice_t{3, 2, CSTXXX_SLAVE_ADDRESS}}},
+    {"2.41 inch",           LILYGO_AMOLED_241,      {I2CDevice_t{6, 7, SY6970_SLAVE_ADDRESS}}},
+    {"1.91 inch no touch",  LILYGO_AMOLED_UNKNOWN,  {}},
+};
+
+typedef struct {
+    std::set<I2CDevice_t> devices;
+    std::vector<MockI2CProbe_t> log;
+} FakeBus_t;
+
+static bool fakeProbe(int sda, int scl, uint8_t address, void *user_data)
+{
+    FakeBus_t *bus = (FakeBus_t *)user_data;
+    bool found = bus->devices.count(I2CDevice_t{sda, scl, address}) != 0;
+    bus->log.push_back({sda, scl, address, found});
+    return found;
+}
+
+static bool expect(bool cond, const char *name)
+{
+    printf("%-40s %s\n", name, cond ? "ok" : "FAIL");
+    return cond;
+}
+
+static int indexOf(uint8_t board)
+{
+    for (uint32_t i = 0; i < probeCount; i++) {
+        if (AMOLED_BOARD_PROBES[i].board == board) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool probedOnce(const std::vector<MockI2CProbe_t> &log)
+{
+    std::set<I2CDevice_t> seen;
+    for (const MockI2CProbe_t &p : log) {
+        if (!seen.insert(I2CDevice_t{p.sda, p.scl, p.address}).second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool checkEngine()
+{
+    bool ok = true;
+    char name[64];
+    for (const BoardModel_t &m : models) {
+        FakeBus_t bus;
+        bus.devices.insert(m.devices.begin(), m.devices.end());
+        int index = detectBoard(AMOLED_BOARD_PROBES, probeCount, fakeProbe, &bus);
+        snprintf(name, sizeof(name), "detect %s", m.name);
+        ok &= expect(index == indexOf(m.board) && probedOnce(bus.log), name);
+
+        // Verify every cached entry, only the entries on the pins of the cached one are probed
+        for (uint32_t i = 0; i < probeCount; i++) {
+            bus.log.clear();
+            bool verified = verifyBoard(AMOLED_BOARD_PROBES, probeCount, i, fakeProbe, &bus);
+            bool pins = true;
+            for (const MockI2CProbe_t &p : bus.log) {
+                pins &= p.sda == AMOLED_BOARD_PROBES[i].sda && p.scl == AMOLED_BOARD_PROBES[i].scl;
+            }
+            if (verified != ((int)i == index) || !pins || !probedOnce(bus.log)) {
+                printf("  %s: verify of entry %u %s\n", m.name, i, verified ? "passed" : "failed");
+                ok = false;
+            }
+        }
+    }
+
+    FakeBus_t bus;
+    ok &= expect(detectBoard(NULL, probeCount, fakeProbe, &bus) == -1 &&
+                 detectBoard(AMOLED_BOARD_PROBES, probeCount, NULL, &bus) == -1 &&
+                 !verifyBoard(AMOLED_BOARD_PROBES, probeCount, probeCount, fakeProbe, &bus) && bus.log.empty(),
+                 "invalid arguments refused");
+
+    // More (pins, address) pairs than the probe cache holds, the last entry matches
+    std::vector<BoardProbe_t> large;
+    for (uint8_t i = 0; i < 12; i++) {
+        large.push_back({1, 2, (uint8_t)(0x20 + i), (uint8_t)(0x40 + i), i});
+    }
+    bus.devices = {I2CDevice_t{1, 2, 0x20 + 11}, I2CDevice_t{1, 2, 0x40 + 11}, I2CDevice_t{1, 2, 0x40}};
+    int index = detectBoard(large.data(), large.size(), fakeProbe, &bus);
+    ok &= expect(index == 11 && verifyBoard(large.data(), large.size(), 11, fakeProbe, &bus),
+                 "table larger than the probe cache");
+    return ok;
+}
+
+// One boot of a new driver instance on the mock bus
+static uint8_t boot(const BoardModel_t &m, std::vector<MockI2CProbe_t> *log)
+{
+    mockI2CClear();
+    for (const I2CDevice_t &d : m.devices) {
+        mockI2CAddDevice(std::get<0>(d), std::get<1>(d), std::get<2>(d));
+    }
+    mockSPIReset();
+    LilyGo_AMOLED amoled;
+    amoled.begin();
+    *log = mockI2CProbeLog();
+    return amoled.getBoardID();
+}
+
+static uint8_t storedBoard()
+{
+    Preferences prefs;
+    prefs.begin("amoled", true);
+    uint8_t board = prefs.getUChar("board", LILYGO_AMOLED_UNKNOWN);
+    prefs.end();
+    return board;
+}
+
+static void storeBoard(uint8_t board)
+{
+    Preferences prefs;
+    prefs.begin("amoled", false);
+    prefs.putUChar("board", board);
+    prefs.end();
+}
+
+static bool sameProbes(const std::vector<MockI2CProbe_t> &log, const std::vector<MockI2CProbe_t> &expected)
+{
+    if (log.size() != expected.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (log[i].sda != expected[i].sda || log[i].scl != expected[i].scl ||
+                log[i].address != expected[i].address || log[i].found != expected[i].found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+* A boot must send exactly the probes of the engine calls given, followed by
+* the probes of the board begin, which are taken from the cold boot.
+*/
+static bool checkBoot(const BoardModel_t &m)
+{
+    bool ok = true;
+    char name[64];
+    std::vector<MockI2CProbe_t> log, tail;
+    // Without a match the driver falls back to the 1.91 inch board
+    uint8_t expected = m.board == LILYGO_AMOLED_UNKNOWN ? LILYGO_AMOLED_191 : m.board;
+    FakeBus_t bus;
+    bus.devices.insert(m.devices.begin(), m.devices.end());
+
+    // Cold boot, full detection
+    mockPrefsClear();
+    detectBoard(AMOLED_BOARD_PROBES, probeCount, fakeProbe, &bus);
+    uint8_t board = boot(m, &log);
+    bool detected = log.size() >= bus.log.size() && sameProbes(std::vector<MockI2CProbe_t>(log.begin(),
+                    log.begin() + bus.log.size()), bus.log);
+    if (detected) {
+        tail.assign(log.begin() + bus.log.size(), log.end());
+    }
+    snprintf(name, sizeof(name), "%s cold boot", m.name);
+    ok &= expect(board == expected && storedBoard() == m.board && detected, name);
+
+    struct {
+        const char *name;
+        uint8_t cached;
+    } cases[] = {
+        {"warm boot", m.board},
+        {"stale cache", (uint8_t)(m.board == LILYGO_AMOLED_241 ? LILYGO_AMOLED_147 : LILYGO_AMOLED_241)},
+        {"invalid cache", 0x7F},
+    };
+    for (auto &c : cases) {
+        storeBoard(c.cached);
+        bus.log.clear();
+        int cached = indexOf(c.cached);
+        bool verified = cached >= 0 && verifyBoard(AMOLED_BOARD_PROBES, probeCount, cached, fakeProbe, &bus);
+        if (!verified) {
+            detectBoard(AMOLED_BOARD_PROBES, probeCount, fakeProbe, &bus);
+        }
+        bus.log.insert(bus.log.end(), tail.begin(), tail.end());
+        board = boot(m, &log);
+        snprintf(name, sizeof(name), "%s %s", m.name, c.name);
+        // A warm boot must find the cached board, nothing answers on the unknown one
+        bool path = c.cached == m.board ? verified || m.board == LILYGO_AMOLED_UNKNOWN : !verified;
+        ok &= expect(board == expected && storedBoard() == m.board && path && sameProbes(log, bus.log), name);
+    }
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    bool ok = checkEngine();
+    mockLogLevel = ARDUHAL_LOG_LEVEL_NONE;
+    for (const BoardModel_t &m : models) {
+        ok &= checkBoot(m);
+    }
+    return ok ? 0 : 1;
+}
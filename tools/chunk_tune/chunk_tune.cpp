@@ -0,0 +1,177 @@
+/**
+ * @file      chunk_tune.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host check of LilyGo_AMOLED::autoTuneChunkSize. The driver runs against the
+ * host mock (tools/mock) on the 1.91 inch QSPI board, every transaction costs
+ * a fixed overhead plus a cost model of its size on top of its bits:
+ *
+ *   fixed          the default queue and interrupt overhead only
+ *   high overhead  a slow interrupt path, larger chunks gain more
+ *   large stall    transactions over 16 KiB stall the bus, e.g. an arbiter
+ *   descriptors    every 4092 byte DMA descriptor adds a little, with a
+ *                  growing penalty for long descriptor chains
+ *
+ * For every model each candidate is timed with a full frame pushed from
+ * internal SRAM, the tuner must select the fastest one (the smallest on a
+ * tie) and store it. Then the NVS cache is checked: a stored size is used
+ * without sending anything, force tunes again and an invalid stored size is
+ * ignored.
+ *
+ * Build : g++ -O2 -DARDUINO=10819 -DBOARD_HAS_PSRAM -DARDUINO_USB_CDC_ON_BOOT=1 -I../mock -I../../src
+ *         chunk_tune.cpp ../mock/MockHost.cpp ../../src/LilyGo_AMOLED.cpp ../../src/PixelKernels.cpp
+ *         ../../src/initSequence.cpp ../../src/I2CBus.cpp ../../src/BoardDetect.cpp
+ *         ../../src/TouchFilter.cpp -o chunk_tune
+ * Usage : chunk_tune
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "LilyGo_AMOLED.h"
+#include "Preferences.h"
+#include "MockHost.h"
+
+typedef struct {
+    uint32_t overheadUs;        // Queued transaction overhead
+    MockSPICostHandler cost;
+    const char *name;
+} TuneModel_t;
+
+static const uint32_t candidates[] = {1024, 2048, 4096, 8192, 16384};
+
+static LilyGo_AMOLED amoled;
+static uint16_t *frame;
+
+static uint32_t largeStall(uint32_t bytes)
+{
+    return bytes > 16384 ? 300 : 0;
+}
+
+static uint32_t descriptors(uint32_t bytes)
+{
+    uint32_t n = (bytes + 4091) / 4092;
+    return n + n * n / 2;
+}
+
+static int64_t timeFrame(uint32_t chunk)
+{
+    uint32_t len = (uint32_t)amoled.width() * amoled.height();
+    amoled.setChunkSize(chunk);
+    int64_t start = mockNow();
+    amoled.setAddrWindow(0, 0, amoled.width() - 1, amoled.height() - 1);
+    amoled.pushColors(frame, len);
+    return mockNow() - start;
+}
+
+static bool tune(const TuneModel_t &model)
+{
+    mockSPISetOverhead(model.overheadUs, 15);
+    mockSPISetCostHandler(model.cost);
+
+    printf("%-14s", model.name);
+    uint32_t expected = 0;
+    int64_t best = INT64_MAX;
+    for (uint32_t chunk : candidates) {
+        // The window is sent once, the tuner averages over frames with a cached one
+        timeFrame(chunk);
+        int64_t us = timeFrame(chunk);
+        printf(" %5u:%6lld", chunk, (long long)us);
+        if (us < best) {
+            best = us;
+            expected = chunk;
+        }
+    }
+
+    amoled.setChunkSize(candidates[0]);
+    uint32_t selected = amoled.autoTuneChunkSize(true);
+    Preferences prefs;
+    prefs.begin("amoled", true);
+    char key[16];
+    snprintf(key, sizeof(key), "chunk%u", amoled.getBoardID());
+    uint32_t stored = prefs.getUInt(key, 0);
+    prefs.end();
+
+    bool ok = selected == expected && amoled.getChunkSize() == expected && stored == expected;
+    printf("  -> %5u %s\n", selected, ok ? "ok" : "FAIL");
+    if (!ok) {
+        printf("  expected %u, in use %u, stored %u\n", expected, amoled.getChunkSize(), stored);
+    }
+    return ok;
+}
+
+static bool checkCache()
+{
+    bool ok = true;
+    char key[16];
+    snprintf(key, sizeof(key), "chunk%u", amoled.getBoardID());
+
+    // A stored size is used as it is
+    mockSPISetOverhead(8, 15);
+    mockSPISetCostHandler(largeStall);
+    amoled.autoTuneChunkSize(true);
+    amoled.setChunkSize(candidates[0]);
+    mockSPIClear();
+    uint32_t selected = amoled.autoTuneChunkSize(false);
+    ok &= selected == 8192 && mockSPIRecords().empty();
+    printf("%-32s %s\n", "stored size, nothing sent", ok ? "ok" : "FAIL");
+
+    // The bus changed, only force measures again
+    mockSPISetCostHandler(NULL);
+    bool cached = amoled.autoTuneChunkSize(false) == 8192;
+    bool forced = amoled.autoTuneChunkSize(true) == 16384;
+    printf("%-32s %s\n", "force tunes again", cached && forced ? "ok" : "FAIL");
+    ok &= cached && forced;
+
+    // An invalid stored size is ignored
+    Preferences prefs;
+    prefs.begin("amoled", false);
+    prefs.putUInt(key, DISPLAY_MAX_CHUNK_SIZE + 1);
+    prefs.end();
+    mockSPIClear();
+    selected = amoled.autoTuneChunkSize(false);
+    bool invalid = selected == 16384 && !mockSPIRecords().empty();
+    printf("%-32s %s\n", "invalid stored size", invalid ? "ok" : "FAIL");
+    ok &= invalid;
+
+    // The selected size is used by the next flush
+    mockSPIClear();
+    timeFrame(amoled.getChunkSize());
+    bool used = true;
+    for (const MockSPIRecord_t &r : mockSPIRecords()) {
+        used &= r.lines != 4 || r.bytes <= selected * sizeof(uint16_t);
+    }
+    printf("%-32s %s\n", "flush uses the selected size", used ? "ok" : "FAIL");
+    return ok && used;
+}
+
+int main(int argc, char **argv)
+{
+    mockPrefsClear();
+    if (!amoled.beginAMOLED_191(false)) {
+        printf("begin failed\n");
+        return 1;
+    }
+    frame = (uint16_t *)calloc(amoled.width() * amoled.height(), sizeof(uint16_t));
+
+    static const TuneModel_t models[] = {
+        {8,  NULL,        "fixed"},
+        {40, NULL,        "high overhead"},
+        {8,  largeStall,  "large stall"},
+        {2,  descriptors, "descriptors"},
+    };
+
+    printf("# %ux%u frame, chunk:us per frame\n", amoled.width(), amoled.height());
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(models) / sizeof(*models); i++) {
+        ok &= tune(models[i]);
+    }
+    ok &= checkCache();
+    free(frame);
+    return ok ? 0 : 1;
+}
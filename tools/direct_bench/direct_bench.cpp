@@ -0,0 +1,313 @@
+/**
+ * @file      direct_bench.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host comparison of the lvgl helper render modes on the virtual display.
+ * A small synthetic UI (clock, spinner, progress bar, text cursor, button) is
+ * animated for a number of frames. Every frame invalidates the areas lvgl
+ * would, the pixels of those areas are "rendered" into a screen buffer and
+ * sent the way the helper sends them in each mode:
+ *
+ *   partial   dirty areas rendered into a separate buffer, sent as is
+ *   full      whole screen rendered and sent every frame
+ *   direct    rendered in place, dirty areas sent with pushRect
+ *   direct+   as direct, with the panel copy only changed pixels are sent
+ *
+ * The panel content is compared with the screen after every mode.
+ *
+ * Build : g++ -O2 -I../../src direct_bench.cpp ../../src/LilyGo_VirtualDisplay.cpp ../../src/PixelKernels.cpp
+ *         ../../src/initSequence.cpp -o direct_bench
+ * Usage : direct_bench [frames] [board 0-3] [rotation 0-3]
+ *
+ * Exits with 1 if the panel does not match the screen in any mode.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "LilyGo_VirtualDisplay.h"
+#include "PixelKernels.h"
+
+#define MAX_AREAS       (8)
+
+enum BenchMode {
+    MODE_PARTIAL,
+    MODE_FULL,
+    MODE_DIRECT,
+    MODE_DIRECT_COPY,
+    MODE_COUNT,
+};
+
+static const char *modeNames[MODE_COUNT] = {"partial", "full", "direct", "direct+"};
+
+typedef struct {
+    uint16_t x, y, w, h;
+} Area_t;
+
+typedef struct {
+    uint64_t rendered;          // Bytes written by the renderer
+    uint64_t sent;              // Pixel bytes on the bus
+    uint64_t busNs;
+    uint32_t transactions;
+    uint32_t areas;
+} ModeStats_t;
+
+static uint16_t screenW, screenH;
+
+static inline uint16_t rgb(uint8_t r, uint8_t g, uint8_t b)
+{
+    return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+}
+
+// Widget geometry, placed relative to the screen size
+static Area_t clockArea, spinnerArea, barArea, cursorArea, buttonArea;
+
+static void layout()
+{
+    clockArea = {8, 8, 128, 32};
+    spinnerArea = {(uint16_t)(screenW - 72), 8, 64, 64};
+    barArea = {8, (uint16_t)(screenH - 24), (uint16_t)(screenW - 16), 16};
+    cursorArea = {40, (uint16_t)(screenH / 2), 2, 20};
+    buttonArea = {(uint16_t)(screenW / 2 - 50), (uint16_t)(screenH / 2 - 20), 100, 40};
+}
+
+static bool inside(const Area_t &a, uint16_t x, uint16_t y)
+{
+    return x >= a.x && x < a.x + a.w && y >= a.y && y < a.y + a.h;
+}
+
+// Clock digit cells, a digit changes the pattern of its 16x32 cell only
+static uint16_t clockPixel(uint16_t x, uint16_t y, uint32_t frame)
+{
+    uint32_t seconds = 12 * 3600 + 34 * 60 + frame;
+    uint8_t digits[8] = {
+        (uint8_t)(seconds / 36000 % 10), (uint8_t)(seconds / 3600 % 10), 10,
+        (uint8_t)(seconds / 600 % 6), (uint8_t)(seconds / 60 % 10), 10,
+        (uint8_t)(seconds / 10 % 6), (uint8_t)(seconds % 10)
+    };
+    uint16_t cx = (x - clockArea.x) / 16, px = (x - clockArea.x) % 16, py = y - clockArea.y;
+    uint8_t d = digits[cx];
+    // Margin around the glyph stays background
+    if (px < 2 || px > 13 || py < 4 || py > 27) {
+        return 0;
+    }
+    bool on = ((px * 7 + py * 3 + d * 11) % 5) < (d == 10 ? 1 : 2);
+    return on ? 0xFFFF : 0;
+}
+
+static uint16_t spinnerPixel(uint16_t x, uint16_t y, uint32_t frame)
+{
+    int dx = x - (spinnerArea.x + 32), dy = y - (spinnerArea.y + 32);
+    int r2 = dx * dx + dy * dy;
+    if (r2 < 24 * 24 || r2 > 30 * 30) {
+        return 0;
+    }
+    // 16 sectors, a quarter of the ring is lit and moves one sector per frame
+    int sector = (int)((atan2(dy, dx) + M_PI) * 8 / M_PI) & 15;
+    return ((sector - (int)frame) & 15) < 4 ? rgb(0, 160, 255) : rgb(40, 40, 40);
+}
+
+static uint16_t barPixel(uint16_t x, uint16_t y, uint32_t frame)
+{
+    uint32_t value = frame % 101;
+    uint16_t fill = (uint16_t)((uint32_t)(barArea.w - 4) * value / 100);
+    if (x < barArea.x + 2 || x >= barArea.x + barArea.w - 2 || y < barArea.y + 2 || y >= barArea.y + barArea.h - 2) {
+        return rgb(80, 80, 80);
+    }
+    return x < barArea.x + 2 + fill ? rgb(0, 200, 80) : rgb(20, 20, 20);
+}
+
+static uint16_t backgroundPixel(uint16_t x, uint16_t y)
+{
+    return rgb(x * 255 / screenW, y * 255 / screenH, 64);
+}
+
+static uint16_t scenePixel(uint16_t x, uint16_t y, uint32_t frame)
+{
+    if (inside(clockArea, x, y)) {
+        return clockPixel(x, y, frame);
+    }
+    if (inside(spinnerArea, x, y)) {
+        return spinnerPixel(x, y, frame);
+    }
+    if (inside(barArea, x, y)) {
+        return barPixel(x, y, frame);
+    }
+    if (inside(cursorArea, x, y)) {
+        return (frame / 15) & 1 ? backgroundPixel(x, y) : 0xFFFF;
+    }
+    if (inside(buttonArea, x, y)) {
+        return frame % 60 >= 30 && frame % 60 < 36 ? rgb(200, 60, 60) : rgb(60, 60, 200);
+    }
+    return backgroundPixel(x, y);
+}
+
+// Areas lvgl invalidates in frame, rounded to even coordinates like the helper rounder
+static uint8_t dirtyAreas(uint32_t frame, Area_t *areas)
+{
+    uint8_t n = 0;
+    if (frame == 0) {
+        areas[n++] = {0, 0, screenW, screenH};
+        return n;
+    }
+    areas[n++] = clockArea;         // Label text is set every second
+    areas[n++] = spinnerArea;       // Arc angle changes
+    areas[n++] = barArea;           // Bar value changes, the whole bar is redrawn
+    if (frame % 15 == 0) {
+        areas[n++] = cursorArea;
+    }
+    if (frame % 60 == 30 || frame % 60 == 36) {
+        areas[n++] = buttonArea;
+    }
+    for (uint8_t i = 0; i < n; i++) {
+        uint16_t x2 = (areas[i].x + areas[i].w + 1) & ~1, y2 = (areas[i].y + areas[i].h + 1) & ~1;
+        areas[i].x &= ~1;
+        areas[i].y &= ~1;
+        areas[i].w = x2 - areas[i].x;
+        areas[i].h = y2 - areas[i].y;
+    }
+    return n;
+}
+
+static void render(uint16_t *screen, const Area_t &a, uint32_t frame)
+{
+    for (uint16_t y = a.y; y < a.y + a.h; y++) {
+        for (uint16_t x = a.x; x < a.x + a.w; x++) {
+            screen[(uint32_t)y * screenW + x] = scenePixel(x, y, frame);
+        }
+    }
+}
+
+// Same as push_direct_area in LV_Helper.cpp
+static void pushDirectArea(LilyGo_Display &display, uint16_t *screen, uint16_t *copy, bool copyValid,
+                           const Area_t &a, ModeStats_t &stats)
+{
+    uint16_t x = a.x, y = a.y, w = a.w, h = a.h;
+    if (copy && copyValid) {
+        if (!pixelChangedArea(screen, copy, screenW, &x, &y, &w, &h)) {
+            return;
+        }
+        uint16_t x2 = (x + w + 1) & ~1, y2 = (y + h + 1) & ~1;
+        x &= ~1;
+        y &= ~1;
+        w = x2 - x;
+        h = y2 - y;
+    }
+    uint32_t offset = (uint32_t)y * screenW + x;
+    display.pushRect(x, y, w, h, screen + offset, screenW);
+    stats.areas++;
+    if (copy) {
+        for (uint16_t i = 0; i < h; i++) {
+            pixelCopy(copy + offset + (uint32_t)i * screenW, screen + offset + (uint32_t)i * screenW, w);
+        }
+    }
+}
+
+static bool runMode(LilyGo_VirtualDisplay &display, BenchMode mode, uint32_t frames, ModeStats_t &stats)
+{
+    const uint32_t pixels = (uint32_t)screenW * screenH;
+    uint16_t *screen = (uint16_t *)calloc(pixels, sizeof(uint16_t));
+    uint16_t *other = (uint16_t *)calloc(pixels, sizeof(uint16_t));
+    if (!screen || !other) {
+        free(screen);
+        free(other);
+        return false;
+    }
+    memset(&stats, 0, sizeof(stats));
+    display.fillScreen(0);
+    display.resetBusStats();
+
+    Area_t areas[MAX_AREAS];
+    bool copyValid = false;
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        uint8_t n = dirtyAreas(frame, areas);
+        display.waitVSync();
+        switch (mode) {
+        case MODE_FULL: {
+            Area_t all = {0, 0, screenW, screenH};
+            render(screen, all, frame);
+            stats.rendered += pixels * sizeof(uint16_t);
+            display.pushColors(0, 0, screenW, screenH, screen);
+            stats.areas++;
+            break;
+        }
+        case MODE_PARTIAL:
+            for (uint8_t i = 0; i < n; i++) {
+                render(screen, areas[i], frame);
+                // The draw buffer holds only the area
+                for (uint16_t r = 0; r < areas[i].h; r++) {
+                    pixelCopy(other + (uint32_t)r * areas[i].w, screen + (uint32_t)(areas[i].y + r) * screenW + areas[i].x, areas[i].w);
+                }
+                stats.rendered += (uint32_t)areas[i].w * areas[i].h * sizeof(uint16_t);
+                display.pushColors(areas[i].x, areas[i].y, areas[i].w, areas[i].h, other);
+                stats.areas++;
+            }
+            break;
+        default:
+            for (uint8_t i = 0; i < n; i++) {
+                render(screen, areas[i], frame);
+                stats.rendered += (uint32_t)areas[i].w * areas[i].h * sizeof(uint16_t);
+            }
+            for (uint8_t i = 0; i < n; i++) {
+                pushDirectArea(display, screen, mode == MODE_DIRECT_COPY ? other : NULL, copyValid, areas[i], stats);
+            }
+            copyValid = true;
+            break;
+        }
+    }
+
+    VirtualBusStats_t bus;
+    display.getBusStats(&bus);
+    stats.sent = bus.bytes;
+    stats.busNs = bus.busNs;
+    stats.transactions = bus.transactions;
+
+    bool match = true;
+    for (uint16_t y = 0; y < screenH && match; y++) {
+        for (uint16_t x = 0; x < screenW; x++) {
+            if (display.getPixel(x, y) != screen[(uint32_t)y * screenW + x]) {
+                printf("%s: panel differs at %u,%u\n", modeNames[mode], x, y);
+                match = false;
+                break;
+            }
+        }
+    }
+    free(screen);
+    free(other);
+    return match;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t frames = argc > 1 ? atoi(argv[1]) : 120;
+    int board = argc > 2 ? atoi(argv[2]) : VIRTUAL_AMOLED_191;
+    uint8_t rotation = argc > 3 ? atoi(argv[3]) : 0;
+    if (frames < 2) {
+        frames = 120;
+    }
+
+    LilyGo_VirtualDisplay display((VirtualDisplayType)board);
+    display.setRotation(rotation);
+    // Pixels are in CPU order as with lvgl 9, the display swaps them while sending
+    display.setSwapBytes(true);
+    screenW = display.width();
+    screenH = display.height();
+    layout();
+
+    printf("# %s, %ux%u rotation %u, %u frames\n", display.getName(), screenW, screenH, rotation, frames);
+    printf("# mode       areas   rendered_kB    sent_kB  trans    bus_ms\n");
+    int ret = 0;
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        ModeStats_t stats = {};
+        if (!runMode(display, (BenchMode)mode, frames, stats)) {
+            ret = 1;
+        }
+        printf("%-10s %7u %13.1f %10.1f %6u %9.1f\n", modeNames[mode], stats.areas,
+               stats.rendered / 1024.0, stats.sent / 1024.0, stats.transactions, stats.busNs / 1e6);
+    }
+    return ret;
+}
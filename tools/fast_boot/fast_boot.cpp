@@ -0,0 +1,187 @@
+/**
+ * @file      fast_boot.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host check of the fast boot of LilyGo_AMOLED::begin against the host mock
+ * (tools/mock). The RDDPM readback of the panel answers from a script, one
+ * power mode per read, a new driver instance per boot.
+ *
+ * Checked for every board:
+ *  - fast boot resets with the timings of the board configuration, sends the
+ *    init sequence once and reads the power mode back, 0x03 with the
+ *    register in the address bits, single line, one byte
+ *  - a panel that is not in sleep out and display on gets a conservative
+ *    reset and up to two more passes, each read back, begin fails and the
+ *    boot profile reports checked and not verified if none of them helps
+ *  - a failed read is handled like a wrong power mode
+ *  - the SPI interface board and a normal boot read nothing back, checked
+ *    stays false, the init is sent twice
+ *
+ * Only the readback logic is checked, the transaction format has to be
+ * confirmed on a QSPI board.
+ *
+ * Build : g++ -O2 -DARDUINO=10819 -DBOARD_HAS_PSRAM -DARDUINO_USB_CDC_ON_BOOT=1 -I../mock -I../../src
+ *         fast_boot.cpp ../mock/MockHost.cpp ../../src/LilyGo_AMOLED.cpp ../../src/PixelKernels.cpp
+ *         ../../src/initSequence.cpp ../../src/I2CBus.cpp ../../src/BoardDetect.cpp
+ *         ../../src/TouchFilter.cpp -o fast_boot
+ * Usage : fast_boot
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "LilyGo_AMOLED.h"
+#include "MockHost.h"
+
+#define PANEL_RDDPM         (0x0A)
+#define PANEL_READ_CMD      (0x03)
+#define PANEL_MODE_ON       (0x9C)      // Booster on, sleep out, normal mode, display on
+#define PANEL_MODE_RESET    (0x08)      // RDDPM after a hardware reset
+#define READ_FAILS          (-1)        // Script entry that fails the transaction
+
+typedef struct {
+    const char *name;
+    const BoardsConfigure_t *board;
+    bool qspi;
+} BoardUnderTest_t;
+
+static const BoardUnderTest_t boards[] = {
+    {"1.47 inch",       &BOARD_AMOLED_147,      true},
+    {"1.91 inch",       &BOARD_AMOLED_191,      true},
+    {"1.91 inch SPI",   &BOARD_AMOLED_191_SPI,  false},
+    {"2.41 inch",       &BOARD_AMOLED_241,      true},
+};
+
+typedef struct {
+    const char *name;
+    bool fastBoot;
+    std::vector<int> modes;     // Answer of each read, the last one repeats
+    bool begins;                // Expected result of begin on a QSPI board
+    uint8_t attempts;           // Expected init passes on a QSPI board
+} Scenario_t;
+
+static const std::vector<Scenario_t> scenarios = {
+    {"normal boot",         false,  {PANEL_MODE_ON},                                true,  2},
+    {"fast boot",           true,   {PANEL_MODE_ON},                                true,  1},
+    {"recovers on retry",   true,   {PANEL_MODE_RESET, PANEL_MODE_ON},              true,  2},
+    {"recovers last pass",  true,   {PANEL_MODE_RESET, PANEL_MODE_RESET, PANEL_MODE_ON}, true, 3},
+    {"panel stays off",     true,   {PANEL_MODE_RESET},                             false, 3},
+    {"sleep out only",      true,   {0x98},                                         false, 3},
+    {"read fails",          true,   {READ_FAILS},                                   false, 3},
+    {"read fails once",     true,   {READ_FAILS, PANEL_MODE_ON},                    true,  2},
+};
+
+static std::vector<int> script;
+static uint32_t reads;
+
+static bool readHandler(uint8_t reg, uint8_t *data, size_t len)
+{
+    int mode = script[reads < script.size() ? reads : script.size() - 1];
+    reads++;
+    if (reg != PANEL_RDDPM || mode == READ_FAILS) {
+        return false;
+    }
+    memset(data, 0, len);
+    data[0] = (uint8_t)mode;
+    return true;
+}
+
+static bool expect(bool cond, const char *name)
+{
+    printf("%-44s %s\n", name, cond ? "ok" : "FAIL");
+    return cond;
+}
+
+static bool begin(LilyGo_AMOLED &amoled, const BoardsConfigure_t *board)
+{
+    if (board == &BOARD_AMOLED_147) {
+        mockI2CAddDevice(board->pmu->sda, board->pmu->scl, AXP2101_SLAVE_ADDRESS);
+        return amoled.beginAMOLED_147();
+    }
+    if (board == &BOARD_AMOLED_191) {
+        return amoled.beginAMOLED_191(false);
+    }
+    if (board == &BOARD_AMOLED_191_SPI) {
+        mockI2CAddDevice(board->pmu->sda, board->pmu->scl, SY6970_SLAVE_ADDRESS);
+        return amoled.beginAMOLED_191_SPI(false);
+    }
+    mockI2CAddDevice(board->pmu->sda, board->pmu->scl, SY6970_SLAVE_ADDRESS);
+    return amoled.beginAMOLED_241(true);
+}
+
+// Every read is the RDDPM readback, single line and right after an init pass
+static bool readsWellFormed(uint32_t *count)
+{
+    const std::vector<MockSPIRecord_t> &records = mockSPIRecords();
+    bool ok = true;
+    *count = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+        const MockSPIRecord_t &r = records[i];
+        if (!r.read) {
+            continue;
+        }
+        (*count)++;
+        ok &= r.cmd == PANEL_READ_CMD && r.addr == (PANEL_RDDPM << 8) && r.lines == 1 && !r.bytes && r.csLow;
+    }
+    return ok;
+}
+
+static bool check(const BoardUnderTest_t &b, const Scenario_t &s)
+{
+    script = s.modes;
+    reads = 0;
+    mockI2CClear();
+    mockSPIReset();
+    mockSPISetReadHandler(readHandler);
+    mockSPIWatchCS(b.board->display.cs);
+
+    LilyGo_AMOLED amoled;
+    amoled.setFastBoot(s.fastBoot);
+    bool begun = begin(amoled, b.board);
+    DisplayBootProfile_t profile;
+    amoled.getBootProfile(&profile);
+    uint32_t count;
+    bool formed = readsWellFormed(&count);
+
+    bool verifying = s.fastBoot && b.qspi;
+    bool expectBegin = verifying ? s.begins : true;
+    uint8_t expectAttempts = verifying ? s.attempts : s.fastBoot ? 1 : 2;
+    uint32_t expectReads = verifying ? s.attempts : 0;
+    const DisplayConfigure_t &d = b.board->display;
+    uint32_t fastResetUs = (d.resetSettleMs + d.resetLowMs + d.resetWaitMs) * 1000;
+
+    bool ok = begun == expectBegin && profile.attempts == expectAttempts && count == expectReads && formed &&
+              profile.checked == verifying && profile.verified == (verifying && s.begins);
+    // A normal boot and a fallback pay the conservative reset, a fast boot only its own
+    if (s.fastBoot && profile.attempts == 1) {
+        ok &= profile.resetUs >= fastResetUs && profile.resetUs < fastResetUs + 1000;
+    } else {
+        ok &= profile.resetUs > fastResetUs;
+    }
+    if (!ok) {
+        printf("  begin %d attempts %u reads %u%s checked %d verified %d reset %u us\n", begun, profile.attempts,
+               count, formed ? "" : " malformed", profile.checked, profile.verified, profile.resetUs);
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s %s", b.name, s.name);
+    return expect(ok, name);
+}
+
+int main(int argc, char **argv)
+{
+    mockLogLevel = ARDUHAL_LOG_LEVEL_NONE;
+    bool ok = true;
+    for (const BoardUnderTest_t &b : boards) {
+        for (const Scenario_t &s : scenarios) {
+            ok &= check(b, s);
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+/**
+ * @file      gesture_test.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host check of src/GestureEngine. Plays touch traces into the engine and
+ * compares the recognized gestures with the expect line of each trace.
+ *
+ * Trace format, one sample per line:
+ *      <ms> <points> <x> <y> [<x2> <y2>]
+ *      tick <ms>                   time passes without a sample
+ *      expect <gesture> ...        gestures the trace must produce, in order
+ *      # comment
+ * Gestures are TAP, DOUBLE_TAP, LONG_PRESS, SWIPE_LEFT, SWIPE_RIGHT, SWIPE_UP,
+ * SWIPE_DOWN, PINCH+, PINCH-, ROTATE+ and ROTATE-. Pinch and rotate report
+ * many steps, repeats of the same gesture are compared as one.
+ * Traces are recorded with examples/Gestures and PRINT_TRACE set to 1.
+ *
+ * Build : g++ -O2 -I../../src gesture_test.cpp ../../src/GestureEngine.cpp -o gesture_test
+ * Usage : gesture_test traces/tap.trace [more traces]
+ *
+ * Exits with 1 if any trace fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "GestureEngine.h"
+
+#define TIMING_REPEAT   (200)
+
+typedef struct {
+    bool tick;
+    TouchEvent_t sample;
+} TraceStep_t;
+
+typedef struct {
+    std::vector<TraceStep_t> steps;
+    std::vector<std::string> expect;
+} Trace_t;
+
+static bool loadTrace(const char *path, Trace_t &trace)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("%s: cannot open\n", path);
+        return false;
+    }
+    char line[256];
+    uint32_t number = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), f)) {
+        number++;
+        char *p = line + strspn(line, " \t");
+        if (*p == '#' || *p == '\n' || *p == '\r' || !*p) {
+            continue;
+        }
+        if (!strncmp(p, "expect", 6)) {
+            for (char *tok = strtok(p + 6, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n")) {
+                trace.expect.push_back(tok);
+            }
+            continue;
+        }
+        TraceStep_t step;
+        memset(&step, 0, sizeof(step));
+        long long ms;
+        int points, x, y, x2 = 0, y2 = 0;
+        if (sscanf(p, "tick %lld", &ms) == 1) {
+            step.tick = true;
+        } else if (sscanf(p, "%lld %d %d %d %d %d", &ms, &points, &x, &y, &x2, &y2) >= 4) {
+            step.sample.points = points;
+            step.sample.x = x;
+            step.sample.y = y;
+            step.sample.x2 = x2;
+            step.sample.y2 = y2;
+        } else {
+            printf("%s:%u: cannot parse\n", path, number);
+            ok = false;
+            break;
+        }
+        step.sample.timestamp = ms * 1000;
+        trace.steps.push_back(step);
+    }
+    fclose(f);
+    return ok;
+}
+
+static std::string gestureName(const GestureEvent_t &event)
+{
+    switch (event.type) {
+    case GESTURE_TAP:           return "TAP";
+    case GESTURE_DOUBLE_TAP:    return "DOUBLE_TAP";
+    case GESTURE_LONG_PRESS:    return "LONG_PRESS";
+    case GESTURE_SWIPE:
+        switch (event.direction) {
+        case GESTURE_DIR_LEFT:  return "SWIPE_LEFT";
+        case GESTURE_DIR_RIGHT: return "SWIPE_RIGHT";
+        case GESTURE_DIR_UP:    return "SWIPE_UP";
+        case GESTURE_DIR_DOWN:  return "SWIPE_DOWN";
+        default:                return "SWIPE";
+        }
+    case GESTURE_PINCH:         return event.scale >= 1.0f ? "PINCH+" : "PINCH-";
+    case GESTURE_ROTATE:        return event.angle >= 0.0f ? "ROTATE+" : "ROTATE-";
+    default:                    return "NONE";
+    }
+}
+
+static void play(GestureEngine &engine, const Trace_t &trace, std::vector<std::string> *out)
+{
+    engine.reset();
+    for (size_t i = 0; i < trace.steps.size(); i++) {
+        const TraceStep_t &step = trace.steps[i];
+        if (step.tick) {
+            engine.tick(step.sample.timestamp);
+        } else {
+            engine.update(step.sample);
+        }
+        GestureEvent_t event;
+        while (engine.read(&event)) {
+            std::string name = gestureName(event);
+            if (out && (out->empty() || out->back() != name || (event.type != GESTURE_PINCH && event.type != GESTURE_ROTATE))) {
+                out->push_back(name);
+            }
+        }
+    }
+}
+
+static std::string join(const std::vector<std::string> &names)
+{
+    std::string s;
+    for (size_t i = 0; i < names.size(); i++) {
+        s += (i ? " " : "") + names[i];
+    }
+    return s.empty() ? "-" : s;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("Usage: %s traces/*.trace\n", argv[0]);
+        return 1;
+    }
+
+    GestureEngine engine;
+    bool ok = true;
+    double worstNs = 0;
+    size_t samples = 0;
+    for (int i = 1; i < argc; i++) {
+        Trace_t trace;
+        const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+        if (!loadTrace(argv[i], trace)) {
+            ok = false;
+            continue;
+        }
+        std::vector<std::string> got;
+        play(engine, trace, &got);
+        bool pass = got == trace.expect;
+        ok &= pass;
+
+        // Average over repeats, the engine does the same work every run
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < TIMING_REPEAT; r++) {
+            play(engine, trace, NULL);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                    TIMING_REPEAT / (trace.steps.size() ? trace.steps.size() : 1);
+        worstNs = ns > worstNs ? ns : worstNs;
+        samples += trace.steps.size();
+
+        printf("%-22s %s  samples:%-4zu %6.1f ns/sample  got: %s", name, pass ? "ok  " : "FAIL",
+               trace.steps.size(), ns, join(got).c_str());
+        if (!pass) {
+            printf("  expected: %s", join(trace.expect).c_str());
+        }
+        printf("\n");
+    }
+    printf("%d traces, %zu samples, worst %.1f ns/sample\n", argc - 1, samples, worstNs);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,341 @@
+/**
+ * @file      i2c_bus.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host check of src/I2CBus against a simulated bus. The simulated devices are
+ * register maps at the addresses of the board devices, a transfer takes the
+ * time it would at 400kHz and can be made to fail.
+ *
+ * Checked:
+ *  - the register callbacks reach the devices, without a default bus they fail
+ *  - burst reads: the ten ADC registers of the PMU cost one transfer, a write
+ *    or the end of burstCacheUs fetches them again, reads outside the range
+ *    go to the bus
+ *  - errors are returned and counted, a failed burst read is not served
+ *  - transfers never overlap, with several tasks on the bus
+ *  - a touch reader at I2C_PRIORITY_HIGH waits for at most the transfer on
+ *    the bus while telemetry tasks keep it busy, printed next to the same run
+ *    with every task at I2C_PRIORITY_LOW
+ *
+ * Build : g++ -O2 -pthread -I../../src i2c_bus.cpp ../../src/I2CBus.cpp -o i2c_bus
+ * Usage : i2c_bus
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include "I2CBus.h"
+
+#define SIM_BYTE_US         (23)        // 9 clocks at 400kHz
+#define SIM_START_US        (10)        // Start, stop and driver overhead per transfer
+
+#define TOUCH_ADDRESS       (0x15)
+#define PMU_ADDRESS         (0x34)
+#define RTC_ADDRESS         (0x51)
+#define SENSOR_ADDRESS      (0x10)
+
+typedef struct {
+    uint8_t address;
+    uint8_t regs[256];
+    uint32_t failEvery;         // Every n-th transfer fails, 0 never
+    uint32_t transfers;
+    uint32_t failed;
+} SimDevice_t;
+
+typedef struct {
+    SimDevice_t devices[4];
+    std::atomic<int> inFlight;
+    std::atomic<uint32_t> overlaps;
+    std::atomic<uint32_t> started;      // Transfers started
+    uint32_t touchStarted;              // started when the last touch transfer began
+} SimBus_t;
+
+static bool ok = true;
+
+static void check(bool pass, const char *what)
+{
+    printf("  %-58s %s\n", what, pass ? "ok" : "FAIL");
+    ok &= pass;
+}
+
+static int simTransfer(void *user_data, uint8_t address, const uint8_t *write, size_t write_len,
+                       uint8_t *read, size_t read_len)
+{
+    SimBus_t *bus = (SimBus_t *)user_data;
+    if (bus->inFlight.fetch_add(1) != 0) {
+        bus->overlaps++;
+    }
+    uint32_t started = bus->started++;
+    if (address == TOUCH_ADDRESS) {
+        bus->touchStarted = started;
+    }
+    // Sleeps like a task blocked on the I2C driver, so that the waiting tasks get the CPU
+    std::this_thread::sleep_for(std::chrono::microseconds(SIM_START_US + (write_len + read_len + 1) * SIM_BYTE_US));
+
+    int result = -1;
+    for (SimDevice_t &dev : bus->devices) {
+        if (dev.address != address) {
+            continue;
+        }
+        dev.transfers++;
+        if (dev.failEvery && dev.transfers % dev.failEvery == 0) {
+            dev.failed++;
+            break;
+        }
+        uint8_t reg = write[0];
+        for (size_t i = 1; i < write_len; i++) {
+            dev.regs[(uint8_t)(reg + i - 1)] = write[i];
+        }
+        for (size_t i = 0; i < read_len; i++) {
+            read[i] = dev.regs[(uint8_t)(reg + i)];
+        }
+        result = 0;
+        break;
+    }
+    bus->inFlight--;
+    return result;
+}
+
+static void resetSim(SimBus_t &sim)
+{
+    static const uint8_t addresses[] = {TOUCH_ADDRESS, PMU_ADDRESS, RTC_ADDRESS, SENSOR_ADDRESS};
+    for (int d = 0; d < 4; d++) {
+        SimDevice_t &dev = sim.devices[d];
+        memset(&dev, 0, sizeof(dev));
+        dev.address = addresses[d];
+        for (int r = 0; r < 256; r++) {
+            dev.regs[r] = (uint8_t)(r ^ dev.address);
+        }
+    }
+    sim.inFlight = 0;
+    sim.overlaps = 0;
+    sim.started = 0;
+    sim.touchStarted = 0;
+}
+
+static void addBoardDevices(I2CBus &bus, I2CBusPriority touch)
+{
+    bus.addDevice({TOUCH_ADDRESS, touch, 0, 0, 0});
+    bus.addDevice({PMU_ADDRESS, I2C_PRIORITY_LOW, 0x34, 0x3D, 5000});
+    bus.addDevice({RTC_ADDRESS, I2C_PRIORITY_LOW, 0, 0, 0});
+    bus.addDevice({SENSOR_ADDRESS, I2C_PRIORITY_LOW, 0, 0, 0});
+}
+
+// Ten single register reads like the PMU driver does for its voltages, returns false on a wrong value
+static bool readAdc(SimBus_t &sim)
+{
+    for (uint8_t reg = 0x34; reg <= 0x3D; reg++) {
+        uint8_t value;
+        if (I2CBus::readCallback(PMU_ADDRESS, reg, &value, 1) != 0 || value != sim.devices[1].regs[reg]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void checkCallbacks(SimBus_t &sim)
+{
+    printf("Callbacks\n");
+    resetSim(sim);
+    I2CBus bus;
+    bus.begin(simTransfer, &sim);
+    addBoardDevices(bus, I2C_PRIORITY_HIGH);
+
+    uint8_t value = 0;
+    I2CBus::setDefault(NULL);
+    check(I2CBus::readCallback(RTC_ADDRESS, 0x04, &value, 1) == -1, "read without a default bus fails");
+    I2CBus::setDefault(&bus);
+    check(I2CBus::readCallback(RTC_ADDRESS, 0x04, &value, 1) == 0 && value == (0x04 ^ RTC_ADDRESS),
+          "read reaches the device");
+    uint8_t time[7] = {0x10, 0x20, 0x30, 0x01, 0x02, 0x03, 0x24};
+    check(I2CBus::writeCallback(RTC_ADDRESS, 0x04, time, 7) == 0 && !memcmp(sim.devices[2].regs + 4, time, 7),
+          "write reaches the device");
+    uint8_t back[7];
+    check(I2CBus::readCallback(RTC_ADDRESS, 0x04, back, 7) == 0 && !memcmp(back, time, 7),
+          "multi byte read returns what was written");
+    uint8_t large[I2C_BUS_MAX_BURST + 1] = {0};
+    check(I2CBus::writeCallback(RTC_ADDRESS, 0x00, large, sizeof(large)) == -1, "write larger than I2C_BUS_MAX_BURST is refused");
+    check(I2CBus::readCallback(0x77, 0x00, &value, 1) == -1, "device that does not answer fails");
+
+    I2CDeviceStats_t stats;
+    check(bus.getStats(RTC_ADDRESS, &stats) && stats.reads == 2 && stats.writes == 1 && stats.bytes == 15,
+          "stats count transfers and bytes");
+    check(bus.getStats(0x77, &stats) && stats.errors == 1, "unknown address is tracked with its error");
+    I2CBus::setDefault(NULL);
+}
+
+static void checkBurst(SimBus_t &sim)
+{
+    printf("Burst reads\n");
+    resetSim(sim);
+    I2CBus bus;
+    bus.begin(simTransfer, &sim);
+    addBoardDevices(bus, I2C_PRIORITY_HIGH);
+    I2CBus::setDefault(&bus);
+    check(!bus.addDevice({0x40, I2C_PRIORITY_LOW, 0x00, I2C_BUS_MAX_BURST, 1000}), "range above I2C_BUS_MAX_BURST is refused");
+
+    check(readAdc(sim) && sim.devices[1].transfers == 1, "ten ADC registers in one transfer");
+    check(readAdc(sim) && sim.devices[1].transfers == 1, "read again within burstCacheUs, no transfer");
+
+    uint8_t pair[2];
+    check(I2CBus::readCallback(PMU_ADDRESS, 0x3C, pair, 2) == 0 && pair[0] == sim.devices[1].regs[0x3C] &&
+          sim.devices[1].transfers == 1, "two register read inside the range is served");
+    check(I2CBus::readCallback(PMU_ADDRESS, 0x3D, pair, 2) == 0 && sim.devices[1].transfers == 2,
+          "read crossing the end of the range goes to the bus");
+
+    uint8_t enable = 0x0F;
+    I2CBus::writeCallback(PMU_ADDRESS, 0x30, &enable, 1);
+    sim.devices[1].regs[0x35] = 0xA5;
+    uint32_t before = sim.devices[1].transfers;
+    check(readAdc(sim) && sim.devices[1].transfers == before + 1, "write drops the burst, new value read");
+
+    sim.devices[1].regs[0x36] = 0x5A;
+    std::this_thread::sleep_for(std::chrono::microseconds(6000));
+    check(readAdc(sim) && sim.devices[1].transfers == before + 2, "burst fetched again after burstCacheUs");
+
+    I2CDeviceStats_t stats;
+    bus.getStats(PMU_ADDRESS, &stats);
+    check(stats.burstHits == 9 + 10 + 1 + 9 + 9 && stats.reads == 4 && stats.writes == 1,
+          "burst hits and transfers counted");
+
+    printf("Errors\n");
+    sim.devices[1].failEvery = 2;
+    sim.devices[1].transfers = 0;
+    bus.resetStats();
+    std::this_thread::sleep_for(std::chrono::microseconds(6000));
+    uint8_t value;
+    check(I2CBus::readCallback(PMU_ADDRESS, 0x34, &value, 1) == 0, "first burst read passes");
+    std::this_thread::sleep_for(std::chrono::microseconds(6000));
+    check(I2CBus::readCallback(PMU_ADDRESS, 0x34, &value, 1) == -1, "failing burst read returns -1");
+    check(I2CBus::readCallback(PMU_ADDRESS, 0x34, &value, 1) == 0 && sim.devices[1].transfers == 3,
+          "failed burst is not served, next read retries");
+    sim.devices[0].failEvery = 3;
+    uint32_t errors = 0;
+    for (int i = 0; i < 30; i++) {
+        uint8_t frame[13];
+        errors += I2CBus::readCallback(TOUCH_ADDRESS, 0x00, frame, 13) != 0;
+    }
+    bus.getStats(PMU_ADDRESS, &stats);
+    check(stats.errors == sim.devices[1].failed && stats.reads == 3, "PMU errors counted");
+    bus.getStats(TOUCH_ADDRESS, &stats);
+    check(stats.errors == 10 && errors == 10 && stats.reads == 30 && stats.bytes == 20 * 13, "touch errors counted, failed bytes not");
+    I2CBus::setDefault(NULL);
+}
+
+typedef struct {
+    uint32_t p99Overtaken;      // Transfers started between the touch read call and its transfer
+    uint32_t maxOvertaken;
+    double avgWaitUs;
+    uint32_t p99WaitUs;
+    uint32_t maxWaitUs;
+    uint32_t reads;
+    uint32_t telemetry;
+} LoadResult_t;
+
+/*
+* Three telemetry tasks read the PMU, the RTC and the sensor back to back,
+* the touch task reads a 13 byte frame every 2ms. The transfers that got the
+* bus before the touch read are counted, the wait times also depend on the
+* host scheduler and are only printed.
+*/
+static LoadResult_t runLoad(SimBus_t &sim, I2CBusPriority touch, uint32_t touchReads)
+{
+    resetSim(sim);
+    I2CBus bus;
+    bus.begin(simTransfer, &sim);
+    addBoardDevices(bus, touch);
+    // Every telemetry read goes to the bus
+    bus.addDevice({PMU_ADDRESS, I2C_PRIORITY_LOW, 0, 0, 0});
+
+    std::atomic<bool> running(true);
+    std::atomic<uint32_t> telemetry(0);
+    std::vector<std::thread> tasks;
+    static const uint8_t addresses[] = {PMU_ADDRESS, RTC_ADDRESS, SENSOR_ADDRESS};
+    for (uint8_t address : addresses) {
+        tasks.emplace_back([&bus, &running, &telemetry, address] {
+            uint8_t buffer[16];
+            while (running) {
+                bus.readRegister(address, 0x00, buffer, sizeof(buffer));
+                telemetry++;
+            }
+        });
+    }
+
+    std::vector<uint32_t> waits, overtaken;
+    for (uint32_t i = 0; i < touchReads; i++) {
+        std::this_thread::sleep_for(std::chrono::microseconds(2000));
+        uint8_t frame[13];
+        uint32_t before = sim.started;
+        bus.readRegister(TOUCH_ADDRESS, 0x00, frame, sizeof(frame));
+        overtaken.push_back(sim.touchStarted - before);
+        I2CDeviceStats_t stats;
+        bus.getStats(TOUCH_ADDRESS, &stats);
+        waits.push_back(stats.lastWaitUs);
+    }
+    running = false;
+    for (std::thread &t : tasks) {
+        t.join();
+    }
+
+    LoadResult_t result;
+    std::sort(overtaken.begin(), overtaken.end());
+    result.p99Overtaken = overtaken[overtaken.size() * 99 / 100];
+    result.maxOvertaken = overtaken.back();
+    std::sort(waits.begin(), waits.end());
+    double sum = 0;
+    for (uint32_t w : waits) {
+        sum += w;
+    }
+    result.avgWaitUs = sum / waits.size();
+    result.p99WaitUs = waits[waits.size() * 99 / 100];
+    result.maxWaitUs = waits.back();
+    result.reads = (uint32_t)waits.size();
+    result.telemetry = telemetry;
+    return result;
+}
+
+static void checkPriority(SimBus_t &sim)
+{
+    printf("Priority, touch reads while three telemetry tasks keep the bus busy\n");
+    const uint32_t telemetryUs = SIM_START_US + (1 + 16 + 1) * SIM_BYTE_US;
+    LoadResult_t fifo = runLoad(sim, I2C_PRIORITY_LOW, 500);
+    uint32_t overlaps = sim.overlaps;
+    LoadResult_t high = runLoad(sim, I2C_PRIORITY_HIGH, 500);
+    overlaps += sim.overlaps;
+    printf("  telemetry transfer %uus\n", telemetryUs);
+    const struct {
+        const char *name;
+        const LoadResult_t &r;
+    } runs[] = {
+        {"touch at I2C_PRIORITY_LOW", fifo},
+        {"touch at I2C_PRIORITY_HIGH", high},
+    };
+    for (const auto &run : runs) {
+        printf("  %-27s overtaken p99 %u max %u  wait avg %6.1fus p99 %5uus max %5uus  (%u telemetry reads)\n",
+               run.name, run.r.p99Overtaken, run.r.maxOvertaken, run.r.avgWaitUs, run.r.p99WaitUs,
+               run.r.maxWaitUs, run.r.telemetry);
+    }
+    check(overlaps == 0, "transfers never overlap");
+    check(high.p99Overtaken <= 1, "high priority waits for at most the transfer on the bus (p99)");
+    check(fifo.p99Overtaken > high.p99Overtaken, "in arrival order the queued telemetry goes first");
+}
+
+int main()
+{
+    SimBus_t sim;
+    checkCallbacks(sim);
+    checkBurst(sim);
+    checkPriority(sim);
+    printf("%s\n", ok ? "All checks passed" : "Some checks FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+/**
+ * @file      init_stream.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host check of the packed panel init sequences (lcd_init_t) against the
+ * readable lcd_cmd_t tables they are generated from. initSequence.cpp is
+ * included here instead of linked, the tables are only visible in its
+ * translation unit.
+ *
+ * Checked for every board:
+ *  - the stream decodes to the table, opcode, len with the delay bits and
+ *    the parameters, and ends exactly after the last entry
+ *
+ * Then the driver runs against the recording bus of the host mock
+ * (tools/mock) on the selected board and its init is compared with what the
+ * previous initBUS loop sent, one writeCommand per entry followed by 120 ms
+ * for len bit 7 and 10 ms for len bit 5, the sequence twice:
+ *  - the same commands with the same parameter bytes, in the same order
+ *  - the delays after the same entries and no other pause
+ *
+ * Build : g++ -O2 -DARDUINO=10819 -DBOARD_HAS_PSRAM -DARDUINO_USB_CDC_ON_BOOT=1 -I../mock -I../../src
+ *         init_stream.cpp ../mock/MockHost.cpp ../../src/LilyGo_AMOLED.cpp ../../src/PixelKernels.cpp
+ *         ../../src/I2CBus.cpp ../../src/BoardDetect.cpp ../../src/TouchFilter.cpp -o init_stream
+ * Usage : init_stream [board 0: 1.47, 1: 1.91, 2: 1.91 SPI, 3: 2.41]
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "LilyGo_AMOLED.h"
+#include "MockHost.h"
+#include "initSequence.cpp"
+
+#define INIT_PASSES         (2)         // The conservative boot sends the sequence twice
+#define GAP_TOLERANCE_US    (1000)      // Bus time between two entries without a delay
+
+typedef struct {
+    const char *name;
+    const lcd_cmd_t *table;
+    uint32_t count;
+    const lcd_init_t *packed;
+} InitStream_t;
+
+static const InitStream_t streams[] = {
+    {"1.47 inch SH8501",        sh8501_cmd,      SH8501_INIT_SEQUENCE_LENGTH,       &sh8501_init},
+    {"1.91 inch RM67162",       rm67162_cmd,     RM67162_INIT_SEQUENCE_LENGTH,      &rm67162_init},
+    {"1.91 inch RM67162 SPI",   rm67162_spi_cmd, RM67162_INIT_SPI_SEQUENCE_LENGTH,  &rm67162_spi_init},
+    {"2.41 inch RM690B0",       rm690b0_cmd,     RM690B0_INIT_SEQUENCE_LENGTH,      &rm690b0_init},
+};
+
+static LilyGo_AMOLED amoled;
+
+static uint32_t delayUs(const lcd_cmd_t &c)
+{
+    return (c.len & 0x80 ? 120000 : 0) + (c.len & 0x20 ? 10000 : 0);
+}
+
+static bool checkStream(const InitStream_t &s)
+{
+    const uint8_t *p = s.packed->data;
+    const uint8_t *end = p + s.packed->size;
+    bool ok = s.packed->count == s.count;
+    uint32_t i = 0;
+    for (; ok && i < s.count; i++) {
+        const lcd_cmd_t &c = s.table[i];
+        uint32_t length = c.len & 0x1F;
+        if (p + 2 + length > end || p[0] != c.addr || p[1] != (uint8_t)c.len || memcmp(p + 2, c.param, length)) {
+            printf("  %s: entry %u 0x%02X differs\n", s.name, i, c.addr);
+            ok = false;
+            break;
+        }
+        p += 2 + length;
+    }
+    ok &= p == end;
+    printf("%-28s %s  %u commands %u bytes, table %zu bytes\n", s.name, ok ? "ok  " : "FAIL", s.count,
+           s.packed->size, s.count * sizeof(lcd_cmd_t));
+    return ok;
+}
+
+// One entry as the previous loop sent it, QSPI one transaction, SPI the command byte and the parameters
+static bool matchEntry(const std::vector<MockSPIRecord_t> &records, size_t *pos, const lcd_cmd_t &c, bool qspi)
+{
+    uint32_t length = c.len & 0x1F;
+    size_t i = *pos;
+    if (qspi) {
+        if (i >= records.size()) {
+            return false;
+        }
+        const MockSPIRecord_t &r = records[i];
+        *pos = i + 1;
+        return r.cmd == 0x02 && r.addr == (c.addr << 8) && r.bytes == length &&
+               (!length || !memcmp(r.data.data(), c.param, length));
+    }
+    if (i >= records.size() || records[i].bytes != 1 || records[i].data[0] != c.addr) {
+        return false;
+    }
+    *pos = ++i;
+    if (!length) {
+        return true;
+    }
+    if (i >= records.size() || records[i].bytes != length || memcmp(records[i].data.data(), c.param, length)) {
+        return false;
+    }
+    *pos = i + 1;
+    return true;
+}
+
+static bool checkBus(const InitStream_t &s, bool qspi)
+{
+    const std::vector<MockSPIRecord_t> &records = mockSPIRecords();
+    size_t pos = 0;
+    bool ok = true;
+    uint32_t sent = 0;
+    for (int pass = 0; pass < INIT_PASSES && ok; pass++) {
+        for (uint32_t i = 0; i < s.count; i++) {
+            const lcd_cmd_t &c = s.table[i];
+            if (!matchEntry(records, &pos, c, qspi)) {
+                printf("  pass %d entry %u: command 0x%02X differs on the bus\n", pass, i, c.addr);
+                ok = false;
+                break;
+            }
+            sent++;
+            // Pause between the end of this entry and the start of the next transaction
+            if (pos >= records.size()) {
+                continue;
+            }
+            int64_t gap = records[pos].startUs - records[pos - 1].endUs;
+            uint32_t expected = delayUs(c);
+            bool last = pass == INIT_PASSES - 1 && i == s.count - 1;
+            if (gap < expected || (!last && gap >= expected + GAP_TOLERANCE_US)) {
+                printf("  pass %d entry %u: command 0x%02X followed by %lld us, expected %u us\n", pass, i, c.addr,
+                       (long long)gap, expected);
+                ok = false;
+            }
+        }
+    }
+    printf("%-28s %s  %u of %u commands on the bus\n", "bus", ok ? "ok  " : "FAIL", sent, INIT_PASSES * s.count);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    int board = argc > 1 ? atoi(argv[1]) : 1;
+    if (board < 0 || board > 3) {
+        board = 1;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(streams) / sizeof(*streams); i++) {
+        ok &= checkStream(streams[i]);
+    }
+
+    // Everything from the reset on is recorded, nothing is sent before the init sequence
+    mockSPIRecordPayload(true);
+    bool begun = false;
+    switch (board) {
+    case 0:
+        mockI2CAddDevice(BOARD_AMOLED_147.pmu->sda, BOARD_AMOLED_147.pmu->scl, AXP2101_SLAVE_ADDRESS);
+        begun = amoled.beginAMOLED_147();
+        break;
+    case 1:
+        begun = amoled.beginAMOLED_191(false);
+        break;
+    case 2:
+        mockI2CAddDevice(BOARD_AMOLED_191_SPI.pmu->sda, BOARD_AMOLED_191_SPI.pmu->scl, SY6970_SLAVE_ADDRESS);
+        begun = amoled.beginAMOLED_191_SPI(false);
+        break;
+    default:
+        mockI2CAddDevice(BOARD_AMOLED_241.pmu->sda, BOARD_AMOLED_241.pmu->scl, SY6970_SLAVE_ADDRESS);
+        begun = amoled.beginAMOLED_241(true);
+        break;
+    }
+    if (!begun) {
+        printf("begin failed\n");
+        return 1;
+    }
+    printf("# %s\n", streams[board].name);
+    ok &= checkBus(streams[board], board != 2);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+/**
+ * @file      merge_replay.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host replay of dirty area traces through the area merge of the lvgl
+ * helpers (src/AreaMerge.h). Every frame of a trace is sent twice to the
+ * recording bus of the host mock (tools/mock), once with the areas as lvgl
+ * left them and once after areaMerge with the board's cost model:
+ *
+ *   lvgl     one pushColors per area lvgl left unjoined
+ *   merged   one pushColors per area left after areaMerge
+ *
+ * Reported per trace are the transactions, the bytes on the bus (commands
+ * and pixels) and the bus time of both, with the saving. The areas of the
+ * merged frames must cover every area of the lvgl frames.
+ *
+ * Trace format, the same as LV_Helper prints with LVGL_HELPER_PRINT_AREAS:
+ *
+ *   # comment
+ *   size <width> <height>      optional, areas outside the screen are clipped
+ *   frame                      starts a frame
+ *   <x1> <y1> <x2> <y2>        one area, inclusive
+ *
+ * The traces in traces/ are synthetic, capture real ones from a board.
+ *
+ * Build : g++ -O2 -DARDUINO=10819 -DBOARD_HAS_PSRAM -DARDUINO_USB_CDC_ON_BOOT=1 -I../mock -I../../src
+ *         merge_replay.cpp ../mock/MockHost.cpp ../../src/LilyGo_AMOLED.cpp ../../src/PixelKernels.cpp
+ *         ../../src/initSequence.cpp ../../src/I2CBus.cpp ../../src/BoardDetect.cpp
+ *         ../../src/TouchFilter.cpp -o merge_replay
+ * Usage : merge_replay [board 0: 1.91 inch, 1: 2.41 inch] trace...
+ *
+ * Exits with 1 if a trace can not be read or a merged frame misses an area.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "LilyGo_AMOLED.h"
+#include "AreaMerge.h"
+#include "MockHost.h"
+
+typedef struct {
+    int32_t x1, y1, x2, y2;
+} Area_t;
+
+typedef std::vector<Area_t> Frame_t;
+
+typedef struct {
+    uint32_t areas;
+    uint32_t transactions;
+    uint64_t bytes;
+    uint64_t busyUs;
+    uint64_t modelNs;
+} ReplayStats_t;
+
+static LilyGo_AMOLED amoled;
+static uint16_t *pixels;
+
+static bool readTrace(const char *path, std::vector<Frame_t> &frames)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        printf("%s: can not open\n", path);
+        return false;
+    }
+    int32_t w = amoled.width(), h = amoled.height();
+    char line[128];
+    bool ok = true;
+    for (uint32_t n = 1; ok && fgets(line, sizeof(line), fp); n++) {
+        Area_t a;
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        } else if (!strncmp(line, "frame", 5)) {
+            frames.push_back(Frame_t());
+        } else if (!strncmp(line, "size", 4)) {
+            if (sscanf(line + 4, "%d %d", &w, &h) != 2 || w > amoled.width() || h > amoled.height()) {
+                printf("%s:%u: trace is larger than the %ux%u screen\n", path, n, amoled.width(), amoled.height());
+                ok = false;
+            }
+        } else if (sscanf(line, "%d %d %d %d", &a.x1, &a.y1, &a.x2, &a.y2) == 4 && !frames.empty()) {
+            a.x1 = a.x1 < 0 ? 0 : a.x1;
+            a.y1 = a.y1 < 0 ? 0 : a.y1;
+            a.x2 = a.x2 >= w ? w - 1 : a.x2;
+            a.y2 = a.y2 >= h ? h - 1 : a.y2;
+            if (a.x1 <= a.x2 && a.y1 <= a.y2) {
+                frames.back().push_back(a);
+            }
+        } else {
+            printf("%s:%u: can not parse \"%.*s\"\n", path, n, (int)strcspn(line, "\n"), line);
+            ok = false;
+        }
+    }
+    fclose(fp);
+    return ok;
+}
+
+static void sendFrame(const Frame_t &frame, const AreaCostModel_t *model, ReplayStats_t *out)
+{
+    mockSPIClear();
+    for (const Area_t &a : frame) {
+        amoled.pushColors(a.x1, a.y1, a.x2 - a.x1 + 1, a.y2 - a.y1 + 1, pixels);
+        out->modelNs += areaCostNs(a.x1, a.y1, a.x2, a.y2, model);
+    }
+    amoled.waitDMADone();
+    MockSPIStats_t stats;
+    mockSPIGetStats(&stats);
+    for (const MockSPIRecord_t &r : mockSPIRecords()) {
+        out->bytes += r.bytes;
+    }
+    out->areas += frame.size();
+    out->transactions += stats.queued + stats.polled;
+    out->busyUs += stats.busyUs;
+}
+
+static bool covers(const Frame_t &merged, const Area_t &a)
+{
+    for (const Area_t &m : merged) {
+        if (m.x1 <= a.x1 && m.y1 <= a.y1 && m.x2 >= a.x2 && m.y2 >= a.y2) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void printStats(const char *name, const ReplayStats_t &s, uint32_t frames)
+{
+    printf("  %-8s %8u %8.1f %10.1f %12.0f %10.1f %10.1f\n", name, s.areas, (double)s.transactions / frames,
+           (double)s.bytes / frames, (double)s.bytes, (double)s.busyUs / frames, s.modelNs / 1000.0 / frames);
+}
+
+static double saved(uint64_t before, uint64_t after)
+{
+    return before ? (1.0 - (double)after / before) * 100.0 : 0;
+}
+
+static bool replay(const char *path, const AreaCostModel_t *model)
+{
+    std::vector<Frame_t> frames;
+    if (!readTrace(path, frames) || frames.empty()) {
+        printf("%s: no frames\n", path);
+        return false;
+    }
+
+    ReplayStats_t base = {}, merged = {};
+    uint32_t merges = 0;
+    bool ok = true;
+    for (size_t f = 0; f < frames.size(); f++) {
+        const Frame_t &frame = frames[f];
+        sendFrame(frame, model, &base);
+
+        Frame_t areas = frame;
+        std::vector<uint8_t> joined(areas.size(), 0);
+        merges += areaMerge(areas.data(), joined.data(), areas.size(), model);
+        Frame_t left;
+        for (size_t i = 0; i < areas.size(); i++) {
+            if (!joined[i]) {
+                left.push_back(areas[i]);
+            }
+        }
+        sendFrame(left, model, &merged);
+
+        for (const Area_t &a : frame) {
+            if (!covers(left, a)) {
+                printf("  frame %zu: area %d,%d %d,%d is not covered after the merge\n", f, a.x1, a.y1, a.x2, a.y2);
+                ok = false;
+            }
+        }
+    }
+
+    uint32_t n = frames.size();
+    printf("%s %s  %u frames, %u merges\n", path, ok ? "ok  " : "FAIL", n, merges);
+    printf("  %-8s %8s %8s %10s %12s %10s %10s\n", "", "areas", "trans/f", "bytes/f", "bytes", "bus us/f", "model us/f");
+    printStats("lvgl", base, n);
+    printStats("merged", merged, n);
+    printf("  %-8s %8s %7.1f%% %9.1f%% %12s %9.1f%% %9.1f%%\n", "saved", "", saved(base.transactions, merged.transactions),
+           saved(base.bytes, merged.bytes), "", saved(base.busyUs, merged.busyUs), saved(base.modelNs, merged.modelNs));
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        printf("Usage: %s [board 0: 1.91 inch, 1: 2.41 inch] trace...\n", argv[0]);
+        return 1;
+    }
+    int board = atoi(argv[1]);
+    bool begun;
+    if (board == 1) {
+        mockI2CAddDevice(BOARD_AMOLED_241.pmu->sda, BOARD_AMOLED_241.pmu->scl, SY6970_SLAVE_ADDRESS);
+        begun = amoled.beginAMOLED_241(true);
+    } else {
+        begun = amoled.beginAMOLED_191(false);
+    }
+    if (!begun) {
+        printf("begin failed\n");
+        return 1;
+    }
+    pixels = (uint16_t *)calloc(amoled.width() * amoled.height(), sizeof(uint16_t));
+
+    AreaCostModel_t model = {amoled.getAreaSetupUs(), amoled.getBusBytesPerSecond(), sizeof(uint16_t)};
+    printf("# %ux%u, area setup %u us, %.1f MB/s\n", amoled.width(), amoled.height(), model.setupUs,
+           model.bytesPerSecond / 1000000.0);
+
+    bool ok = true;
+    for (int i = 2; i < argc; i++) {
+        ok &= replay(argv[i], &model);
+    }
+    free(pixels);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file      Arduino.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host stand-in for the parts of the arduino-esp32 core used by the driver,
+ * see MockHost.h.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <assert.h>
+#include <algorithm>
+#include "esp_arduino_version.h"
+#include "esp_idf_version.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_sleep.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "MockHost.h"
+
+using std::min;
+using std::max;
+
+#define IRAM_ATTR
+#ifndef _BV
+#define _BV(b)                  (1UL << (b))
+#endif
+
+#define LOW                     (0x0)
+#define HIGH                    (0x1)
+#define INPUT                   (0x01)
+#define OUTPUT                  (0x03)
+#define PULLUP                  (0x04)
+#define INPUT_PULLUP            (0x05)
+#define RISING                  (0x01)
+#define FALLING                 (0x02)
+#define CHANGE                  (0x03)
+#define MSBFIRST                (1)
+#define DEC                     (10)
+#define HEX                     (16)
+
+#define ARDUHAL_LOG_LEVEL_NONE      (0)
+#define ARDUHAL_LOG_LEVEL_ERROR     (1)
+#define ARDUHAL_LOG_LEVEL_WARN      (2)
+#define ARDUHAL_LOG_LEVEL_INFO      (3)
+#define ARDUHAL_LOG_LEVEL_DEBUG     (4)
+#define ARDUHAL_LOG_LEVEL           (mockLogLevel)
+
+#define log_e(format, ...)      mockLog(ARDUHAL_LOG_LEVEL_ERROR, "E", __func__, format, ##__VA_ARGS__)
+#define log_w(format, ...)      mockLog(ARDUHAL_LOG_LEVEL_WARN, "W", __func__, format, ##__VA_ARGS__)
+#define log_i(format, ...)      mockLog(ARDUHAL_LOG_LEVEL_INFO, "I", __func__, format, ##__VA_ARGS__)
+#define log_d(format, ...)      mockLog(ARDUHAL_LOG_LEVEL_DEBUG, "D", __func__, format, ##__VA_ARGS__)
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+        size_t n = 0;
+        while (size--) {
+            n += write(*buffer++);
+        }
+        return n;
+    }
+    size_t print(const char *s)
+    {
+        return write((const uint8_t *)s, strlen(s));
+    }
+    size_t print(unsigned long n, int base = DEC)
+    {
+        char buffer[16];
+        snprintf(buffer, sizeof(buffer), base == HEX ? "%lX" : "%lu", n);
+        return print(buffer);
+    }
+    size_t println(const char *s = "")
+    {
+        return print(s) + print("\r\n");
+    }
+    size_t println(unsigned long n, int base = DEC)
+    {
+        return print(n, base) + print("\r\n");
+    }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        return len > 0 ? write((const uint8_t *)buffer, std::min((size_t)len, sizeof(buffer) - 1)) : 0;
+    }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available()
+    {
+        return 0;
+    }
+    virtual int read()
+    {
+        return -1;
+    }
+};
+
+// Writes to stdout
+class HardwareSerial : public Stream
+{
+public:
+    size_t write(uint8_t c) override
+    {
+        return fwrite(&c, 1, 1, stdout);
+    }
+    using Print::write;
+};
+extern HardwareSerial Serial;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+uint32_t analogReadMilliVolts(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode);
+void detachInterrupt(uint8_t pin);
+void delay(uint32_t ms);
+unsigned long millis();
+unsigned long micros();
+float temperatureRead();
+bool psramFound();
+void *ps_malloc(size_t size);
@@ -0,0 +1,1040 @@
+/**
+ * @file      MockHost.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * See MockHost.h.
+ */
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "SD.h"
+#include "Wire.h"
+#include "Preferences.h"
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include <chrono>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <stdarg.h>
+
+// The containers below are never destroyed, the driver's destructor may run after them
+HardwareSerial Serial;
+SPIClass SPI;
+SDFS SD;
+TwoWire Wire(0);
+int mockLogLevel = ARDUHAL_LOG_LEVEL_ERROR;
+
+/*
+* Clock
+*/
+static MockClockMode clockMode = MOCK_CLOCK_VIRTUAL;
+static int64_t clockSkew = 0;
+static int64_t hostStart = -1;
+static double hostScale = 1.0;
+
+static int64_t hostUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int64_t clockNow()
+{
+    if (clockMode == MOCK_CLOCK_VIRTUAL) {
+        return clockSkew;
+    }
+    if (hostStart < 0) {
+        hostStart = hostUs();
+    }
+    return (int64_t)((hostUs() - hostStart) * hostScale) + clockSkew;
+}
+
+void mockSetClockMode(MockClockMode mode, double host_scale)
+{
+    int64_t now = clockNow();
+    clockMode = mode;
+    hostScale = host_scale;
+    hostStart = hostUs();
+    clockSkew = now;
+}
+
+/*
+* SPI master
+*/
+typedef struct {
+    spi_transaction_t *trans;
+    int64_t startUs;
+    int64_t endUs;
+    uint64_t hash;
+    bool started;
+    size_t record;
+} Pending_t;
+
+struct MockSPIDevice {
+    spi_device_interface_config_t config;
+    std::deque<Pending_t> pending;          // Queued, in bus order
+    std::deque<spi_transaction_t *> done;   // Finished, result not taken yet
+};
+
+static MockSPIDevice *spiDevice = NULL;
+static int64_t busFreeUs = 0;
+static uint32_t queuedOverheadUs = 8;
+static uint32_t pollingOverheadUs = 15;
+static bool recordPayload = false;
+static int watchCS = -1;
+static MockSPIReadHandler readHandler = NULL;
+static MockSPICostHandler costHandler = NULL;
+static std::vector<MockSPIRecord_t> &records = *new std::vector<MockSPIRecord_t>();
+static MockSPIStats_t spiStats;
+
+/*
+* GPIO and interrupts
+*/
+typedef struct {
+    void (*handler)(void);
+    void (*handlerArg)(void *);
+    void *arg;
+    int mode;
+} Interrupt_t;
+
+static std::map<int, int> &gpioLevel = *new std::map<int, int>();
+static std::map<int, Interrupt_t> &interrupts = *new std::map<int, Interrupt_t>();
+static int tePin = -1;
+static uint32_t tePeriodUs = 0;
+static int64_t teNextUs = -1;
+
+static bool running = false;
+
+static void fireEdge(int pin, int mode)
+{
+    auto it = interrupts.find(pin);
+    if (it == interrupts.end() || !(it->second.mode & mode)) {
+        return;
+    }
+    if (it->second.handlerArg) {
+        it->second.handlerArg(it->second.arg);
+    } else if (it->second.handler) {
+        it->second.handler();
+    }
+}
+
+static uint64_t hashBytes(const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ p[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+static const void *txData(const spi_transaction_t *t)
+{
+    return (t->flags & SPI_TRANS_USE_TXDATA) ? (const void *)t->tx_data : t->tx_buffer;
+}
+
+static uint8_t dataLines(uint32_t flags)
+{
+    return (flags & SPI_TRANS_MODE_QIO) ? 4 : ((flags & SPI_TRANS_MODE_DIO) ? 2 : 1);
+}
+
+// Fill the bus shape of t into record and return its duration on the bus
+static int64_t describe(MockSPIDevice *dev, spi_transaction_t *t, MockSPIRecord_t *r, uint32_t overhead_us)
+{
+    uint32_t flags = t->flags;
+    uint8_t cmd_bits = dev->config.command_bits;
+    uint8_t addr_bits = dev->config.address_bits;
+    uint8_t dummy_bits = dev->config.dummy_bits;
+    if (flags & (SPI_TRANS_VARIABLE_CMD | SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY)) {
+        spi_transaction_ext_t *e = (spi_transaction_ext_t *)t;
+        cmd_bits = (flags & SPI_TRANS_VARIABLE_CMD) ? e->command_bits : cmd_bits;
+        addr_bits = (flags & SPI_TRANS_VARIABLE_ADDR) ? e->address_bits : addr_bits;
+        dummy_bits = (flags & SPI_TRANS_VARIABLE_DUMMY) ? e->dummy_bits : dummy_bits;
+    }
+    uint8_t lines = dataLines(flags);
+    uint8_t cmd_lines = (flags & SPI_TRANS_MULTILINE_CMD) ? lines : 1;
+    uint8_t addr_lines = (flags & SPI_TRANS_MULTILINE_ADDR) ? lines : 1;
+
+    r->cmd = t->cmd;
+    r->addr = (uint32_t)t->addr;
+    r->cmdBits = cmd_bits;
+    r->addrBits = addr_bits;
+    r->lines = lines;
+    r->flags = flags;
+    r->bytes = t->length / 8;
+    r->read = t->rxlength != 0;
+    r->csKeep = (flags & SPI_TRANS_CS_KEEP_ACTIVE) != 0;
+
+    // Clock cycles of every phase, a read is taken as a single line phase
+    uint64_t cycles = (cmd_bits + cmd_lines - 1) / cmd_lines + (addr_bits + addr_lines - 1) / addr_lines + dummy_bits +
+                      (t->length + lines - 1) / lines + t->rxlength;
+    if (costHandler) {
+        overhead_us += costHandler(r->bytes);
+    }
+    return overhead_us + (int64_t)((cycles * 1000000ULL + dev->config.clock_speed_hz - 1) / dev->config.clock_speed_hz);
+}
+
+static bool csLow()
+{
+    if (spiDevice && spiDevice->config.spics_io_num >= 0) {
+        return true;
+    }
+    return watchCS >= 0 && mockGPIOLevel(watchCS) == LOW;
+}
+
+// Next event time of the bus, -1 if idle
+static int64_t nextBusEvent()
+{
+    if (!spiDevice || spiDevice->pending.empty()) {
+        return -1;
+    }
+    const Pending_t &p = spiDevice->pending.front();
+    return p.started ? p.endUs : p.startUs;
+}
+
+int64_t mockNextEvent()
+{
+    int64_t bus = nextBusEvent();
+    int64_t te = tePin >= 0 ? teNextUs : -1;
+    if (bus < 0) {
+        return te;
+    }
+    if (te < 0) {
+        return bus;
+    }
+    return min(bus, te);
+}
+
+/*
+* Critical sections
+*/
+static int criticalDepth = 0;
+static bool inIsr = false;
+static MockCriticalStats_t criticalStats;
+
+// Run every bus and TE event up to now, in time order
+static void runEvents(int64_t now)
+{
+    if (running) {
+        return;
+    }
+    if (criticalDepth) {
+        int64_t next = mockNextEvent();
+        if (next >= 0 && next <= now) {
+            criticalStats.deferred++;
+        }
+        return;
+    }
+    running = true;
+    inIsr = true;
+    while (true) {
+        int64_t bus = nextBusEvent();
+        int64_t te = tePin >= 0 ? teNextUs : -1;
+        bool do_bus = bus >= 0 && bus <= now && (te < 0 || bus <= te);
+        bool do_te = !do_bus && te >= 0 && te <= now;
+        if (!do_bus && !do_te) {
+            break;
+        }
+        if (do_te) {
+            teNextUs += tePeriodUs;
+            gpioLevel[tePin] = HIGH;
+            fireEdge(tePin, RISING);
+            gpioLevel[tePin] = LOW;
+            continue;
+        }
+        Pending_t &p = spiDevice->pending.front();
+        if (!p.started) {
+            p.started = true;
+            if (spiDevice->config.pre_cb) {
+                spiDevice->config.pre_cb(p.trans);
+            }
+            records[p.record].csLow = csLow();
+            continue;
+        }
+        spi_transaction_t *t = p.trans;
+        MockSPIRecord_t &r = records[p.record];
+        const void *tx = txData(t);
+        if (tx && r.bytes) {
+            bool changed = recordPayload ? memcmp(r.data.data(), tx, r.bytes) != 0 : hashBytes(tx, r.bytes) != p.hash;
+            if (changed) {
+                spiStats.bufferModified++;
+            }
+        }
+        spiStats.busyUs += p.endUs - p.startUs;
+        spiDevice->pending.pop_front();
+        spiDevice->done.push_back(t);
+        if (spiDevice->config.post_cb) {
+            spiDevice->config.post_cb(t);
+        }
+    }
+    inIsr = false;
+    running = false;
+}
+
+int64_t mockNow()
+{
+    int64_t now = clockNow();
+    runEvents(now);
+    return now;
+}
+
+void mockAdvance(int64_t us)
+{
+    if (us > 0) {
+        clockSkew += us;
+    }
+    mockNow();
+}
+
+static void advanceTo(int64_t t)
+{
+    if (criticalDepth && !inIsr) {
+        criticalStats.blocked++;
+    }
+    int64_t now = clockNow();
+    if (t > now) {
+        clockSkew += t - now;
+    }
+    mockNow();
+}
+
+int64_t esp_timer_get_time()
+{
+    return mockNow();
+}
+
+void mockEnterCritical(portMUX_TYPE *mux, bool isr)
+{
+    if (isr != inIsr) {
+        criticalStats.wrongContext++;
+    }
+    if (isr) {
+        criticalStats.isrSections++;
+    } else {
+        criticalStats.taskSections++;
+    }
+    mux->owner++;
+    // Interrupts can not nest into the task, only the task masks them
+    if (!inIsr) {
+        criticalDepth++;
+    }
+}
+
+void mockExitCritical(portMUX_TYPE *mux, bool isr)
+{
+    if (mux->owner <= 0) {
+        criticalStats.unbalanced++;
+        return;
+    }
+    mux->owner--;
+    if (!inIsr && !--criticalDepth) {
+        // Deliver what was held back
+        mockNow();
+    }
+}
+
+void mockCriticalGetStats(MockCriticalStats_t *stats)
+{
+    *stats = criticalStats;
+}
+
+void mockCriticalClear()
+{
+    memset(&criticalStats, 0, sizeof(criticalStats));
+}
+
+void mockSPISetOverhead(uint32_t queued_us, uint32_t polling_us)
+{
+    queuedOverheadUs = queued_us;
+    pollingOverheadUs = polling_us;
+}
+
+void mockSPIRecordPayload(bool enable)
+{
+    recordPayload = enable;
+}
+
+void mockSPIWatchCS(int pin)
+{
+    watchCS = pin;
+}
+
+void mockSPISetReadHandler(MockSPIReadHandler handler)
+{
+    readHandler = handler;
+}
+
+void mockSPISetCostHandler(MockSPICostHandler handler)
+{
+    costHandler = handler;
+}
+
+const std::vector<MockSPIRecord_t> &mockSPIRecords()
+{
+    return records;
+}
+
+void mockSPIGetStats(MockSPIStats_t *stats)
+{
+    mockNow();
+    *stats = spiStats;
+    stats->queueSize = spiDevice ? spiDevice->config.queue_size : 0;
+}
+
+void mockSPIClear()
+{
+    // Transactions in flight keep their records until they are done
+    mockNow();
+    if (spiDevice && !spiDevice->pending.empty()) {
+        size_t first = spiDevice->pending.front().record;
+        records.erase(records.begin(), records.begin() + first);
+        for (Pending_t &p : spiDevice->pending) {
+            p.record -= first;
+        }
+    } else {
+        records.clear();
+    }
+    memset(&spiStats, 0, sizeof(spiStats));
+}
+
+void mockSPIReset()
+{
+    int64_t now = mockNow();
+    delete spiDevice;
+    spiDevice = NULL;
+    busFreeUs = now;
+    records.clear();
+    memset(&spiStats, 0, sizeof(spiStats));
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config, int dma_chan)
+{
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host)
+{
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *config, spi_device_handle_t *handle)
+{
+    if (spiDevice) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    spiDevice = new MockSPIDevice;
+    spiDevice->config = *config;
+    *handle = spiDevice;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    if (handle != spiDevice || !spiDevice->pending.empty()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    delete spiDevice;
+    spiDevice = NULL;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t ticks)
+{
+    return ESP_OK;
+}
+
+void spi_device_release_bus(spi_device_handle_t handle)
+{
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t ticks)
+{
+    int64_t now = mockNow();
+    uint32_t in_flight = handle->pending.size() + handle->done.size();
+    if (in_flight >= (uint32_t)handle->config.queue_size) {
+        spiStats.overLimit++;
+    }
+    for (const Pending_t &p : handle->pending) {
+        if (p.trans == trans) {
+            spiStats.descriptorReuse++;
+        }
+    }
+    for (spi_transaction_t *t : handle->done) {
+        if (t == trans) {
+            spiStats.descriptorReuse++;
+        }
+    }
+
+    MockSPIRecord_t r = {};
+    Pending_t p = {};
+    int64_t duration = describe(handle, trans, &r, queuedOverheadUs);
+    r.queuedUs = now;
+    r.startUs = max(now, busFreeUs);
+    r.endUs = r.startUs + duration;
+    const void *tx = txData(trans);
+    if (tx && r.bytes) {
+        if (recordPayload) {
+            r.data.assign((const uint8_t *)tx, (const uint8_t *)tx + r.bytes);
+        } else {
+            p.hash = hashBytes(tx, r.bytes);
+        }
+    }
+    busFreeUs = r.endUs;
+    p.trans = trans;
+    p.startUs = r.startUs;
+    p.endUs = r.endUs;
+    p.record = records.size();
+    records.push_back(r);
+    handle->pending.push_back(p);
+
+    spiStats.queued++;
+    in_flight++;
+    if (in_flight > spiStats.maxInFlight) {
+        spiStats.maxInFlight = in_flight;
+    }
+    mockNow();
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t ticks)
+{
+    mockNow();
+    if (handle->done.empty()) {
+        if (handle->pending.empty()) {
+            spiStats.resultWithoutQueued++;
+            return ESP_ERR_TIMEOUT;
+        }
+        advanceTo(handle->pending.front().endUs);
+    }
+    *trans = handle->done.front();
+    handle->done.pop_front();
+    spiStats.results++;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    int64_t now = mockNow();
+    if (!handle->pending.empty() || !handle->done.empty()) {
+        spiStats.pollingWhileQueued++;
+    }
+    MockSPIRecord_t r = {};
+    int64_t duration = describe(handle, trans, &r, pollingOverheadUs);
+    r.queuedUs = now;
+    r.startUs = max(now, busFreeUs);
+    r.endUs = r.startUs + duration;
+    r.polling = true;
+    const void *tx = txData(trans);
+    if (tx && r.bytes && recordPayload) {
+        r.data.assign((const uint8_t *)tx, (const uint8_t *)tx + r.bytes);
+    }
+    busFreeUs = r.endUs;
+    advanceTo(r.startUs);
+    if (handle->config.pre_cb) {
+        handle->config.pre_cb(trans);
+    }
+    r.csLow = csLow();
+    bool ok = true;
+    if (trans->rxlength) {
+        uint8_t *rx = (trans->flags & SPI_TRANS_USE_RXDATA) ? trans->rx_data : (uint8_t *)trans->rx_buffer;
+        memset(rx, 0, trans->rxlength / 8);
+        ok = readHandler && readHandler((trans->addr >> 8) & 0xFF, rx, trans->rxlength / 8);
+    }
+    records.push_back(r);
+    spiStats.polled++;
+    spiStats.busyUs += duration;
+    advanceTo(r.endUs);
+    if (handle->config.post_cb) {
+        handle->config.post_cb(trans);
+    }
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+void SPIClass::writeBytes(const uint8_t *data, uint32_t size)
+{
+    int64_t now = mockNow();
+    MockSPIRecord_t r = {};
+    r.queuedUs = now;
+    r.startUs = max(now, busFreeUs);
+    r.endUs = r.startUs + SPI_BUS_OVERHEAD_US + ((uint64_t)size * 8 * 1000000ULL + _freq - 1) / _freq;
+    r.lines = 1;
+    r.bytes = size;
+    r.polling = true;
+    r.csLow = csLow();
+    if (recordPayload) {
+        r.data.assign(data, data + size);
+    }
+    busFreeUs = r.endUs;
+    spiStats.polled++;
+    spiStats.busyUs += r.endUs - r.startUs;
+    records.push_back(r);
+    advanceTo(r.endUs);
+}
+
+/*
+* GPIO
+*/
+int mockGPIOLevel(int pin)
+{
+    auto it = gpioLevel.find(pin);
+    return it == gpioLevel.end() ? HIGH : it->second;
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    gpioLevel[pin] = val ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin)
+{
+    return mockGPIOLevel(pin);
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level)
+{
+    gpioLevel[pin] = level ? HIGH : LOW;
+    return ESP_OK;
+}
+
+uint16_t analogRead(uint8_t pin)
+{
+    return 0;
+}
+
+uint32_t analogReadMilliVolts(uint8_t pin)
+{
+    return 0;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode)
+{
+    interrupts[pin] = {handler, NULL, NULL, mode};
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode)
+{
+    interrupts[pin] = {NULL, handler, arg, mode};
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    interrupts.erase(pin);
+}
+
+void mockTEStart(int pin, uint32_t period_us, int64_t first_us)
+{
+    tePin = pin;
+    tePeriodUs = period_us;
+    teNextUs = first_us;
+    mockNow();
+}
+
+void mockTEStop()
+{
+    tePin = -1;
+    teNextUs = -1;
+}
+
+void delay(uint32_t ms)
+{
+    if (criticalDepth && !inIsr) {
+        criticalStats.blocked++;
+    }
+    mockAdvance((int64_t)ms * 1000);
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(mockNow() / 1000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)mockNow();
+}
+
+float temperatureRead()
+{
+    return 25.0f;
+}
+
+void mockLog(int level, const char *tag, const char *func, const char *format, ...)
+{
+    if (level > mockLogLevel) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "[%s][%s] ", tag, func);
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+/*
+* Heap
+*/
+static int heapFailAfter = -1;
+static std::set<const void *> &externalRam = *new std::set<const void *>();
+
+static bool heapAllow()
+{
+    if (heapFailAfter < 0) {
+        return true;
+    }
+    if (heapFailAfter == 0) {
+        return false;
+    }
+    heapFailAfter--;
+    return true;
+}
+
+void mockHeapFailAfter(int count)
+{
+    heapFailAfter = count;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    if (!heapAllow()) {
+        return NULL;
+    }
+    void *p = malloc(size);
+    if (p && (caps & MALLOC_CAP_SPIRAM)) {
+        externalRam.insert(p);
+    }
+    return p;
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    void *p = heap_caps_malloc(n * size, caps);
+    if (p) {
+        memset(p, 0, n * size);
+    }
+    return p;
+}
+
+void heap_caps_free(void *ptr)
+{
+    externalRam.erase(ptr);
+    free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return (caps & MALLOC_CAP_SPIRAM) ? 8 * 1024 * 1024 : 256 * 1024;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return heap_caps_get_free_size(caps);
+}
+
+bool esp_ptr_external_ram(const void *ptr)
+{
+    return externalRam.count(ptr) != 0;
+}
+
+bool psramFound()
+{
+    return true;
+}
+
+void *ps_malloc(size_t size)
+{
+    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+}
+
+/*
+* FreeRTOS, tasks do not run, semaphores are given by interrupts
+*/
+struct MockSemaphore {
+    uint32_t count;
+};
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return new MockSemaphore{0};
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    delete sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    int64_t deadline = ticks == portMAX_DELAY ? INT64_MAX : mockNow() + (int64_t)ticks * 1000;
+    while (true) {
+        mockNow();
+        if (sem->count) {
+            sem->count--;
+            return pdTRUE;
+        }
+        int64_t next = mockNextEvent();
+        if (next < 0 && deadline == INT64_MAX) {
+            log_e("Waiting forever for a semaphore nothing can give");
+            return pdFALSE;
+        }
+        if (next < 0 || next > deadline) {
+            advanceTo(deadline);
+            if (sem->count) {
+                sem->count--;
+                return pdTRUE;
+            }
+            return pdFALSE;
+        }
+        advanceTo(next);
+    }
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem->count) {
+        return pdFALSE;
+    }
+    sem->count = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *woken)
+{
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xSemaphoreGive(sem);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    return pdFAIL;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    delay(ticks);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    return 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+}
+
+/*
+* I2C
+*/
+typedef struct {
+    uint8_t regs[256];
+    uint8_t pointer;
+} I2CDevice_t;
+
+static std::map<std::tuple<int, int, uint8_t>, I2CDevice_t> &i2cDevices =
+    *new std::map<std::tuple<int, int, uint8_t>, I2CDevice_t>();
+static std::map<uint8_t, uint32_t> &i2cProbes = *new std::map<uint8_t, uint32_t>();
+static uint32_t i2cTransfers = 0;
+static std::vector<MockI2CProbe_t> &i2cProbeLog = *new std::vector<MockI2CProbe_t>();
+
+void mockI2CAddDevice(int sda, int scl, uint8_t address)
+{
+    I2CDevice_t device = {};
+    i2cDevices[std::make_tuple(sda, scl, address)] = device;
+}
+
+void mockI2CClear()
+{
+    i2cDevices.clear();
+    i2cProbes.clear();
+    i2cProbeLog.clear();
+    i2cTransfers = 0;
+}
+
+uint32_t mockI2CProbes(uint8_t address)
+{
+    return i2cProbes[address];
+}
+
+uint32_t mockI2CTransfers()
+{
+    return i2cTransfers;
+}
+
+const std::vector<MockI2CProbe_t> &mockI2CProbeLog()
+{
+    return i2cProbeLog;
+}
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency)
+{
+    if (sda != -1) {
+        _sda = sda;
+        _scl = scl;
+    }
+    return true;
+}
+
+bool TwoWire::end()
+{
+    _sda = -1;
+    _scl = -1;
+    return true;
+}
+
+void TwoWire::beginTransmission(uint16_t address)
+{
+    _address = address;
+    _txLen = 0;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    i2cTransfers++;
+    auto it = i2cDevices.find(std::make_tuple(_sda, _scl, (uint8_t)_address));
+    if (!_txLen) {
+        i2cProbes[_address]++;
+        i2cProbeLog.push_back({_sda, _scl, (uint8_t)_address, it != i2cDevices.end()});
+    }
+    if (it == i2cDevices.end()) {
+        return 2;
+    }
+    if (_txLen) {
+        I2CDevice_t &d = it->second;
+        d.pointer = _tx[0];
+        for (size_t i = 1; i < _txLen; i++) {
+            d.regs[d.pointer++] = _tx[i];
+        }
+    }
+    return 0;
+}
+
+size_t TwoWire::requestFrom(uint16_t address, size_t size, bool sendStop)
+{
+    i2cTransfers++;
+    _rxLen = 0;
+    _rxPos = 0;
+    auto it = i2cDevices.find(std::make_tuple(_sda, _scl, (uint8_t)address));
+    if (it == i2cDevices.end()) {
+        return 0;
+    }
+    I2CDevice_t &d = it->second;
+    while (_rxLen < size && _rxLen < sizeof(_rx)) {
+        _rx[_rxLen++] = d.regs[d.pointer++];
+    }
+    return _rxLen;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if (_txLen >= sizeof(_tx)) {
+        return 0;
+    }
+    _tx[_txLen++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t size)
+{
+    size_t n = 0;
+    while (n < size && write(data[n])) {
+        n++;
+    }
+    return n;
+}
+
+int TwoWire::available()
+{
+    return _rxLen - _rxPos;
+}
+
+int TwoWire::read()
+{
+    return _rxPos < _rxLen ? _rx[_rxPos++] : -1;
+}
+
+size_t TwoWire::readBytes(uint8_t *buffer, size_t length)
+{
+    size_t n = 0;
+    while (n < length && _rxPos < _rxLen) {
+        buffer[n++] = _rx[_rxPos++];
+    }
+    return n;
+}
+
+/*
+* Preferences
+*/
+static std::map<std::string, std::map<std::string, uint32_t>> &prefsStore =
+    *new std::map<std::string, std::map<std::string, uint32_t>>();
+
+void mockPrefsClear()
+{
+    prefsStore.clear();
+}
+
+bool Preferences::begin(const char *name, bool readOnly)
+{
+    _name = name;
+    return true;
+}
+
+void Preferences::end()
+{
+    _name = NULL;
+}
+
+bool Preferences::remove(const char *key)
+{
+    return _name && prefsStore[_name].erase(key) != 0;
+}
+
+uint8_t Preferences::getUChar(const char *key, uint8_t defaultValue)
+{
+    return (uint8_t)getUInt(key, defaultValue);
+}
+
+size_t Preferences::putUChar(const char *key, uint8_t value)
+{
+    return putUInt(key, value) ? 1 : 0;
+}
+
+uint32_t Preferences::getUInt(const char *key, uint32_t defaultValue)
+{
+    if (!_name) {
+        return defaultValue;
+    }
+    auto &ns = prefsStore[_name];
+    auto it = ns.find(key);
+    return it == ns.end() ? defaultValue : it->second;
+}
+
+size_t Preferences::putUInt(const char *key, uint32_t value)
+{
+    if (!_name) {
+        return 0;
+    }
+    prefsStore[_name][key] = value;
+    return 4;
+}
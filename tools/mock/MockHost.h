@@ -0,0 +1,156 @@
+/**
+ * @file      MockHost.h
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host stand-ins for the arduino-esp32 core, esp-idf and the sensor libraries,
+ * enough to build src/LilyGo_AMOLED.cpp on the host and drive it from the
+ * tools. The headers in this directory shadow the real ones, add it to the
+ * include path before ../../src and link MockHost.cpp:
+ *
+ *   g++ -O2 -DARDUINO=10819 -DBOARD_HAS_PSRAM -DARDUINO_USB_CDC_ON_BOOT=1 -I../mock -I../../src tool.cpp ../mock/MockHost.cpp \
+ *       ../../src/LilyGo_AMOLED.cpp ../../src/PixelKernels.cpp ../../src/initSequence.cpp \
+ *       ../../src/I2CBus.cpp ../../src/BoardDetect.cpp ../../src/TouchFilter.cpp
+ *
+ * Clock
+ *   esp_timer_get_time, millis and the FreeRTOS ticks read one mock clock.
+ *   In MOCK_CLOCK_VIRTUAL code takes no time, only blocking calls (delay,
+ *   semaphores, waiting for a transaction) move the clock, which makes the
+ *   results exact and repeatable. MOCK_CLOCK_HOST adds the host time spent
+ *   in between, used by the benchmarks to overlap real copy work with the
+ *   modelled bus, optionally scaled to approximate a slower CPU.
+ *
+ * SPI master
+ *   One bus, transactions are sent in order. A transaction starts when it is
+ *   queued and the bus is free and takes the configured overhead plus its
+ *   bits at the device clock, on 1 or 4 lines as the flags select. pre_cb
+ *   and post_cb are called at its start and end. Every transaction is
+ *   recorded, with its bytes if payload recording is on, and the driver is
+ *   checked against the rules of the real driver, see MockSPIStats_t.
+ *
+ * Interrupts
+ *   Handlers attached with attachInterrupt(Arg) are called at the mock time
+ *   of the edge, from whatever mock call moves the clock past it. The only
+ *   edge source is the TE signal of mockTEStart. The SPI callbacks and the
+ *   edges run in interrupt context. A critical section held by the task
+ *   masks them until it is left, see MockCriticalStats_t.
+ *
+ * Tasks are not run, xTaskCreate fails.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+enum MockClockMode {
+    MOCK_CLOCK_VIRTUAL,         // Only blocking calls take time
+    MOCK_CLOCK_HOST,            // Host time between the calls is added
+};
+
+// host_scale multiplies the host time in MOCK_CLOCK_HOST
+void mockSetClockMode(MockClockMode mode, double host_scale = 1.0);
+int64_t mockNow();
+// Let time pass, e.g. the CPU time of work that is not run on the host
+void mockAdvance(int64_t us);
+// Time of the next pending bus or TE event, -1 if there is none
+int64_t mockNextEvent();
+
+// log_x output at or below this level, ARDUHAL_LOG_LEVEL_ERROR by default
+extern int mockLogLevel;
+void mockLog(int level, const char *tag, const char *func, const char *format, ...) __attribute__((format(printf, 4, 5)));
+
+typedef struct {
+    int64_t queuedUs;           // spi_device_queue_trans or polling call
+    int64_t startUs;
+    int64_t endUs;
+    uint16_t cmd;
+    uint32_t addr;
+    uint8_t cmdBits;            // As sent, after SPI_TRANS_VARIABLE_*
+    uint8_t addrBits;
+    uint8_t lines;              // Data lines
+    uint32_t flags;             // SPI_TRANS_*
+    uint32_t bytes;             // Data bytes
+    bool polling;               // spi_device_polling_transmit or SPIClass
+    bool read;                  // Has a receive phase
+    bool csLow;                 // CS asserted when the transaction started
+    bool csKeep;                // SPI_TRANS_CS_KEEP_ACTIVE
+    std::vector<uint8_t> data;  // Bytes sent, only with mockSPIRecordPayload
+} MockSPIRecord_t;
+
+typedef struct {
+    uint32_t queued;            // Transactions queued
+    uint32_t polled;            // Polling transactions
+    uint32_t results;           // Results taken with spi_device_get_trans_result
+    uint32_t maxInFlight;       // Most transactions queued and not yet taken back
+    uint32_t queueSize;         // queue_size of the device
+    uint32_t overLimit;         // Queued with queue_size transactions already in flight
+    uint32_t descriptorReuse;   // Descriptor queued again before its result was taken
+    uint32_t bufferModified;    // Transmit data changed between queueing and the end of the transaction
+    uint32_t pollingWhileQueued;// Polling transaction with queued transactions in flight
+    uint32_t resultWithoutQueued;   // spi_device_get_trans_result with nothing in flight
+    uint64_t busyUs;            // Time the bus was sending
+} MockSPIStats_t;
+
+// Transaction overhead, queued and polling, microseconds, 8 and 15 by default
+void mockSPISetOverhead(uint32_t queued_us, uint32_t polling_us);
+// Keep the bytes of every transaction in its record, off by default
+void mockSPIRecordPayload(bool enable);
+// Pin sampled into csLow, for GPIO driven CS, -1 for none
+void mockSPIWatchCS(int pin);
+// Register reads, fills data for the command in the address bits, returns false to fail the read
+typedef bool (*MockSPIReadHandler)(uint8_t reg, uint8_t *data, size_t len);
+void mockSPISetReadHandler(MockSPIReadHandler handler);
+// Extra microseconds of a transaction of the given data bytes, on top of the overhead, NULL for none
+typedef uint32_t (*MockSPICostHandler)(uint32_t bytes);
+void mockSPISetCostHandler(MockSPICostHandler handler);
+const std::vector<MockSPIRecord_t> &mockSPIRecords();
+void mockSPIGetStats(MockSPIStats_t *stats);
+// Forget the records and the counters, the bus state is kept
+void mockSPIClear();
+// Drop the device and everything in flight, as after a reboot, so that another driver instance can begin
+void mockSPIReset();
+
+int mockGPIOLevel(int pin);
+
+// TE edges on pin every period_us, the first one at first_us
+void mockTEStart(int pin, uint32_t period_us, int64_t first_us);
+void mockTEStop();
+
+// I2C devices, a 256 byte register file each, addressed by pins and address
+void mockI2CAddDevice(int sda, int scl, uint8_t address);
+void mockI2CClear();
+// Address only transactions (probes) sent to address on any pins
+uint32_t mockI2CProbes(uint8_t address);
+// All transactions on the fake bus
+uint32_t mockI2CTransfers();
+
+typedef struct {
+    int sda;
+    int scl;
+    uint8_t address;
+    bool found;                 // A device acknowledged
+} MockI2CProbe_t;
+
+// Address only transactions in the order they were sent, cleared by mockI2CClear
+const std::vector<MockI2CProbe_t> &mockI2CProbeLog();
+
+typedef struct {
+    uint32_t taskSections;      // portENTER_CRITICAL
+    uint32_t isrSections;       // portENTER_CRITICAL_ISR
+    uint32_t wrongContext;      // The ISR variant outside an interrupt or the task variant inside one
+    uint32_t blocked;           // Blocking call with a critical section held by the task
+    uint32_t unbalanced;        // Exit without a matching enter
+    uint32_t deferred;          // Interrupts held back until a critical section was left
+} MockCriticalStats_t;
+
+void mockCriticalGetStats(MockCriticalStats_t *stats);
+void mockCriticalClear();
+
+// Let the allocation after the next count ones fail, -1 never fails
+void mockHeapFailAfter(int count);
+
+// Erase every Preferences namespace, as after a flash erase
+void mockPrefsClear();
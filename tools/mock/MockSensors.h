@@ -0,0 +1,286 @@
+#pragma once
+// Host stand-ins for the SensorLib and XPowersLib classes the driver derives from,
+// see MockHost.h. A device is present when it answers on the fake I2C bus, all
+// other calls do nothing.
+#include <stdint.h>
+#include "Wire.h"
+
+#define SENSORLIB_VERSION_MAJOR     0
+#define SENSORLIB_VERSION_MINOR     2
+#define SENSORLIB_VERSION_PATCH     4
+
+#define AXP2101_SLAVE_ADDRESS       (0x34)
+#define SY6970_SLAVE_ADDRESS        (0x6A)
+#define BQ25896_SLAVE_ADDRESS       (0x6B)
+#define CSTXXX_SLAVE_ADDRESS        (0x15)
+#define CST816_SLAVE_ADDRESS        (0x15)
+#define CST226SE_SLAVE_ADDRESS      (0x5A)
+#define CHSC5816_SLAVE_ADDRESS      (0x2E)
+#define CM32181_SLAVE_ADDRESS       (0x10)
+#define PCF85063_SLAVE_ADDRESS      (0x51)
+
+#define XPOWERS_AXP2101_ADC_DATA_RELUST0    (0x34)
+#define XPOWERS_AXP2101_ADC_DATA_RELUST9    (0x3D)
+#define XPOWERS_AXP2101_CHG_CUR_0MA         (0)
+#define XPOWERS_AXP2101_CHG_CUR_200MA       (8)
+
+#define POWERS_PPM_REG_0EH                  (0x0E)
+#define POWERS_PPM_REG_13H                  (0x13)
+
+enum {
+    XPOWERS_CHG_LED_OFF,
+    XPOWERS_CHG_LED_BLINK_1HZ,
+    XPOWERS_CHG_LED_BLINK_4HZ,
+    XPOWERS_CHG_LED_ON,
+    XPOWERS_CHG_LED_CTRL_CHG,
+};
+
+typedef int (*iic_fptr_t)(uint8_t devAddr, uint8_t regAddr, uint8_t *data, uint8_t len);
+
+enum TouchDrvModel {
+    TouchDrv_UNKOWN,
+    TouchDrv_CST8XX,
+    TouchDrv_CST226,
+};
+
+// Present when register 0 of address reads through the callback
+static inline bool mockCallbackPresent(uint8_t address, iic_fptr_t read)
+{
+    uint8_t value;
+    return read && read(address, 0, &value, 1) == 0;
+}
+
+static inline bool mockWirePresent(TwoWire &wire, uint8_t address, int sda, int scl)
+{
+    wire.begin(sda, scl);
+    wire.beginTransmission(address);
+    return wire.endTransmission() == 0;
+}
+
+class XPowersAXP2101
+{
+public:
+    bool begin(uint8_t address, iic_fptr_t read, iic_fptr_t write)
+    {
+        return mockCallbackPresent(address, read);
+    }
+    uint64_t getIrqStatus()
+    {
+        return 0;
+    }
+    void clearIrqStatus() {}
+    bool enableIRQ(uint64_t params)
+    {
+        return true;
+    }
+    bool disableIRQ(uint64_t params)
+    {
+        return true;
+    }
+    void setChargingLedMode(uint8_t mode) {}
+    bool setChargerConstantCurr(uint8_t current)
+    {
+        return true;
+    }
+    bool setALDO1Voltage(uint16_t mv)
+    {
+        return true;
+    }
+    bool setALDO3Voltage(uint16_t mv)
+    {
+        return true;
+    }
+    bool setBLDO1Voltage(uint16_t mv)
+    {
+        return true;
+    }
+    bool enableALDO1()
+    {
+        return true;
+    }
+    bool enableALDO3()
+    {
+        return true;
+    }
+    bool enableBLDO1()
+    {
+        return true;
+    }
+    bool disableALDO3()
+    {
+        return true;
+    }
+    bool disableBLDO1()
+    {
+        return true;
+    }
+    bool disableDC2()
+    {
+        return true;
+    }
+    bool disableDC3()
+    {
+        return true;
+    }
+    bool disableDC4()
+    {
+        return true;
+    }
+    bool disableDC5()
+    {
+        return true;
+    }
+    bool disableCPUSLDO()
+    {
+        return true;
+    }
+    void enableBattDetection() {}
+    void enableVbusVoltageMeasure() {}
+    void enableBattVoltageMeasure() {}
+    void disableTemperatureMeasure() {}
+    void disableBattDetection() {}
+    void disableVbusVoltageMeasure() {}
+    void disableBattVoltageMeasure() {}
+    void disableSystemVoltageMeasure() {}
+    virtual uint16_t getBattVoltage()
+    {
+        return 0;
+    }
+    virtual uint16_t getVbusVoltage()
+    {
+        return 0;
+    }
+    virtual uint16_t getSystemVoltage()
+    {
+        return 0;
+    }
+    virtual bool isBatteryConnect()
+    {
+        return false;
+    }
+    virtual bool isCharging()
+    {
+        return false;
+    }
+    virtual bool isVbusIn()
+    {
+        return false;
+    }
+};
+
+// SY6970 and BQ25896
+class MockPowersCharger
+{
+public:
+    bool begin(uint8_t address, iic_fptr_t read, iic_fptr_t write)
+    {
+        return mockCallbackPresent(address, read);
+    }
+    void enableMeasure() {}
+    void disableMeasure() {}
+    void disableADCMeasure() {}
+    void enableOTG() {}
+    void disableOTG() {}
+    void enableCharge() {}
+    void disableCharge() {}
+    void disableStatLed() {}
+    uint16_t getBattVoltage()
+    {
+        return 0;
+    }
+    uint16_t getVbusVoltage()
+    {
+        return 0;
+    }
+    uint16_t getSystemVoltage()
+    {
+        return 0;
+    }
+    bool isCharging()
+    {
+        return false;
+    }
+    bool isVbusIn()
+    {
+        return false;
+    }
+};
+
+class PowersSY6970 : public MockPowersCharger {};
+class PowersBQ25896 : public MockPowersCharger {};
+
+class MockTouchDrv
+{
+public:
+    void setPins(int rst, int irq) {}
+    bool begin(TwoWire &wire, uint8_t address, int sda, int scl)
+    {
+        return mockWirePresent(wire, address, sda, scl);
+    }
+    bool begin(uint8_t address, iic_fptr_t read, iic_fptr_t write)
+    {
+        return mockCallbackPresent(address, read);
+    }
+    uint8_t getPoint(int16_t *x, int16_t *y, uint8_t size = 1)
+    {
+        return 0;
+    }
+    virtual bool isPressed()
+    {
+        return false;
+    }
+    void setMaxCoordinates(uint16_t x, uint16_t y) {}
+    void setSwapXY(bool swap) {}
+    void setMirrorXY(bool mirrorX, bool mirrorY) {}
+    void sleep() {}
+};
+
+class TouchDrvCHSC5816 : public MockTouchDrv {};
+
+class TouchDrvCSTXXX : public MockTouchDrv
+{
+public:
+    void setTouchDrvModel(TouchDrvModel model) {}
+    void setCenterButtonCoordinate(int16_t x, int16_t y) {}
+};
+
+class SensorCM32181
+{
+public:
+    enum Sampling {
+        SAMPLING_X1,
+        SAMPLING_X2,
+        SAMPLING_X1_8,
+        SAMPLING_X1_4,
+    };
+    bool begin(uint8_t address, iic_fptr_t read, iic_fptr_t write)
+    {
+        return mockCallbackPresent(address, read);
+    }
+    void setSampling(Sampling sampling) {}
+    void powerOn() {}
+    void powerDown() {}
+};
+
+template <class chipType>
+class SensorCommon
+{
+public:
+    bool begin(uint8_t address, iic_fptr_t read, iic_fptr_t write)
+    {
+        return mockCallbackPresent(address, read);
+    }
+};
+
+template <class chipType>
+class RTCCommon {};
+
+// SensorLib 0.2 layout, no begin of its own
+class SensorPCF85063 : public SensorCommon<SensorPCF85063>, public RTCCommon<SensorPCF85063>
+{
+public:
+    bool init(TwoWire &wire, int sda, int scl)
+    {
+        return mockWirePresent(wire, PCF85063_SLAVE_ADDRESS, sda, scl);
+    }
+};
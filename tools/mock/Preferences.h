@@ -0,0 +1,19 @@
+#pragma once
+// Host stand-in, see MockHost.h. Namespaces live until mockPrefsClear, like NVS across reboots.
+#include <stdint.h>
+#include <stddef.h>
+
+class Preferences
+{
+public:
+    Preferences() : _name(NULL) {}
+    bool begin(const char *name, bool readOnly = false);
+    void end();
+    bool remove(const char *key);
+    uint8_t getUChar(const char *key, uint8_t defaultValue = 0);
+    size_t putUChar(const char *key, uint8_t value);
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0);
+    size_t putUInt(const char *key, uint32_t value);
+private:
+    const char *_name;
+};
@@ -0,0 +1,32 @@
+#pragma once
+// Host stand-in, see MockHost.h, there is never a card
+#include "FS.h"
+#include "SPI.h"
+
+typedef enum {
+    CARD_NONE,
+    CARD_MMC,
+    CARD_SD,
+    CARD_SDHC,
+    CARD_UNKNOWN,
+} sdcard_type_t;
+
+class SDFS
+{
+public:
+    bool begin(uint8_t ss, SPIClass &spi, uint32_t frequency, const char *mountpoint)
+    {
+        return false;
+    }
+    void end() {}
+    sdcard_type_t cardType()
+    {
+        return CARD_NONE;
+    }
+    uint64_t cardSize()
+    {
+        return 0;
+    }
+};
+
+extern SDFS SD;
@@ -0,0 +1,39 @@
+#pragma once
+// Host stand-in, see MockHost.h. Writes are recorded like polling transactions on one line.
+#include <stdint.h>
+#include <stddef.h>
+
+#define SPI_MODE0               (0)
+#define HSPI                    (2)
+#define FSPI                    (1)
+
+// Per call overhead of SPIClass::writeBytes, microseconds
+#define SPI_BUS_OVERHEAD_US     (10)
+
+class SPISettings
+{
+public:
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) : _clock(clock) {}
+    uint32_t _clock;
+};
+
+class SPIClass
+{
+public:
+    SPIClass(uint8_t bus = HSPI) : _freq(1000000) {}
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+    void end() {}
+    void beginTransaction(SPISettings settings)
+    {
+        _freq = settings._clock;
+    }
+    void endTransaction() {}
+    void write(uint8_t data)
+    {
+        writeBytes(&data, 1);
+    }
+    void writeBytes(const uint8_t *data, uint32_t size);
+    uint32_t _freq;
+};
+
+extern SPIClass SPI;
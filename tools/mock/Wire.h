@@ -0,0 +1,40 @@
+#pragma once
+// Host stand-in, see MockHost.h. Devices are register files declared with mockI2CAddDevice.
+#include <stdint.h>
+#include <stddef.h>
+#include "Arduino.h"
+
+class TwoWire : public Stream
+{
+public:
+    TwoWire(uint8_t bus) : _sda(-1), _scl(-1), _timeout(50), _address(0), _txLen(0), _rxLen(0), _rxPos(0) {}
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    bool end();
+    void setClock(uint32_t frequency) {}
+    void setTimeOut(uint16_t timeout_ms)
+    {
+        _timeout = timeout_ms;
+    }
+    uint16_t getTimeOut()
+    {
+        return _timeout;
+    }
+    void beginTransmission(uint16_t address);
+    uint8_t endTransmission(bool sendStop = true);
+    size_t requestFrom(uint16_t address, size_t size, bool sendStop = true);
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t *data, size_t size) override;
+    int available() override;
+    int read() override;
+    size_t readBytes(uint8_t *buffer, size_t length);
+private:
+    int _sda, _scl;
+    uint16_t _timeout;
+    uint16_t _address;
+    uint8_t _tx[64];
+    size_t _txLen;
+    uint8_t _rx[64];
+    size_t _rxLen, _rxPos;
+};
+
+extern TwoWire Wire;
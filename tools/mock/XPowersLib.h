@@ -0,0 +1,3 @@
+#pragma once
+// Host stand-in, see MockSensors.h
+#include "MockSensors.h"
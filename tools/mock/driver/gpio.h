@@ -0,0 +1,23 @@
+#pragma once
+// Host stand-in, see MockHost.h
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    GPIO_NUM_NC = -1,
+    GPIO_NUM_14 = 14,
+    GPIO_NUM_MAX = 49,
+} gpio_num_t;
+
+// Same pin state as digitalWrite
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level);
+static inline esp_err_t gpio_hold_en(gpio_num_t pin)
+{
+    return ESP_OK;
+}
+static inline esp_err_t gpio_hold_dis(gpio_num_t pin)
+{
+    return ESP_OK;
+}
+static inline void gpio_deep_sleep_hold_en() {}
+static inline void gpio_deep_sleep_hold_dis() {}
@@ -0,0 +1,113 @@
+#pragma once
+// Host stand-in for the esp-idf 4.4 SPI master driver, see MockHost.h
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef enum {
+    SPI1_HOST = 0,
+    SPI2_HOST = 1,
+    SPI3_HOST = 2,
+} spi_host_device_t;
+
+#define SPI_DMA_CH_AUTO                 (3)
+#define SPICOMMON_BUSFLAG_MASTER        (1 << 0)
+#define SPICOMMON_BUSFLAG_GPIO_PINS     (1 << 5)
+#define SPI_DEVICE_HALFDUPLEX           (1 << 4)
+
+#define SPI_TRANS_MODE_DIO              (1 << 0)
+#define SPI_TRANS_MODE_QIO              (1 << 1)
+#define SPI_TRANS_USE_RXDATA            (1 << 2)
+#define SPI_TRANS_USE_TXDATA            (1 << 3)
+#define SPI_TRANS_MODE_DIOQIO_ADDR      (1 << 4)
+#define SPI_TRANS_VARIABLE_CMD          (1 << 5)
+#define SPI_TRANS_VARIABLE_ADDR         (1 << 6)
+#define SPI_TRANS_VARIABLE_DUMMY        (1 << 7)
+#define SPI_TRANS_CS_KEEP_ACTIVE        (1 << 8)
+#define SPI_TRANS_MULTILINE_CMD         (1 << 9)
+#define SPI_TRANS_MODE_OCT              (1 << 10)
+#define SPI_TRANS_MULTILINE_ADDR        SPI_TRANS_MODE_DIOQIO_ADDR
+
+typedef struct spi_transaction_t spi_transaction_t;
+typedef void (*transaction_cb_t)(spi_transaction_t *trans);
+
+struct spi_transaction_t {
+    uint32_t flags;
+    uint16_t cmd;
+    uint64_t addr;
+    size_t length;
+    size_t rxlength;
+    void *user;
+    union {
+        const void *tx_buffer;
+        uint8_t tx_data[4];
+    };
+    union {
+        void *rx_buffer;
+        uint8_t rx_data[4];
+    };
+};
+
+typedef struct {
+    struct spi_transaction_t base;
+    uint8_t command_bits;
+    uint8_t address_bits;
+    uint8_t dummy_bits;
+} spi_transaction_ext_t;
+
+typedef struct {
+    union {
+        int mosi_io_num;
+        int data0_io_num;
+    };
+    union {
+        int miso_io_num;
+        int data1_io_num;
+    };
+    int sclk_io_num;
+    union {
+        int quadwp_io_num;
+        int data2_io_num;
+    };
+    union {
+        int quadhd_io_num;
+        int data3_io_num;
+    };
+    int data4_io_num;
+    int data5_io_num;
+    int data6_io_num;
+    int data7_io_num;
+    int max_transfer_sz;
+    uint32_t flags;
+    int intr_flags;
+} spi_bus_config_t;
+
+typedef struct {
+    uint8_t command_bits;
+    uint8_t address_bits;
+    uint8_t dummy_bits;
+    uint8_t mode;
+    uint16_t duty_cycle_pos;
+    uint16_t cs_ena_pretrans;
+    uint8_t cs_ena_posttrans;
+    int clock_speed_hz;
+    int input_delay_ns;
+    int spics_io_num;
+    uint32_t flags;
+    int queue_size;
+    transaction_cb_t pre_cb;
+    transaction_cb_t post_cb;
+} spi_device_interface_config_t;
+
+typedef struct MockSPIDevice *spi_device_handle_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config, int dma_chan);
+esp_err_t spi_bus_free(spi_host_device_t host);
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *config, spi_device_handle_t *handle);
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle);
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t ticks);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t ticks);
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans);
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t ticks);
+void spi_device_release_bus(spi_device_handle_t handle);
@@ -0,0 +1,21 @@
+#pragma once
+// Host stand-in, see MockHost.h, raw readings are taken as millivolts
+#include <stdint.h>
+
+typedef enum { ADC_UNIT_1 = 1 } adc_unit_t;
+typedef enum { ADC_ATTEN_DB_11 = 3, ADC_ATTEN_DB_12 = 3 } adc_atten_t;
+typedef enum { ADC_WIDTH_BIT_12 = 3 } adc_bits_width_t;
+typedef struct {
+    uint32_t vref;
+} esp_adc_cal_characteristics_t;
+
+static inline int esp_adc_cal_characterize(adc_unit_t unit, adc_atten_t atten, adc_bits_width_t width,
+        uint32_t vref, esp_adc_cal_characteristics_t *chars)
+{
+    chars->vref = vref;
+    return 0;
+}
+static inline uint32_t esp_adc_cal_raw_to_voltage(uint32_t raw, const esp_adc_cal_characteristics_t *chars)
+{
+    return raw;
+}
@@ -0,0 +1,4 @@
+#pragma once
+// Host stand-in, see MockHost.h
+#define ESP_IDF_VERSION_VAL(major, minor, patch)        ((major << 16) | (minor << 8) | (patch))
+#define ESP_IDF_VERSION         ESP_IDF_VERSION_VAL(4, 4, 6)
@@ -0,0 +1,16 @@
+#pragma once
+// Host stand-in, see MockHost.h
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+    ESP_SLEEP_WAKEUP_TOUCHPAD,
+    ESP_SLEEP_WAKEUP_ULP,
+} esp_sleep_source_t;
+
+static inline esp_sleep_source_t esp_sleep_get_wakeup_cause()
+{
+    return ESP_SLEEP_WAKEUP_UNDEFINED;
+}
@@ -0,0 +1,6 @@
+#pragma once
+// Host stand-in, see MockHost.h
+#include <stdint.h>
+#include "esp_err.h"
+// Mock clock, microseconds
+int64_t esp_timer_get_time();
@@ -0,0 +1,32 @@
+#pragma once
+// Host stand-in, see MockHost.h. One tick is one millisecond of the mock clock.
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE                 (0)
+#define pdTRUE                  (1)
+#define pdPASS                  (pdTRUE)
+#define pdFAIL                  (pdFALSE)
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS      (1)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+
+// Interrupts are delivered synchronously by the mock clock, there is nothing to switch to
+#define portYIELD_FROM_ISR()
+
+// A critical section held by the task masks the mock interrupts, see mockCriticalGetStats
+typedef struct {
+    int owner;                  // Nesting depth
+} portMUX_TYPE;
+void mockEnterCritical(portMUX_TYPE *mux, bool isr);
+void mockExitCritical(portMUX_TYPE *mux, bool isr);
+#define portMUX_INITIALIZER_UNLOCKED    {0}
+#define portMUX_INITIALIZE(mux)         ((mux)->owner = 0)
+#define portENTER_CRITICAL(mux)         mockEnterCritical(mux, false)
+#define portEXIT_CRITICAL(mux)          mockExitCritical(mux, false)
+#define portENTER_CRITICAL_ISR(mux)     mockEnterCritical(mux, true)
+#define portEXIT_CRITICAL_ISR(mux)      mockExitCritical(mux, true)
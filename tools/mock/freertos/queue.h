@@ -0,0 +1,5 @@
+#pragma once
+// Host stand-in, see MockHost.h
+#include "FreeRTOS.h"
+
+typedef struct MockQueue *QueueHandle_t;
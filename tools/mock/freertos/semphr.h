@@ -0,0 +1,12 @@
+#pragma once
+// Host stand-in, see MockHost.h
+#include "FreeRTOS.h"
+
+typedef struct MockSemaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary();
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+// Blocking advances the mock clock to the next event that can give the semaphore, or to the timeout
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *woken);
@@ -0,0 +1,155 @@
+/**
+ * @file      partial_bench.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host benchmark of the bytes per frame of typical UI updates, sent as a full
+ * frame (the previous fullRefresh of the 1.47 inch board) or as the
+ * invalidated area only. The virtual display models the same window, chunk
+ * and bus as the driver, on the 1.47 inch panel the area is rotated into the
+ * panel scan order like pushColors of LilyGo_AMOLED does.
+ *
+ * Every area is rounded like lv_rounder_cb of the lvgl helper, even start and
+ * odd end, then the changed pixels are rendered into the screen and sent. The
+ * panel is compared with the screen after every update.
+ *
+ * Build : g++ -O2 -I../../src partial_bench.cpp ../../src/LilyGo_VirtualDisplay.cpp ../../src/PixelKernels.cpp
+ *         ../../src/initSequence.cpp -o partial_bench
+ * Usage : partial_bench [board 0-3] [rotation 0-3]
+ *
+ * Exits with 1 if the panel does not match the screen after any update.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "LilyGo_VirtualDisplay.h"
+#include "PixelKernels.h"
+
+typedef struct {
+    const char *name;
+    uint16_t x, y, w, h;        // Invalidated area before rounding
+} Update_t;
+
+static const Update_t updates[] = {
+    {"cursor blink 2x18",   101, 88,  2,   18},
+    {"label 96x20",         8,   40,  96,  20},
+    {"clock digits 60x32",  300, 8,   60,  32},
+    {"slider knob 24x24",   170, 150, 24,  24},
+    {"list row 368x30",     0,   120, 368, 30},
+};
+
+static uint16_t screenW, screenH;
+
+// Move the area inside the screen, rows and areas of the landscape layout are shortened in portrait
+static Update_t place(const Update_t &u)
+{
+    Update_t p = u;
+    p.w = p.w > screenW ? screenW : p.w;
+    p.h = p.h > screenH ? screenH : p.h;
+    p.x = p.x + p.w > screenW ? screenW - p.w : p.x;
+    p.y = p.y + p.h > screenH ? screenH - p.h : p.y;
+    return p;
+}
+
+// Same as lv_rounder_cb, clipped to the screen
+static void roundArea(const Update_t &u, uint16_t *x, uint16_t *y, uint16_t *w, uint16_t *h)
+{
+    uint16_t x1 = u.x & ~1, y1 = u.y & ~1;
+    uint16_t x2 = (u.x + u.w - 1) | 1, y2 = (u.y + u.h - 1) | 1;
+    if (x2 >= screenW) {
+        x2 = screenW - 1;
+    }
+    if (y2 >= screenH) {
+        y2 = screenH - 1;
+    }
+    *x = x1;
+    *y = y1;
+    *w = x2 - x1 + 1;
+    *h = y2 - y1 + 1;
+}
+
+// A new pattern in the area of update, the rest of the screen keeps its pixels
+static void render(uint16_t *screen, const Update_t &u, uint32_t step)
+{
+    for (uint16_t y = u.y; y < u.y + u.h; y++) {
+        for (uint16_t x = u.x; x < u.x + u.w; x++) {
+            screen[(uint32_t)y * screenW + x] = (uint16_t)((x * 31 + y * 7 + step * 0x1234) ^ 0xA5A5);
+        }
+    }
+}
+
+static bool compare(LilyGo_VirtualDisplay &display, const uint16_t *screen, const char *name)
+{
+    for (uint16_t y = 0; y < screenH; y++) {
+        for (uint16_t x = 0; x < screenW; x++) {
+            if (display.getPixel(x, y) != screen[(uint32_t)y * screenW + x]) {
+                printf("%s: panel differs at %u,%u\n", name, x, y);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int board = argc > 1 ? atoi(argv[1]) : VIRTUAL_AMOLED_147;
+    uint8_t rotation = argc > 2 ? atoi(argv[2]) : 0;
+
+    LilyGo_VirtualDisplay display((VirtualDisplayType)board);
+    display.setRotation(rotation);
+    // Pixels are in CPU order, the display swaps them while sending
+    display.setSwapBytes(true);
+    screenW = display.width();
+    screenH = display.height();
+
+    const uint32_t pixels = (uint32_t)screenW * screenH;
+    uint16_t *screen = (uint16_t *)calloc(pixels, sizeof(uint16_t));
+    uint16_t *area = (uint16_t *)calloc(pixels, sizeof(uint16_t));
+    if (!screen || !area) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    display.fillScreen(0);
+
+    const VirtualPanel_t *panel = display.getPanel();
+    printf("# %s, %ux%u rotation %u, %u MHz x%u%s\n", display.getName(), screenW, screenH, rotation,
+           panel->freq / 1000000, panel->lanes, panel->softRotate ? ", rotated in software" : "");
+    printf("# %-22s %24s %24s\n", "update", "full frame", "partial area");
+    int ret = 0;
+    for (size_t i = 0; i < sizeof(updates) / sizeof(*updates); i++) {
+        Update_t u = place(updates[i]);
+        VirtualBusStats_t full, partial;
+
+        render(screen, u, i);
+        display.resetBusStats();
+        display.pushColors(0, 0, screenW, screenH, screen);
+        display.getBusStats(&full);
+        if (!compare(display, screen, u.name)) {
+            ret = 1;
+        }
+
+        render(screen, u, i + 1);
+        uint16_t x, y, w, h;
+        roundArea(u, &x, &y, &w, &h);
+        for (uint16_t r = 0; r < h; r++) {
+            pixelCopy(area + (uint32_t)r * w, screen + (uint32_t)(y + r) * screenW + x, w);
+        }
+        display.resetBusStats();
+        display.pushColors(x, y, w, h, area);
+        display.getBusStats(&partial);
+        if (!compare(display, screen, u.name)) {
+            ret = 1;
+        }
+
+        printf("  %-22s %9llu B / %6llu us %9llu B / %6llu us\n", u.name,
+               (unsigned long long)full.bytes, (unsigned long long)(full.busNs / 1000),
+               (unsigned long long)partial.bytes, (unsigned long long)(partial.busNs / 1000));
+    }
+    free(screen);
+    free(area);
+    return ret;
+}
@@ -0,0 +1,237 @@
+/**
+ * @file      profile_sync.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host check of the DISPLAY_PROFILE counters, which the transaction done
+ * interrupt updates while the task queues more flushes and reads them. The
+ * driver runs against the host mock (tools/mock) on the 1.91 inch board,
+ * the mock delivers the SPI callbacks in interrupt context and a critical
+ * section held by the task masks them.
+ *
+ * Flushes of several sizes are queued back to back with pushColorsDMA, so
+ * every flush is still in flight when the next one starts, and a snapshot
+ * is taken after every call. Checked:
+ *  - every snapshot is consistent: the histogram adds up to the flushes and
+ *    no counter goes backwards
+ *  - the flushes, bytes, transactions, commands and CS time match the
+ *    recorded bus exactly
+ *  - the latency of every flush is taken from its own start, the last and
+ *    maximum latency and the histogram match the DMA done times
+ *  - a reset with flushes in flight drops them as a whole
+ *  - every critical section is entered in the right context, never blocks
+ *    and is left again
+ *
+ * Build : g++ -O2 -DDISPLAY_PROFILE=1 -DARDUINO=10819 -DBOARD_HAS_PSRAM -DARDUINO_USB_CDC_ON_BOOT=1 -I../mock
+ *         -I../../src profile_sync.cpp ../mock/MockHost.cpp ../../src/LilyGo_AMOLED.cpp
+ *         ../../src/PixelKernels.cpp ../../src/initSequence.cpp ../../src/I2CBus.cpp
+ *         ../../src/BoardDetect.cpp ../../src/TouchFilter.cpp -o profile_sync
+ * Usage : profile_sync [flushes]
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "LilyGo_AMOLED.h"
+#include "MockHost.h"
+
+#if !DISPLAY_PROFILE
+#error "Build with -DDISPLAY_PROFILE=1"
+#endif
+
+static LilyGo_AMOLED amoled;
+static std::vector<int64_t> doneUs;
+
+static void dmaDone(void *user_data)
+{
+    doneUs.push_back(mockNow());
+}
+
+static uint8_t bucketOf(uint32_t us)
+{
+    uint8_t bucket = 0;
+    uint32_t bound = 500;
+    while (bucket < DISPLAY_PROFILE_BUCKETS - 1 && us > bound) {
+        bound <<= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static bool consistent(const DisplayProfile_t &p, const DisplayProfile_t &prev, uint32_t call)
+{
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < DISPLAY_PROFILE_BUCKETS; i++) {
+        sum += p.histogram[i];
+    }
+    if (sum != p.flushes || p.flushes < prev.flushes || p.bytes < prev.bytes || p.csUs < prev.csUs ||
+            p.transactions < prev.transactions) {
+        printf("  snapshot after call %u: %u flushes, histogram %u, bytes %llu after %llu\n", call, p.flushes, sum,
+               (unsigned long long)p.bytes, (unsigned long long)prev.bytes);
+        return false;
+    }
+    return true;
+}
+
+// Queue flushes back to back, then compare the counters with the recorded bus
+static bool run(uint32_t flushes, const char *name)
+{
+    static const uint16_t sizes[][2] = {{536, 240}, {64, 32}, {200, 100}, {536, 40}, {8, 8}};
+    uint16_t *frame = (uint16_t *)calloc(536 * 240, sizeof(uint16_t));
+    std::vector<int64_t> calls;
+    uint64_t bytes = 0;
+    bool ok = true;
+
+    amoled.resetProfile();
+    mockSPIClear();
+    doneUs.clear();
+    DisplayProfile_t prev = {}, p;
+    for (uint32_t i = 0; i < flushes; i++) {
+        const uint16_t *s = sizes[i % (sizeof(sizes) / sizeof(*sizes))];
+        uint32_t len = (uint32_t)s[0] * s[1];
+        amoled.setAddrWindow(0, 0, s[0] - 1, s[1] - 1);
+        calls.push_back(mockNow());
+        amoled.pushColorsDMA(frame, len);
+        bytes += len * sizeof(uint16_t);
+        amoled.getProfile(&p);
+        ok &= consistent(p, prev, i);
+        prev = p;
+    }
+    amoled.waitDMADone();
+    amoled.getProfile(&p);
+    ok &= consistent(p, prev, flushes);
+
+    // CS is held from the start of the first transaction of a burst or command to the end of its last
+    uint32_t transactions = 0, commands = 0;
+    uint64_t cs = 0;
+    int64_t csStart = -1;
+    const std::vector<MockSPIRecord_t> &records = mockSPIRecords();
+    for (size_t i = 0; i < records.size(); i++) {
+        const MockSPIRecord_t &r = records[i];
+        bool pixels = r.lines == 4;
+        pixels ? transactions++ : commands++;
+        if (!pixels || r.cmdBits) {
+            csStart = r.startUs;
+        }
+        // A burst ends before the next command or RAMWR chunk
+        bool end = !pixels || i + 1 == records.size() || records[i + 1].lines != 4 || records[i + 1].cmdBits;
+        if (end) {
+            cs += r.endUs - csStart;
+        }
+    }
+    if (p.flushes != flushes || p.bytes != bytes || p.transactions != transactions || p.commands != commands ||
+            p.csUs != cs) {
+        printf("  %s: flushes %u/%u bytes %llu/%llu transactions %u/%u commands %u/%u cs %llu/%llu us\n", name,
+               p.flushes, flushes, (unsigned long long)p.bytes, (unsigned long long)bytes, p.transactions,
+               transactions, p.commands, commands, (unsigned long long)p.csUs, (unsigned long long)cs);
+        ok = false;
+    }
+
+    uint32_t histogram[DISPLAY_PROFILE_BUCKETS] = {};
+    uint32_t max_us = 0, last_us = 0;
+    for (size_t i = 0; i < doneUs.size() && i < calls.size(); i++) {
+        last_us = doneUs[i] - calls[i];
+        max_us = max_us > last_us ? max_us : last_us;
+        histogram[bucketOf(last_us)]++;
+    }
+    if (doneUs.size() != flushes || p.maxFlushUs != max_us || p.lastFlushUs != last_us ||
+            memcmp(histogram, p.histogram, sizeof(histogram))) {
+        printf("  %s: latency last %u/%u max %u/%u us, %zu done callbacks\n", name, p.lastFlushUs, last_us,
+               p.maxFlushUs, max_us, doneUs.size());
+        ok = false;
+    }
+
+    // A reset waits for the flushes in flight
+    amoled.setAddrWindow(0, 0, 535, 239);
+    amoled.pushColorsDMA(frame, 536 * 240);
+    amoled.resetProfile();
+    amoled.getProfile(&p);
+    if (p.flushes || p.bytes || p.transactions || p.csUs) {
+        printf("  %s: %u flushes %llu bytes left after the reset\n", name, p.flushes, (unsigned long long)p.bytes);
+        ok = false;
+    }
+
+    free(frame);
+    printf("%-24s %s  flushes:%u max:%u us kbps:%u\n", name, ok ? "ok  " : "FAIL", flushes, max_us, prev.kbytesPerSecond);
+    return ok;
+}
+
+// The mock must mask interrupts in a critical section and see every misuse
+static bool selfTest()
+{
+    static uint32_t posted;
+    spi_device_interface_config_t devcfg = {};
+    devcfg.clock_speed_hz = 40000000;
+    devcfg.spics_io_num = -1;
+    devcfg.queue_size = 2;
+    devcfg.post_cb = [](spi_transaction_t *t) {
+        posted++;
+    };
+    spi_device_handle_t spi;
+    spi_bus_add_device(SPI3_HOST, &devcfg, &spi);
+    mockCriticalClear();
+
+    static uint8_t buffer[64];
+    spi_transaction_t t = {};
+    t.tx_buffer = buffer;
+    t.length = sizeof(buffer) * 8;
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+    portENTER_CRITICAL(&mux);
+    spi_device_queue_trans(spi, &t, portMAX_DELAY);
+    mockAdvance(1000);
+    bool masked = posted == 0;
+    portEXIT_CRITICAL(&mux);
+    bool delivered = posted == 1;
+    spi_transaction_t *result;
+    spi_device_get_trans_result(spi, &result, portMAX_DELAY);
+    spi_bus_remove_device(spi);
+
+    portENTER_CRITICAL_ISR(&mux);
+    portEXIT_CRITICAL_ISR(&mux);
+    portENTER_CRITICAL(&mux);
+    delay(1);
+    portEXIT_CRITICAL(&mux);
+    portEXIT_CRITICAL(&mux);
+
+    MockCriticalStats_t stats;
+    mockCriticalGetStats(&stats);
+    bool ok = masked && delivered && stats.deferred && stats.wrongContext == 1 && stats.blocked == 1 &&
+              stats.unbalanced == 1;
+    printf("%-24s %s  masked:%d delivered:%d deferred:%u wrong context:%u blocked:%u unbalanced:%u\n",
+           "mock self test", ok ? "ok  " : "FAIL", masked, delivered, stats.deferred, stats.wrongContext,
+           stats.blocked, stats.unbalanced);
+    mockCriticalClear();
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t flushes = argc > 1 ? atoi(argv[1]) : 40;
+    if (!flushes) {
+        flushes = 40;
+    }
+
+    bool ok = selfTest();
+    if (!amoled.beginAMOLED_191(false)) {
+        printf("begin failed\n");
+        return 1;
+    }
+    amoled.setDMADoneCallback(dmaDone, NULL);
+    mockCriticalClear();
+    ok &= run(flushes, "back to back");
+    amoled.setChunkSize(2048);
+    ok &= run(flushes, "small chunks");
+
+    MockCriticalStats_t stats;
+    mockCriticalGetStats(&stats);
+    bool locks = stats.isrSections && stats.taskSections && !stats.wrongContext && !stats.blocked && !stats.unbalanced;
+    printf("%-24s %s  task:%u isr:%u wrong context:%u blocked:%u unbalanced:%u\n", "critical sections",
+           locks ? "ok  " : "FAIL", stats.taskSections, stats.isrSections, stats.wrongContext, stats.blocked,
+           stats.unbalanced);
+    return ok && locks ? 0 : 1;
+}
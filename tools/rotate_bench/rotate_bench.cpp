@@ -0,0 +1,179 @@
+/**
+ * @file      rotate_bench.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host benchmark of the 1.47 inch (SH8501) rotate-and-send path on a 368x194
+ * frame. The panel scans 90 degrees from rotation 0, every frame is rotated
+ * before it is sent:
+ *
+ *   column loop   the previous path, the whole frame is rotated into the
+ *                 PSRAM frame buffer reading one source column at a time,
+ *                 then the frame buffer is sent
+ *   tiled         LilyGo_AMOLED::pushRect, strips are rotated with the tiled
+ *                 kernel into two internal SRAM buffers, one is sent while
+ *                 the next is rotated
+ *
+ * The driver runs against the host mock (tools/mock) with the bus modelled
+ * at the board's QSPI clock and the host time of the rotation added, so the
+ * frame time shows how much of the rotation is hidden behind the transfer.
+ * The host rotates many times faster than the ESP32-S3 from PSRAM and keeps
+ * the whole frame in its caches, which hides the cost of the column reads.
+ * The rotation alone is reported too, cpu scale multiplies the host time to
+ * approximate the slower CPU. The panel data of both paths is compared.
+ *
+ * Build : g++ -O2 -DARDUINO=10819 -DBOARD_HAS_PSRAM -DARDUINO_USB_CDC_ON_BOOT=1 -I../mock -I../../src
+ *         rotate_bench.cpp ../mock/MockHost.cpp ../../src/LilyGo_AMOLED.cpp ../../src/PixelKernels.cpp
+ *         ../../src/initSequence.cpp ../../src/I2CBus.cpp ../../src/BoardDetect.cpp
+ *         ../../src/TouchFilter.cpp -o rotate_bench
+ * Usage : rotate_bench [iterations] [cpu scale]
+ *
+ * Exits with 1 if the panel data of the two paths differs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "LilyGo_AMOLED.h"
+#include "PixelKernels.h"
+#include "MockHost.h"
+
+static LilyGo_AMOLED amoled;
+
+static uint32_t seed = 1;
+
+static uint16_t random16()
+{
+    seed = seed * 1103515245u + 12345u;
+    return (uint16_t)(seed >> 8);
+}
+
+// The rotation of the previous pushColors, one source column per panel row
+static void columnLoop(uint16_t *dst, const uint16_t *p, uint16_t width, uint16_t hight)
+{
+    uint32_t cum = 0;
+    for (uint16_t j = 0; j < width; j++) {
+        for (uint16_t i = 0; i < hight; i++) {
+            dst[cum] = ((uint16_t)p[width * (hight - i - 1) + j]);
+            cum++;
+        }
+    }
+}
+
+static void columnLoopFrame(uint16_t *frame, const uint16_t *src, uint16_t width, uint16_t hight)
+{
+    columnLoop(frame, src, width, hight);
+    amoled.setAddrWindow(amoled.height() - hight, 0, amoled.height() - 1, width - 1);
+    amoled.pushColors(frame, width * hight);
+}
+
+static void tiledFrame(uint16_t *frame, const uint16_t *src, uint16_t width, uint16_t hight)
+{
+    amoled.pushRect(0, 0, width, hight, (uint16_t *)src, width);
+}
+
+// Panel bytes of the pixel bursts recorded since the last mockSPIClear
+static std::vector<uint8_t> panelData()
+{
+    std::vector<uint8_t> out;
+    for (const MockSPIRecord_t &r : mockSPIRecords()) {
+        if (r.lines == 4) {
+            out.insert(out.end(), r.data.begin(), r.data.end());
+        }
+    }
+    return out;
+}
+
+static double timeFrames(void (*fn)(uint16_t *, const uint16_t *, uint16_t, uint16_t), uint16_t *frame,
+                         const uint16_t *src, uint16_t width, uint16_t hight, int iterations, MockSPIStats_t *stats)
+{
+    mockSPIClear();
+    int64_t start = mockNow();
+    for (int i = 0; i < iterations; i++) {
+        fn(frame, src, width, hight);
+    }
+    double us = (double)(mockNow() - start) / iterations;
+    mockSPIGetStats(stats);
+    return us;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 50;
+    if (iterations <= 0) {
+        iterations = 50;
+    }
+    double scale = argc > 2 ? atof(argv[2]) : 1.0;
+    if (scale <= 0) {
+        scale = 1.0;
+    }
+
+    const BoardsConfigure_t *board = &BOARD_AMOLED_147;
+    mockI2CAddDevice(board->pmu->sda, board->pmu->scl, AXP2101_SLAVE_ADDRESS);
+    if (!amoled.beginAMOLED_147()) {
+        printf("begin failed\n");
+        return 1;
+    }
+    uint16_t width = amoled.width(), hight = amoled.height();
+    uint32_t len = (uint32_t)width * hight;
+
+    uint16_t *src = (uint16_t *)ps_malloc(len * sizeof(uint16_t));
+    uint16_t *frame = (uint16_t *)ps_malloc(len * sizeof(uint16_t));
+    if (!src || !frame) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        src[i] = random16();
+    }
+
+    // Rotation alone, on the host CPU
+    uint16_t *tiled = (uint16_t *)malloc(len * sizeof(uint16_t));
+    mockSetClockMode(MOCK_CLOCK_HOST, scale);
+    int64_t start = mockNow();
+    for (int i = 0; i < iterations; i++) {
+        columnLoop(frame, src, width, hight);
+    }
+    double loop_us = (double)(mockNow() - start) / iterations;
+    start = mockNow();
+    for (int i = 0; i < iterations; i++) {
+        pixelRotate90Strip(tiled, src, width, hight, 0, width, false);
+    }
+    double tile_us = (double)(mockNow() - start) / iterations;
+    bool ok = memcmp(frame, tiled, len * sizeof(uint16_t)) == 0;
+    free(tiled);
+
+    // Send path, the previous one sent PSRAM directly
+    MockSPIStats_t loop_stats, tile_stats;
+    mockSPIRecordPayload(true);
+    amoled.setBounceBuffers(0, 0);
+    timeFrames(columnLoopFrame, frame, src, width, hight, 1, &loop_stats);
+    std::vector<uint8_t> loop_data = panelData();
+    double loop_frame = timeFrames(columnLoopFrame, frame, src, width, hight, iterations, &loop_stats);
+    amoled.setBounceBuffers(2, 4096);
+    timeFrames(tiledFrame, frame, src, width, hight, 1, &tile_stats);
+    std::vector<uint8_t> tile_data = panelData();
+    double tile_frame = timeFrames(tiledFrame, frame, src, width, hight, iterations, &tile_stats);
+    mockSPIRecordPayload(false);
+    mockSetClockMode(MOCK_CLOCK_VIRTUAL);
+
+    if (loop_data != tile_data || loop_data.size() != len * sizeof(uint16_t)) {
+        printf("Panel data differs between the paths\n");
+        ok = false;
+    }
+
+    printf("# %ux%u frame, %d iterations, QSPI %d MHz, cpu scale %.1f\n", width, hight, iterations,
+           board->display.freq / 1000000, scale);
+    printf("%-14s %10s %10s %10s %8s\n", "path", "rotate us", "frame us", "bus us", "fps");
+    printf("%-14s %10.1f %10.1f %10.1f %8.1f\n", "column loop", loop_us, loop_frame,
+           (double)loop_stats.busyUs / iterations, 1000000.0 / loop_frame);
+    printf("%-14s %10.1f %10.1f %10.1f %8.1f\n", "tiled", tile_us, tile_frame,
+           (double)tile_stats.busyUs / iterations, 1000000.0 / tile_frame);
+
+    heap_caps_free(src);
+    heap_caps_free(frame);
+    return ok ? 0 : 1;
+}
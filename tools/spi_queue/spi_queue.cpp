@@ -0,0 +1,307 @@
+/**
+ * @file      spi_queue.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host check of the queued QSPI transfers of LilyGo_AMOLED. The driver is
+ * built against the host mock (tools/mock), whose spi_device_queue_trans and
+ * spi_device_get_trans_result model the bus of the 1.91 inch QSPI board and
+ * check every transaction against the rules of the esp-idf driver.
+ *
+ * Checked for every run:
+ *  - no descriptor is queued again before its result was taken
+ *  - no more than queue_size transactions are in flight
+ *  - no transmit buffer is changed while its transaction is queued
+ *  - no polling transaction is sent while queued ones are in flight
+ *  - CS is asserted for every chunk and released only after the last one
+ *  - the DMA done callback is called once per flush, after the last chunk
+ *  - the panel receives the pixels that were pushed
+ *  - the bounce throughput is timed from the first queued chunk to the last
+ *    one sent, bursts that overlap in time are counted once
+ *
+ * Build : g++ -O2 -DARDUINO=10819 -DBOARD_HAS_PSRAM -DARDUINO_USB_CDC_ON_BOOT=1 -I../mock -I../../src
+ *         spi_queue.cpp ../mock/MockHost.cpp ../../src/LilyGo_AMOLED.cpp ../../src/PixelKernels.cpp
+ *         ../../src/initSequence.cpp ../../src/I2CBus.cpp ../../src/BoardDetect.cpp
+ *         ../../src/TouchFilter.cpp -o spi_queue
+ * Usage : spi_queue [frames]
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include "LilyGo_AMOLED.h"
+#include "PixelKernels.h"
+#include "MockHost.h"
+
+typedef struct {
+    bool swap;
+    bool psram;                 // Source in PSRAM, staged through the bounce ring
+    bool callback;              // pushColorsDMA returns before the transfer is done
+    uint8_t bounceNum;
+    uint32_t chunkPixels;
+    const char *name;
+} QueueRun_t;
+
+typedef struct {
+    uint32_t calls;
+    int64_t lastUs;
+} DoneCount_t;
+
+static LilyGo_AMOLED amoled;
+
+static void dmaDone(void *user_data)
+{
+    DoneCount_t *done = (DoneCount_t *)user_data;
+    done->calls++;
+    done->lastUs = mockNow();
+}
+
+static void fillFrame(uint16_t *frame, uint32_t len, uint32_t seed)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        seed = seed * 1103515245u + 12345u;
+        frame[i] = seed >> 16;
+    }
+}
+
+/*
+* Split the records into bursts, a burst starts with the RAMWR chunk. Returns
+* false if a chunk is not where the queue put it.
+*/
+static bool checkBursts(const std::vector<MockSPIRecord_t> &records, const char *name,
+                        std::vector<size_t> &ends, std::vector<uint8_t> &pixels)
+{
+    bool ok = true;
+    bool inBurst = false;
+    for (size_t i = 0; i < records.size(); i++) {
+        const MockSPIRecord_t &r = records[i];
+        if (!r.csLow) {
+            printf("  %s: transaction %zu sent with CS released\n", name, i);
+            ok = false;
+        }
+        if (r.lines != 4) {
+            if (inBurst) {
+                printf("  %s: command 0x%02X inside a pixel burst\n", name, (r.addr >> 8) & 0xFF);
+                ok = false;
+            }
+            continue;
+        }
+        bool first = r.cmdBits != 0;
+        if (first && (r.cmd != 0x32 || r.addr != 0x002C00 || r.addrBits != 24)) {
+            printf("  %s: burst %zu does not start with RAMWR\n", name, ends.size());
+            ok = false;
+        }
+        if (first == inBurst) {
+            printf("  %s: chunk %zu %s\n", name, i, first ? "starts a burst before the last one ended" : "outside a burst");
+            ok = false;
+        }
+        pixels.insert(pixels.end(), r.data.begin(), r.data.end());
+        inBurst = true;
+        // CS is released by the transaction after the last chunk, or by the burst end
+        bool last = i + 1 == records.size() || records[i + 1].lines != 4 || records[i + 1].cmdBits != 0;
+        if (last) {
+            ends.push_back(i);
+            inBurst = false;
+        }
+    }
+    return ok;
+}
+
+// Union of the bursts from their first chunk queued to their last chunk sent
+static uint64_t spanUs(const std::vector<MockSPIRecord_t> &records, const std::vector<size_t> &ends)
+{
+    uint64_t span = 0;
+    int64_t start = -1, end = -1;
+    size_t first = 0;
+    for (size_t last : ends) {
+        while (first < last && !(records[first].lines == 4 && records[first].cmdBits != 0)) {
+            first++;
+        }
+        if (start < 0 || records[first].queuedUs > end) {
+            span += start < 0 ? 0 : end - start;
+            start = records[first].queuedUs;
+        }
+        end = std::max(end, records[last].endUs);
+        first = last + 1;
+    }
+    return start < 0 ? 0 : span + end - start;
+}
+
+static bool run(const QueueRun_t &cfg, uint32_t frames)
+{
+    const uint32_t len = amoled.width() * amoled.height();
+    DoneCount_t done = {};
+    bool ok = true;
+
+    if (!amoled.setBounceBuffers(cfg.bounceNum, cfg.chunkPixels) || !amoled.setChunkSize(cfg.chunkPixels)) {
+        printf("%-20s FAIL  bounce buffers\n", cfg.name);
+        return false;
+    }
+    amoled.setSwapBytes(cfg.swap);
+    amoled.setDMADoneCallback(cfg.callback ? dmaDone : NULL, &done);
+
+    std::vector<uint16_t *> sources;
+    for (uint32_t f = 0; f < frames; f++) {
+        uint16_t *frame = (uint16_t *)(cfg.psram ? ps_malloc(len * 2) : malloc(len * 2));
+        fillFrame(frame, len, f + 1);
+        sources.push_back(frame);
+    }
+
+    mockSPIRecordPayload(true);
+    mockSPIClear();
+    amoled.resetBounceStats();
+    std::vector<int64_t> returned;
+    for (uint32_t f = 0; f < frames; f++) {
+        amoled.setAddrWindow(0, 0, amoled.width() - 1, amoled.height() - 1);
+        amoled.pushColorsDMA(sources[f], len);
+        returned.push_back(mockNow());
+    }
+    amoled.waitDMADone();
+
+    MockSPIStats_t stats;
+    mockSPIGetStats(&stats);
+    const std::vector<MockSPIRecord_t> &records = mockSPIRecords();
+    std::vector<size_t> ends;
+    std::vector<uint8_t> pixels;
+    ok &= checkBursts(records, cfg.name, ends, pixels);
+
+    if (stats.descriptorReuse || stats.overLimit || stats.bufferModified || stats.pollingWhileQueued || stats.resultWithoutQueued) {
+        printf("  %s: reuse:%u over limit:%u modified:%u polling:%u stray result:%u\n", cfg.name, stats.descriptorReuse,
+               stats.overLimit, stats.bufferModified, stats.pollingWhileQueued, stats.resultWithoutQueued);
+        ok = false;
+    }
+    if (stats.maxInFlight > stats.queueSize) {
+        printf("  %s: %u transactions in flight, queue size %u\n", cfg.name, stats.maxInFlight, stats.queueSize);
+        ok = false;
+    }
+    if (ends.size() != frames) {
+        printf("  %s: %zu pixel bursts for %u frames\n", cfg.name, ends.size(), frames);
+        ok = false;
+    }
+    if (cfg.callback) {
+        if (done.calls != frames) {
+            printf("  %s: DMA done called %u times for %u frames\n", cfg.name, done.calls, frames);
+            ok = false;
+        } else if (!ends.empty() && done.lastUs != records[ends.back()].endUs) {
+            printf("  %s: DMA done at %lld us, last chunk ends at %lld us\n", cfg.name,
+                   (long long)done.lastUs, (long long)records[ends.back()].endUs);
+            ok = false;
+        }
+        // Without a stall on the ring the flush returns before the last chunk is sent
+        if (!ends.empty() && returned.back() >= records[ends.back()].endUs) {
+            printf("  %s: pushColorsDMA returned after the transfer\n", cfg.name);
+            ok = false;
+        }
+    } else if (!ends.empty() && returned.back() < records[ends.back()].endUs) {
+        printf("  %s: pushColorsDMA returned before the transfer was done\n", cfg.name);
+        ok = false;
+    }
+
+    if (cfg.swap || cfg.psram) {
+        DisplayBounceStats_t bounce;
+        amoled.getBounceStats(&bounce);
+        uint64_t span = spanUs(records, ends);
+        if (bounce.activeUs != span) {
+            printf("  %s: bounce transfers active %llu us, bursts span %llu us\n", cfg.name,
+                   (unsigned long long)bounce.activeUs, (unsigned long long)span);
+            ok = false;
+        }
+    }
+
+    std::vector<uint8_t> expected;
+    for (uint32_t f = 0; f < frames; f++) {
+        std::vector<uint16_t> copy(sources[f], sources[f] + len);
+        if (cfg.swap) {
+            pixelSwapCopy(copy.data(), copy.data(), len);
+        }
+        expected.insert(expected.end(), (uint8_t *)copy.data(), (uint8_t *)(copy.data() + len));
+    }
+    if (pixels != expected) {
+        printf("  %s: panel data differs from the pushed frames\n", cfg.name);
+        ok = false;
+    }
+
+    for (uint32_t f = 0; f < frames; f++) {
+        heap_caps_free(sources[f]);
+    }
+    amoled.setDMADoneCallback(NULL, NULL);
+    mockSPIRecordPayload(false);
+
+    printf("%-20s %s  queued:%-5u in flight:%-3u bus:%6llu us\n", cfg.name, ok ? "ok  " : "FAIL",
+           stats.queued, stats.maxInFlight, (unsigned long long)stats.busyUs);
+    return ok;
+}
+
+// The checks must see a broken queue: reuse a descriptor, overfill the queue,
+// change a buffer of three queued transactions and poll behind them
+static bool selfTest()
+{
+    spi_device_interface_config_t devcfg = {};
+    devcfg.clock_speed_hz = 40000000;
+    devcfg.spics_io_num = -1;
+    devcfg.queue_size = 2;
+    spi_device_handle_t spi;
+    spi_bus_add_device(SPI3_HOST, &devcfg, &spi);
+    mockSPIClear();
+
+    static uint8_t buffer[64];
+    spi_transaction_t t[3] = {};
+    for (int i = 0; i < 3; i++) {
+        t[i].tx_buffer = buffer;
+        t[i].length = sizeof(buffer) * 8;
+    }
+    spi_transaction_t *result;
+    spi_device_queue_trans(spi, &t[0], portMAX_DELAY);
+    spi_device_queue_trans(spi, &t[0], portMAX_DELAY);
+    spi_device_queue_trans(spi, &t[1], portMAX_DELAY);
+    buffer[0] ^= 1;
+    spi_device_polling_transmit(spi, &t[2]);
+    for (int i = 0; i < 4; i++) {
+        spi_device_get_trans_result(spi, &result, portMAX_DELAY);
+    }
+
+    MockSPIStats_t stats;
+    mockSPIGetStats(&stats);
+    spi_bus_remove_device(spi);
+    bool ok = stats.descriptorReuse == 1 && stats.overLimit == 1 && stats.bufferModified == 3 &&
+              stats.pollingWhileQueued == 1 && stats.resultWithoutQueued == 1;
+    printf("%-20s %s  reuse:%u over limit:%u modified:%u polling:%u stray result:%u\n", "mock self test",
+           ok ? "ok  " : "FAIL", stats.descriptorReuse, stats.overLimit, stats.bufferModified,
+           stats.pollingWhileQueued, stats.resultWithoutQueued);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t frames = argc > 1 ? atoi(argv[1]) : 4;
+    if (!frames) {
+        frames = 4;
+    }
+
+    bool ok = selfTest();
+    if (!amoled.beginAMOLED_191(false)) {
+        printf("begin failed\n");
+        return 1;
+    }
+    mockSPIWatchCS(amoled.getBoardsConfigure()->display.cs);
+
+    static const QueueRun_t runs[] = {
+        {false, false, true,  2, 4096,  "direct callback"},
+        {false, false, false, 2, 4096,  "direct blocking"},
+        {true,  false, true,  2, 4096,  "swap 2x4096"},
+        {true,  true,  true,  4, 2048,  "psram swap 4x2048"},
+        {false, true,  true,  3, 1000,  "psram 3x1000"},
+        {true,  true,  false, 2, 16384, "psram swap blocking"},
+    };
+
+    for (size_t i = 0; i < sizeof(runs) / sizeof(*runs); i++) {
+        ok &= run(runs[i], frames);
+    }
+    return ok ? 0 : 1;
+}
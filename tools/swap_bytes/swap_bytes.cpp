@@ -0,0 +1,310 @@
+/**
+ * @file      swap_bytes.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host check and benchmark of the byte swap of LilyGo_AMOLED. The driver runs
+ * against the recording bus of the host mock (tools/mock) on the 1.91 inch
+ * board, QSPI or SPI.
+ *
+ * Checked:
+ *  - the panel receives every pixel swapped, for SRAM and PSRAM sources,
+ *    lengths around the chunk size and unaligned sources
+ *  - the caller's buffer is never changed
+ *  - setSwapBytes returns false and leaves the swap off when no bounce buffer
+ *    can be allocated, the pixels are then sent as they are
+ *  - the bounce ring can not be disabled while the swap is on, and a failed
+ *    allocation of the ring turns the swap off
+ *  - pushRect of rows wider than a bounce buffer, or without a ring, sends
+ *    the rows intact and leaves the caller's buffer alone
+ *
+ * Then a full frame is timed with and without the swap, from SRAM and PSRAM.
+ * The mock clock adds the host time of the copies, cpu scale multiplies it to
+ * approximate the slower CPU, the swap is hidden behind the transfer as long
+ * as the frame time does not grow. The bookkeeping of the mock is scaled too,
+ * large scales overstate every row alike.
+ *
+ * Build : g++ -O2 -DARDUINO=10819 -DBOARD_HAS_PSRAM -DARDUINO_USB_CDC_ON_BOOT=1 -I../mock -I../../src
+ *         swap_bytes.cpp ../mock/MockHost.cpp ../../src/LilyGo_AMOLED.cpp ../../src/PixelKernels.cpp
+ *         ../../src/initSequence.cpp ../../src/I2CBus.cpp ../../src/BoardDetect.cpp
+ *         ../../src/TouchFilter.cpp -o swap_bytes
+ * Usage : swap_bytes [bus 0: QSPI, 1: SPI] [iterations] [cpu scale]
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "LilyGo_AMOLED.h"
+#include "PixelKernels.h"
+#include "MockHost.h"
+
+static LilyGo_AMOLED amoled;
+static bool qspi = true;
+
+static uint32_t seed = 1;
+
+static uint16_t random16()
+{
+    seed = seed * 1103515245u + 12345u;
+    return (uint16_t)(seed >> 8);
+}
+
+// Pixel bytes of the records since the last mockSPIClear, the SPI bus sends RAMWR in setAddrWindow
+static std::vector<uint8_t> panelData()
+{
+    std::vector<uint8_t> out;
+    for (const MockSPIRecord_t &r : mockSPIRecords()) {
+        if (!qspi || r.lines == 4) {
+            out.insert(out.end(), r.data.begin(), r.data.end());
+        }
+    }
+    return out;
+}
+
+static bool sendAndCompare(const uint16_t *src, uint32_t len, bool swapped, const char *name)
+{
+    std::vector<uint16_t> before(src, src + len);
+    std::vector<uint16_t> expected(before);
+    if (swapped) {
+        pixelSwapCopy(expected.data(), expected.data(), len);
+    }
+
+    amoled.setAddrWindow(0, 0, amoled.width() - 1, amoled.height() - 1);
+    amoled.waitDMADone();
+    mockSPIClear();
+    amoled.pushColors((uint16_t *)src, len);
+    std::vector<uint8_t> data = panelData();
+
+    bool ok = true;
+    if (data.size() != len * sizeof(uint16_t) || memcmp(data.data(), expected.data(), data.size())) {
+        printf("  %s: panel data of %u pixels differs\n", name, len);
+        ok = false;
+    }
+    if (memcmp(src, before.data(), len * sizeof(uint16_t))) {
+        printf("  %s: source buffer of %u pixels was changed\n", name, len);
+        ok = false;
+    }
+    return ok;
+}
+
+static bool checkLengths(bool psram, bool swapped, const char *name)
+{
+    const uint32_t chunk = amoled.getChunkSize();
+    const uint32_t lengths[] = {1, 2, 3, 255, chunk - 1, chunk, chunk + 1, 3 * chunk + 7};
+    uint32_t max = 3 * chunk + 8;
+    uint16_t *buf = (uint16_t *)(psram ? ps_malloc(max * sizeof(uint16_t)) : malloc(max * sizeof(uint16_t)));
+    for (uint32_t i = 0; i < max; i++) {
+        buf[i] = random16();
+    }
+    bool ok = true;
+    for (uint32_t len : lengths) {
+        ok &= sendAndCompare(buf, len, swapped, name);
+        // Unaligned to four bytes
+        ok &= sendAndCompare(buf + 1, len, swapped, name);
+    }
+    heap_caps_free(buf);
+    printf("%-32s %s\n", name, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static bool expect(bool cond, const char *name)
+{
+    printf("%-32s %s\n", name, cond ? "ok" : "FAIL");
+    return cond;
+}
+
+static bool checkFallbacks()
+{
+    bool ok = true;
+    uint32_t len = 1000;
+    uint16_t *buf = (uint16_t *)malloc(len * sizeof(uint16_t));
+    for (uint32_t i = 0; i < len; i++) {
+        buf[i] = random16();
+    }
+
+    // The ring can not go away below a swap
+    ok &= expect(amoled.setSwapBytes(true), "swap on");
+    ok &= expect(!amoled.setBounceBuffers(0, 0), "no ring refused while swapping");
+    ok &= expect(sendAndCompare(buf, len, true, "swap after refused"), "still swapped");
+
+    // No ring, the swap is refused and the data goes out as it is
+    amoled.setSwapBytes(false);
+    ok &= expect(amoled.setBounceBuffers(0, 0), "ring disabled");
+    ok &= expect(!amoled.setSwapBytes(true), "swap refused without ring");
+    ok &= expect(sendAndCompare(buf, len, false, "unswapped"), "sent unswapped, source kept");
+
+    // The ring can not be allocated
+    mockHeapFailAfter(0);
+    ok &= expect(amoled.setBounceBuffers(2, 4096) == false, "ring allocation fails");
+    ok &= expect(!amoled.setSwapBytes(true), "swap refused when out of memory");
+    mockHeapFailAfter(-1);
+    ok &= expect(sendAndCompare(buf, len, false, "unswapped oom"), "sent unswapped, source kept");
+
+    // A failed allocation of a new ring turns the swap off
+    ok &= expect(amoled.setBounceBuffers(2, 4096) && amoled.setSwapBytes(true), "swap on again");
+    mockHeapFailAfter(0);
+    ok &= expect(!amoled.setBounceBuffers(2, 2048), "new ring allocation fails");
+    mockHeapFailAfter(-1);
+    ok &= expect(sendAndCompare(buf, len, false, "swap dropped"), "swap turned off with the ring");
+
+    amoled.setBounceBuffers(2, 4096);
+    free(buf);
+    return ok;
+}
+
+// Pixel bytes of the records since the last mockSPIClear, without the commands of the address windows
+static std::vector<uint8_t> windowData()
+{
+    std::vector<uint8_t> out;
+    const std::vector<MockSPIRecord_t> &records = mockSPIRecords();
+    for (size_t i = 0; i < records.size(); i++) {
+        const MockSPIRecord_t &r = records[i];
+        if (qspi ? r.lines != 4 : r.bytes == 1) {
+            // The SPI bus sends CASET and RASET parameters as a separate write
+            if (!qspi && (r.data[0] == 0x2A || r.data[0] == 0x2B)) {
+                i++;
+            }
+            continue;
+        }
+        out.insert(out.end(), r.data.begin(), r.data.end());
+    }
+    return out;
+}
+
+static bool checkRect(const uint16_t *src, uint16_t w, uint16_t h, uint32_t stride, bool swapped, const char *name)
+{
+    std::vector<uint16_t> before(src, src + (uint32_t)h * stride);
+    std::vector<uint16_t> expected;
+    for (uint16_t i = 0; i < h; i++) {
+        expected.insert(expected.end(), src + (uint32_t)i * stride, src + (uint32_t)i * stride + w);
+    }
+    if (swapped) {
+        pixelSwapCopy(expected.data(), expected.data(), expected.size());
+    }
+
+    amoled.waitDMADone();
+    mockSPIClear();
+    amoled.pushRect(2, 1, w, h, (uint16_t *)src, stride);
+    std::vector<uint8_t> data = windowData();
+    bool ok = true;
+    if (data.size() != expected.size() * sizeof(uint16_t) || memcmp(data.data(), expected.data(), data.size())) {
+        printf("  %s: panel data of %ux%u differs\n", name, w, h);
+        ok = false;
+    }
+    if (memcmp(src, before.data(), before.size() * sizeof(uint16_t))) {
+        printf("  %s: source buffer was changed\n", name);
+        ok = false;
+    }
+    return expect(ok, name);
+}
+
+// Rows that no bounce buffer holds go out one window per row, swapped ones in scratch pieces
+static bool checkRows()
+{
+    const uint16_t w = amoled.width() - 16, h = 5;
+    const uint32_t stride = amoled.width();
+    uint16_t *buf = (uint16_t *)ps_malloc(h * stride * sizeof(uint16_t));
+    for (uint32_t i = 0; i < h * stride; i++) {
+        buf[i] = random16();
+    }
+    bool ok = true;
+    ok &= expect(amoled.setBounceBuffers(2, 128) && amoled.setSwapBytes(true), "ring narrower than a row");
+    ok &= checkRect(buf, w, h, stride, true, "rect rows swapped");
+    amoled.setSwapBytes(false);
+    ok &= checkRect(buf, w, h, stride, false, "rect rows");
+    amoled.setBounceBuffers(0, 0);
+    ok &= checkRect(buf, w, h, stride, false, "rect rows without ring");
+    amoled.setBounceBuffers(2, 4096);
+    heap_caps_free(buf);
+    return ok;
+}
+
+static double timeFrames(uint16_t *src, uint32_t len, int iterations, uint64_t *busy)
+{
+    amoled.waitDMADone();
+    mockSPIClear();
+    int64_t start = mockNow();
+    for (int i = 0; i < iterations; i++) {
+        amoled.setAddrWindow(0, 0, amoled.width() - 1, amoled.height() - 1);
+        amoled.pushColors(src, len);
+    }
+    double us = (double)(mockNow() - start) / iterations;
+    MockSPIStats_t stats;
+    mockSPIGetStats(&stats);
+    *busy = stats.busyUs / iterations;
+    return us;
+}
+
+static void bench(int iterations, double scale)
+{
+    uint32_t len = (uint32_t)amoled.width() * amoled.height();
+    uint16_t *sram = (uint16_t *)malloc(len * sizeof(uint16_t));
+    uint16_t *psram = (uint16_t *)ps_malloc(len * sizeof(uint16_t));
+    for (uint32_t i = 0; i < len; i++) {
+        sram[i] = psram[i] = random16();
+    }
+
+    printf("# %ux%u frame, %d iterations, %s %d MHz, cpu scale %.1f\n", amoled.width(), amoled.height(), iterations,
+           qspi ? "QSPI" : "SPI", amoled.getBoardsConfigure()->display.freq / 1000000, scale);
+    printf("%-16s %10s %10s %10s %10s\n", "source", "frame us", "bus us", "copy us", "MB/s");
+    mockSetClockMode(MOCK_CLOCK_HOST, scale);
+    for (int run = 0; run < 4; run++) {
+        bool swap = run & 1;
+        uint16_t *src = run & 2 ? psram : sram;
+        amoled.setSwapBytes(swap);
+        amoled.resetBounceStats();
+        uint64_t busy;
+        double us = timeFrames(src, len, iterations, &busy);
+        DisplayBounceStats_t stats;
+        amoled.getBounceStats(&stats);
+        char name[32];
+        snprintf(name, sizeof(name), "%s%s", run & 2 ? "psram" : "sram", swap ? " swap" : "");
+        printf("%-16s %10.1f %10llu %10.1f %10.2f\n", name, us, (unsigned long long)busy,
+               (double)stats.copyUs / iterations, len * sizeof(uint16_t) / us);
+    }
+    mockSetClockMode(MOCK_CLOCK_VIRTUAL);
+    amoled.setSwapBytes(false);
+    free(sram);
+    heap_caps_free(psram);
+}
+
+int main(int argc, char **argv)
+{
+    qspi = !(argc > 1 && atoi(argv[1]) == 1);
+    int iterations = argc > 2 ? atoi(argv[2]) : 20;
+    if (iterations <= 0) {
+        iterations = 20;
+    }
+    double scale = argc > 3 ? atof(argv[3]) : 1.0;
+    if (scale <= 0) {
+        scale = 1.0;
+    }
+
+    if (!qspi) {
+        mockI2CAddDevice(BOARD_AMOLED_191_SPI.pmu->sda, BOARD_AMOLED_191_SPI.pmu->scl, SY6970_SLAVE_ADDRESS);
+    }
+    if (!(qspi ? amoled.beginAMOLED_191(false) : amoled.beginAMOLED_191_SPI(false))) {
+        printf("begin failed\n");
+        return 1;
+    }
+    mockSPIRecordPayload(true);
+
+    bool ok = true;
+    ok &= expect(amoled.setSwapBytes(true), "swap on");
+    ok &= checkLengths(false, true, "sram swap");
+    ok &= checkLengths(true, true, "psram swap");
+    amoled.setSwapBytes(false);
+    ok &= checkLengths(false, false, "sram");
+    ok &= checkLengths(true, false, "psram");
+    ok &= checkFallbacks();
+    ok &= checkRows();
+    mockSPIRecordPayload(false);
+
+    bench(iterations, scale);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file      te_sync.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host simulation of the tearing effect (TE) synchronization. The driver runs
+ * against the host mock (tools/mock), which raises the TE interrupt of the
+ * 1.91 inch board at a fixed period. Every frame renders for a while (the
+ * mock clock is advanced), calls waitVSync and sends the whole screen.
+ *
+ * Checked for every run:
+ *  - a synced frame starts sending exactly at a TE edge, never at an edge
+ *    that passed while the frame was rendering
+ *  - a frame waits no longer than the timeout, frames without an edge in
+ *    time are counted as missed and nothing else is
+ *  - the TE edge counter matches the edges raised
+ *
+ * Build : g++ -O2 -DARDUINO=10819 -DBOARD_HAS_PSRAM -DARDUINO_USB_CDC_ON_BOOT=1 -I../mock -I../../src
+ *         te_sync.cpp ../mock/MockHost.cpp ../../src/LilyGo_AMOLED.cpp ../../src/PixelKernels.cpp
+ *         ../../src/initSequence.cpp ../../src/I2CBus.cpp ../../src/BoardDetect.cpp
+ *         ../../src/TouchFilter.cpp -o te_sync
+ * Usage : te_sync [frames]
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "LilyGo_AMOLED.h"
+#include "MockHost.h"
+
+typedef struct {
+    uint32_t periodUs;          // TE period, 0 for a panel that does not raise TE
+    uint32_t renderUs;          // Render time of a frame before waitVSync
+    uint32_t jitterUs;          // Random extra render time, up to
+    uint32_t timeoutMs;
+    const char *name;
+} TERun_t;
+
+static LilyGo_AMOLED amoled;
+static uint16_t *frame;
+static uint32_t seed = 1;
+
+static uint32_t random32()
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 1;
+}
+
+// Start of the first pixel burst recorded since the last mockSPIClear
+static int64_t burstStart()
+{
+    for (const MockSPIRecord_t &r : mockSPIRecords()) {
+        if (r.lines == 4) {
+            return r.startUs;
+        }
+    }
+    return -1;
+}
+
+static bool run(const TERun_t &cfg, uint32_t frames)
+{
+    const int te = amoled.getBoardsConfigure()->display.te;
+    const uint32_t len = amoled.width() * amoled.height();
+    bool ok = true;
+
+    amoled.setTESync(TE_SYNC_WAIT, cfg.timeoutMs);
+    amoled.resetTEStats();
+    int64_t first = mockNow() + 1000;
+    if (cfg.periodUs) {
+        mockTEStart(te, cfg.periodUs, first);
+    }
+
+    uint32_t synced = 0, missed = 0;
+    uint64_t busy = 0;
+    int64_t start = mockNow();
+    for (uint32_t f = 0; f < frames; f++) {
+        mockAdvance(cfg.renderUs + (cfg.jitterUs ? random32() % cfg.jitterUs : 0));
+        int64_t wait_start = mockNow();
+        amoled.waitVSync();
+        int64_t waited = mockNow() - wait_start;
+
+        mockSPIClear();
+        amoled.setAddrWindow(0, 0, amoled.width() - 1, amoled.height() - 1);
+        amoled.pushColors(frame, len);
+        int64_t sent = burstStart();
+        MockSPIStats_t stats;
+        mockSPIGetStats(&stats);
+        busy += stats.busyUs;
+
+        bool edge = cfg.periodUs && waited < (int64_t)cfg.timeoutMs * 1000;
+        if (edge) {
+            synced++;
+            // The commands of the window go first, the burst follows them on the bus
+            int64_t since = (wait_start + waited - first) % cfg.periodUs;
+            if (since != 0 || wait_start + waited - first < 0 || waited == 0) {
+                printf("  %s: frame %u left waitVSync %lld us after an edge, waited %lld us\n", cfg.name, f,
+                       (long long)since, (long long)waited);
+                ok = false;
+            }
+            if (sent - (wait_start + waited) > 200) {
+                printf("  %s: frame %u burst started %lld us after the edge\n", cfg.name, f,
+                       (long long)(sent - (wait_start + waited)));
+                ok = false;
+            }
+        } else {
+            missed++;
+            if (waited != (int64_t)cfg.timeoutMs * 1000) {
+                printf("  %s: frame %u missed after %lld us, timeout %u ms\n", cfg.name, f, (long long)waited, cfg.timeoutMs);
+                ok = false;
+            }
+        }
+    }
+    int64_t elapsed = mockNow() - start;
+
+    DisplayTEStats_t stats;
+    amoled.getTEStats(&stats);
+    uint32_t edges = cfg.periodUs && mockNow() >= first ? (mockNow() - first) / cfg.periodUs + 1 : 0;
+    mockTEStop();
+    if (stats.frames != frames || stats.missed != missed) {
+        printf("  %s: stats %u frames %u missed, seen %u frames %u missed\n", cfg.name, stats.frames, stats.missed,
+               frames, missed);
+        ok = false;
+    }
+    if (stats.vsyncs != edges) {
+        printf("  %s: %u TE edges counted, %u raised\n", cfg.name, stats.vsyncs, edges);
+        ok = false;
+    }
+
+    printf("%-22s %s  fps:%5.1f synced:%-4u missed:%-4u max wait:%6u us bus:%4.0f%%\n", cfg.name, ok ? "ok  " : "FAIL",
+           frames * 1000000.0 / elapsed, synced, stats.missed, stats.maxWaitUs, busy * 100.0 / elapsed);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t frames = argc > 1 ? atoi(argv[1]) : 120;
+    if (!frames) {
+        frames = 120;
+    }
+
+    if (!amoled.beginAMOLED_191(false)) {
+        printf("begin failed\n");
+        return 1;
+    }
+    frame = (uint16_t *)calloc(amoled.width() * amoled.height(), sizeof(uint16_t));
+
+    static const TERun_t runs[] = {
+        {16667, 2000,  0,     50, "60Hz light frames"},
+        {16667, 2000,  8000,  50, "60Hz jitter"},
+        {16667, 20000, 0,     50, "60Hz slow render"},
+        {16667, 14000, 10000, 50, "60Hz around a period"},
+        {33333, 1000,  0,     20, "30Hz short timeout"},
+        {0,     1000,  0,     20, "no TE signal"},
+    };
+
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(runs) / sizeof(*runs); i++) {
+        ok &= run(runs[i], frames);
+    }
+    free(frame);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,288 @@
+/**
+ * @file      touch_filter.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host bench of src/TouchFilter. Synthetic finger paths with a known true
+ * position are sampled like the touch controller does (report interval,
+ * pixel noise, integer coordinates) and shown like the lvgl helper does: the
+ * latest sample is read every indev period and is on the panel once the frame
+ * is flushed. Every shown point is compared with where the finger really is
+ * at that moment.
+ *
+ *  lag     mean distance to the finger while it moves, pixels
+ *  jitter  RMS distance to the finger while it is held still, pixels
+ *  worst   largest distance seen, pixels
+ *  delay   sample to frame flushed, what getLvglTouchLatency reports
+ *
+ * Traces in the tools/gesture_test format have no true position, for them
+ * the jitter is the mean change of direction of the shown path.
+ *
+ * Build : g++ -O2 -I../../src touch_filter.cpp ../../src/TouchFilter.cpp -o touch_filter
+ * Usage : touch_filter [trace ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "TouchFilter.h"
+
+typedef struct {
+    const char *name;
+    uint32_t reportMs;          // Controller report interval while touched
+    uint32_t readMs;            // lvgl indev read period
+    uint32_t flushMs;           // Indev read to frame flushed, render and bus time
+    float noise;                // Pixels, standard deviation of the controller noise
+    TouchFilterConfig_t preset;
+} BenchBoard_t;
+
+typedef struct {
+    const char *name;
+    uint32_t durationMs;
+} BenchPath_t;
+
+typedef struct {
+    double lag;
+    double jitter;
+    double worst;
+    double delay;
+} BenchResult_t;
+
+static const BenchPath_t paths[] = {
+    {"hold still",   1500},
+    {"slow drag",    1500},
+    {"fast drag",    600},
+    {"flick",        400},
+    {"circle",       1500},
+    {"drag and stop", 1500},
+};
+
+static uint32_t seed = 1;
+
+static float noise(float sigma)
+{
+    // Sum of uniforms, close enough to normal
+    float s = 0;
+    for (int i = 0; i < 4; i++) {
+        seed = seed * 1103515245u + 12345u;
+        s += (float)(seed >> 8) / (float)(1 << 24) - 0.5f;
+    }
+    return s * sigma * 1.732f;
+}
+
+// True finger position of path p at time t in milliseconds, returns false once lifted
+static bool finger(int p, float t, float *x, float *y, bool *moving)
+{
+    if (t > paths[p].durationMs) {
+        return false;
+    }
+    float s = t / 1000.0f;
+    *moving = true;
+    switch (p) {
+    case 0:
+        *x = 120;
+        *y = 300;
+        *moving = false;
+        break;
+    case 1:
+        *x = 40 + 80 * s;
+        *y = 100 + 60 * s;
+        break;
+    case 2:
+        *x = 20 + 350 * s;
+        *y = 400 - 500 * s;
+        break;
+    case 3: {
+        // Accelerates, then leaves the screen moving fast
+        *x = 200 - 1200 * s * s;
+        *y = 250;
+        break;
+    }
+    case 4:
+        *x = 120 + 80 * cosf(2 * 3.14159265f * s);
+        *y = 300 + 80 * sinf(2 * 3.14159265f * s);
+        break;
+    default:
+        // Eases into a stop after 600ms and rests there
+        if (t < 600) {
+            float f = t / 600.0f;
+            *x = 40 + 160 * (2 * f - f * f);
+        } else {
+            *x = 200;
+            *moving = false;
+        }
+        *y = 200;
+        break;
+    }
+    return true;
+}
+
+static BenchResult_t runPath(const BenchBoard_t &board, int p, const TouchFilterConfig_t *config)
+{
+    TouchFilter filter;
+    if (config) {
+        filter.setConfig(*config);
+    }
+    BenchResult_t result = {0, 0, 0, 0};
+    uint32_t moving = 0, still = 0, frames = 0;
+
+    TouchEvent_t latest;
+    bool have = false;
+    uint32_t nextReport = 0;
+    float x, y;
+    bool isMoving;
+    // 1ms steps, the read phase is offset so that reads do not line up with reports
+    for (uint32_t t = 0; finger(p, (float)t, &x, &y, &isMoving); t++) {
+        if (t == nextReport) {
+            latest.timestamp = (int64_t)t * 1000;
+            latest.points = 1;
+            latest.x = (int16_t)lroundf(x + noise(board.noise));
+            latest.y = (int16_t)lroundf(y + noise(board.noise));
+            if (config) {
+                filter.update(&latest);
+            }
+            have = true;
+            nextReport += board.reportMs;
+        }
+        if (!have || (t + 7) % board.readMs) {
+            continue;
+        }
+        float fx, fy;
+        bool m;
+        if (!finger(p, (float)(t + board.flushMs), &fx, &fy, &m)) {
+            break;
+        }
+        double d = hypot(latest.x - fx, latest.y - fy);
+        if (m) {
+            result.lag += d;
+            moving++;
+        } else {
+            result.jitter += d * d;
+            still++;
+        }
+        result.worst = d > result.worst ? d : result.worst;
+        result.delay += t + board.flushMs - latest.timestamp / 1000.0;
+        frames++;
+    }
+    result.lag = moving ? result.lag / moving : 0;
+    result.jitter = still ? sqrt(result.jitter / still) : 0;
+    result.delay = frames ? result.delay / frames : 0;
+    return result;
+}
+
+static void benchBoard(const BenchBoard_t &board)
+{
+    TouchFilterConfig_t smooth = board.preset;
+    smooth.predictMs = 0;
+    const struct {
+        const char *name;
+        const TouchFilterConfig_t *config;
+    } filters[] = {
+        {"raw", NULL},
+        {"smooth", &smooth},
+        {"predict", &board.preset},
+    };
+
+    printf("%s: %ums reports, %ums reads, %ums to flushed, noise %.1fpx, predict %ums\n", board.name,
+           board.reportMs, board.readMs, board.flushMs, board.noise, board.preset.predictMs);
+    printf("  %-14s", "path");
+    for (size_t f = 0; f < sizeof(filters) / sizeof(*filters); f++) {
+        printf(" | %-7s lag jitter worst", filters[f].name);
+    }
+    printf(" | delay\n");
+    for (size_t p = 0; p < sizeof(paths) / sizeof(*paths); p++) {
+        printf("  %-14s", paths[p].name);
+        double delay = 0;
+        for (size_t f = 0; f < sizeof(filters) / sizeof(*filters); f++) {
+            // Same noise for every filter
+            seed = 1 + p;
+            BenchResult_t r = runPath(board, p, filters[f].config);
+            printf(" |   %9.1f %6.2f %5.1f", r.lag, r.jitter, r.worst);
+            delay = r.delay;
+        }
+        printf(" | %4.1fms\n", delay);
+    }
+}
+
+/*
+* Mean angle between successive moves of the shown path, in degrees. A still
+* finger with noise scores high, a smooth path low.
+*/
+static double pathWobble(const std::vector<TouchEvent_t> &samples)
+{
+    double sum = 0;
+    uint32_t n = 0;
+    for (size_t i = 2; i < samples.size(); i++) {
+        const TouchEvent_t &a = samples[i - 2], &b = samples[i - 1], &c = samples[i];
+        if (!a.points || !b.points || !c.points) {
+            continue;
+        }
+        double ax = b.x - a.x, ay = b.y - a.y, bx = c.x - b.x, by = c.y - b.y;
+        if ((!ax && !ay) || (!bx && !by)) {
+            continue;
+        }
+        double turn = fabs(atan2(ax * by - ay * bx, ax * bx + ay * by)) * 180.0 / 3.14159265;
+        sum += turn;
+        n++;
+    }
+    return n ? sum / n : 0;
+}
+
+static void benchTrace(const char *path, const TouchFilterConfig_t &config)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("%s: cannot open\n", path);
+        return;
+    }
+    std::vector<TouchEvent_t> raw, smooth;
+    TouchFilter filter(config);
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        long long ms;
+        int points, x, y;
+        if (sscanf(line, "%lld %d %d %d", &ms, &points, &x, &y) != 4) {
+            continue;
+        }
+        TouchEvent_t e;
+        memset(&e, 0, sizeof(e));
+        e.timestamp = ms * 1000;
+        e.points = points;
+        e.x = x;
+        e.y = y;
+        raw.push_back(e);
+        filter.update(&e);
+        smooth.push_back(e);
+    }
+    fclose(f);
+    const char *name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    printf("  %-22s samples:%-4zu wobble raw:%5.1f filtered:%5.1f degrees\n", name, raw.size(),
+           pathWobble(raw), pathWobble(smooth));
+}
+
+int main(int argc, char **argv)
+{
+    static const BenchBoard_t boards[] = {
+        {"1.47 CHSC5816", 16, 16, 10, 1.5f, TOUCH_FILTER_AMOLED_147},
+        {"1.91 CST816",   10, 16, 10, 1.5f, TOUCH_FILTER_AMOLED_191},
+        {"2.41 CST226",   10, 16, 14, 1.0f, TOUCH_FILTER_AMOLED_241},
+    };
+    for (size_t i = 0; i < sizeof(boards) / sizeof(*boards); i++) {
+        benchBoard(boards[i]);
+    }
+
+    if (argc > 1) {
+        const TouchFilterConfig_t config = TOUCH_FILTER_AMOLED_241;
+        printf("Traces, 2.41 preset without prediction\n");
+        TouchFilterConfig_t smooth = config;
+        smooth.predictMs = 0;
+        for (int i = 1; i < argc; i++) {
+            benchTrace(argv[i], smooth);
+        }
+    }
+    return 0;
+}
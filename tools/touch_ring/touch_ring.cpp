@@ -0,0 +1,296 @@
+/**
+ * @file      touch_ring.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host check of src/TouchRing.h. A producer thread plays synthetic gesture
+ * streams (taps, swipes, long presses, drags) into the ring the way the touch
+ * sampler task does, a consumer thread drains it the way touchpad_read does,
+ * one sample per read with continue_reading while more are pending.
+ *
+ * Checked for every run:
+ *  - samples arrive complete and in order, no sample is received twice
+ *  - every sample that is not received was counted as dropped
+ *  - every press ends with a release, also when samples were dropped
+ *  - with a consumer that keeps up nothing is dropped
+ *
+ * Without a consumer the ring fills up with presses, only a release takes
+ * the last slot. Then a writer thread publishes samples into TouchSnapshot
+ * while reader threads load it the way getPoint does, every field of a
+ * sample derives from one counter so a torn copy is detected.
+ *
+ * Build : g++ -O2 -pthread -I../../src touch_ring.cpp -o touch_ring
+ * Usage : touch_ring [gestures]
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include "TouchRing.h"
+
+typedef struct {
+    uint32_t readPeriodUs;      // lvgl indev read period
+    uint32_t stallUs;           // Extra consumer delay every 16 reads, 0 for none
+    uint32_t sampleUs;          // Controller report interval while touched
+    bool expectNoDrops;
+    const char *name;
+} RingRun_t;
+
+static uint32_t seed = 1;
+
+static uint32_t random32()
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 1;
+}
+
+/*
+* Gesture streams as the sampler queues them: samples while the finger is
+* down, one release at the end. The timestamp carries a running sequence
+* number in its low bits so that the consumer can check the order.
+*/
+static void makeGestures(std::vector<TouchEvent_t> &out, uint32_t gestures, uint32_t sampleUs)
+{
+    int64_t t = 0;
+    for (uint32_t g = 0; g < gestures; g++) {
+        uint32_t kind = random32() % 4;
+        int16_t x = random32() % 240, y = random32() % 536;
+        uint32_t samples;
+        int16_t dx = 0, dy = 0;
+        switch (kind) {
+        case 0:             // Tap
+            samples = 1 + random32() % 3;
+            break;
+        case 1:             // Swipe
+            samples = 5 + random32() % 10;
+            dx = (int16_t)(random32() % 41) - 20;
+            dy = (int16_t)(random32() % 41) - 20;
+            break;
+        case 2:             // Long press, small jitter
+            samples = 50 + random32() % 30;
+            break;
+        default:            // Slow drag
+            samples = 20 + random32() % 60;
+            dx = (int16_t)(random32() % 7) - 3;
+            dy = (int16_t)(random32() % 7) - 3;
+            break;
+        }
+        for (uint32_t i = 0; i < samples; i++) {
+            TouchEvent_t e;
+            e.timestamp = t;
+            e.x = x + dx * (int16_t)i + (kind == 2 ? (int16_t)(random32() % 3) - 1 : 0);
+            e.y = y + dy * (int16_t)i;
+            e.points = 1;
+            out.push_back(e);
+            t += sampleUs;
+        }
+        TouchEvent_t release = {t, 0, 0, 0};
+        out.push_back(release);
+        t += sampleUs * (5 + random32() % 20);
+    }
+    // Sequence numbers make every sample unique
+    for (size_t i = 0; i < out.size(); i++) {
+        out[i].timestamp = (out[i].timestamp << 20) | (int64_t)i;
+    }
+}
+
+static bool sameEvent(const TouchEvent_t &a, const TouchEvent_t &b)
+{
+    return a.timestamp == b.timestamp && a.x == b.x && a.y == b.y && a.points == b.points;
+}
+
+static bool run(const RingRun_t &cfg, uint32_t gestures)
+{
+    std::vector<TouchEvent_t> sent;
+    makeGestures(sent, gestures, cfg.sampleUs);
+
+    TouchRing ring;
+    std::vector<TouchEvent_t> received;
+    received.reserve(sent.size());
+    std::vector<bool> pushed(sent.size());
+    std::atomic<bool> producing(true);
+
+    std::thread producer([&]() {
+        for (size_t i = 0; i < sent.size(); i++) {
+            pushed[i] = ring.push(sent[i]);
+            std::this_thread::sleep_for(std::chrono::microseconds(cfg.sampleUs));
+        }
+        producing = false;
+    });
+
+    std::thread consumer([&]() {
+        uint32_t reads = 0;
+        while (producing || ring.available()) {
+            // One indev read, repeated while continue_reading would be set
+            TouchEvent_t e;
+            bool more;
+            do {
+                more = false;
+                if (ring.pop(&e)) {
+                    received.push_back(e);
+                    more = ring.available() != 0;
+                }
+            } while (more);
+            std::this_thread::sleep_for(std::chrono::microseconds(cfg.readPeriodUs));
+            if (cfg.stallUs && (++reads & 15) == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(cfg.stallUs));
+            }
+        }
+    });
+
+    producer.join();
+    consumer.join();
+
+    bool ok = true;
+    size_t expected = 0;
+    uint32_t presses = 0, releases = 0;
+    bool down = false;
+    for (size_t i = 0, j = 0; i < sent.size(); i++) {
+        if (!pushed[i]) {
+            continue;
+        }
+        expected++;
+        if (j >= received.size() || !sameEvent(sent[i], received[j])) {
+            printf("  %s: sample %zu missing or out of order\n", cfg.name, i);
+            ok = false;
+            break;
+        }
+        j++;
+    }
+    if (ok && received.size() != expected) {
+        printf("  %s: %zu samples received, %zu queued\n", cfg.name, received.size(), expected);
+        ok = false;
+    }
+    if (sent.size() - expected != ring.dropped()) {
+        printf("  %s: %zu samples lost, %u counted as dropped\n", cfg.name, sent.size() - expected, ring.dropped());
+        ok = false;
+    }
+    for (size_t i = 0; i < received.size(); i++) {
+        if (received[i].points && !down) {
+            presses++;
+        } else if (!received[i].points && down) {
+            releases++;
+        }
+        down = received[i].points != 0;
+    }
+    if (presses != releases || down || (cfg.expectNoDrops && ring.dropped())) {
+        printf("  %s: %u dropped, %u presses, %u releases\n", cfg.name, ring.dropped(), presses, releases);
+        ok = false;
+    }
+
+    printf("%-16s %s  samples:%-6zu received:%-6zu dropped:%-5u presses:%u\n", cfg.name, ok ? "ok  " : "FAIL",
+           sent.size(), received.size(), ring.dropped(), presses);
+    return ok;
+}
+
+// No consumer, the release of the touch must find room behind its presses
+static bool checkFull()
+{
+    TouchRing ring;
+    TouchEvent_t press = {1, 10, 20, 1, 0, 0};
+    TouchEvent_t release = {2, 0, 0, 0, 0, 0};
+    uint32_t queued = 0;
+    while (ring.push(press)) {
+        queued++;
+    }
+    bool ok = queued == TOUCH_RING_SIZE - 1 && ring.push(release) && ring.available() == TOUCH_RING_SIZE &&
+              !ring.push(press) && !ring.push(release) && ring.dropped() == 3;
+    TouchEvent_t e = press;
+    uint32_t popped = 0;
+    while (ring.pop(&e)) {
+        popped++;
+    }
+    ok &= popped == TOUCH_RING_SIZE && e.points == 0;
+    printf("%-16s %s  presses queued:%u dropped:%u\n", "full ring", ok ? "ok  " : "FAIL", queued, ring.dropped());
+    return ok;
+}
+
+// Every field derives from the counter, the reader can check that a copy is not torn
+static TouchEvent_t snapshotEvent(uint32_t n)
+{
+    TouchEvent_t e;
+    memset(&e, 0, sizeof(e));
+    e.timestamp = n;
+    e.x = (int16_t)(n & 0x7FFF);
+    e.y = (int16_t)~e.x;
+    e.points = (n & 1) + 1;
+    e.x2 = (int16_t)(e.x ^ 0x5A5A);
+    e.y2 = (int16_t)(n >> 15);
+    return e;
+}
+
+static bool checkSnapshot(uint32_t writes)
+{
+    TouchSnapshot snapshot;
+    std::atomic<bool> writing(true);
+    std::atomic<uint32_t> torn(0), backwards(0), loads(0);
+
+    auto reader = [&]() {
+        int64_t last = 0;
+        while (writing) {
+            TouchEvent_t e;
+            snapshot.load(&e);
+            loads++;
+            if (!e.timestamp) {
+                continue;       // Still the cleared state
+            }
+            TouchEvent_t expected = snapshotEvent((uint32_t)e.timestamp);
+            if (memcmp(&e, &expected, sizeof(e))) {
+                torn++;
+            }
+            if (e.timestamp < last) {
+                backwards++;
+            }
+            last = e.timestamp;
+        }
+    };
+    std::thread r1(reader), r2(reader);
+    std::thread writer([&]() {
+        for (uint32_t n = 1; n <= writes; n++) {
+            snapshot.store(snapshotEvent(n));
+        }
+        writing = false;
+    });
+    writer.join();
+    r1.join();
+    r2.join();
+
+    TouchEvent_t e;
+    snapshot.load(&e);
+    bool ok = !torn && !backwards && e.timestamp == writes;
+    printf("%-16s %s  writes:%u loads:%u torn:%u backwards:%u\n", "snapshot", ok ? "ok  " : "FAIL", writes,
+           loads.load(), torn.load(), backwards.load());
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t gestures = argc > 1 ? atoi(argv[1]) : 40;
+    if (!gestures) {
+        gestures = 40;
+    }
+
+    // Time runs 10 times faster than on the board: 10ms reports against a 30ms read period
+    static const RingRun_t runs[] = {
+        {3000,  0,      1000,  true,  "lvgl 30ms"},
+        {500,   0,      100,   true,  "fast reports"},
+        {3000,  40000,  1000,  false, "stalled reader"},
+        {0,     0,      0,     false, "no delays"},
+    };
+
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(runs) / sizeof(*runs); i++) {
+        ok &= run(runs[i], gestures);
+    }
+    ok &= checkFull();
+    ok &= checkSnapshot(2000000);
+    return ok ? 0 : 1;
+}
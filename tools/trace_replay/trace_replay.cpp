@@ -0,0 +1,313 @@
+/**
+ * @file      trace_replay.cpp
+ * @author    Lewis He (lewishe@outlook.com)
+ * @license   MIT
+ * @copyright Copyright (c) 2023  Shenzhen Xin Yuan Electronic Technology Co., Ltd
+ * @date      2023-05-29
+ *
+ * Host tool that replays a display bus trace recorded with LilyGo_AMOLED::startTrace.
+ * The panel RAM is rebuilt from the CASET/RASET/RAMWR commands and pixel data, and
+ * the bus time of every frame is estimated from the recorded bus clock and width.
+ *
+ * Build : g++ -O2 -I../../src trace_replay.cpp -o trace_replay
+ * Usage : trace_replay trace.bin [-o overhead_us] [-p frame.ppm] [-v]
+ *         -o  Fixed cost of one transaction, default 8us for QSPI and 20us for SPI
+ *         -p  Write the area of the panel RAM touched by the trace as PPM
+ *         -v  Print every transaction
+ *
+ * The last line is a checksum of the panel RAM, equal checksums mean that two
+ * traces leave the same picture on the panel.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "DisplayTrace.h"
+
+#define LCD_CMD_CASET   (0x2A)
+#define LCD_CMD_RASET   (0x2B)
+#define LCD_CMD_RAMWR   (0x2C)
+#define LCD_CMD_RAMWRC  (0x3C)
+
+typedef struct {
+    uint32_t transactions;
+    uint64_t bytes;
+    uint64_t busNs;
+    uint32_t firstUs;
+    uint32_t lastUs;
+} FrameStats_t;
+
+typedef struct {
+    uint16_t width, height;
+    uint16_t *ram;
+    uint16_t win[4];
+    uint16_t x, y;
+    bool windowKnown;
+    uint16_t minX, minY, maxX, maxY;
+    bool touched;
+    int pending;            // High byte of a pixel split across two transactions, -1 if none
+} PanelRAM_t;
+
+static void panelWriteByte(PanelRAM_t *p, uint8_t b)
+{
+    if (p->pending < 0) {
+        p->pending = b;
+        return;
+    }
+    uint16_t c = (uint16_t)((p->pending << 8) | b);
+    p->pending = -1;
+    if (!p->windowKnown || p->x >= p->width || p->y >= p->height) {
+        return;
+    }
+    p->ram[(uint32_t)p->y * p->width + p->x] = c;
+    if (!p->touched) {
+        p->minX = p->maxX = p->x;
+        p->minY = p->maxY = p->y;
+        p->touched = true;
+    } else {
+        if (p->x < p->minX) p->minX = p->x;
+        if (p->x > p->maxX) p->maxX = p->x;
+        if (p->y < p->minY) p->minY = p->y;
+        if (p->y > p->maxY) p->maxY = p->y;
+    }
+    if (++p->x > p->win[2]) {
+        p->x = p->win[0];
+        if (++p->y > p->win[3]) {
+            p->y = p->win[1];
+        }
+    }
+}
+
+static void panelCommand(PanelRAM_t *p, uint8_t cmd, const uint8_t *param, uint32_t length)
+{
+    switch (cmd) {
+    case LCD_CMD_CASET:
+    case LCD_CMD_RASET:
+        if (!param || length < 4) {
+            // Parameters were not recorded, pixel data can no longer be placed
+            p->windowKnown = false;
+            break;
+        }
+        {
+            uint8_t i = cmd == LCD_CMD_CASET ? 0 : 1;
+            p->win[i] = (uint16_t)((param[0] << 8) | param[1]);
+            p->win[i + 2] = (uint16_t)((param[2] << 8) | param[3]);
+            p->windowKnown = true;
+        }
+        break;
+    case LCD_CMD_RAMWR:
+        p->x = p->win[0];
+        p->y = p->win[1];
+        p->pending = -1;
+        break;
+    case LCD_CMD_RAMWRC:
+        // Continue at the current position
+        break;
+    default:
+        break;
+    }
+}
+
+static bool writePPM(const PanelRAM_t *p, const char *filename)
+{
+    if (!p->touched) {
+        fprintf(stderr, "Trace contains no pixel data\n");
+        return false;
+    }
+    FILE *fp = fopen(filename, "wb");
+    if (!fp) {
+        return false;
+    }
+    uint16_t w = p->maxX - p->minX + 1;
+    uint16_t h = p->maxY - p->minY + 1;
+    fprintf(fp, "P6\n%u %u\n255\n", w, h);
+    for (uint16_t y = p->minY; y <= p->maxY; y++) {
+        for (uint16_t x = p->minX; x <= p->maxX; x++) {
+            uint16_t c = p->ram[(uint32_t)y * p->width + x];
+            uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+            uint8_t rgb[3] = {(uint8_t)((r << 3) | (r >> 2)), (uint8_t)((g << 2) | (g >> 4)), (uint8_t)((b << 3) | (b >> 2))};
+            fwrite(rgb, 1, 3, fp);
+        }
+    }
+    fclose(fp);
+    return true;
+}
+
+static void printFrame(uint32_t index, const FrameStats_t *f)
+{
+    printf("%6u %8u %10llu %10llu %10u\n", index, f->transactions,
+           (unsigned long long)f->bytes, (unsigned long long)(f->busNs / 1000),
+           f->transactions ? f->lastUs - f->firstUs : 0);
+}
+
+int main(int argc, char **argv)
+{
+    const char *input = NULL;
+    const char *ppm = NULL;
+    int overhead_us = -1;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            overhead_us = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+            ppm = argv[++i];
+        } else if (!strcmp(argv[i], "-v")) {
+            verbose = true;
+        } else {
+            input = argv[i];
+        }
+    }
+    if (!input) {
+        fprintf(stderr, "Usage: %s trace.bin [-o overhead_us] [-p frame.ppm] [-v]\n", argv[0]);
+        return 2;
+    }
+
+    FILE *fp = fopen(input, "rb");
+    if (!fp) {
+        perror(input);
+        return 1;
+    }
+
+    DisplayTraceHeader_t header;
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+            header.magic != DISPLAY_TRACE_MAGIC || header.version != DISPLAY_TRACE_VERSION) {
+        fprintf(stderr, "%s is not a display trace\n", input);
+        fclose(fp);
+        return 1;
+    }
+    if (!header.freq || !header.lanes) {
+        fprintf(stderr, "Invalid bus configuration in trace header\n");
+        fclose(fp);
+        return 1;
+    }
+    if (overhead_us < 0) {
+        overhead_us = header.lanes == 1 ? 20 : 8;
+    }
+
+    PanelRAM_t panel;
+    memset(&panel, 0, sizeof(panel));
+    panel.width = header.gramWidth;
+    panel.height = header.gramHeight;
+    panel.pending = -1;
+    panel.ram = (uint16_t *)calloc((uint32_t)panel.width * panel.height, sizeof(uint16_t));
+    if (!panel.ram) {
+        fprintf(stderr, "Out of memory\n");
+        fclose(fp);
+        return 1;
+    }
+
+    printf("# %ux%u, %u line(s) at %u Hz, %d us per transaction\n",
+           header.gramWidth, header.gramHeight, header.lanes, header.freq, overhead_us);
+    printf("# frame    trans      bytes     bus_us    wall_us\n");
+
+    FrameStats_t frame, total;
+    memset(&frame, 0, sizeof(frame));
+    memset(&total, 0, sizeof(total));
+    uint32_t frames = 0;
+    uint8_t *payload = NULL;
+    uint32_t payload_size = 0;
+    DisplayTraceRecord_t r;
+    int ret = 0;
+
+    while (fread(&r, sizeof(r), 1, fp) == 1) {
+        if (r.flags & TRACE_FRAME) {
+            if (frame.transactions) {
+                printFrame(frames++, &frame);
+            }
+            memset(&frame, 0, sizeof(frame));
+            continue;
+        }
+
+        uint8_t *data = NULL;
+        if (r.flags & TRACE_PAYLOAD) {
+            if (r.length > payload_size) {
+                uint8_t *p = (uint8_t *)realloc(payload, r.length);
+                if (!p) {
+                    fprintf(stderr, "Out of memory\n");
+                    ret = 1;
+                    break;
+                }
+                payload = p;
+                payload_size = r.length;
+            }
+            if (fread(payload, 1, r.length, fp) != r.length) {
+                fprintf(stderr, "Truncated trace\n");
+                ret = 1;
+                break;
+            }
+            data = payload;
+        }
+
+        // Command and address phases on one line, the SPI interface only sends the command byte
+        uint64_t bits = 0;
+        if (!(r.flags & TRACE_CONTINUE)) {
+            bits += header.lanes == 1 ? 8 : 32;
+        }
+        uint64_t data_bits = (uint64_t)r.length * 8;
+        if (r.flags & TRACE_QIO) {
+            data_bits /= header.lanes;
+        }
+        uint64_t ns = (bits + data_bits) * 1000000000ULL / header.freq + overhead_us * 1000ULL;
+
+        if (!frame.transactions) {
+            frame.firstUs = r.timestamp;
+        }
+        frame.lastUs = r.timestamp;
+        frame.transactions++;
+        frame.busNs += ns;
+        total.transactions++;
+        total.busNs += ns;
+
+        uint8_t panel_cmd = (r.addr >> 8) & 0xFF;
+        if (r.cmd == 0x02 && !(r.flags & TRACE_CONTINUE)) {
+            panelCommand(&panel, panel_cmd, data, r.length);
+        } else {
+            // Pixel data, either a RAMWR/RAMWRC burst start or a continuation
+            if (!(r.flags & TRACE_CONTINUE)) {
+                panelCommand(&panel, panel_cmd, NULL, 0);
+            }
+            frame.bytes += r.length;
+            total.bytes += r.length;
+            if (data) {
+                for (uint32_t i = 0; i < r.length; i++) {
+                    panelWriteByte(&panel, data[i]);
+                }
+            }
+        }
+
+        if (verbose) {
+            printf("  %10u cmd:0x%02X reg:0x%02X len:%-7u flags:%s%s%s%s%s %llu ns\n",
+                   r.timestamp, r.cmd, panel_cmd, r.length,
+                   (r.flags & TRACE_QIO) ? " QIO" : "",
+                   (r.flags & TRACE_CONTINUE) ? " CONT" : "",
+                   (r.flags & TRACE_CS_BEGIN) ? " CS+" : "",
+                   (r.flags & TRACE_CS_END) ? " CS-" : "",
+                   (r.flags & TRACE_POLLING) ? " POLL" : "",
+                   (unsigned long long)ns);
+        }
+    }
+    if (frame.transactions) {
+        printFrame(frames++, &frame);
+    }
+    fclose(fp);
+    free(payload);
+
+    printf("# total %u frame(s), %u transactions, %llu bytes, %llu us on the bus\n",
+           frames, total.transactions, (unsigned long long)total.bytes,
+           (unsigned long long)(total.busNs / 1000));
+
+    // FNV-1a over the panel RAM
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < (uint32_t)panel.width * panel.height; i++) {
+        hash = (hash ^ (panel.ram[i] & 0xFF)) * 16777619u;
+        hash = (hash ^ (panel.ram[i] >> 8)) * 16777619u;
+    }
+    printf("# ram checksum %08X\n", hash);
+
+    if (ppm && !writePPM(&panel, ppm)) {
+        ret = 1;
+    }
+    free(panel.ram);
+    return ret;
+}